@@ -12,6 +12,7 @@ LOCAL_SRC_FILES:= \
     ND/systemmanager.cpp \
     ND/radio_state.cpp \
     silo.cpp \
+    rsp_prefix_trie.cpp \
     ND/silo_voice.cpp \
     ND/silo_network.cpp \
     ND/silo_sim.cpp \
@@ -21,8 +22,11 @@ LOCAL_SRC_FILES:= \
     ND/silo_misc.cpp \
     ND/silo_ims.cpp \
     ND/silo_common.cpp \
+    ND/signal_filter.cpp \
+    ND/sim_file_cache.cpp \
     ND/channel_nd.cpp \
     channelbase.cpp \
+    channel_reactor.cpp \
     channel_atcmd.cpp \
     channel_data.cpp \
     channel_DLC2.cpp \
@@ -39,8 +43,13 @@ LOCAL_SRC_FILES:= \
     ND/thread_ops.cpp \
     cmdcontext.cpp \
     command.cpp \
+    cmdqueue.cpp \
+    latency_stats.cpp \
+    request_coalescer.cpp \
     request_info.cpp \
+    timer_wheel.cpp \
     response.cpp \
+    rxbuffer.cpp \
     request_info_table.cpp \
     thread_manager.cpp \
     ND/MODEMS/initializer.cpp \
@@ -49,6 +58,7 @@ LOCAL_SRC_FILES:= \
     ND/MODEMS/init7160.cpp \
     ND/MODEMS/init7260.cpp \
     ND/MODEMS/data_util.cpp \
+    ND/MODEMS/netlink_ifconfig.cpp \
     ND/MODEMS/te_xmm6260.cpp \
     ND/MODEMS/te_xmm6360.cpp \
     ND/MODEMS/te_xmm7160.cpp \
@@ -59,87 +59,6 @@ int MapErrorCodeToRilDataFailCause(UINT32 uiCause)
     }
 }
 
-void init_sockaddr_in(struct sockaddr_in* sin, const char* addr)
-{
-    sin->sin_family = AF_INET;
-    sin->sin_port = 0;
-    sin->sin_addr.s_addr = inet_addr(addr);
-}
-
-BOOL setaddr6(int sockfd6, struct ifreq* ifr, const char* addr)
-{
-    int ret;
-
-    struct in6_ifreq ifr6;
-    inet_pton(AF_INET6, addr, &ifr6.ifr6_addr);
-
-    ioctl(sockfd6, SIOGIFINDEX, ifr);
-    ifr6.ifr6_ifindex = ifr->ifr_ifindex;
-    ifr6.ifr6_prefixlen = 64; //prefix_len;
-
-    RIL_LOG_INFO("setaddr6() - calling SIOCSIFADDR ADDR:%s INET:%s\r\n",addr,ifr->ifr_name);
-    errno = 0;
-    ret = ioctl(sockfd6, SIOCSIFADDR, &ifr6);
-    if (ret < 0)
-    {
-        RIL_LOG_CRITICAL("setaddr6() : SIOCSIFADDR : %s\r\n",
-                strerror(errno));
-        return FALSE;
-    }
-
-    return TRUE;
-}
-
-BOOL setaddr(int s, struct ifreq* ifr, const char* addr)
-{
-    int ret;
-    init_sockaddr_in((struct sockaddr_in*) &ifr->ifr_addr, addr);
-    RIL_LOG_INFO("setaddr - calling SIOCSIFADDR\r\n");
-    errno = 0; // NOERROR
-    ret = ioctl(s, SIOCSIFADDR, ifr);
-    if (ret < 0)
-    {
-        RIL_LOG_CRITICAL("setaddr() : SIOCSIFADDR : %s\r\n",
-            strerror(errno));
-        return FALSE;
-    }
-    return TRUE;
-}
-
-BOOL setflags(int s, struct ifreq* ifr, int set, int clr)
-{
-    int ret;
-    RIL_LOG_INFO("setflags - calling SIOCGIFFLAGS\r\n");
-    ret = ioctl(s, SIOCGIFFLAGS, ifr);
-    if (ret < 0)
-    {
-        RIL_LOG_CRITICAL("setflags : SIOCGIFFLAGS : %s\r\n", strerror(errno));
-        return FALSE;
-    }
-
-    ifr->ifr_flags = (ifr->ifr_flags & (~clr)) | set;
-    RIL_LOG_INFO("setflags - calling SIOCGIFFLAGS 2\r\n");
-    ret = ioctl(s, SIOCSIFFLAGS, ifr);
-    if (ret < 0)
-    {
-        RIL_LOG_CRITICAL("setflags: SIOCSIFFLAGS 2 : %s\r\n", strerror(errno));
-        return FALSE;
-    }
-    return TRUE;
-}
-
-BOOL setmtu(int s, struct ifreq* ifr)
-{
-    ifr->ifr_mtu = CTE::GetTE().GetMTU();
-    RIL_LOG_INFO("setmtu - calling SIOCSIFMTU\r\n");
-    if(ioctl(s, SIOCSIFMTU, ifr) < 0)
-    {
-        RIL_LOG_CRITICAL("setmtu: ERROR: SIOCSIFMTU\r\n");
-        return FALSE;
-    }
-    return TRUE;
-}
-
 BOOL ExtractLocalAddressAndSubnetMask(char* pAddressAndSubnetMask,
         char* pIPv4LocalAddr, UINT32 uiIPv4LocalAddrSize,
         char* pIPv6LocalAddr, UINT32 uiIPv6LocalAddrSize,
@@ -17,12 +17,6 @@
 #include <arpa/inet.h>
 #include <linux/gsmmux.h>
 
-// Helper functions for configuring data connections
-BOOL setaddr6(int sockfd6, struct ifreq* ifr, const char* addr);
-BOOL setaddr(int s, struct ifreq* ifr, const char* addr);
-BOOL setflags(int s, struct ifreq* ifr, int set, int clr);
-BOOL setmtu(int s, struct ifreq* ifr);
-
 int MapErrorCodeToRilDataFailCause(UINT32 uiCause);
 
 // Helper function to extract local address and subnet mask from <LOCAL_ADDR and SUBNET_MASK>
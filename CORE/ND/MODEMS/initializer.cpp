@@ -603,11 +603,18 @@ Error:
     return bRet;
 }
 
+//
+// The ports are opened concurrently, one thread per channel, as opening a port
+// waits for the modem to set up its DLC. The channels only start to be used once
+// all of them are open.
+//
 BOOL CInitializer::OpenChannelPortsOnly()
 {
     RIL_LOG_VERBOSE("CInitializer::OpenChannelPortsOnly() - Enter\r\n");
 
     BOOL bRet = FALSE;
+    PORT_OPEN_DATA rgPortOpenData[RIL_CHANNEL_MAX];
+    UINT32 uiNumPorts = 0;
 
     CMutex::Lock(m_pPortsManagerMutex);
 
@@ -617,7 +624,6 @@ BOOL CInitializer::OpenChannelPortsOnly()
         goto Done;
     }
 
-    //  Init our array of global CChannel pointers.
     for (UINT32 i = 0; i < g_uiRilChannelCurMax && i < RIL_CHANNEL_MAX; i++)
     {
         if (i == RIL_CHANNEL_RESERVED)
@@ -626,40 +632,39 @@ BOOL CInitializer::OpenChannelPortsOnly()
         if (IsChannelUndefined(i))
             continue;
 
-        /*
-         * In flight mode, changing the WiFi state will result in MODEM_UP and
-         * NOTIFY_MODEM_SHUTDOWN received within few milliseconds. Upon receiving MODEM_UP, init
-         * thread will start opening the ports. Even upon receiving NOTIFY_MODEM_SHUTDOWN, port
-         * opening will continue. Port opening fails only if the mux closes the tty ports. Mux
-         * will close the tty only if the MMGR switches off/closes the ttyIFX0. Since it takes
-         * quite a long time for the port opening failure, it is better to check modem status
-         * before opening each port to avoid delays in cleaning up the resources.
-         */
-        if (E_MMGR_EVENT_MODEM_UP != CTE::GetTE().GetLastModemEvent())
+        PORT_OPEN_DATA* pData = &rgPortOpenData[uiNumPorts++];
+        pData->uiChannel = i;
+        pData->bOpened = FALSE;
+        pData->pThread = new CThread(OpenChannelPortThreadProc, pData, THREAD_FLAGS_JOINABLE, 0);
+
+        if (NULL == pData->pThread || !CThread::IsInitialized(pData->pThread))
         {
-            RIL_LOG_CRITICAL("CInitializer::OpenChannelPortsOnly() : Channel[%d] OpenPort()"
-                    " failed due to modem not up\r\n", i);
-            goto Done;
+            // open it from this thread instead
+            RIL_LOG_WARNING("CInitializer::OpenChannelPortsOnly() : Channel[%d] Unable to"
+                    " launch port open thread\r\n", i);
+            delete pData->pThread;
+            pData->pThread = NULL;
+            pData->bOpened = OpenChannelPort(i);
         }
+    }
+
+    bRet = TRUE;
 
-        if (!g_pRilChannel[i]->OpenPort())
+    for (UINT32 i = 0; i < uiNumPorts; i++)
+    {
+        if (NULL != rgPortOpenData[i].pThread)
         {
-            RIL_LOG_CRITICAL("CInitializer::OpenChannelPortsOnly() : Channel[%d] OpenPort()"
-                    " failed\r\n", i);
-            goto Done;
+            CThread::Wait(rgPortOpenData[i].pThread, WAIT_FOREVER);
+            delete rgPortOpenData[i].pThread;
+            rgPortOpenData[i].pThread = NULL;
         }
 
-        if (!g_pRilChannel[i]->InitPort())
+        if (!rgPortOpenData[i].bOpened)
         {
-            RIL_LOG_CRITICAL("CInitializer::OpenChannelPortsOnly() : Channel[%d] InitPort()"
-                    " failed\r\n", i);
-            goto Done;
+            bRet = FALSE;
         }
     }
 
-    //  We made it this far, return TRUE.
-    bRet = TRUE;
-
 Done:
     CMutex::Unlock(m_pPortsManagerMutex);
 
@@ -667,6 +672,49 @@ Done:
     return bRet;
 }
 
+BOOL CInitializer::OpenChannelPort(UINT32 uiChannel)
+{
+    /*
+     * In flight mode, changing the WiFi state will result in MODEM_UP and
+     * NOTIFY_MODEM_SHUTDOWN received within few milliseconds. Upon receiving MODEM_UP, init
+     * thread will start opening the ports. Even upon receiving NOTIFY_MODEM_SHUTDOWN, port
+     * opening will continue. Port opening fails only if the mux closes the tty ports. Mux
+     * will close the tty only if the MMGR switches off/closes the ttyIFX0. Since it takes
+     * quite a long time for the port opening failure, it is better to check modem status
+     * before opening each port to avoid delays in cleaning up the resources.
+     */
+    if (E_MMGR_EVENT_MODEM_UP != CTE::GetTE().GetLastModemEvent())
+    {
+        RIL_LOG_CRITICAL("CInitializer::OpenChannelPort() : Channel[%d] OpenPort()"
+                " failed due to modem not up\r\n", uiChannel);
+        return FALSE;
+    }
+
+    if (!g_pRilChannel[uiChannel]->OpenPort())
+    {
+        RIL_LOG_CRITICAL("CInitializer::OpenChannelPort() : Channel[%d] OpenPort()"
+                " failed\r\n", uiChannel);
+        return FALSE;
+    }
+
+    if (!g_pRilChannel[uiChannel]->InitPort())
+    {
+        RIL_LOG_CRITICAL("CInitializer::OpenChannelPort() : Channel[%d] InitPort()"
+                " failed\r\n", uiChannel);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+void* CInitializer::OpenChannelPortThreadProc(void* pArg)
+{
+    PORT_OPEN_DATA* pData = (PORT_OPEN_DATA*)pArg;
+
+    pData->bOpened = OpenChannelPort(pData->uiChannel);
+    return NULL;
+}
+
 void CInitializer::CloseChannelPorts()
 {
     RIL_LOG_VERBOSE("CInitializer::CloseChannelPorts() - Enter\r\n");
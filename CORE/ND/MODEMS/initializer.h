@@ -19,6 +19,7 @@
 
 class CChannel;
 class CSilo;
+class CThread;
 class CSystemCapabilities;
 
 enum SILO_TYPE {
@@ -90,6 +91,15 @@ private:
     CSilo* CreateSilo(CChannel* pChannel, int siloType, CSystemCapabilities* pSysCaps);
     int GetSiloConfig(UINT32 channel);
 
+    // Port opening of one channel, run on its own thread by OpenChannelPortsOnly()
+    struct PORT_OPEN_DATA {
+        UINT32 uiChannel;
+        CThread* pThread;
+        BOOL bOpened;
+    };
+    static BOOL OpenChannelPort(UINT32 uiChannel);
+    static void* OpenChannelPortThreadProc(void* pArg);
+
     // Modem initialization helper functions (called by component init functions)
     BOOL SendModemInitCommands(eComInitIndex eInitIndex);
     static void* StartModemInitializationThreadWrapper(void* pArg);
@@ -0,0 +1,448 @@
+////////////////////////////////////////////////////////////////////////////
+// netlink_ifconfig.cpp
+//
+// Copyright 2009 Intrinsyc Software International, Inc.  All rights reserved.
+// Patents pending in the United States of America and other jurisdictions.
+//
+//
+// Description:
+//    Implementation of the configuration of a network interface through
+//    rtnetlink.
+//
+//    The kernel handles the messages of a batch in order, in the context of
+//    the sender, and queues one acknowledgement per message before sendmsg()
+//    returns. The acknowledgements are matched to the requests by sequence
+//    number; stale ones of a batch that timed out are dropped.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <net/if.h>
+#include <arpa/inet.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+
+#include "types.h"
+#include "rillog.h"
+#include "sync_ops.h"
+#include "netlink_ifconfig.h"
+
+// Time given to the kernel to acknowledge a batch
+static const int ACK_TIMEOUT_SEC = 1;
+
+CMutex* CNetlinkIfConfig::m_pLock = NULL;
+int CNetlinkIfConfig::m_iSocket = -1;
+UINT32 CNetlinkIfConfig::m_uiSequence = 0;
+
+///////////////////////////////////////////////////////////////////////////////
+BOOL CNetlinkIfConfig::Init()
+{
+    if (NULL != m_pLock)
+    {
+        return TRUE;
+    }
+
+    m_pLock = new CMutex();
+    if (NULL == m_pLock)
+    {
+        RIL_LOG_CRITICAL("CNetlinkIfConfig::Init() - Cannot allocate lock\r\n");
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+void CNetlinkIfConfig::Destroy()
+{
+    CMutex* pLock = m_pLock;
+
+    if (NULL == pLock)
+    {
+        return;
+    }
+
+    CMutex::Lock(pLock);
+    m_pLock = NULL;
+    CloseSocket();
+    CMutex::Unlock(pLock);
+
+    delete pLock;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+CNetlinkIfConfig::CNetlinkIfConfig(const char* pszInterfaceName) :
+    m_iInterfaceIndex(0),
+    m_uiLength(0),
+    m_uiRequestStart(0),
+    m_nRequests(0),
+    m_bOverflow(FALSE)
+{
+    m_szInterfaceName[0] = '\0';
+    if (NULL != pszInterfaceName)
+    {
+        strncpy(m_szInterfaceName, pszInterfaceName, MAX_INTERFACE_NAME_SIZE - 1);
+        m_szInterfaceName[MAX_INTERFACE_NAME_SIZE - 1] = '\0';
+        m_iInterfaceIndex = if_nametoindex(m_szInterfaceName);
+    }
+
+    if (0 == m_iInterfaceIndex)
+    {
+        RIL_LOG_CRITICAL("CNetlinkIfConfig::CNetlinkIfConfig() - No interface [%s]\r\n",
+                m_szInterfaceName);
+    }
+}
+
+BOOL CNetlinkIfConfig::BeginLinkRequest(UINT32 uiFlags, UINT32 uiChange)
+{
+    struct ifinfomsg ifi;
+
+    memset(&ifi, 0, sizeof(ifi));
+    ifi.ifi_family = AF_UNSPEC;
+    ifi.ifi_index = m_iInterfaceIndex;
+    ifi.ifi_flags = uiFlags;
+    ifi.ifi_change = uiChange;
+
+    if (!BeginRequest(RTM_NEWLINK, 0, &ifi, sizeof(ifi)))
+    {
+        return FALSE;
+    }
+
+    // the kernel finds the link by name if its index is unknown
+    return (0 != m_iInterfaceIndex
+            || AddAttribute(IFLA_IFNAME, m_szInterfaceName, strlen(m_szInterfaceName) + 1));
+}
+
+BOOL CNetlinkIfConfig::SetLink(UINT32 uiFlagsSet, UINT32 uiFlagsClear)
+{
+    if (!BeginLinkRequest(uiFlagsSet, uiFlagsSet | uiFlagsClear))
+    {
+        return FALSE;
+    }
+
+    EndRequest(0, "link flags set=0x%X clear=0x%X", uiFlagsSet, uiFlagsClear);
+    return TRUE;
+}
+
+//
+// The MTU is a request of its own, so the kernel refusing it does not keep
+// the link from being brought up by the SetLink request.
+//
+BOOL CNetlinkIfConfig::SetMtu(UINT32 uiMtu)
+{
+    if (0 == uiMtu)
+    {
+        return TRUE;
+    }
+
+    if (!BeginLinkRequest(0, 0) || !AddAttribute(IFLA_MTU, &uiMtu, sizeof(uiMtu)))
+    {
+        return FALSE;
+    }
+
+    EndRequest(0, "mtu=%u", uiMtu);
+    return TRUE;
+}
+
+BOOL CNetlinkIfConfig::AddAddress(int family, const char* pszAddress, UINT8 uiPrefixLength)
+{
+    struct ifaddrmsg ifa;
+    BYTE rgbAddress[sizeof(struct in6_addr)];
+    UINT32 uiAddressSize = (AF_INET6 == family) ? sizeof(struct in6_addr)
+            : sizeof(struct in_addr);
+
+    if (NULL == pszAddress || 1 != inet_pton(family, pszAddress, rgbAddress))
+    {
+        RIL_LOG_CRITICAL("CNetlinkIfConfig::AddAddress() - Invalid address [%s]\r\n",
+                (NULL == pszAddress) ? "" : pszAddress);
+        return FALSE;
+    }
+
+    if (0 == m_iInterfaceIndex)
+    {
+        RIL_LOG_CRITICAL("CNetlinkIfConfig::AddAddress() - No interface [%s]\r\n",
+                m_szInterfaceName);
+        return FALSE;
+    }
+
+    memset(&ifa, 0, sizeof(ifa));
+    ifa.ifa_family = family;
+    ifa.ifa_prefixlen = uiPrefixLength;
+    ifa.ifa_index = m_iInterfaceIndex;
+
+    if (!BeginRequest(RTM_NEWADDR, NLM_F_CREATE | NLM_F_REPLACE, &ifa, sizeof(ifa))
+            || !AddAttribute(IFA_LOCAL, rgbAddress, uiAddressSize)
+            || !AddAttribute(IFA_ADDRESS, rgbAddress, uiAddressSize))
+    {
+        return FALSE;
+    }
+
+    EndRequest(0, "add address %s/%u", pszAddress, uiPrefixLength);
+    return TRUE;
+}
+
+//
+// Without any address attribute, the kernel removes the first address of the
+// interface. As with SIOCSIFADDR 0.0.0.0, the secondary addresses go with it.
+//
+BOOL CNetlinkIfConfig::DeleteIpV4Address()
+{
+    struct ifaddrmsg ifa;
+
+    if (0 == m_iInterfaceIndex)
+    {
+        RIL_LOG_CRITICAL("CNetlinkIfConfig::DeleteIpV4Address() - No interface [%s]\r\n",
+                m_szInterfaceName);
+        return FALSE;
+    }
+
+    memset(&ifa, 0, sizeof(ifa));
+    ifa.ifa_family = AF_INET;
+    ifa.ifa_index = m_iInterfaceIndex;
+
+    if (!BeginRequest(RTM_DELADDR, 0, &ifa, sizeof(ifa)))
+    {
+        return FALSE;
+    }
+
+    EndRequest(EADDRNOTAVAIL, "delete IPv4 address");
+    return TRUE;
+}
+
+BOOL CNetlinkIfConfig::Commit()
+{
+    struct sockaddr_nl kernel;
+    struct nlmsghdr* pHeader;
+    UINT32 uiFirstSequence;
+    UINT32 uiOffset;
+    BOOL bRet = FALSE;
+
+    if (m_bOverflow)
+    {
+        RIL_LOG_CRITICAL("CNetlinkIfConfig::Commit() - [%s] Too many requests\r\n",
+                m_szInterfaceName);
+        return FALSE;
+    }
+
+    if (0 == m_nRequests)
+    {
+        return TRUE;
+    }
+
+    if (NULL == m_pLock)
+    {
+        RIL_LOG_CRITICAL("CNetlinkIfConfig::Commit() - Not initialized\r\n");
+        return FALSE;
+    }
+
+    CMutex::Lock(m_pLock);
+
+    if (!OpenSocket())
+    {
+        goto Error;
+    }
+
+    uiFirstSequence = m_uiSequence + 1;
+    for (uiOffset = 0; uiOffset < m_uiLength; uiOffset += NLMSG_ALIGN(pHeader->nlmsg_len))
+    {
+        pHeader = (struct nlmsghdr*)((BYTE*)m_rguiBuffer + uiOffset);
+        pHeader->nlmsg_seq = ++m_uiSequence;
+    }
+
+    memset(&kernel, 0, sizeof(kernel));
+    kernel.nl_family = AF_NETLINK;
+
+    if (sendto(m_iSocket, m_rguiBuffer, m_uiLength, 0, (struct sockaddr*)&kernel,
+            sizeof(kernel)) != (ssize_t)m_uiLength)
+    {
+        RIL_LOG_CRITICAL("CNetlinkIfConfig::Commit() - [%s] sendto() failed, errno=[%d]\r\n",
+                m_szInterfaceName, errno);
+
+        // opened again by the next transaction
+        CloseSocket();
+        goto Error;
+    }
+
+    bRet = ReadAcks(uiFirstSequence);
+
+Error:
+    CMutex::Unlock(m_pLock);
+
+    RIL_LOG_INFO("CNetlinkIfConfig::Commit() - [%s] [%u] requests, bRet=[%d]\r\n",
+            m_szInterfaceName, m_nRequests, bRet);
+
+    m_uiLength = 0;
+    m_nRequests = 0;
+    return bRet;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+BOOL CNetlinkIfConfig::BeginRequest(UINT16 type, UINT16 flags, const void* pHeader,
+        UINT32 uiHeaderSize)
+{
+    struct nlmsghdr* pMsg;
+
+    if (m_nRequests >= E_MAX_REQUESTS
+            || m_uiLength + NLMSG_SPACE(uiHeaderSize) > E_BUFFER_SIZE)
+    {
+        m_bOverflow = TRUE;
+        return FALSE;
+    }
+
+    m_uiRequestStart = m_uiLength;
+    pMsg = (struct nlmsghdr*)((BYTE*)m_rguiBuffer + m_uiLength);
+    memset(pMsg, 0, NLMSG_SPACE(uiHeaderSize));
+    pMsg->nlmsg_len = NLMSG_LENGTH(uiHeaderSize);
+    pMsg->nlmsg_type = type;
+    pMsg->nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK | flags;
+    memcpy(NLMSG_DATA(pMsg), pHeader, uiHeaderSize);
+
+    m_uiLength += NLMSG_SPACE(uiHeaderSize);
+    return TRUE;
+}
+
+BOOL CNetlinkIfConfig::AddAttribute(UINT16 type, const void* pData, UINT32 uiSize)
+{
+    struct nlmsghdr* pMsg = (struct nlmsghdr*)((BYTE*)m_rguiBuffer + m_uiRequestStart);
+    struct rtattr* pAttr;
+
+    if (m_uiLength + RTA_SPACE(uiSize) > E_BUFFER_SIZE)
+    {
+        m_bOverflow = TRUE;
+        return FALSE;
+    }
+
+    pAttr = (struct rtattr*)((BYTE*)m_rguiBuffer + m_uiLength);
+    memset(pAttr, 0, RTA_SPACE(uiSize));
+    pAttr->rta_type = type;
+    pAttr->rta_len = RTA_LENGTH(uiSize);
+    memcpy(RTA_DATA(pAttr), pData, uiSize);
+
+    m_uiLength += RTA_SPACE(uiSize);
+    pMsg->nlmsg_len = m_uiLength - m_uiRequestStart;
+    return TRUE;
+}
+
+void CNetlinkIfConfig::EndRequest(int iIgnoredError, const char* pszFormat, ...)
+{
+    va_list args;
+
+    va_start(args, pszFormat);
+    vsnprintf(m_rgszDescription[m_nRequests], E_MAX_DESCRIPTION, pszFormat, args);
+    va_end(args);
+
+    m_rgiIgnoredError[m_nRequests] = iIgnoredError;
+    m_rgbAcked[m_nRequests] = FALSE;
+    m_nRequests++;
+}
+
+// Called with the lock held
+BOOL CNetlinkIfConfig::ReadAcks(UINT32 uiFirstSequence)
+{
+    UINT32 rguiReply[E_BUFFER_SIZE / sizeof(UINT32)];
+    UINT32 nAcked = 0;
+    BOOL bRet = TRUE;
+
+    while (nAcked < m_nRequests)
+    {
+        ssize_t iRead = recv(m_iSocket, rguiReply, sizeof(rguiReply), 0);
+        struct nlmsghdr* pMsg = (struct nlmsghdr*)rguiReply;
+        UINT32 uiLength;
+
+        if (iRead < 0)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+
+            RIL_LOG_CRITICAL("CNetlinkIfConfig::ReadAcks() - [%s] recv() failed, errno=[%d],"
+                    " [%u] of [%u] requests acknowledged\r\n", m_szInterfaceName, errno,
+                    nAcked, m_nRequests);
+            return FALSE;
+        }
+
+        for (uiLength = (UINT32)iRead; NLMSG_OK(pMsg, uiLength); pMsg = NLMSG_NEXT(pMsg, uiLength))
+        {
+            UINT32 uiIndex = pMsg->nlmsg_seq - uiFirstSequence;
+            int iError;
+
+            // acknowledgement of an earlier batch
+            if (NLMSG_ERROR != pMsg->nlmsg_type || uiIndex >= m_nRequests
+                    || m_rgbAcked[uiIndex])
+            {
+                continue;
+            }
+
+            m_rgbAcked[uiIndex] = TRUE;
+            nAcked++;
+
+            iError = -((struct nlmsgerr*)NLMSG_DATA(pMsg))->error;
+            if (0 != iError && m_rgiIgnoredError[uiIndex] != iError)
+            {
+                RIL_LOG_CRITICAL("CNetlinkIfConfig::ReadAcks() - [%s] %s failed: %s\r\n",
+                        m_szInterfaceName, m_rgszDescription[uiIndex], strerror(iError));
+                bRet = FALSE;
+            }
+            else
+            {
+                RIL_LOG_INFO("CNetlinkIfConfig::ReadAcks() - [%s] %s\r\n",
+                        m_szInterfaceName, m_rgszDescription[uiIndex]);
+            }
+        }
+    }
+
+    return bRet;
+}
+
+// Called with the lock held
+BOOL CNetlinkIfConfig::OpenSocket()
+{
+    struct sockaddr_nl local;
+    struct timeval timeout;
+
+    if (m_iSocket >= 0)
+    {
+        return TRUE;
+    }
+
+    m_iSocket = socket(AF_NETLINK, SOCK_DGRAM, NETLINK_ROUTE);
+    if (m_iSocket < 0)
+    {
+        RIL_LOG_CRITICAL("CNetlinkIfConfig::OpenSocket() - socket() failed, errno=[%d]\r\n",
+                errno);
+        return FALSE;
+    }
+
+    memset(&local, 0, sizeof(local));
+    local.nl_family = AF_NETLINK;
+
+    timeout.tv_sec = ACK_TIMEOUT_SEC;
+    timeout.tv_usec = 0;
+
+    if (bind(m_iSocket, (struct sockaddr*)&local, sizeof(local)) < 0
+            || setsockopt(m_iSocket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) < 0)
+    {
+        RIL_LOG_CRITICAL("CNetlinkIfConfig::OpenSocket() - Cannot set up socket,"
+                " errno=[%d]\r\n", errno);
+        CloseSocket();
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+// Called with the lock held
+void CNetlinkIfConfig::CloseSocket()
+{
+    if (m_iSocket >= 0)
+    {
+        close(m_iSocket);
+        m_iSocket = -1;
+    }
+}
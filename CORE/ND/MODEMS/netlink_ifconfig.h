@@ -0,0 +1,84 @@
+////////////////////////////////////////////////////////////////////////////
+// netlink_ifconfig.h
+//
+// Copyright 2009 Intrinsyc Software International, Inc.  All rights reserved.
+// Patents pending in the United States of America and other jurisdictions.
+//
+//
+// Description:
+//    Configuration of a network interface through rtnetlink. The link state,
+//    MTU and addresses of an interface are queued then sent to the kernel in
+//    a single transaction on a socket kept open by the RIL. Each request is
+//    acknowledged on its own, so a failure is reported for the attribute that
+//    failed and does not prevent the others from being applied.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef RRIL_NETLINK_IFCONFIG_H
+#define RRIL_NETLINK_IFCONFIG_H
+
+#include "types.h"
+#include "rril.h"
+
+class CMutex;
+
+class CNetlinkIfConfig
+{
+public:
+    // Create the lock serializing the transactions, the socket is opened on first use
+    static BOOL Init();
+    static void Destroy();
+
+    CNetlinkIfConfig(const char* pszInterfaceName);
+
+    // Change the link flags (IFF_UP, IFF_NOARP...)
+    BOOL SetLink(UINT32 uiFlagsSet, UINT32 uiFlagsClear);
+
+    // Change the MTU in a request of its own, nothing is queued if it is 0
+    BOOL SetMtu(UINT32 uiMtu);
+
+    // Add an address of family AF_INET or AF_INET6
+    BOOL AddAddress(int family, const char* pszAddress, UINT8 uiPrefixLength);
+
+    // Remove the primary IPv4 address, there is no error if there is none
+    BOOL DeleteIpV4Address();
+
+    // Apply the queued requests in order. Returns TRUE if all of them succeeded.
+    BOOL Commit();
+
+private:
+    enum
+    {
+        E_BUFFER_SIZE = 1024,
+        E_MAX_REQUESTS = 8,
+        E_MAX_DESCRIPTION = 64
+    };
+
+    BOOL BeginRequest(UINT16 type, UINT16 flags, const void* pHeader, UINT32 uiHeaderSize);
+    BOOL BeginLinkRequest(UINT32 uiFlags, UINT32 uiChange);
+    BOOL AddAttribute(UINT16 type, const void* pData, UINT32 uiSize);
+    void EndRequest(int iIgnoredError, const char* pszFormat, ...);
+    BOOL ReadAcks(UINT32 uiFirstSequence);
+
+    static BOOL OpenSocket();
+    static void CloseSocket();
+
+    char m_szInterfaceName[MAX_INTERFACE_NAME_SIZE];
+    int m_iInterfaceIndex;                  // 0 if unknown
+
+    // the batch of requests, each one is a netlink message
+    UINT32 m_rguiBuffer[E_BUFFER_SIZE / sizeof(UINT32)];
+    UINT32 m_uiLength;
+    UINT32 m_uiRequestStart;                // offset of the request being added
+    UINT32 m_nRequests;
+    BOOL m_bOverflow;
+    int m_rgiIgnoredError[E_MAX_REQUESTS];
+    BOOL m_rgbAcked[E_MAX_REQUESTS];
+    char m_rgszDescription[E_MAX_REQUESTS][E_MAX_DESCRIPTION];
+
+    static CMutex* m_pLock;
+    static int m_iSocket;
+    static UINT32 m_uiSequence;
+};
+
+#endif // RRIL_NETLINK_IFCONFIG_H
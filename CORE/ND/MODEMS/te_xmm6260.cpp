@@ -40,6 +40,7 @@
 #include "callbacks.h"
 #include "init6260.h"
 #include "bertlv_util.h"
+#include "latency_stats.h"
 
 
 CTE_XMM6260::CTE_XMM6260(CTE& cte)
@@ -2267,6 +2268,11 @@ RIL_RESULT_CODE CTE_XMM6260::CoreHookStrings(REQUEST_DATA& rReqData,
             res = SetSrvccParams(rReqData, (const char**) pszRequest);
             break;
 
+        case RIL_OEM_HOOK_STRING_GET_LATENCY_STATS:
+            RIL_LOG_INFO("Received Commmand: RIL_OEM_HOOK_STRING_GET_LATENCY_STATS");
+            res = GetLatencyStats(rReqData);
+            break;
+
         case RIL_OEM_HOOK_STRING_SET_DEFAULT_APN:
             RIL_LOG_INFO("Received Commmand: RIL_OEM_HOOK_STRING_SET_DEFAULT_APN");
             // Send this command on ATCMD channel
@@ -4636,6 +4642,35 @@ Error:
     return res;
 }
 
+RIL_RESULT_CODE CTE_XMM6260::GetLatencyStats(REQUEST_DATA& rReqData)
+{
+    RIL_LOG_VERBOSE("CTE_XMM6260::GetLatencyStats() - Enter\r\n");
+    P_ND_GET_LATENCY_STATS pResponse = NULL;
+    RIL_RESULT_CODE res = RRIL_RESULT_ERROR;
+
+    pResponse = (P_ND_GET_LATENCY_STATS) malloc(sizeof(S_ND_GET_LATENCY_STATS));
+    if (NULL == pResponse)
+    {
+        RIL_LOG_CRITICAL("CTE_XMM6260::GetLatencyStats() -"
+                " Could not allocate memory for response\r\n");
+        goto Error;
+    }
+
+    memset(pResponse, 0, sizeof(S_ND_GET_LATENCY_STATS));
+    CLatencyStats::GetReport(pResponse->szLatencyStats, sizeof(pResponse->szLatencyStats));
+    pResponse->sResponsePointer.pszLatencyStats = pResponse->szLatencyStats;
+
+    // Response data are passed in pContextData2 and len in cbContextData2
+    // when response is immediate.
+    rReqData.pContextData2 = (void*)pResponse;
+    rReqData.cbContextData2 = sizeof(S_ND_GET_LATENCY_STATS_PTR);
+
+    res = RRIL_RESULT_OK_IMMEDIATE;
+Error:
+    RIL_LOG_VERBOSE("CTE_XMM6260::GetLatencyStats() - Exit\r\n");
+    return res;
+}
+
 RIL_RESULT_CODE CTE_XMM6260::SetSrvccParams(REQUEST_DATA& rReqData, const char** pszRequest)
 {
     RIL_LOG_VERBOSE("CTE_XMM6260::SetSrvccParams() - Enter\r\n");
@@ -323,6 +323,7 @@ private:
                              const UINT32 uiDataSize);
     RIL_RESULT_CODE SetSrvccParams(REQUEST_DATA& rReqData,
                                    const char** pszRequest);
+    RIL_RESULT_CODE GetLatencyStats(REQUEST_DATA& rReqData);
     RIL_RESULT_CODE ParseXGATR(const char* pszRsp, RESPONSE_DATA& rRspData);
     RIL_RESULT_CODE ParseXDRV(const char* pszRsp, RESPONSE_DATA& rRspData);
     RIL_RESULT_CODE ParseCGED(const char* pszRsp, RESPONSE_DATA& rRspData);
@@ -37,6 +37,7 @@
 #include "reset.h"
 #include "data_util.h"
 #include "init7160.h"
+#include "signal_filter.h"
 
 CTE_XMM7160::CTE_XMM7160(CTE& cte)
 : CTE_XMM6360(cte)
@@ -186,7 +187,7 @@ RIL_RESULT_CODE CTE_XMM7160::ParseSignalStrength(RESPONSE_DATA& rRspData)
     RIL_SignalStrength_v6* pSigStrData = NULL;
     const char* pszRsp = rRspData.szResponse;
 
-    pSigStrData = ParseXCESQ(pszRsp, FALSE);
+    pSigStrData = (RIL_SignalStrength_v6*)malloc(sizeof(RIL_SignalStrength_v6));
     if (NULL == pSigStrData)
     {
         RIL_LOG_CRITICAL("CTE_XMM7160::ParseSignalStrength() -"
@@ -194,12 +195,24 @@ RIL_RESULT_CODE CTE_XMM7160::ParseSignalStrength(RESPONSE_DATA& rRspData)
         goto Error;
     }
 
+    if (!ParseXCESQ(pszRsp, FALSE, *pSigStrData))
+    {
+        RIL_LOG_CRITICAL("CTE_XMM7160::ParseSignalStrength() - parsing failed\r\n");
+        goto Error;
+    }
+
     rRspData.pData   = (void*)pSigStrData;
     rRspData.uiDataSize  = sizeof(RIL_SignalStrength_v6);
 
     res = RRIL_RESULT_OK;
 
 Error:
+    if (RRIL_RESULT_OK != res)
+    {
+        free(pSigStrData);
+        pSigStrData = NULL;
+    }
+
     RIL_LOG_VERBOSE("CTE_XMM7160::ParseSignalStrength() - Exit\r\n");
     return res;
 }
@@ -1306,7 +1319,8 @@ Error:
     return res;
 }
 
-RIL_SignalStrength_v6* CTE_XMM7160::ParseXCESQ(const char*& rszPointer, const BOOL bUnsolicited)
+BOOL CTE_XMM7160::ParseXCESQ(const char*& rszPointer, const BOOL bUnsolicited,
+        RIL_SignalStrength_v6& rSigStrData)
 {
     RIL_LOG_VERBOSE("CTE_XMM7160::ParseXCESQ() - Enter\r\n");
     RIL_RESULT_CODE res = RRIL_RESULT_ERROR;
@@ -1320,7 +1334,6 @@ RIL_SignalStrength_v6* CTE_XMM7160::ParseXCESQ(const char*& rszPointer, const BO
     int rsrq = 0; // Reference signal received quality
     int rsrp = 0; // Reference signal received power
     int rssnr = -1; // Radio signal strength Noise Ratio value
-    RIL_SignalStrength_v6* pSigStrData = NULL;
 
     if (!bUnsolicited)
     {
@@ -1407,27 +1420,19 @@ RIL_SignalStrength_v6* CTE_XMM7160::ParseXCESQ(const char*& rszPointer, const BO
         }
     }
 
-    pSigStrData = (RIL_SignalStrength_v6*)malloc(sizeof(RIL_SignalStrength_v6));
-    if (NULL == pSigStrData)
-    {
-        RIL_LOG_CRITICAL("CTE_XMM7160::ParseXCESQ() -"
-                " Could not allocate memory for RIL_SignalStrength_v6.\r\n");
-        goto Error;
-    }
-
     // reset to default values
-    pSigStrData->GW_SignalStrength.signalStrength = -1;
-    pSigStrData->GW_SignalStrength.bitErrorRate   = -1;
-    pSigStrData->CDMA_SignalStrength.dbm = -1;
-    pSigStrData->CDMA_SignalStrength.ecio = -1;
-    pSigStrData->EVDO_SignalStrength.dbm = -1;
-    pSigStrData->EVDO_SignalStrength.ecio = -1;
-    pSigStrData->EVDO_SignalStrength.signalNoiseRatio = -1;
-    pSigStrData->LTE_SignalStrength.signalStrength = -1;
-    pSigStrData->LTE_SignalStrength.rsrp = INT_MAX;
-    pSigStrData->LTE_SignalStrength.rsrq = INT_MAX;
-    pSigStrData->LTE_SignalStrength.rssnr = INT_MAX;
-    pSigStrData->LTE_SignalStrength.cqi = INT_MAX;
+    rSigStrData.GW_SignalStrength.signalStrength = -1;
+    rSigStrData.GW_SignalStrength.bitErrorRate   = -1;
+    rSigStrData.CDMA_SignalStrength.dbm = -1;
+    rSigStrData.CDMA_SignalStrength.ecio = -1;
+    rSigStrData.EVDO_SignalStrength.dbm = -1;
+    rSigStrData.EVDO_SignalStrength.ecio = -1;
+    rSigStrData.EVDO_SignalStrength.signalNoiseRatio = -1;
+    rSigStrData.LTE_SignalStrength.signalStrength = -1;
+    rSigStrData.LTE_SignalStrength.rsrp = INT_MAX;
+    rSigStrData.LTE_SignalStrength.rsrq = INT_MAX;
+    rSigStrData.LTE_SignalStrength.rssnr = INT_MAX;
+    rSigStrData.LTE_SignalStrength.cqi = INT_MAX;
 
     /*
      * If the current serving cell is GERAN cell, then <rxlev> and <ber> are set to
@@ -1463,8 +1468,8 @@ RIL_SignalStrength_v6* CTE_XMM7160::ParseXCESQ(const char*& rszPointer, const BO
             rxlev = 31;
         }
 
-        pSigStrData->GW_SignalStrength.signalStrength = rxlev;
-        pSigStrData->GW_SignalStrength.bitErrorRate   = ber;
+        rSigStrData.GW_SignalStrength.signalStrength = rxlev;
+        rSigStrData.GW_SignalStrength.bitErrorRate   = ber;
     }
     else if (255 != rscp)
     {
@@ -1485,7 +1490,7 @@ RIL_SignalStrength_v6* CTE_XMM7160::ParseXCESQ(const char*& rszPointer, const BO
             rscp = 31;
         }
 
-        pSigStrData->GW_SignalStrength.signalStrength = rscp;
+        rSigStrData.GW_SignalStrength.signalStrength = rscp;
     }
     else if (255 != rsrq && 255 != rsrp)
     {
@@ -1506,26 +1511,20 @@ RIL_SignalStrength_v6* CTE_XMM7160::ParseXCESQ(const char*& rszPointer, const BO
          * You can refer to the latest CAT specification on XCESQI AT command
          * to understand where these numbers come from
          */
-        pSigStrData->LTE_SignalStrength.rsrp = 140 - rsrp;
-        pSigStrData->LTE_SignalStrength.rsrq = 20 - rsrq / 2;
-        pSigStrData->LTE_SignalStrength.rssnr = rssnr * 5;
+        rSigStrData.LTE_SignalStrength.rsrp = 140 - rsrp;
+        rSigStrData.LTE_SignalStrength.rsrq = 20 - rsrq / 2;
+        rSigStrData.LTE_SignalStrength.rssnr = rssnr * 5;
     }
     else
     {
         RIL_LOG_INFO("CTE_XMM7160::ParseXCESQ - "
-                "pSigStrData set to default values\r\n");
+                "signal strength set to default values\r\n");
     }
 
     res = RRIL_RESULT_OK;
 Error:
-    if (RRIL_RESULT_OK != res)
-    {
-        free(pSigStrData);
-        pSigStrData = NULL;
-    }
-
     RIL_LOG_VERBOSE("CTE_XMM7160::ParseXCESQ - Exit()\r\n");
-    return pSigStrData;
+    return (RRIL_RESULT_OK == res);
 }
 
 void CTE_XMM7160::QuerySignalStrength()
@@ -1557,11 +1556,10 @@ RIL_RESULT_CODE CTE_XMM7160::ParseUnsolicitedSignalStrength(RESPONSE_DATA& rRspD
     RIL_LOG_VERBOSE("CTE_XMM7160::ParseUnsolicitedSignalStrength() - Enter\r\n");
 
     RIL_RESULT_CODE res = RRIL_RESULT_ERROR;
-    RIL_SignalStrength_v6* pSigStrData = NULL;
+    RIL_SignalStrength_v6 sigStrData;
     const char* pszRsp = rRspData.szResponse;
 
-    pSigStrData = ParseXCESQ(pszRsp, FALSE);
-    if (NULL == pSigStrData)
+    if (!ParseXCESQ(pszRsp, FALSE, sigStrData))
     {
         RIL_LOG_CRITICAL("CTE_XMM7160::ParseUnsolicitedSignalStrength() -"
                 " parsing failed\r\n");
@@ -1570,13 +1568,10 @@ RIL_RESULT_CODE CTE_XMM7160::ParseUnsolicitedSignalStrength(RESPONSE_DATA& rRspD
 
     res = RRIL_RESULT_OK;
 
-    RIL_onUnsolicitedResponse(RIL_UNSOL_SIGNAL_STRENGTH, (void*)pSigStrData,
-            sizeof(RIL_SignalStrength_v6));
+    // queried to refresh the framework, reported whatever the last report was
+    CSignalStrengthFilter::OnSignalStrength(sigStrData, TRUE);
 
 Error:
-    free(pSigStrData);
-    pSigStrData = NULL;
-
     RIL_LOG_VERBOSE("CTE_XMM7160::ParseUnsolicitedSignalStrength() - Exit\r\n");
     return res;
 }
@@ -134,7 +134,8 @@ public:
 
     virtual const char* GetSignalStrengthReportingString();
 
-    virtual RIL_SignalStrength_v6* ParseXCESQ(const char*& rszPointer, const BOOL bUnsolicited);
+    virtual BOOL ParseXCESQ(const char*& rszPointer, const BOOL bUnsolicited,
+            RIL_SignalStrength_v6& rSigStrData);
 
     virtual const char* GetReadCellInfoString();
 
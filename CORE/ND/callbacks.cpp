@@ -19,6 +19,8 @@
 #include "util.h"
 #include "oemhookids.h"
 #include "channel_data.h"
+#include "latency_stats.h"
+#include "timer_wheel.h"
 
 void notifyChangedCallState(void* param)
 {
@@ -492,3 +494,23 @@ void triggerQueryUiccInfo(void* /*param*/)
 {
     CTE::GetTE().QueryUiccInfo();
 }
+
+void triggerLatencyStatsDump(void* /*param*/)
+{
+    UINT32 uiInterval = CLatencyStats::GetDumpInterval();
+
+    CLatencyStats::Dump();
+    CTimerWheel::Dump();
+
+    if (0 != uiInterval)
+    {
+        RIL_requestTimedCallback(triggerLatencyStatsDump, NULL, uiInterval, 0);
+    }
+}
+
+void triggerCloseIdleSmsLink(void* param)
+{
+    UINT32 uiGeneration = (UINT32)param;
+
+    CTE::GetTE().CloseIdleSmsLink(uiGeneration);
+}
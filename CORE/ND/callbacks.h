@@ -103,4 +103,14 @@ void triggerCellBroadcastActivation(void* param);
 //
 void triggerQueryUiccInfo(void* param);
 
+//
+// Callback to write the command latency statistics to the log periodically
+//
+void triggerLatencyStatsDump(void* param);
+
+//
+// Callback to close the SMS relay link when no segment followed the last one sent
+//
+void triggerCloseIdleSmsLink(void* param);
+
 #endif
@@ -11,6 +11,8 @@
 //
 /////////////////////////////////////////////////////////////////////////////
 
+#include <string.h>
+
 #include "cellInfo_cache.h"
 #include "util.h"
 #include "rillog.h"
@@ -91,8 +93,10 @@ BOOL operator==(const RIL_CellInfo& first, const RIL_CellInfo& second)
 
 CellInfoCache::CellInfoCache()
 {
-    memset(&m_sCellInfo, 0, sizeof(S_ND_N_CELL_INFO_DATA));
-    m_iCacheSize = 0;
+    memset(m_rgSnapshots, 0, sizeof(m_rgSnapshots));
+    memset(m_rgSnapshots[0].rgiSlots, -1, sizeof(m_rgSnapshots[0].rgiSlots));
+    memset(m_rgSnapshots[1].rgiSlots, -1, sizeof(m_rgSnapshots[1].rgiSlots));
+    m_pCurrent = &m_rgSnapshots[0];
     m_pCacheLock = new CMutex();
 }
 
@@ -103,78 +107,230 @@ CellInfoCache::~CellInfoCache()
 
 BOOL CellInfoCache::getCellInfo(P_ND_N_CELL_INFO_DATA pRetData, UINT32& uiItemCount)
 {
+    SNAPSHOT* pSnapshot;
+    UINT32 uiSequence;
+
     if (pRetData == NULL)
         return FALSE;
-    // loop through the cache and copy the info to the pRetData
-    CMutex::Lock(m_pCacheLock);
-    uiItemCount = m_iCacheSize;
-    for (INT32 i = 0; i < m_iCacheSize; i++)
+
+    do
     {
-        pRetData->pnCellData[i] = m_sCellInfo.pnCellData[i];
-    }
-    CMutex::Unlock(m_pCacheLock);
+        pSnapshot = m_pCurrent;
+        uiSequence = pSnapshot->uiSequence;
+        __sync_synchronize();
+
+        uiItemCount = pSnapshot->iCount;
+        memcpy(pRetData->pnCellData, pSnapshot->rgCells, uiItemCount * sizeof(RIL_CellInfo));
+
+        __sync_synchronize();
+    } while ((uiSequence & 1) || uiSequence != pSnapshot->uiSequence);
+
     return TRUE;
 }
 
-INT32 CellInfoCache::checkCache(const RIL_CellInfo& pData)
+//
+// Hash of the fields identifying the cell, the signal strength is left out so that
+// a cell is found again when only its signal changed.
+//
+UINT32 CellInfoCache::GetIdentityHash(const RIL_CellInfo& rCell)
+{
+    UINT32 rguiKey[6];
+    UINT32 nKeys = 0;
+    UINT32 uiHash = 2166136261U;
+
+    rguiKey[nKeys++] = rCell.cellInfoType;
+    switch (rCell.cellInfoType)
+    {
+        case RIL_CELL_INFO_TYPE_GSM:
+        {
+            const RIL_CellIdentityGsm& rId = rCell.CellInfo.gsm.cellIdentityGsm;
+            rguiKey[nKeys++] = rId.mcc;
+            rguiKey[nKeys++] = rId.mnc;
+            rguiKey[nKeys++] = rId.lac;
+            rguiKey[nKeys++] = rId.cid;
+            break;
+        }
+        case RIL_CELL_INFO_TYPE_WCDMA:
+        {
+            const RIL_CellIdentityWcdma& rId = rCell.CellInfo.wcdma.cellIdentityWcdma;
+            rguiKey[nKeys++] = rId.mcc;
+            rguiKey[nKeys++] = rId.mnc;
+            rguiKey[nKeys++] = rId.lac;
+            rguiKey[nKeys++] = rId.cid;
+            rguiKey[nKeys++] = rId.psc;
+            break;
+        }
+        case RIL_CELL_INFO_TYPE_LTE:
+        {
+            const RIL_CellIdentityLte& rId = rCell.CellInfo.lte.cellIdentityLte;
+            rguiKey[nKeys++] = rId.mcc;
+            rguiKey[nKeys++] = rId.mnc;
+            rguiKey[nKeys++] = rId.ci;
+            rguiKey[nKeys++] = rId.pci;
+            rguiKey[nKeys++] = rId.tac;
+            break;
+        }
+        default:
+            break;
+    }
+
+    // FNV-1a over the 32 bit fields
+    for (UINT32 i = 0; i < nKeys; i++)
+    {
+        uiHash = (uiHash ^ rguiKey[i]) * 16777619U;
+    }
+    return uiHash;
+}
+
+BOOL CellInfoCache::IsSameCell(const RIL_CellInfo& rFirst, const RIL_CellInfo& rSecond)
+{
+    if (rFirst.cellInfoType != rSecond.cellInfoType)
+    {
+        return FALSE;
+    }
+
+    switch (rFirst.cellInfoType)
+    {
+        case RIL_CELL_INFO_TYPE_GSM:
+            return rFirst.CellInfo.gsm.cellIdentityGsm == rSecond.CellInfo.gsm.cellIdentityGsm;
+        case RIL_CELL_INFO_TYPE_WCDMA:
+            return rFirst.CellInfo.wcdma.cellIdentityWcdma
+                    == rSecond.CellInfo.wcdma.cellIdentityWcdma;
+        case RIL_CELL_INFO_TYPE_LTE:
+            return rFirst.CellInfo.lte.cellIdentityLte == rSecond.CellInfo.lte.cellIdentityLte;
+        default:
+            return FALSE;
+    }
+}
+
+INT32 CellInfoCache::findCell(const SNAPSHOT& rSnapshot, const RIL_CellInfo& rCell,
+        UINT32 uiHash)
 {
-    RIL_LOG_VERBOSE("CellInfoCache::checkCache() %d\r\n", m_iCacheSize);
-    for (INT32 i = 0; i < m_iCacheSize; i++)
+    // linear probing, the table is never more than half full
+    for (UINT32 uiSlot = uiHash & E_HASH_MASK; ; uiSlot = (uiSlot + 1) & E_HASH_MASK)
     {
-        if (pData == m_sCellInfo.pnCellData[i])
+        INT32 iIndex = rSnapshot.rgiSlots[uiSlot];
+
+        if (iIndex < 0)
+        {
+            return -1;
+        }
+
+        if (IsSameCell(rCell, rSnapshot.rgCells[iIndex]))
         {
-            RIL_LOG_VERBOSE("CellInfoCache::checkCache() - Found match at %d\r\n",i);
-            return i;
+            return iIndex;
         }
     }
-    return -1;
 }
 
+//
+// The new list is compared with the current snapshot in one pass: each new cell is
+// looked up by identity, the cells of the snapshot not found were removed. A list
+// received again in the same order is recognized without looking up the cells.
+//
 BOOL CellInfoCache::updateCache(const P_ND_N_CELL_INFO_DATA pData, const INT32 aItemsCount)
 {
+    SNAPSHOT* pCurrent;
+    SNAPSHOT* pNext;
+    UINT32 rguiHashes[RRIL_MAX_CELL_ID_COUNT];
+    BOOL rgbFound[RRIL_MAX_CELL_ID_COUNT];
+    INT32 iAdded = 0;
+    INT32 iChanged = 0;
+    INT32 iRemoved;
+    INT32 iFound = 0;
     BOOL ret = FALSE;
 
     RIL_LOG_VERBOSE("CellInfoCache::updateCache() - aItemsCount %d \r\n",aItemsCount);
-    if (NULL == pData || aItemsCount > RRIL_MAX_CELL_ID_COUNT)
+    if (NULL == pData || aItemsCount < 0 || aItemsCount > RRIL_MAX_CELL_ID_COUNT)
     {
         RIL_LOG_INFO("CellInfoCache::updateCache() - Invalid data\r\n");
-        goto Error;
+        return FALSE;
+    }
+
+    // Access mutex, only updates take it
+    CMutex::Lock(m_pCacheLock);
+    pCurrent = m_pCurrent;
+
+    if (aItemsCount == pCurrent->iCount)
+    {
+        INT32 i = 0;
+
+        while (i < aItemsCount && pData->pnCellData[i] == pCurrent->rgCells[i])
+        {
+            i++;
+        }
+
+        if (i == aItemsCount)
+        {
+            RIL_LOG_VERBOSE("CellInfoCache::updateCache() - Unchanged\r\n");
+            goto Done;
+        }
     }
-    else
+
+    memset(rgbFound, 0, sizeof(rgbFound));
+    for (INT32 i = 0; i < aItemsCount; i++)
     {
-        // if there were more items in the cache before
-        if (aItemsCount != m_iCacheSize)
+        INT32 iIndex;
+
+        rguiHashes[i] = GetIdentityHash(pData->pnCellData[i]);
+        iIndex = findCell(*pCurrent, pData->pnCellData[i], rguiHashes[i]);
+        if (iIndex < 0)
         {
-            ret = TRUE;
+            iAdded++;
         }
         else
         {
-            for (INT32 storeIndex= 0; storeIndex < aItemsCount; storeIndex++)
+            if (!rgbFound[iIndex])
             {
-                if (checkCache(pData->pnCellData[storeIndex]) < 0 ) // new item
-                {
-                    ret = TRUE;
-                    break;
-                }
+                rgbFound[iIndex] = TRUE;
+                iFound++;
+            }
+
+            if (!(pData->pnCellData[i] == pCurrent->rgCells[iIndex]))
+            {
+                iChanged++;
             }
         }
     }
+    iRemoved = pCurrent->iCount - iFound;
 
-    if (ret)
+    if (0 == iAdded && 0 == iChanged && 0 == iRemoved)
     {
-        RIL_LOG_INFO("CellInfoCache::updateCache() -"
-                "Updating cache with %d items\r\n", aItemsCount);
-        // Access mutex
-        CMutex::Lock(m_pCacheLock);
-        m_iCacheSize = aItemsCount;
-        memset(&m_sCellInfo, 0, sizeof(S_ND_N_CELL_INFO_DATA));
-        for (INT32 j = 0; j < m_iCacheSize; j++)
+        RIL_LOG_VERBOSE("CellInfoCache::updateCache() - Unchanged, reordered\r\n");
+        goto Done;
+    }
+
+    pNext = (pCurrent == &m_rgSnapshots[0]) ? &m_rgSnapshots[1] : &m_rgSnapshots[0];
+
+    pNext->uiSequence++;
+    __sync_synchronize();
+
+    pNext->iCount = aItemsCount;
+    pNext->uiGeneration = pCurrent->uiGeneration + 1;
+    memcpy(pNext->rgCells, pData->pnCellData, aItemsCount * sizeof(RIL_CellInfo));
+    memset(pNext->rgiSlots, -1, sizeof(pNext->rgiSlots));
+    for (INT32 i = 0; i < aItemsCount; i++)
+    {
+        UINT32 uiSlot = rguiHashes[i] & E_HASH_MASK;
+
+        while (pNext->rgiSlots[uiSlot] >= 0)
         {
-            m_sCellInfo.pnCellData[j] = pData->pnCellData[j];
+            uiSlot = (uiSlot + 1) & E_HASH_MASK;
         }
-        // release mutex
-        CMutex::Unlock(m_pCacheLock);
+        pNext->rgiSlots[uiSlot] = (INT8)i;
     }
-Error:
+
+    __sync_synchronize();
+    pNext->uiSequence++;
+    m_pCurrent = pNext;
+
+    RIL_LOG_INFO("CellInfoCache::updateCache() - Generation %u: %d items, %d added,"
+            " %d removed, %d changed\r\n", pNext->uiGeneration, aItemsCount, iAdded,
+            iRemoved, iChanged);
+    ret = TRUE;
+
+Done:
+    // release mutex
+    CMutex::Unlock(m_pCacheLock);
     return ret;
 }
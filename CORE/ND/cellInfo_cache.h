@@ -24,15 +24,42 @@ class CellInfoCache
 public:
     CellInfoCache();
     ~CellInfoCache();
+    // Returns TRUE if cells were added, removed or changed since the last update
     BOOL updateCache(const P_ND_N_CELL_INFO_DATA pData, const INT32 aItemsCount);
+    // Never blocks, even while the cache is being updated
     BOOL getCellInfo(P_ND_N_CELL_INFO_DATA pRetData, UINT32& uiItemCount);
-    bool IsCellInfoCacheEmpty() { return m_iCacheSize <= 0; }
+    bool IsCellInfoCacheEmpty() { return m_pCurrent->iCount <= 0; }
+    UINT32 GetGeneration() { return m_pCurrent->uiGeneration; }
 
 private:
-    INT32 checkCache(const RIL_CellInfo& pData);
-    S_ND_N_CELL_INFO_DATA m_sCellInfo;
-    INT32 m_iCacheSize;
-    CMutex* m_pCacheLock;
+    enum
+    {
+        // power of 2, at least twice RRIL_MAX_CELL_ID_COUNT
+        E_HASH_SLOTS = 128,
+        E_HASH_MASK = E_HASH_SLOTS - 1
+    };
+
+    /*
+     * The cache is updated by writing the snapshot not in use, then making it the
+     * current one. A reader copying a snapshot retries if it was written meanwhile,
+     * which takes a whole update to happen while it copies.
+     */
+    struct SNAPSHOT
+    {
+        volatile UINT32 uiSequence;     // odd while the snapshot is written
+        UINT32 uiGeneration;
+        INT32 iCount;
+        RIL_CellInfo rgCells[RRIL_MAX_CELL_ID_COUNT];
+        INT8 rgiSlots[E_HASH_SLOTS];    // index of the cell by identity, -1 if none
+    };
+
+    static UINT32 GetIdentityHash(const RIL_CellInfo& rCell);
+    static BOOL IsSameCell(const RIL_CellInfo& rFirst, const RIL_CellInfo& rSecond);
+    INT32 findCell(const SNAPSHOT& rSnapshot, const RIL_CellInfo& rCell, UINT32 uiHash);
+
+    SNAPSHOT m_rgSnapshots[2];
+    SNAPSHOT* volatile m_pCurrent;
+    CMutex* m_pCacheLock;               // serializes the updates
 };
 
 #endif
@@ -20,6 +20,7 @@
 #include "response.h"
 #include "cmdcontext.h"
 #include "reset.h"
+#include "latency_stats.h"
 #include "channel_nd.h"
 #include "te.h"
 #include "rril_OEM.h"
@@ -31,6 +32,7 @@
 
 CChannel::CChannel(UINT32 uiChannel)
 : CChannelBase(uiChannel),
+  m_iPipelinedResponses(0),
   m_pResponse(NULL)
 {
     RIL_LOG_VERBOSE("CChannel::CChannel() - Enter/Exit\r\n");
@@ -140,8 +142,6 @@ BOOL CChannel::SendCommand(CCommand*& rpCmd)
     CResponse*      pResponse = NULL;
     RIL_RESULT_CODE resCode = RRIL_E_UNKNOWN_ERROR;
     BOOL            bResult = FALSE;
-    PFN_TE_POSTCMDHANDLER postCmdHandler = NULL;
-    POST_CMD_HANDLER_DATA data;
 
     if (NULL == rpCmd)
     {
@@ -155,6 +155,11 @@ BOOL CChannel::SendCommand(CCommand*& rpCmd)
     RIL_LOG_VERBOSE("CChannel::SendCommand() - DEBUG: chnl=[%d] Executing command with ID="
             "[0x%x,%d]\r\n", m_uiRilChannel, rpCmd->GetRequestID(), rpCmd->GetRequestID());
 
+    if (rpCmd->IsPipelined() && 1 < CTE::GetTE().GetMaxPipelinedCommands())
+    {
+        return SendPipelinedCommands(rpCmd);
+    }
+
     if (NULL == rpCmd->GetATCmd1())
     {
         // noop operation
@@ -189,18 +194,13 @@ BOOL CChannel::SendCommand(CCommand*& rpCmd)
         pATCommand2 = (char*) rpCmd->GetATCmd2();
         UINT32 nCmd1Length = (NULL == pATCommand) ? 0 : strlen(pATCommand);
         UINT32 nCmd2Length = (NULL == pATCommand2) ? 0 : strlen(pATCommand2);
-        CRLFExpandedString cmd1(pATCommand, nCmd1Length);
-        CRLFExpandedString cmd2(pATCommand2, nCmd2Length);
-
-        // GetString will return a pointer to the actual command buffer or "NULL"
-        const char* pPrintStr = cmd1.GetString();
-        const char* pPrintCmd2Str = cmd2.GetString();
 
+        // %R prints "NULL" for a missing command
         if (CRilLog::IsFullLogBuild())
             RIL_LOG_INFO("CChannel::SendCommand() -"
                     " chnl=[%d] RILReqID=[%d] retries=[%d] Timeout=[%d]"
-                    " cmd1=[%s] cmd2=[%s]\r\n", m_uiRilChannel, rpCmd->GetRequestID(), numRetries,
-                    rpCmd->GetTimeout(), pPrintStr, pPrintCmd2Str);
+                    " cmd1=[%R] cmd2=[%R]\r\n", m_uiRilChannel, rpCmd->GetRequestID(), numRetries,
+                    rpCmd->GetTimeout(), pATCommand, nCmd1Length, pATCommand2, nCmd2Length);
         else
             RIL_LOG_INFO("CChannel::SendCommand() - chnl=[%d] RILReqID=[%d] retries=[%d]"
                     " Timeout=[%d]\r\n", m_uiRilChannel, rpCmd->GetRequestID(), numRetries,
@@ -225,6 +225,7 @@ BOOL CChannel::SendCommand(CCommand*& rpCmd)
             CMutex::Unlock(m_pResponseObjectAccessMutex);
 
             nCmd1Length = (NULL == pATCommand) ? 0 : strlen(pATCommand);
+            rpCmd->StampStage(E_CMD_STAGE_SENT);
             BOOL bSuccess = WriteToPort(pATCommand, nCmd1Length, uiBytesWritten);
             // write the command out to the com port
             if (!bSuccess)
@@ -232,7 +233,8 @@ BOOL CChannel::SendCommand(CCommand*& rpCmd)
                 // write() = -1, error.
                 if (CRilLog::IsFullLogBuild())
                     RIL_LOG_CRITICAL("CChannel::SendCommand() - write() = -1, chnl=[%d] Error"
-                            " writing command: %s\r\n", m_uiRilChannel, pPrintStr);
+                            " writing command: %R\r\n", m_uiRilChannel, pATCommand,
+                            nCmd1Length);
                 else
                     RIL_LOG_CRITICAL("CChannel::SendCommand() - write() = -1, chnl=[%d] Error"
                             " writing requestId: %d\r\n", m_uiRilChannel, rpCmd->GetRequestID());
@@ -244,7 +246,8 @@ BOOL CChannel::SendCommand(CCommand*& rpCmd)
             {
                 if (CRilLog::IsFullLogBuild())
                     RIL_LOG_CRITICAL("CChannel::SendCommand() - chnl=[%d] Only wrote [%d] chars of"
-                            " command to port: %s\r\n", m_uiRilChannel, uiBytesWritten, pPrintStr);
+                            " command to port: %R\r\n", m_uiRilChannel, uiBytesWritten,
+                            pATCommand, nCmd1Length);
                 else
                     RIL_LOG_CRITICAL("CChannel::SendCommand() - chnl=[%d] Only wrote [%d] chars of"
                             " command to port, RequestId=[%d]\r\n", m_uiRilChannel, uiBytesWritten,
@@ -261,7 +264,7 @@ BOOL CChannel::SendCommand(CCommand*& rpCmd)
             {
                 if (CRilLog::IsFullLogBuild())
                     RIL_LOG_CRITICAL("CChannel::SendCommand() - chnl=[%d] No response received to"
-                            " TX [%s]\r\n", m_uiRilChannel, pPrintStr);
+                            " TX [%R]\r\n", m_uiRilChannel, pATCommand, nCmd1Length);
                 else
                     RIL_LOG_CRITICAL("CChannel::SendCommand() - chnl=[%d] No response received for"
                             " requestId [%d]\r\n", m_uiRilChannel, rpCmd->GetRequestID());
@@ -271,6 +274,7 @@ BOOL CChannel::SendCommand(CCommand*& rpCmd)
             if (!pResponse->IsTimedOutFlag())
             {
                 //  Our response is complete!
+                rpCmd->StampStage(E_CMD_STAGE_RESPONDED);
                 break;
             }
             else if (resCode == RRIL_E_MODEM_RESET)
@@ -321,10 +325,262 @@ BOOL CChannel::SendCommand(CCommand*& rpCmd)
     {
         goto Error;
     }
+    rpCmd->StampStage(E_CMD_STAGE_PARSED);
 
     bResult = TRUE;
 
 Error:
+    CompleteCommand(rpCmd, pResponse);
+
+    if (!bResult)
+    {
+        RIL_LOG_CRITICAL("CChannel::SendCommand() Failed");
+    }
+
+    RIL_LOG_VERBOSE("CChannel::SendCommand() - Exit\r\n");
+    return bResult;
+}
+
+BOOL CChannel::IsPipelinedCommand(CCommand* pCmd)
+{
+    return pCmd->IsPipelined();
+}
+
+//
+// Send the given pipelined command along with the pipelined commands queued behind it,
+// back to back, then match the final responses to the commands in order.
+// Returns FALSE if a command could not be written to the port.
+//
+BOOL CChannel::SendPipelinedCommands(CCommand*& rpCmd)
+{
+    RIL_LOG_VERBOSE("CChannel::SendPipelinedCommands() - Enter\r\n");
+
+    CCommand*       rgpCmds[MAX_PIPELINED_COMMANDS];
+    CCommand*       pCmd = NULL;
+    CResponse*      pResponse = NULL;
+    UINT32          uiMaxCmds = CTE::GetTE().GetMaxPipelinedCommands();
+    UINT32          nCmds = 0;
+    UINT32          nSent = 0;
+    UINT32          nCmdsWritten = 0;
+    UINT32          i;
+    BOOL            bResult = TRUE;
+
+    if (uiMaxCmds > MAX_PIPELINED_COMMANDS)
+    {
+        uiMaxCmds = MAX_PIPELINED_COMMANDS;
+    }
+
+    rgpCmds[nCmds++] = rpCmd;
+    rpCmd = NULL;
+
+    // Any character received while an abortable command executes aborts it,
+    // such a command can only be the last one of a batch.
+    while (nCmds < uiMaxCmds
+            && !IsReqIDAbortable(rgpCmds[nCmds - 1]->GetRequestID())
+            && g_pTxQueue[m_uiRilChannel]->DequeueIf(pCmd, IsPipelinedCommand))
+    {
+        if (!CTE::GetTE().IsRequestAllowed(pCmd->GetRequestID(), pCmd->GetToken(),
+                pCmd->GetChannel(), pCmd->IsInitCommand(), pCmd->GetCallId()))
+        {
+            delete pCmd;
+            pCmd = NULL;
+            continue;
+        }
+
+        rgpCmds[nCmds++] = pCmd;
+        pCmd = NULL;
+    }
+
+    if (1 == nCmds)
+    {
+        // Nothing to pipeline it with
+        rpCmd = rgpCmds[0];
+        rpCmd->SetPipelined(FALSE);
+        return SendCommand(rpCmd);
+    }
+
+    RIL_LOG_INFO("CChannel::SendPipelinedCommands() - chnl=[%d] Sending [%u] commands\r\n",
+            m_uiRilChannel, nCmds);
+
+    CMutex::Lock(m_pResponseObjectAccessMutex);
+
+    // empty the queue before sending the commands
+    ClearCmdThreadBlockedOnRxQueue();
+    m_iPipelinedResponses = 0;
+    g_pRxQueue[m_uiRilChannel]->MakeEmpty();
+    if (NULL != m_pResponse)
+        m_pResponse->FreeData();
+
+    CMutex::Unlock(m_pResponseObjectAccessMutex);
+
+    nCmdsWritten = nCmds;
+    for (nSent = 0; nSent < nCmds; nSent++)
+    {
+        const char* pATCommand = rgpCmds[nSent]->GetATCmd1();
+        UINT32 nCmdLength = strlen(pATCommand);
+        UINT32 uiBytesWritten = 0;
+
+        if (CRilLog::IsFullLogBuild())
+            RIL_LOG_INFO("CChannel::SendPipelinedCommands() - chnl=[%d] RILReqID=[%d]"
+                    " Timeout=[%d] cmd=[%R]\r\n", m_uiRilChannel,
+                    rgpCmds[nSent]->GetRequestID(), rgpCmds[nSent]->GetTimeout(),
+                    pATCommand, nCmdLength);
+        else
+            RIL_LOG_INFO("CChannel::SendPipelinedCommands() - chnl=[%d] RILReqID=[%d]"
+                    " Timeout=[%d]\r\n", m_uiRilChannel, rgpCmds[nSent]->GetRequestID(),
+                    rgpCmds[nSent]->GetTimeout());
+
+        // Tell the response thread to queue one more final response
+        CMutex::Lock(m_pResponseObjectAccessMutex);
+        if (IsCmdThreadBlockedOnRxQueue())
+        {
+            m_iPipelinedResponses++;
+        }
+        else
+        {
+            SetCmdThreadBlockedOnRxQueue();
+        }
+        CMutex::Unlock(m_pResponseObjectAccessMutex);
+
+        rgpCmds[nSent]->StampStage(E_CMD_STAGE_SENT);
+        BOOL bSuccess = WriteToPort(pATCommand, nCmdLength, uiBytesWritten);
+        if (!bSuccess)
+        {
+            DO_REQUEST_CLEAN_UP(); // Reason saved in WriteToPort
+        }
+
+        if (!bSuccess || nCmdLength != uiBytesWritten)
+        {
+            RIL_LOG_CRITICAL("CChannel::SendPipelinedCommands() - chnl=[%d] Only wrote [%d]"
+                    " chars of requestId [%d], the rest is sent one by one\r\n",
+                    m_uiRilChannel, uiBytesWritten, rgpCmds[nSent]->GetRequestID());
+
+            // no response to expect for this one
+            CMutex::Lock(m_pResponseObjectAccessMutex);
+            if (m_iPipelinedResponses > 0)
+            {
+                m_iPipelinedResponses--;
+            }
+            else
+            {
+                ClearCmdThreadBlockedOnRxQueue();
+            }
+            CMutex::Unlock(m_pResponseObjectAccessMutex);
+
+            // part of it may have reached the modem, do not send it again
+            FailCommand(rgpCmds[nSent], FALSE);
+            nCmdsWritten = nSent;
+            nSent++;
+            bResult = FALSE;
+            break;
+        }
+    }
+
+    // Responses come back in the order the commands were written
+    for (i = 0; i < nCmdsWritten; i++)
+    {
+        pCmd = rgpCmds[i];
+        rgpCmds[i] = NULL;
+
+        (void) ReadQueue(pResponse, pCmd->GetTimeout());
+
+        if (NULL == pResponse)
+        {
+            RIL_LOG_CRITICAL("CChannel::SendPipelinedCommands() - chnl=[%d] No response received"
+                    " for requestId [%d]\r\n", m_uiRilChannel, pCmd->GetRequestID());
+            FailCommand(pCmd, TRUE);
+            break;
+        }
+
+        if (pResponse->IsTimedOutFlag())
+        {
+            RIL_LOG_CRITICAL("CChannel::SendPipelinedCommands() - ***** Command timed out"
+                    " chnl=[%d]! timeout=[%d]ms No response for requestId [%d] *****\r\n",
+                    m_uiRilChannel, pCmd->GetTimeout(), pCmd->GetRequestID());
+
+            // Later responses cannot be matched reliably any more
+            CMutex::Lock(m_pResponseObjectAccessMutex);
+            m_iPipelinedResponses = 0;
+            CMutex::Unlock(m_pResponseObjectAccessMutex);
+
+            (void) HandleTimeout(pCmd, pResponse, 1 /* Cmd Index */);
+            CompleteCommand(pCmd, pResponse);
+            break;
+        }
+
+        pCmd->StampStage(E_CMD_STAGE_RESPONDED);
+
+        if (ParseResponse(pCmd, pResponse))
+        {
+            pCmd->StampStage(E_CMD_STAGE_PARSED);
+        }
+
+        CompleteCommand(pCmd, pResponse);
+    }
+
+    CMutex::Lock(m_pResponseObjectAccessMutex);
+    ClearCmdThreadBlockedOnRxQueue();
+    m_iPipelinedResponses = 0;
+    CMutex::Unlock(m_pResponseObjectAccessMutex);
+
+    // The commands written after the one that failed may still be answered late. They are
+    // failed rather than sent again, so that such a response cannot be taken for the
+    // response to the copy sent again.
+    for (i = 0; i < nCmdsWritten; i++)
+    {
+        if (NULL != rgpCmds[i])
+        {
+            RIL_LOG_CRITICAL("CChannel::SendPipelinedCommands() - chnl=[%d] Failing requestId"
+                    " [%d] sent before the failure\r\n", m_uiRilChannel,
+                    rgpCmds[i]->GetRequestID());
+            FailCommand(rgpCmds[i], TRUE);
+        }
+    }
+
+    // Put back the commands never written at the front of the queue, in order, to be sent
+    // one by one
+    for (i = nSent; i < nCmds; i++)
+    {
+        rgpCmds[i]->SetPipelined(FALSE);
+        if (!g_pTxQueue[m_uiRilChannel]->Enqueue(rgpCmds[i], rgpCmds[i]->IsHighPriority(),
+                TRUE))
+        {
+            RIL_LOG_CRITICAL("CChannel::SendPipelinedCommands() - chnl=[%d] Unable to queue"
+                    " requestId [%d] again\r\n", m_uiRilChannel, rgpCmds[i]->GetRequestID());
+            FailCommand(rgpCmds[i], FALSE);
+        }
+        rgpCmds[i] = NULL;
+    }
+
+    RIL_LOG_VERBOSE("CChannel::SendPipelinedCommands() - Exit\r\n");
+    return bResult;
+}
+
+//
+// Complete a command that will not get its response with a generic failure
+//
+void CChannel::FailCommand(CCommand*& rpCmd, BOOL bTimedOut)
+{
+    CResponse* pResponse = new CResponse(this);
+
+    if (NULL != pResponse)
+    {
+        pResponse->SetResultCode(RIL_E_GENERIC_FAILURE);
+        pResponse->SetUnsolicitedFlag(FALSE);
+        pResponse->SetTimedOutFlag(bTimedOut);
+    }
+
+    CompleteCommand(rpCmd, pResponse);
+}
+
+//
+// Run the post command handler of a command, or complete its request, then free it
+//
+void CChannel::CompleteCommand(CCommand*& rpCmd, CResponse*& rpResponse)
+{
+    PFN_TE_POSTCMDHANDLER postCmdHandler = NULL;
+    POST_CMD_HANDLER_DATA data;
+
     postCmdHandler = rpCmd->GetPostCmdHandlerFcn();
     memset(&data, 0, sizeof(POST_CMD_HANDLER_DATA));
 
@@ -337,11 +593,11 @@ Error:
         data.requestId = rpCmd->GetRequestID();
         data.uiResultCode = RRIL_RESULT_OK;
 
-        if (NULL != pResponse)
+        if (NULL != rpResponse)
         {
-             data.uiErrorCode = pResponse->GetErrorCode();
-             data.uiResultCode = pResponse->GetResultCode();
-             pResponse->GetData(data.pData, data.uiDataSize);
+             data.uiErrorCode = rpResponse->GetErrorCode();
+             data.uiResultCode = rpResponse->GetResultCode();
+             rpResponse->GetData(data.pData, data.uiDataSize);
         }
 
         /*
@@ -360,11 +616,11 @@ Error:
         data.requestId = rpCmd->GetRequestID();
         data.uiResultCode = RRIL_RESULT_ERROR;
 
-        if (NULL != pResponse)
+        if (NULL != rpResponse)
         {
-             data.uiErrorCode = pResponse->GetErrorCode();
-             data.uiResultCode = pResponse->GetResultCode();
-             pResponse->GetData(data.pData, data.uiDataSize);
+             data.uiErrorCode = rpResponse->GetErrorCode();
+             data.uiResultCode = rpResponse->GetResultCode();
+             rpResponse->GetData(data.pData, data.uiDataSize);
         }
 
         /*
@@ -374,19 +630,15 @@ Error:
         CTE::GetTE().PostCmdHandlerCompleteRequest(data);
     }
 
-    if (!bResult)
-    {
-        RIL_LOG_CRITICAL("CChannel::SendCommand() Failed");
-    }
+    rpCmd->StampStage(E_CMD_STAGE_COMPLETED);
+    CLatencyStats::Record(rpCmd, m_uiRilChannel);
 
     delete rpCmd;
     rpCmd = NULL;
 
-    delete pResponse;
-    pResponse = NULL;
+    delete rpResponse;
+    rpResponse = NULL;
 
-    RIL_LOG_VERBOSE("CChannel::SendCommand() - Exit\r\n");
-    return bResult;
 }
 
 //
@@ -467,15 +719,13 @@ RIL_RESULT_CODE CChannel::GetResponse(CCommand*& rpCmd, CResponse*& rpResponse)
         SetCmdThreadBlockedOnRxQueue();
 
         UINT32 cmdStrLen = (NULL == pATCommand) ? 0 : strlen(pATCommand);
-        CRLFExpandedString cmd(pATCommand, cmdStrLen);
-        const char* pPrintStr = cmd.GetString();
 
         BOOL bSuccess = WriteToPort(pATCommand, cmdStrLen, uiBytesWritten);
         if (!bSuccess)
         {
             if (CRilLog::IsFullLogBuild())
                 RIL_LOG_CRITICAL("CChannel::GetResponse() - chnl=[%d] Error sending 2nd command:"
-                        " %s\r\n", m_uiRilChannel, pPrintStr);
+                        " %R\r\n", m_uiRilChannel, pATCommand, cmdStrLen);
             else
                 RIL_LOG_CRITICAL("CChannel::GetResponse() - chnl=[%d] Error sending 2nd command"
                         " with request ID=[%d]\r\n", m_uiRilChannel, rpCmd->GetRequestID());
@@ -487,7 +737,8 @@ RIL_RESULT_CODE CChannel::GetResponse(CCommand*& rpCmd, CResponse*& rpResponse)
         {
             if (CRilLog::IsFullLogBuild())
                 RIL_LOG_CRITICAL("CChannel::GetResponse() - chnl=[%d] Could only write [%d] chars"
-                        " of 2nd command: %s\r\n", m_uiRilChannel, uiBytesWritten, pPrintStr);
+                        " of 2nd command: %R\r\n", m_uiRilChannel, uiBytesWritten,
+                        pATCommand, cmdStrLen);
             else
                 RIL_LOG_CRITICAL("CChannel::GetResponse() - chnl=[%d] Could only write [%d] chars"
                         " of 2nd command RequestID=[%d]\r\n",
@@ -503,8 +754,8 @@ RIL_RESULT_CODE CChannel::GetResponse(CCommand*& rpCmd, CResponse*& rpResponse)
         {
             if (CRilLog::IsFullLogBuild())
                 RIL_LOG_CRITICAL("CChannel::GetResponse() - ***** Command2 timed out chnl=[%d] !"
-                        " timeout=[%d]ms No response to TX [%s] *****\r\n",
-                        m_uiRilChannel, rpCmd->GetTimeout(), pPrintStr);
+                        " timeout=[%d]ms No response to TX [%R] *****\r\n",
+                        m_uiRilChannel, rpCmd->GetTimeout(), pATCommand, cmdStrLen);
             else
                 RIL_LOG_CRITICAL("CChannel::GetResponse() - ***** Command2 timed out chnl=[%d] !"
                         " timeout=[%d]ms No response to requestID [%d] *****\r\n",
@@ -829,9 +1080,8 @@ BOOL CChannel::ProcessModemData(char* szRxBytes, UINT32 uiRxBytesSize)
         goto Error;
     }
 
-    RIL_LOG_INFO("CChannel::ProcessModemData() - INFO: chnl=[%d] size=[%d] RX [%s]\r\n",
-            m_uiRilChannel, uiRxBytesSize,
-            CRLFExpandedString(szRxBytes,uiRxBytesSize).GetString());
+    RIL_LOG_INFO("CChannel::ProcessModemData() - INFO: chnl=[%d] size=[%d] RX [%R]\r\n",
+            m_uiRilChannel, uiRxBytesSize, szRxBytes, uiRxBytesSize);
 
     CMutex::Lock(m_pResponseObjectAccessMutex);
 
@@ -848,14 +1098,17 @@ BOOL CChannel::ProcessModemData(char* szRxBytes, UINT32 uiRxBytesSize)
         }
     }
 
-    // append data to our response buffer
-    if (!m_pResponse->Append(szRxBytes, uiRxBytesSize))
+    // add data to the receive buffer; data read into its write window is not copied
+    if (!m_RxBuffer.Commit(szRxBytes, uiRxBytesSize))
     {
-        RIL_LOG_CRITICAL("CChannel::ProcessModemData() - chnl=[%d] Append failed\r\n",
+        RIL_LOG_CRITICAL("CChannel::ProcessModemData() - chnl=[%d] Commit failed\r\n",
                 m_uiRilChannel);
         goto Error;
     }
 
+    // the pending response covers everything not framed yet
+    m_pResponse->SetView(m_RxBuffer.Data(), m_RxBuffer.Size());
+
     if (m_bTimeoutWaitingForResponse)
     {
         m_pResponse->SetCorruptFlag(TRUE);
@@ -865,8 +1118,8 @@ BOOL CChannel::ProcessModemData(char* szRxBytes, UINT32 uiRxBytesSize)
     // process the data received thus far
     while (m_pResponse->IsCompleteResponse())
     {
-        // yes; transfer data to a new buffer; this leaves data in the member variable
-        //  buffer if we have more than a complete response
+        // yes; split off the complete response; this leaves a view of the remainder
+        //  in the member variable if we have more than a complete response
         CResponse* pResponse = NULL;
         if (!CResponse::TransferData(m_pResponse, pResponse))
         {
@@ -875,6 +1128,9 @@ BOOL CChannel::ProcessModemData(char* szRxBytes, UINT32 uiRxBytesSize)
             goto Error;
         }
 
+        // both views stay valid until the next read into the receive buffer
+        m_RxBuffer.Consume(pResponse->Size());
+
         // process the response
         if (!ProcessResponse(pResponse))
         {
@@ -904,15 +1160,15 @@ BOOL CChannel::ProcessResponse(CResponse*& rpResponse)
 
     if (rpResponse->IsIgnoreFlag())
     {
-        RIL_LOG_INFO("CChannel::ProcessResponse : chnl=[%u] Ignoring %s\r\n", m_uiRilChannel,
-                CRLFExpandedString(rpResponse->Data(), rpResponse->Size()).GetString());
+        RIL_LOG_INFO("CChannel::ProcessResponse : chnl=[%u] Ignoring %R\r\n", m_uiRilChannel,
+                rpResponse->Data(), rpResponse->Size());
     }
     else if (rpResponse->IsUnrecognizedFlag())
     {
         // garbage in buffer, discard
         RIL_LOG_INFO("CChannel::ProcessResponse : chnl=[%d] Unidentified response, size [%d]"
-                       "  %s\r\n", m_uiRilChannel, rpResponse->Size(),
-                       CRLFExpandedString(rpResponse->Data(), rpResponse->Size()).GetString());
+                       "  %R\r\n", m_uiRilChannel, rpResponse->Size(),
+                       rpResponse->Data(), rpResponse->Size());
     }
     else if (rpResponse->IsUnsolicitedFlag())
     {
@@ -935,8 +1191,16 @@ BOOL CChannel::ProcessResponse(CResponse*& rpResponse)
         // command result
         if (IsCmdThreadBlockedOnRxQueue())
         {
-            // response expected, stop waiting for response and queue it
-            ClearCmdThreadBlockedOnRxQueue();
+            // response expected, queue it; stop waiting unless more pipelined
+            // commands are outstanding
+            if (m_iPipelinedResponses > 0)
+            {
+                m_iPipelinedResponses--;
+            }
+            else
+            {
+                ClearCmdThreadBlockedOnRxQueue();
+            }
 
             //  Make sure the command thread is listening for a response in proper state.
             //  Sometimes, the Rx Queue IsEmpty() is TRUE, but we enqueue and signal just before
@@ -949,6 +1213,14 @@ BOOL CChannel::ProcessResponse(CResponse*& rpResponse)
             //RIL_LOG_INFO("CChannel::ProcessResponse() - Enqueue response  resultcode=[%d]\r\n",
             //        rpResponse->GetResultCode() );
 
+            // The command thread parses the response after the next read,
+            // give it its own copy of the text
+            if (!rpResponse->Detach())
+            {
+                RIL_LOG_CRITICAL("CChannel::ProcessResponse() - Unable to copy response\r\n");
+                goto Error;
+            }
+
             // Queue the command response
             if (!g_pRxQueue[m_uiRilChannel]->Enqueue(rpResponse))
             {
@@ -958,6 +1230,8 @@ BOOL CChannel::ProcessResponse(CResponse*& rpResponse)
 
             // Queue has ownership of this now
             rpResponse = NULL;
+            CLatencyStats::SampleQueueDepth(m_uiRilChannel, CLatencyStats::E_QUEUE_RX,
+                    g_pRxQueue[m_uiRilChannel]->GetCount());
 
             // signal Tx thread
             //RIL_LOG_INFO("CChannel::ProcessResponse : Signal g_RxQueueEvent BEGIN\r\n");
@@ -969,8 +1243,8 @@ BOOL CChannel::ProcessResponse(CResponse*& rpResponse)
         else
         {
             RIL_LOG_INFO("CChannel::ProcessResponse : chnl=[%d] Non recognized response:"
-                    " [%d] %s\r\n", m_uiRilChannel, rpResponse->Size(),
-                    CRLFExpandedString(rpResponse->Data(), rpResponse->Size()).GetString());
+                    " [%d] %R\r\n", m_uiRilChannel, rpResponse->Size(),
+                    rpResponse->Data(), rpResponse->Size());
         }
     }
 
@@ -1067,8 +1341,15 @@ void CChannel::FlushResponse()
     void* pData = NULL;
     UINT32 uiDataSize = 0;
 
+    // the response thread frames in place, do not reset the buffer under it
+    CMutex::Lock(m_pResponseObjectAccessMutex);
+
+    // Flush any data not yet processed
+    m_RxBuffer.Flush();
+
     if (NULL == m_pResponse)
     {
+        CMutex::Unlock(m_pResponseObjectAccessMutex);
         return;
     }
 
@@ -1078,11 +1359,9 @@ void CChannel::FlushResponse()
     {
         m_pResponse->FreeData();
     }
-    // Flush any data not yet processed
-    if (m_pResponse->Data())
-    {
-        m_pResponse->Flush();
-    }
+    m_pResponse->ClearView();
+
+    CMutex::Unlock(m_pResponseObjectAccessMutex);
 }
 
 //
@@ -101,6 +101,20 @@ private:
     //  helper function to request modem restart due to command time-out
     void RequestCleanUpOnCommandTimeout(CCommand* rpCmd, UINT32 uiCmdIndex);
 
+    //  Pipelining of read-only queries (see REQ_INFO::bPipelined)
+    BOOL SendPipelinedCommands(CCommand*& rpCmd);
+    static BOOL IsPipelinedCommand(CCommand* pCmd);
+
+    //  Post command handling common to all send paths, frees the command and response
+    void CompleteCommand(CCommand*& rpCmd, CResponse*& rpRsp);
+    void FailCommand(CCommand*& rpCmd, BOOL bTimedOut);
+
+    static const UINT32 MAX_PIPELINED_COMMANDS = 8;
+
+    // Final responses the response thread still has to queue once the current
+    // one is queued, protected by m_pResponseObjectAccessMutex
+    int m_iPipelinedResponses;
+
 protected:
     CResponse* m_pResponse;
 };
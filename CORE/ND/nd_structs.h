@@ -357,4 +357,20 @@ typedef struct
     char szSrvccPairs[MAX_BUFFER_SIZE];
 } S_ND_SRVCC_RESPONSE_VALUE, *P_ND_SRVCC_RESPONSE_VALUE;
 
+//
+// Structs for retrieving the command latency statistics
+//
+const UINT32 MAX_LATENCY_STATS_SIZE = 8192;
+
+typedef struct
+{
+    char* pszLatencyStats;
+} S_ND_GET_LATENCY_STATS_PTR, *P_ND_GET_LATENCY_STATS_PTR;
+
+typedef struct
+{
+    S_ND_GET_LATENCY_STATS_PTR sResponsePointer;
+    char szLatencyStats[MAX_LATENCY_STATS_SIZE];
+} S_ND_GET_LATENCY_STATS, *P_ND_GET_LATENCY_STATS;
+
 #endif
@@ -23,6 +23,13 @@
 #include "repository.h"
 #include "rildmain.h"
 #include "reset.h"
+#include "callbacks.h"
+#include "latency_stats.h"
+#include "request_coalescer.h"
+#include "timer_wheel.h"
+#include "signal_filter.h"
+#include "sim_file_cache.h"
+#include "netlink_ifconfig.h"
 #include <cutils/properties.h>
 #include <utils/Log.h>
 
@@ -85,6 +92,9 @@ void RIL_onRequestComplete(RIL_Token tRIL, RIL_Errno eErrNo, void* pResponse, si
     gs_pRilEnv->OnRequestComplete(tRIL, eErrNo, pResponse, responseLen);
     RIL_LOG_INFO("After OnRequestComplete(): token=0x%08x, eErrNo=%d, pResponse=[0x%08x],"
             " len=[%d]\r\n", tRIL, eErrNo, pResponse, responseLen);
+
+    // identical requests attached to this one get the same response
+    CRequestCoalescer::OnRequestComplete(tRIL, eErrNo, pResponse, responseLen);
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -93,6 +103,9 @@ void RIL_onUnsolicitedResponse(int unsolResponseID, const void* pData, size_t da
 {
     bool bSendNotification = true;
 
+    // cached results this notification makes out of date are dropped
+    CRequestCoalescer::OnUnsolicitedResponse(unsolResponseID);
+
     if ((CTE::GetTE().IsPlatformShutDownRequested() || CTE::GetTE().IsRadioRequestPending())
             && RIL_UNSOL_RESPONSE_RADIO_STATE_CHANGED != unsolResponseID
             && RIL_UNSOL_RESPONSE_SIM_STATUS_CHANGED != unsolResponseID
@@ -469,6 +482,24 @@ void RIL_requestTimedCallback(RIL_TimedCallback callback, void* pParam,
     gs_pRilEnv->RequestTimedCallback(callback, pParam, &myTimeval);
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////////
+void RIL_requestTimerCallback(RIL_TimedCallback callback, void* pParam,
+                                           const unsigned long seconds,
+                                           const unsigned long microSeconds,
+                                           BOOL bCoalesce)
+{
+    RIL_LOG_VERBOSE("RIL_requestTimerCallback() sec=[%d]  usec=[%d]\r\n",
+            seconds, microSeconds);
+
+    // the framework gets those the wheel cannot take (not started yet or full)
+    if (TIMER_ID_INVALID == CTimerWheel::Schedule(callback, pParam,
+            seconds * 1000 + microSeconds / 1000, bCoalesce))
+    {
+        RIL_requestTimedCallback(callback, pParam, seconds, microSeconds);
+    }
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 /**
@@ -560,6 +591,42 @@ static void* mainLoop(void* param)
     // Initialize storage mechanism for error causes
     CModemRestart::Init();
 
+    // Initialize command latency statistics, losing them is not fatal
+    if (!CLatencyStats::Init())
+    {
+        RIL_LOG_CRITICAL("mainLoop() - CLatencyStats::Init() FAILED\r\n");
+    }
+
+    // Initialize coalescing of identical requests, requests go on their own without it
+    if (!CRequestCoalescer::Init())
+    {
+        RIL_LOG_CRITICAL("mainLoop() - CRequestCoalescer::Init() FAILED\r\n");
+    }
+
+    // Start the timer thread, timed callbacks are left to the framework without it
+    if (!CTimerWheel::Init())
+    {
+        RIL_LOG_CRITICAL("mainLoop() - CTimerWheel::Init() FAILED\r\n");
+    }
+
+    // Initialize filtering of signal strength notifications, all are reported without it
+    if (!CSignalStrengthFilter::Init())
+    {
+        RIL_LOG_CRITICAL("mainLoop() - CSignalStrengthFilter::Init() FAILED\r\n");
+    }
+
+    // Initialize the SIM file cache, all SIM IO requests go to the modem without it
+    if (!CSimFileCache::Init())
+    {
+        RIL_LOG_CRITICAL("mainLoop() - CSimFileCache::Init() FAILED\r\n");
+    }
+
+    // Initialize the configuration of the data interfaces, they stay down without it
+    if (!CNetlinkIfConfig::Init())
+    {
+        RIL_LOG_CRITICAL("mainLoop() - CNetlinkIfConfig::Init() FAILED\r\n");
+    }
+
     // Initialize helper thread that processes MMGR callbacks
     if (!CDeferThread::Init())
     {
@@ -580,6 +647,12 @@ static void* mainLoop(void* param)
 
     RIL_LOG_INFO("[RIL STATE] RIL INIT COMPLETED\r\n");
 
+    if (0 != CLatencyStats::GetDumpInterval())
+    {
+        RIL_requestTimedCallback(triggerLatencyStatsDump, NULL,
+                CLatencyStats::GetDumpInterval(), 0);
+    }
+
 Error:
     if (!dwRet)
     {
@@ -61,5 +61,17 @@ void RIL_requestTimedCallback(RIL_TimedCallback callback,
                                             const unsigned long seconds,
                                             const unsigned long microSeconds);
 
+// Same as above on the RIL timer thread. The callback is not serialized with onRequest
+// and the framework callbacks, it must only use state that is locked or already shared
+// with the channel threads.
+// With bCoalesce, the callback is not added again if it is already pending with the
+// same pParam, it then runs at the earlier of the two times. pParam must not be
+// allocated memory the callback frees.
+void RIL_requestTimerCallback(RIL_TimedCallback callback,
+                                            void* pParam,
+                                            const unsigned long seconds,
+                                            const unsigned long microSeconds,
+                                            BOOL bCoalesce = FALSE);
+
 
 #endif // RRIL_RILDMAIN_H
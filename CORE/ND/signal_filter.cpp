@@ -0,0 +1,281 @@
+////////////////////////////////////////////////////////////////////////////
+// signal_filter.cpp
+//
+// Copyright 2009 Intrinsyc Software International, Inc.  All rights reserved.
+// Patents pending in the United States of America and other jurisdictions.
+//
+//
+// Description:
+//    Implementation of the filtering of the signal strength notifications.
+//
+//    A value worth reporting but arriving too soon after the last report is
+//    held and reported by a timed callback when the minimum interval expires,
+//    unless a later value brought the signal back within the hysteresis.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "types.h"
+#include "rillog.h"
+#include "sync_ops.h"
+#include "util.h"
+#include "repository.h"
+#include "rildmain.h"
+#include "te.h"
+#include "signal_filter.h"
+
+// Default hysteresis, 0 reports every change
+static const int DEFAULT_HYSTERESIS_GW = 2;     // RSSI steps, 4 dBm
+static const int DEFAULT_HYSTERESIS_LTE = 3;    // dBm
+
+// Default minimum interval between two reports
+static const UINT32 DEFAULT_MIN_INTERVAL = 1000;  // ms
+
+CMutex* CSignalStrengthFilter::m_pLock = NULL;
+RIL_SignalStrength_v6 CSignalStrengthFilter::m_rgSigStrength[2];
+UINT32 CSignalStrengthFilter::m_uiReported = 0;
+UINT32 CSignalStrengthFilter::m_uiLatest = 0;
+BOOL CSignalStrengthFilter::m_bReportedValid = FALSE;
+BOOL CSignalStrengthFilter::m_bLatestValid = FALSE;
+BOOL CSignalStrengthFilter::m_bPending = FALSE;
+UINT32 CSignalStrengthFilter::m_uiLastReportTime = 0;
+int CSignalStrengthFilter::m_iHysteresisGW = DEFAULT_HYSTERESIS_GW;
+int CSignalStrengthFilter::m_iHysteresisLTE = DEFAULT_HYSTERESIS_LTE;
+UINT32 CSignalStrengthFilter::m_uiMinInterval = DEFAULT_MIN_INTERVAL;
+UINT32 CSignalStrengthFilter::m_uiReceived = 0;
+UINT32 CSignalStrengthFilter::m_uiReportedCount = 0;
+
+///////////////////////////////////////////////////////////////////////////////
+BOOL CSignalStrengthFilter::Init()
+{
+    CRepository repository;
+    int iTemp = 0;
+
+    if (NULL != m_pLock)
+    {
+        return TRUE;
+    }
+
+    if (repository.Read(g_szGroupRILSettings, g_szSignalHysteresisGW, iTemp) && iTemp >= 0)
+    {
+        m_iHysteresisGW = iTemp;
+    }
+
+    if (repository.Read(g_szGroupRILSettings, g_szSignalHysteresisLTE, iTemp) && iTemp >= 0)
+    {
+        m_iHysteresisLTE = iTemp;
+    }
+
+    if (repository.Read(g_szGroupRILSettings, g_szSignalMinInterval, iTemp) && iTemp >= 0)
+    {
+        m_uiMinInterval = (UINT32)iTemp;
+    }
+
+    memset(m_rgSigStrength, 0, sizeof(m_rgSigStrength));
+    m_uiReported = 0;
+    m_uiLatest = 0;
+    m_bReportedValid = FALSE;
+    m_bLatestValid = FALSE;
+    m_bPending = FALSE;
+
+    m_pLock = new CMutex();
+    if (NULL == m_pLock)
+    {
+        RIL_LOG_CRITICAL("CSignalStrengthFilter::Init() - Cannot allocate lock\r\n");
+        return FALSE;
+    }
+
+    RIL_LOG_INFO("CSignalStrengthFilter::Init() - Hysteresis GW [%d] LTE [%d],"
+            " min interval [%u] ms\r\n", m_iHysteresisGW, m_iHysteresisLTE, m_uiMinInterval);
+    return TRUE;
+}
+
+void CSignalStrengthFilter::Destroy()
+{
+    CMutex* pLock = m_pLock;
+
+    if (NULL == pLock)
+    {
+        return;
+    }
+
+    CMutex::Lock(pLock);
+    m_pLock = NULL;
+    RIL_LOG_INFO("CSignalStrengthFilter::Destroy() - [%u] received, [%u] reported\r\n",
+            m_uiReceived, m_uiReportedCount);
+    CMutex::Unlock(pLock);
+
+    delete pLock;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void CSignalStrengthFilter::OnSignalStrength(const RIL_SignalStrength_v6& rSigStrength,
+        BOOL bForce)
+{
+    UINT32 uiElapsed;
+
+    if (NULL == m_pLock)
+    {
+        RIL_onUnsolicitedResponse(RIL_UNSOL_SIGNAL_STRENGTH, (void*)&rSigStrength,
+                sizeof(RIL_SignalStrength_v6));
+        return;
+    }
+
+    CMutex::Lock(m_pLock);
+
+    m_uiReceived++;
+    m_uiLatest = 1 - m_uiReported;
+    memcpy(&m_rgSigStrength[m_uiLatest], &rSigStrength, sizeof(RIL_SignalStrength_v6));
+    m_bLatestValid = TRUE;
+
+    if (bForce)
+    {
+        Report();
+    }
+    else if (SCREEN_STATE_OFF == CTE::GetTE().GetScreenState())
+    {
+        // nobody is looking and the modem may stop notifying any time, the value is
+        // queried and reported again when the screen is turned on
+        m_bLatestValid = FALSE;
+        m_bPending = FALSE;
+    }
+    else if (!m_bReportedValid)
+    {
+        Report();
+    }
+    else if (!IsSignificant(m_rgSigStrength[m_uiReported], m_rgSigStrength[m_uiLatest]))
+    {
+        m_bPending = FALSE;
+    }
+    else
+    {
+        uiElapsed = GetMonotonicTickCount() - m_uiLastReportTime;
+        if (uiElapsed >= m_uiMinInterval)
+        {
+            Report();
+        }
+        else if (!m_bPending)
+        {
+            UINT32 uiDelay = m_uiMinInterval - uiElapsed;
+
+            // FlushCallback runs under m_pLock, it does not need the framework loop
+            m_bPending = TRUE;
+            RIL_requestTimerCallback(FlushCallback, NULL, uiDelay / 1000,
+                    (uiDelay % 1000) * 1000, TRUE);
+        }
+    }
+
+    CMutex::Unlock(m_pLock);
+}
+
+BOOL CSignalStrengthFilter::GetLatest(RIL_SignalStrength_v6& rSigStrength)
+{
+    BOOL bRet = FALSE;
+
+    if (NULL == m_pLock)
+    {
+        return FALSE;
+    }
+
+    CMutex::Lock(m_pLock);
+    if (m_bLatestValid)
+    {
+        memcpy(&rSigStrength, &m_rgSigStrength[m_uiLatest], sizeof(RIL_SignalStrength_v6));
+        bRet = TRUE;
+    }
+    CMutex::Unlock(m_pLock);
+
+    return bRet;
+}
+
+void CSignalStrengthFilter::Invalidate()
+{
+    if (NULL == m_pLock)
+    {
+        return;
+    }
+
+    CMutex::Lock(m_pLock);
+    m_bLatestValid = FALSE;
+    m_bPending = FALSE;
+    CMutex::Unlock(m_pLock);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+int CSignalStrengthFilter::GetRat(const RIL_SignalStrength_v6& rSigStrength)
+{
+    if (INT_MAX != rSigStrength.LTE_SignalStrength.rsrp)
+    {
+        return E_RAT_LTE;
+    }
+
+    if (rSigStrength.GW_SignalStrength.signalStrength >= 0
+            && rSigStrength.GW_SignalStrength.signalStrength <= 31)
+    {
+        return E_RAT_GW;
+    }
+
+    return E_RAT_NONE;
+}
+
+BOOL CSignalStrengthFilter::IsSignificant(const RIL_SignalStrength_v6& rReported,
+        const RIL_SignalStrength_v6& rLatest)
+{
+    int rat = GetRat(rLatest);
+
+    if (rat != GetRat(rReported))
+    {
+        return TRUE;
+    }
+
+    if (E_RAT_GW == rat && m_iHysteresisGW > 0)
+    {
+        return abs(rLatest.GW_SignalStrength.signalStrength
+                - rReported.GW_SignalStrength.signalStrength) >= m_iHysteresisGW;
+    }
+
+    if (E_RAT_LTE == rat && m_iHysteresisLTE > 0)
+    {
+        return abs(rLatest.LTE_SignalStrength.rsrp
+                - rReported.LTE_SignalStrength.rsrp) >= m_iHysteresisLTE;
+    }
+
+    return 0 != memcmp(&rReported, &rLatest, sizeof(RIL_SignalStrength_v6));
+}
+
+//
+// Called with the lock held. The framework copies the value before returning, the
+// reported buffer is not written until the next report swaps the buffers again.
+//
+void CSignalStrengthFilter::Report()
+{
+    m_uiReported = m_uiLatest;
+    m_bReportedValid = TRUE;
+    m_bPending = FALSE;
+    m_uiLastReportTime = GetMonotonicTickCount();
+    m_uiReportedCount++;
+
+    RIL_LOG_VERBOSE("CSignalStrengthFilter::Report() - [%u] received, [%u] reported\r\n",
+            m_uiReceived, m_uiReportedCount);
+
+    RIL_onUnsolicitedResponse(RIL_UNSOL_SIGNAL_STRENGTH,
+            (void*)&m_rgSigStrength[m_uiReported], sizeof(RIL_SignalStrength_v6));
+}
+
+void CSignalStrengthFilter::FlushCallback(void* /*pParam*/)
+{
+    if (NULL == m_pLock)
+    {
+        return;
+    }
+
+    CMutex::Lock(m_pLock);
+    if (m_bPending && SCREEN_STATE_OFF != CTE::GetTE().GetScreenState())
+    {
+        Report();
+    }
+    CMutex::Unlock(m_pLock);
+}
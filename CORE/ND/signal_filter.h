@@ -0,0 +1,78 @@
+////////////////////////////////////////////////////////////////////////////
+// signal_filter.h
+//
+// Copyright 2009 Intrinsyc Software International, Inc.  All rights reserved.
+// Patents pending in the United States of America and other jurisdictions.
+//
+//
+// Description:
+//    Filtering of the signal strength notifications. A notification is only
+//    reported to the framework if the signal moved by more than a per RAT
+//    hysteresis since the last report, no sooner than a minimum interval after
+//    it, and not while the screen is off. The latest value received is kept
+//    to answer RIL_REQUEST_SIGNAL_STRENGTH.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef RRIL_SIGNAL_FILTER_H
+#define RRIL_SIGNAL_FILTER_H
+
+#include "types.h"
+#include "rril.h"
+
+class CMutex;
+
+class CSignalStrengthFilter
+{
+public:
+    static BOOL Init();
+    static void Destroy();
+
+    // Called with each signal strength notification of the modem. With bForce, the
+    // value is reported straight away, as after the screen is turned on.
+    static void OnSignalStrength(const RIL_SignalStrength_v6& rSigStrength,
+            BOOL bForce = FALSE);
+
+    // Latest value received since the notifications were last enabled. Returns FALSE
+    // if there is none, the modem must then be queried.
+    static BOOL GetLatest(RIL_SignalStrength_v6& rSigStrength);
+
+    // Called when the modem stops sending the notifications (screen off, modem reset)
+    static void Invalidate();
+
+private:
+    enum
+    {
+        E_RAT_NONE,
+        E_RAT_GW,
+        E_RAT_LTE
+    };
+
+    static int GetRat(const RIL_SignalStrength_v6& rSigStrength);
+    static BOOL IsSignificant(const RIL_SignalStrength_v6& rReported,
+            const RIL_SignalStrength_v6& rLatest);
+    static void Report();
+    static void FlushCallback(void* pParam);
+
+    static CMutex* m_pLock;
+
+    // Double buffer: one value is the last reported, the other is written with the
+    // values received until one of them is reported. No copy is made to report it.
+    static RIL_SignalStrength_v6 m_rgSigStrength[2];
+    static UINT32 m_uiReported;         // index of the last reported value
+    static UINT32 m_uiLatest;           // index of the latest value received
+    static BOOL m_bReportedValid;       // FALSE until a value is reported
+    static BOOL m_bLatestValid;         // FALSE until a value is received
+    static BOOL m_bPending;             // latest value waits for the minimum interval
+    static UINT32 m_uiLastReportTime;
+
+    static int m_iHysteresisGW;         // in RSSI steps (2 dBm)
+    static int m_iHysteresisLTE;        // in dBm on the RSRP
+    static UINT32 m_uiMinInterval;      // ms
+
+    // counters
+    static UINT32 m_uiReceived;
+    static UINT32 m_uiReportedCount;
+};
+
+#endif // RRIL_SIGNAL_FILTER_H
@@ -31,6 +31,7 @@
 #include "te.h"
 #include "te_base.h"
 #include "oemhookids.h"
+#include "signal_filter.h"
 #if defined(M2_DUALSIM_FEATURE_ENABLED)
 #include "repository.h"
 #endif
@@ -140,8 +141,8 @@ BOOL CSilo_Network::ParseXNITZINFO(CResponse* const pResponse, const char*& rszP
     UINT32 uiFullNameLength = 0;
     char* pShortName = NULL;
     UINT32 uiShortNameLength = 0;
-    char* pUtf8FullName = NULL;
-    char* pUtf8ShortName = NULL;
+    char szUtf8FullName[MAX_BUFFER_SIZE] = {'\0'};
+    char szUtf8ShortName[MAX_BUFFER_SIZE] = {'\0'};
 
     UINT32 uiDst = 0;
     UINT32 uiHour, uiMins, uiSecs;
@@ -177,9 +178,8 @@ BOOL CSilo_Network::ParseXNITZINFO(CResponse* const pResponse, const char*& rszP
         goto Error;
     }
 
-    pUtf8FullName = ConvertUCS2ToUTF8(pFullName, uiFullNameLength - 1);
-    RIL_LOG_INFO("CSilo_Network::ParseXNITZINFO() - Long oper: \"%s\"\r\n",
-            pUtf8FullName ? pUtf8FullName : "NULL");
+    ConvertUCS2HexToUTF8(pFullName, uiFullNameLength - 1, szUtf8FullName, MAX_BUFFER_SIZE);
+    RIL_LOG_INFO("CSilo_Network::ParseXNITZINFO() - Long oper: \"%s\"\r\n", szUtf8FullName);
 
     //  Parse the "<Shortname>"
     if (!ExtractQuotedStringWithAllocatedMemory(rszPointer, pShortName, uiShortNameLength,
@@ -190,9 +190,8 @@ BOOL CSilo_Network::ParseXNITZINFO(CResponse* const pResponse, const char*& rszP
         goto Error;
     }
 
-    pUtf8ShortName = ConvertUCS2ToUTF8(pShortName, uiShortNameLength - 1);
-    RIL_LOG_INFO("CSilo_Network::ParseXNITZINFO() - Short oper: \"%s\"\r\n",
-            pUtf8ShortName ? pUtf8ShortName: "NULL");
+    ConvertUCS2HexToUTF8(pShortName, uiShortNameLength - 1, szUtf8ShortName, MAX_BUFFER_SIZE);
+    RIL_LOG_INFO("CSilo_Network::ParseXNITZINFO() - Short oper: \"%s\"\r\n", szUtf8ShortName);
 
     //  Parse the <tz>,
     if (!ExtractQuotedString(rszPointer, szTimeZone, TIME_ZONE_SIZE, rszPointer) ||
@@ -359,8 +358,7 @@ BOOL CSilo_Network::ParseXNITZINFO(CResponse* const pResponse, const char*& rszP
      * Completing RIL_UNSOL_RESPONSE_VOICE_NETWORK_STATE_CHANGED will result in
      * framework triggering the RIL_REQUEST_OPERATOR request.
      */
-    if ((NULL != pUtf8FullName && 0 < strlen(pUtf8FullName)) ||
-                                (NULL != pUtf8ShortName && 0 < strlen(pUtf8ShortName)))
+    if ('\0' != szUtf8FullName[0] || '\0' != szUtf8ShortName[0])
     {
         RIL_onUnsolicitedResponse(RIL_UNSOL_RESPONSE_VOICE_NETWORK_STATE_CHANGED, NULL, 0);
     }
@@ -373,12 +371,6 @@ Error:
         pszTimeData = NULL;
     }
 
-    delete[] pUtf8FullName;
-    pUtf8FullName = NULL;
-
-    delete[] pUtf8ShortName;
-    pUtf8ShortName = NULL;
-
     delete[] pFullName;
     pFullName = NULL;
 
@@ -1337,7 +1329,7 @@ BOOL CSilo_Network::ParseXCSQ(CResponse* const pResponse, const char*& rszPointe
     const char* pszStart = NULL;
     char szBackup[MAX_NETWORK_DATA_SIZE] = {0};
     UINT32 uiRSSI = 0, uiBER = 0;
-    RIL_SignalStrength_v6* pSigStrData = NULL;
+    RIL_SignalStrength_v6 sigStrData;
 
     if (NULL == pResponse)
     {
@@ -1347,14 +1339,7 @@ BOOL CSilo_Network::ParseXCSQ(CResponse* const pResponse, const char*& rszPointe
 
     pResponse->SetUnsolicitedFlag(TRUE);
 
-    pSigStrData = (RIL_SignalStrength_v6*)malloc(sizeof(RIL_SignalStrength_v6));
-    if (NULL == pSigStrData)
-    {
-        RIL_LOG_CRITICAL("CSilo_Network::ParseXCSQ() -"
-                " Could not allocate memory for RIL_SignalStrength_v6.\r\n");
-        goto Error;
-    }
-    memset(pSigStrData, 0x00, sizeof(RIL_SignalStrength_v6));
+    memset(&sigStrData, 0x00, sizeof(RIL_SignalStrength_v6));
 
     if (!FindAndSkipRspEnd(rszPointer, m_szNewLine, pszDummy))
     {
@@ -1383,36 +1368,26 @@ BOOL CSilo_Network::ParseXCSQ(CResponse* const pResponse, const char*& rszPointe
         goto Error;
     }
 
-    pSigStrData->GW_SignalStrength.signalStrength = (int) uiRSSI;
-    pSigStrData->GW_SignalStrength.bitErrorRate   = (int) uiBER;
+    sigStrData.GW_SignalStrength.signalStrength = (int) uiRSSI;
+    sigStrData.GW_SignalStrength.bitErrorRate   = (int) uiBER;
 
-    pSigStrData->CDMA_SignalStrength.dbm=-1;
-    pSigStrData->CDMA_SignalStrength.ecio=-1;
-    pSigStrData->EVDO_SignalStrength.dbm=-1;
-    pSigStrData->EVDO_SignalStrength.ecio=-1;
-    pSigStrData->EVDO_SignalStrength.signalNoiseRatio=-1;
-    pSigStrData->LTE_SignalStrength.signalStrength=-1;
-    pSigStrData->LTE_SignalStrength.rsrp=INT_MAX;
-    pSigStrData->LTE_SignalStrength.rsrq=INT_MAX;
-    pSigStrData->LTE_SignalStrength.rssnr=INT_MAX;
-    pSigStrData->LTE_SignalStrength.cqi=INT_MAX;
+    sigStrData.CDMA_SignalStrength.dbm=-1;
+    sigStrData.CDMA_SignalStrength.ecio=-1;
+    sigStrData.EVDO_SignalStrength.dbm=-1;
+    sigStrData.EVDO_SignalStrength.ecio=-1;
+    sigStrData.EVDO_SignalStrength.signalNoiseRatio=-1;
+    sigStrData.LTE_SignalStrength.signalStrength=-1;
+    sigStrData.LTE_SignalStrength.rsrp=INT_MAX;
+    sigStrData.LTE_SignalStrength.rsrq=INT_MAX;
+    sigStrData.LTE_SignalStrength.rssnr=INT_MAX;
+    sigStrData.LTE_SignalStrength.cqi=INT_MAX;
 
-    pResponse->SetResultCode(RIL_UNSOL_SIGNAL_STRENGTH);
-
-    if (!pResponse->SetData((void*)pSigStrData, sizeof(RIL_SignalStrength_v6), FALSE))
-    {
-        goto Error;
-    }
+    // reported to the framework by the filter, if worth it
+    CSignalStrengthFilter::OnSignalStrength(sigStrData);
 
     bRet = TRUE;
 
 Error:
-    if (!bRet)
-    {
-        free(pSigStrData);
-        pSigStrData = NULL;
-    }
-
     RIL_LOG_VERBOSE("CSilo_Network::ParseXCSQ() - Exit\r\n");
     return bRet;
 }
@@ -1427,7 +1402,7 @@ BOOL CSilo_Network::ParseXCESQI(CResponse* const pResponse, const char*& rszPoin
     const char* pszDummy = NULL;
     const char* pszStart = NULL;
     char szBackup[MAX_NETWORK_DATA_SIZE] = {0};
-    RIL_SignalStrength_v6* pSigStrData = NULL;
+    RIL_SignalStrength_v6 sigStrData;
 
     if (NULL == pResponse)
     {
@@ -1451,28 +1426,17 @@ BOOL CSilo_Network::ParseXCESQI(CResponse* const pResponse, const char*& rszPoin
             MAX_NETWORK_DATA_SIZE - strlen(szBackup), pszDummy);
     CTE::GetTE().SaveNetworkData(LAST_NETWORK_XCSQ, szBackup);
 
-    pSigStrData = CTE::GetTE().ParseXCESQ(rszPointer, TRUE);
-    if (NULL == pSigStrData)
+    if (!CTE::GetTE().ParseXCESQ(rszPointer, TRUE, sigStrData))
     {
-        RIL_LOG_CRITICAL("CSilo_Network::ParseXCESQI() -"
-                " Could not allocate memory for RIL_SignalStrength_v6.\r\n");
+        RIL_LOG_CRITICAL("CSilo_Network::ParseXCESQI() - Could not parse notification.\r\n");
         goto Error;
     }
 
-    if (!pResponse->SetData((void*)pSigStrData, sizeof(RIL_SignalStrength_v6), FALSE))
-    {
-        goto Error;
-    }
+    // reported to the framework by the filter, if worth it
+    CSignalStrengthFilter::OnSignalStrength(sigStrData);
 
-    pResponse->SetResultCode(RIL_UNSOL_SIGNAL_STRENGTH);
     bRet = TRUE;
 Error:
-    if (!bRet)
-    {
-        free(pSigStrData);
-        pSigStrData = NULL;
-    }
-
     RIL_LOG_VERBOSE("CSilo_Network::ParseXCESQI() - Exit\r\n");
     return bRet;
 }
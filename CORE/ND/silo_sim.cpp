@@ -26,6 +26,7 @@
 #include "te.h"
 #include "reset.h"
 #include "ccatprofile.h"
+#include "sim_file_cache.h"
 
 #include <cutils/properties.h>
 
@@ -358,6 +359,7 @@ void CSilo_SIM::ParsePduForRefresh(const char* pszPdu)
     char szRefreshType[3] = {0};
     RIL_SimRefreshResponse_v7* pSimRefreshResp = NULL;
     UINT32 uiPduLength = strlen(pszPdu);
+    BOOL bFileListFound = FALSE;
 
     //  Need to see if this is a SIM_REFRESH command.
     //  Check for "8103", jump next byte and verify if followed by "01".
@@ -409,6 +411,7 @@ void CSilo_SIM::ParsePduForRefresh(const char* pszPdu)
                         // See ril.h: aid : For SIM_INIT result this field is set to AID of
                         //      application that caused REFRESH
                         pSimRefreshResp->aid = NULL;
+                        CSimFileCache::InvalidateAll();
                     }
                     else if ( (0 == strncmp(szRefreshType, "04", 2)) ||
                               (0 == strncmp(szRefreshType, "05", 2)) ||
@@ -424,6 +427,7 @@ void CSilo_SIM::ParsePduForRefresh(const char* pszPdu)
                          * the SIM RESET procedure on the modem side. So, don't send
                          * the RIL_UNSOL_SIM_REFRESH for SIM_RESET refresh type.
                          */
+                        CSimFileCache::InvalidateAll();
                         goto event_notify;
                     }
                     else if ( (0 == strncmp(szRefreshType, "01", 2)) ||
@@ -459,6 +463,11 @@ void CSilo_SIM::ParsePduForRefresh(const char* pszPdu)
                                             szFileTagLength[0], szFileTagLength[1]);
                                     RIL_LOG_INFO("file tag length = %d\r\n", uiFileTagLength);
                                     uiPos += 2;  //  we read the tag length
+
+                                    //  Drop all the files of the list from the cache
+                                    CSimFileCache::InvalidateFileList(&pszPdu[uiPos],
+                                            uiFileTagLength);
+                                    bFileListFound = TRUE;
                                     uiPos += (uiFileTagLength * 2);
 
                                     if (uiPos <= uiPduLength)
@@ -485,6 +494,12 @@ void CSilo_SIM::ParsePduForRefresh(const char* pszPdu)
                                 }
                             }
                         }
+
+                        if (!bFileListFound)
+                        {
+                            //  Files that changed are unknown
+                            CSimFileCache::InvalidateAll();
+                        }
                     }
 
                     /*
@@ -606,6 +621,12 @@ BOOL CSilo_SIM::ParseXSIM(CResponse* const pResponse, const char*& rszPointer)
 
     CTE::GetTE().HandleSimState(uiSIMState, bNotifySimStatusChange);
 
+    // card removed, swapped, reset or blocked: none of its files can be trusted
+    if (CTE::GetTE().GetSimAppState() != oldAppState)
+    {
+        CSimFileCache::InvalidateAll();
+    }
+
     if (RIL_APPSTATE_UNKNOWN != CTE::GetTE().GetSimAppState()
             && RIL_APPSTATE_UNKNOWN == oldAppState)
     {
@@ -850,7 +850,6 @@ BOOL CSilo_Voice::ParseUSSDInfo(CResponse* const pResponse, const char*& rszPoin
             char* pUCS2String = pszDataString;
             UINT32 uiUCS2StrLength = uiDataStringLen;
             const UINT32 LANGUAGE_CODE_LENGTH = 4;
-            char* pUtf8Buffer = NULL;
 
             if (17 == uiDCS) // UCS2; message preceded by language indication
             {
@@ -864,23 +863,15 @@ BOOL CSilo_Voice::ParseUSSDInfo(CResponse* const pResponse, const char*& rszPoin
                      */
                     pUCS2String += LANGUAGE_CODE_LENGTH;
                     uiUCS2StrLength -= LANGUAGE_CODE_LENGTH;
-                    pUtf8Buffer = ConvertUCS2ToUTF8(pUCS2String,
-                                                            uiUCS2StrLength);
+                    ConvertUCS2HexToUTF8(pUCS2String, uiUCS2StrLength,
+                            pUssdStatus->szMessage, MAX_BUFFER_SIZE);
                 }
             }
             else
             {
-                pUtf8Buffer = ConvertUCS2ToUTF8(pUCS2String, uiUCS2StrLength);
+                ConvertUCS2HexToUTF8(pUCS2String, uiUCS2StrLength,
+                        pUssdStatus->szMessage, MAX_BUFFER_SIZE);
             }
-
-            /*
-             * CopyString done only when both pUssdStatus->szMessage and
-             * pUtf8Buffer are not null.
-             */
-            CopyStringNullTerminate(pUssdStatus->szMessage, pUtf8Buffer,
-                                                            MAX_BUFFER_SIZE);
-            delete[] pUtf8Buffer;
-            pUtf8Buffer = NULL;
         }
         else
         {
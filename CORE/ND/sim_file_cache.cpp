@@ -0,0 +1,517 @@
+////////////////////////////////////////////////////////////////////////////
+// sim_file_cache.cpp
+//
+// Copyright 2009 Intrinsyc Software International, Inc.  All rights reserved.
+// Patents pending in the United States of America and other jurisdictions.
+//
+//
+// Description:
+//    Implementation of the cache of the SIM elementary files.
+//
+//    Entries are kept in a fixed table, chained by hash bucket and evicted
+//    round robin once the table is full. Files the modem writes on its own
+//    (SMS, location, keys, call meters...) are never cached.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "types.h"
+#include "rillog.h"
+#include "sync_ops.h"
+#include "util.h"
+#include "repository.h"
+#include "sim_file_cache.h"
+
+// Status words of a successful command
+static const int SW1_OK = 0x90;
+static const int SW2_OK = 0x00;
+
+// P2 of an UPDATE RECORD in absolute mode
+static const int RECORD_MODE_ABSOLUTE = 4;
+
+// File ID of the MF, starting each path of a REFRESH file list
+static const int FILE_ID_MF = 0x3F00;
+
+// Files also written by the modem, outside of RIL_REQUEST_SIM_IO
+static const int g_rgiUncachedFiles[] =
+{
+    0x6F3C,     // EF_SMS, +CMGW, +CMGD and class 2 messages
+    0x6F43,     // EF_SMSS
+    0x6F47,     // EF_SMSR
+    0x6F7E,     // EF_LOCI
+    0x6F73,     // EF_PSLOCI
+    0x6FE3,     // EF_EPSLOCI
+    0x6FE4,     // EF_EPSNSC
+    0x6F20,     // EF_KC
+    0x4F20,     // EF_KC under DF_GSM
+    0x6F52,     // EF_KCGPRS
+    0x4F52,     // EF_KCGPRS under DF_GSM
+    0x6F08,     // EF_KEYS
+    0x6F09,     // EF_KEYSPS
+    0x6F5B,     // EF_START-HFN
+    0x6F5C,     // EF_THRESHOLD
+    0x6F7B,     // EF_FPLMN
+    0x6FC4,     // EF_NETPAR
+    0x6F39,     // EF_ACM
+    0x6F37,     // EF_ACMmax
+    0x6F41,     // EF_PUCT
+    0x6F44,     // EF_LND
+    0x6F80,     // EF_ICI
+    0x6F81,     // EF_OCI
+    0x6FCA,     // EF_MWIS
+    0x6F11,     // EF_VOICE_MAIL_INDICATOR_CPHS
+    0x6F13      // EF_CFF_CPHS
+};
+
+CMutex* CSimFileCache::m_pLock = NULL;
+CSimFileCache::ENTRY CSimFileCache::m_rgEntries[E_MAX_ENTRIES];
+int CSimFileCache::m_rgiBuckets[E_BUCKETS];
+UINT32 CSimFileCache::m_uiNextVictim = 0;
+UINT32 CSimFileCache::m_uiGeneration = 0;
+UINT32 CSimFileCache::m_uiHits = 0;
+UINT32 CSimFileCache::m_uiMisses = 0;
+
+///////////////////////////////////////////////////////////////////////////////
+BOOL CSimFileCache::Init()
+{
+    CRepository repository;
+    int iTemp = 1;
+
+    if (NULL != m_pLock)
+    {
+        return TRUE;
+    }
+
+    if (repository.Read(g_szGroupRILSettings, g_szSimFileCacheEnabled, iTemp) && 0 == iTemp)
+    {
+        RIL_LOG_INFO("CSimFileCache::Init() - Cache disabled\r\n");
+        return TRUE;
+    }
+
+    memset(m_rgEntries, 0, sizeof(m_rgEntries));
+    for (int i = 0; i < E_BUCKETS; i++)
+    {
+        m_rgiBuckets[i] = -1;
+    }
+    m_uiNextVictim = 0;
+
+    m_pLock = new CMutex();
+    if (NULL == m_pLock)
+    {
+        RIL_LOG_CRITICAL("CSimFileCache::Init() - Cannot allocate lock\r\n");
+        return FALSE;
+    }
+
+    RIL_LOG_INFO("CSimFileCache::Init() - [%d] entries\r\n", E_MAX_ENTRIES);
+    return TRUE;
+}
+
+void CSimFileCache::Destroy()
+{
+    CMutex* pLock = m_pLock;
+
+    if (NULL == pLock)
+    {
+        return;
+    }
+
+    CMutex::Lock(pLock);
+    m_pLock = NULL;
+    for (int i = 0; i < E_MAX_ENTRIES; i++)
+    {
+        if (m_rgEntries[i].bUsed)
+        {
+            FreeEntry(i);
+        }
+    }
+    RIL_LOG_INFO("CSimFileCache::Destroy() - [%u] hits, [%u] misses\r\n",
+            m_uiHits, m_uiMisses);
+    CMutex::Unlock(pLock);
+
+    delete pLock;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void CSimFileCache::PrepareRequest(const RIL_SIM_IO_v6& rSimIoArgs,
+        S_SIM_IO_CONTEXT_DATA& rContextData)
+{
+    const char* pszPath = (NULL == rSimIoArgs.path) ? "" : rSimIoArgs.path;
+    const char* pszAid = (NULL == rSimIoArgs.aidPtr) ? "" : rSimIoArgs.aidPtr;
+    BOOL bUpdate = (SIM_COMMAND_UPDATE_BINARY == rSimIoArgs.command
+            || SIM_COMMAND_UPDATE_RECORD == rSimIoArgs.command);
+
+    memset(&rContextData, 0, sizeof(S_SIM_IO_CONTEXT_DATA));
+    rContextData.command = rSimIoArgs.command;
+    rContextData.fileId = rSimIoArgs.fileid;
+    rContextData.p1 = rSimIoArgs.p1;
+    rContextData.p2 = rSimIoArgs.p2;
+    rContextData.p3 = rSimIoArgs.p3;
+
+    if (NULL == m_pLock)
+    {
+        return;
+    }
+
+    // an update changes the file even if its response never comes
+    if (bUpdate)
+    {
+        InvalidateFile(rSimIoArgs.fileid);
+    }
+
+    if ((!bUpdate && !IsCachedCommand(rSimIoArgs.command))
+            || !IsCachedFile(rSimIoArgs.fileid)
+            || strlen(pszPath) >= MAX_SIM_PATH_SIZE
+            || strlen(pszAid) >= MAX_AID_SIZE)
+    {
+        return;
+    }
+
+    if (bUpdate)
+    {
+        // only written through if the response to the read is known to be the data
+        if (NULL == rSimIoArgs.data || rSimIoArgs.p3 <= 0
+                || strlen(rSimIoArgs.data) != (size_t)rSimIoArgs.p3 * 2
+                || strlen(rSimIoArgs.data) >= MAX_SIM_IO_DATA_SIZE
+                || (SIM_COMMAND_UPDATE_RECORD == rSimIoArgs.command
+                        && RECORD_MODE_ABSOLUTE != rSimIoArgs.p2))
+        {
+            return;
+        }
+
+        for (size_t i = 0; '\0' != rSimIoArgs.data[i]; i++)
+        {
+            rContextData.szData[i] = toupper(rSimIoArgs.data[i]);
+        }
+    }
+
+    strncpy(rContextData.szPath, pszPath, MAX_SIM_PATH_SIZE - 1);
+    strncpy(rContextData.szAid, pszAid, MAX_AID_SIZE - 1);
+
+    CMutex::Lock(m_pLock);
+    rContextData.uiGeneration = m_uiGeneration;
+    CMutex::Unlock(m_pLock);
+
+    rContextData.bCached = TRUE;
+}
+
+RIL_SIM_IO_Response* CSimFileCache::Lookup(const S_SIM_IO_CONTEXT_DATA& rContextData,
+        UINT32& ruiResponseSize)
+{
+    RIL_SIM_IO_Response* pResponse = NULL;
+    UINT32 cbResponse = 0;
+    int iEntry;
+
+    if (NULL == m_pLock || !rContextData.bCached || !IsCachedCommand(rContextData.command))
+    {
+        return NULL;
+    }
+
+    CMutex::Lock(m_pLock);
+
+    iEntry = FindEntry(rContextData.command, rContextData,
+            GetHash(rContextData.command, rContextData));
+    if (iEntry < 0)
+    {
+        m_uiMisses++;
+        goto Done;
+    }
+
+    // same layout as the response of ParseSimIo(), the string follows the struct
+    if (NULL != m_rgEntries[iEntry].pszResponse)
+    {
+        cbResponse = strlen(m_rgEntries[iEntry].pszResponse) + 1;
+    }
+
+    pResponse = (RIL_SIM_IO_Response*)malloc(sizeof(RIL_SIM_IO_Response) + cbResponse);
+    if (NULL == pResponse)
+    {
+        RIL_LOG_CRITICAL("CSimFileCache::Lookup() - Cannot allocate response\r\n");
+        goto Done;
+    }
+
+    pResponse->sw1 = m_rgEntries[iEntry].sw1;
+    pResponse->sw2 = m_rgEntries[iEntry].sw2;
+    pResponse->simResponse = NULL;
+    if (0 != cbResponse)
+    {
+        pResponse->simResponse = (char*)(pResponse + 1);
+        memcpy(pResponse->simResponse, m_rgEntries[iEntry].pszResponse, cbResponse);
+    }
+
+    ruiResponseSize = sizeof(RIL_SIM_IO_Response);
+    m_uiHits++;
+
+    RIL_LOG_VERBOSE("CSimFileCache::Lookup() - Hit command=%d fileid=%04X p1=%d p2=%d p3=%d,"
+            " [%u] hits, [%u] misses\r\n", rContextData.command, rContextData.fileId,
+            rContextData.p1, rContextData.p2, rContextData.p3, m_uiHits, m_uiMisses);
+
+Done:
+    CMutex::Unlock(m_pLock);
+    return pResponse;
+}
+
+void CSimFileCache::OnResponse(const S_SIM_IO_CONTEXT_DATA& rContextData,
+        const RIL_SIM_IO_Response* pResponse)
+{
+    if (NULL == m_pLock || !rContextData.bCached || NULL == pResponse
+            || SW1_OK != pResponse->sw1 || SW2_OK != pResponse->sw2)
+    {
+        return;
+    }
+
+    CMutex::Lock(m_pLock);
+
+    // the file may have changed since the request was sent
+    if (rContextData.uiGeneration != m_uiGeneration)
+    {
+        goto Done;
+    }
+
+    switch (rContextData.command)
+    {
+        case SIM_COMMAND_UPDATE_BINARY:
+            Store(SIM_COMMAND_READ_BINARY, rContextData, pResponse->sw1, pResponse->sw2,
+                    rContextData.szData);
+            break;
+
+        case SIM_COMMAND_UPDATE_RECORD:
+            Store(SIM_COMMAND_READ_RECORD, rContextData, pResponse->sw1, pResponse->sw2,
+                    rContextData.szData);
+            break;
+
+        default:
+            if (NULL == pResponse->simResponse
+                    || strlen(pResponse->simResponse) < E_MAX_RESPONSE_LENGTH)
+            {
+                Store(rContextData.command, rContextData, pResponse->sw1, pResponse->sw2,
+                        pResponse->simResponse);
+            }
+            break;
+    }
+
+Done:
+    CMutex::Unlock(m_pLock);
+}
+
+void CSimFileCache::InvalidateFile(int fileId)
+{
+    if (NULL == m_pLock)
+    {
+        return;
+    }
+
+    CMutex::Lock(m_pLock);
+    DropFile(fileId);
+    m_uiGeneration++;
+    CMutex::Unlock(m_pLock);
+}
+
+void CSimFileCache::InvalidateFileList(const char* pszFileList, UINT32 uiLength)
+{
+    UINT32 uiFiles = 0;
+
+    if (NULL == m_pLock)
+    {
+        return;
+    }
+
+    // number of files then the full path of each file, an ID that is not the MF
+    // is either an EF or a DF, which has no cached record
+    if (NULL == pszFileList || uiLength < 1 || strlen(pszFileList) < uiLength * 2)
+    {
+        RIL_LOG_CRITICAL("CSimFileCache::InvalidateFileList() - Invalid file list\r\n");
+        InvalidateAll();
+        return;
+    }
+
+    CMutex::Lock(m_pLock);
+    for (UINT32 i = 2; i + 4 <= uiLength * 2; i += 4)
+    {
+        int fileId = (SemiByteCharsToByte(pszFileList[i], pszFileList[i + 1]) << 8)
+                | SemiByteCharsToByte(pszFileList[i + 2], pszFileList[i + 3]);
+
+        if (FILE_ID_MF != fileId)
+        {
+            DropFile(fileId);
+            uiFiles++;
+        }
+    }
+    m_uiGeneration++;
+    CMutex::Unlock(m_pLock);
+
+    RIL_LOG_INFO("CSimFileCache::InvalidateFileList() - [%u] files dropped\r\n", uiFiles);
+}
+
+void CSimFileCache::InvalidateAll()
+{
+    if (NULL == m_pLock)
+    {
+        return;
+    }
+
+    CMutex::Lock(m_pLock);
+    for (int i = 0; i < E_MAX_ENTRIES; i++)
+    {
+        if (m_rgEntries[i].bUsed)
+        {
+            FreeEntry(i);
+        }
+    }
+    m_uiGeneration++;
+    RIL_LOG_INFO("CSimFileCache::InvalidateAll() - [%u] hits, [%u] misses\r\n",
+            m_uiHits, m_uiMisses);
+    CMutex::Unlock(m_pLock);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+BOOL CSimFileCache::IsCachedCommand(int command)
+{
+    return SIM_COMMAND_READ_BINARY == command
+            || SIM_COMMAND_READ_RECORD == command
+            || SIM_COMMAND_GET_RESPONSE == command;
+}
+
+BOOL CSimFileCache::IsCachedFile(int fileId)
+{
+    for (UINT32 i = 0; i < sizeof(g_rgiUncachedFiles) / sizeof(g_rgiUncachedFiles[0]); i++)
+    {
+        if (fileId == g_rgiUncachedFiles[i])
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+// FNV-1a
+UINT32 CSimFileCache::GetHash(int command, const S_SIM_IO_CONTEXT_DATA& rKey)
+{
+    const int rgiValues[] = { command, rKey.fileId, rKey.p1, rKey.p2, rKey.p3 };
+    UINT32 uiHash = 2166136261U;
+
+    for (UINT32 i = 0; i < sizeof(rgiValues) / sizeof(rgiValues[0]); i++)
+    {
+        uiHash = (uiHash ^ (UINT32)rgiValues[i]) * 16777619U;
+    }
+
+    for (const char* psz = rKey.szPath; '\0' != *psz; psz++)
+    {
+        uiHash = (uiHash ^ (BYTE)*psz) * 16777619U;
+    }
+
+    for (const char* psz = rKey.szAid; '\0' != *psz; psz++)
+    {
+        uiHash = (uiHash ^ (BYTE)*psz) * 16777619U;
+    }
+
+    return uiHash;
+}
+
+// Called with the lock held
+int CSimFileCache::FindEntry(int command, const S_SIM_IO_CONTEXT_DATA& rKey, UINT32 uiHash)
+{
+    for (int i = m_rgiBuckets[uiHash % E_BUCKETS]; i >= 0; i = m_rgEntries[i].iNext)
+    {
+        const ENTRY& rEntry = m_rgEntries[i];
+
+        if (rEntry.uiHash == uiHash
+                && rEntry.command == command
+                && rEntry.fileId == rKey.fileId
+                && rEntry.p1 == rKey.p1
+                && rEntry.p2 == rKey.p2
+                && rEntry.p3 == rKey.p3
+                && 0 == strcmp(rEntry.szPath, rKey.szPath)
+                && 0 == strcmp(rEntry.szAid, rKey.szAid))
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+// Called with the lock held
+void CSimFileCache::FreeEntry(int iEntry)
+{
+    ENTRY& rEntry = m_rgEntries[iEntry];
+    int* piLink = &m_rgiBuckets[rEntry.uiHash % E_BUCKETS];
+
+    while (*piLink >= 0 && *piLink != iEntry)
+    {
+        piLink = &m_rgEntries[*piLink].iNext;
+    }
+
+    if (*piLink == iEntry)
+    {
+        *piLink = rEntry.iNext;
+    }
+
+    free(rEntry.pszResponse);
+    memset(&rEntry, 0, sizeof(ENTRY));
+}
+
+// Called with the lock held
+void CSimFileCache::Store(int command, const S_SIM_IO_CONTEXT_DATA& rKey, int sw1, int sw2,
+        const char* pszResponse)
+{
+    UINT32 uiHash = GetHash(command, rKey);
+    int iEntry = FindEntry(command, rKey, uiHash);
+    char* pszCopy = NULL;
+
+    if (NULL != pszResponse && '\0' != pszResponse[0])
+    {
+        pszCopy = strdup(pszResponse);
+        if (NULL == pszCopy)
+        {
+            RIL_LOG_CRITICAL("CSimFileCache::Store() - Cannot allocate response\r\n");
+            return;
+        }
+    }
+
+    if (iEntry >= 0)
+    {
+        FreeEntry(iEntry);
+    }
+    else
+    {
+        iEntry = m_uiNextVictim;
+        m_uiNextVictim = (m_uiNextVictim + 1) % E_MAX_ENTRIES;
+        if (m_rgEntries[iEntry].bUsed)
+        {
+            FreeEntry(iEntry);
+        }
+    }
+
+    ENTRY& rEntry = m_rgEntries[iEntry];
+    rEntry.bUsed = TRUE;
+    rEntry.uiHash = uiHash;
+    rEntry.command = command;
+    rEntry.fileId = rKey.fileId;
+    rEntry.p1 = rKey.p1;
+    rEntry.p2 = rKey.p2;
+    rEntry.p3 = rKey.p3;
+    strncpy(rEntry.szPath, rKey.szPath, MAX_SIM_PATH_SIZE - 1);
+    strncpy(rEntry.szAid, rKey.szAid, MAX_AID_SIZE - 1);
+    rEntry.sw1 = sw1;
+    rEntry.sw2 = sw2;
+    rEntry.pszResponse = pszCopy;
+    rEntry.iNext = m_rgiBuckets[uiHash % E_BUCKETS];
+    m_rgiBuckets[uiHash % E_BUCKETS] = iEntry;
+}
+
+// Called with the lock held. The size of the file is not changed by an update
+// but its GET RESPONSE is dropped too, as after a REFRESH.
+void CSimFileCache::DropFile(int fileId)
+{
+    for (int i = 0; i < E_MAX_ENTRIES; i++)
+    {
+        if (m_rgEntries[i].bUsed && fileId == m_rgEntries[i].fileId)
+        {
+            FreeEntry(i);
+        }
+    }
+}
@@ -0,0 +1,102 @@
+////////////////////////////////////////////////////////////////////////////
+// sim_file_cache.h
+//
+// Copyright 2009 Intrinsyc Software International, Inc.  All rights reserved.
+// Patents pending in the United States of America and other jurisdictions.
+//
+//
+// Description:
+//    Cache of the SIM elementary files read with RIL_REQUEST_SIM_IO. Successful
+//    READ BINARY, READ RECORD and GET RESPONSE are kept by (command, file ID,
+//    path, P1, P2, P3, AID) and answered without going to the modem. Updates
+//    are written through. Files are dropped when a REFRESH lists them and the
+//    whole cache when the SIM application state changes.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef RRIL_SIM_FILE_CACHE_H
+#define RRIL_SIM_FILE_CACHE_H
+
+#include "types.h"
+#include "rril.h"
+
+class CMutex;
+
+class CSimFileCache
+{
+public:
+    static BOOL Init();
+    static void Destroy();
+
+    // Fill the cache key of a SIM IO request into its context data. Updates drop
+    // the cached records of their file until they complete.
+    static void PrepareRequest(const RIL_SIM_IO_v6& rSimIoArgs,
+            S_SIM_IO_CONTEXT_DATA& rContextData);
+
+    // Copy of the cached response to a read, allocated the way ParseSimIo() does.
+    // Returns NULL if the response is not cached.
+    static RIL_SIM_IO_Response* Lookup(const S_SIM_IO_CONTEXT_DATA& rContextData,
+            UINT32& ruiResponseSize);
+
+    // Called with the response of a successful SIM IO request
+    static void OnResponse(const S_SIM_IO_CONTEXT_DATA& rContextData,
+            const RIL_SIM_IO_Response* pResponse);
+
+    // Drop the cached records of a file, whatever its path
+    static void InvalidateFile(int fileId);
+
+    // Drop the files of the file list of a REFRESH proactive command, given as the
+    // hex string of the value of the file list TLV
+    static void InvalidateFileList(const char* pszFileList, UINT32 uiLength);
+
+    static void InvalidateAll();
+
+private:
+    enum
+    {
+        E_MAX_ENTRIES = 256,
+        E_BUCKETS = 64,
+        E_MAX_RESPONSE_LENGTH = 512     // hex chars, a record is at most 255 bytes
+    };
+
+    struct ENTRY
+    {
+        BOOL bUsed;
+        UINT32 uiHash;
+        int command;
+        int fileId;
+        int p1;
+        int p2;
+        int p3;
+        char szPath[MAX_SIM_PATH_SIZE];
+        char szAid[MAX_AID_SIZE];
+        int sw1;
+        int sw2;
+        char* pszResponse;              // NULL if the response has no data
+        int iNext;                      // next entry of the bucket, -1 if last
+    };
+
+    static BOOL IsCachedCommand(int command);
+    static BOOL IsCachedFile(int fileId);
+    static UINT32 GetHash(int command, const S_SIM_IO_CONTEXT_DATA& rKey);
+    static int FindEntry(int command, const S_SIM_IO_CONTEXT_DATA& rKey, UINT32 uiHash);
+    static void FreeEntry(int iEntry);
+    static void Store(int command, const S_SIM_IO_CONTEXT_DATA& rKey, int sw1, int sw2,
+            const char* pszResponse);
+    static void DropFile(int fileId);
+
+    static CMutex* m_pLock;
+    static ENTRY m_rgEntries[E_MAX_ENTRIES];
+    static int m_rgiBuckets[E_BUCKETS];     // first entry of each bucket, -1 if empty
+    static UINT32 m_uiNextVictim;           // round robin eviction
+
+    // Incremented on each invalidation. A response is only cached if nothing was
+    // invalidated since its request was sent.
+    static UINT32 m_uiGeneration;
+
+    // counters
+    static UINT32 m_uiHits;
+    static UINT32 m_uiMisses;
+};
+
+#endif // RRIL_SIM_FILE_CACHE_H
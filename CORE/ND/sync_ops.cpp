@@ -14,10 +14,18 @@
 #include "rillog.h"
 #include "rril.h"
 #include "types.h"
+#include "util.h"
 #include <errno.h>
-#include <assert.h>
-#include <time.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <stdint.h>
+#include <sys/eventfd.h>
+
+// Period at which events without an eventfd are checked by the waits
+static const int EVENT_NO_FD_POLL_INTERVAL = 10;
 
 CMutex::CMutex()
 {
@@ -257,39 +265,9 @@ void CMutex::Unlock(CMutex* pMutex)
     }
 }
 
-// Use to convert our timeout to a timespec in the future
-timespec msFromNowToTimespec(UINT32 msInFuture)
-{
-    timespec FutureTime;
-    timeval Now;
-    UINT32 usFromNow;
-
-    gettimeofday(&Now, NULL);
-
-    usFromNow = ((msInFuture % 1000) * 1000) + Now.tv_usec;
-
-    if (usFromNow >= 1000000 )
-    {
-        Now.tv_sec++;
-        FutureTime.tv_sec = Now.tv_sec + (msInFuture / 1000);
-        FutureTime.tv_nsec = (usFromNow - 1000000) * 1000;
-    }
-    else
-    {
-        FutureTime.tv_nsec = usFromNow * 1000;
-        FutureTime.tv_sec = Now.tv_sec + (msInFuture / 1000);
-    }
-
-    return FutureTime;
-}
-
 CEvent::CEvent(const char* szName, BOOL fManual, BOOL fInitial) : CMutex()
 {
-    EnterMutex();
-
-    pthread_cond_init(&m_EventCond, NULL);
-
-    m_fSignaled = fInitial;
+    m_fSignaled = FALSE;
     m_fManual   = fManual;
     m_szName    = NULL;
 
@@ -299,12 +277,27 @@ CEvent::CEvent(const char* szName, BOOL fManual, BOOL fInitial) : CMutex()
         m_szName = strdup(szName);
     }
 
-    LeaveMutex();
+    m_fd = eventfd(0, EFD_NONBLOCK);
+    if (m_fd < 0)
+    {
+        RIL_LOG_CRITICAL("CEvent::CEvent() : eventfd() failed, errno=[%d], waits will poll\r\n",
+                errno);
+    }
+
+    if (fInitial)
+    {
+        Signal();
+    }
 }
 
 CEvent::~CEvent()
 {
-    pthread_cond_destroy(&m_EventCond);
+    if (m_fd >= 0)
+    {
+        close(m_fd);
+        m_fd = -1;
+    }
+
     if (m_szName)
     {
         free((void*)m_szName);
@@ -312,64 +305,35 @@ CEvent::~CEvent()
     }
 }
 
-void CEvent::CreateObserver(CMultipleEvent* pMultipleEvent, int iValue)
+// Must be called with the event mutex held
+void CEvent::ClearSignal()
 {
-    EnterMutex();
-
-    CObserver* pNewObserver = new CObserver(pMultipleEvent, iValue);
-    m_mObservers.push_front(pNewObserver);
+    uint64_t uiValue;
 
-    LeaveMutex();
-}
-
-void CEvent::DeleteObserver(CMultipleEvent* pMultipleEvent)
-{
-    EnterMutex();
+    m_fSignaled = FALSE;
 
-    for (mapObserverIterator it = m_mObservers.begin(); it != m_mObservers.end(); it++)
+    if (m_fd >= 0 && read(m_fd, &uiValue, sizeof(uiValue)) < 0)
     {
-        CObserver* pObserver = *it;
-        if (pObserver && (pObserver->m_pMultipleEvent == pMultipleEvent))
-        {
-            m_mObservers.erase(it);
-            delete pObserver;
-            pObserver = NULL;
-            break;
-        }
+        RIL_LOG_CRITICAL("CEvent::ClearSignal() : read() failed, errno=[%d]\r\n", errno);
     }
-
-    LeaveMutex();
 }
 
-BOOL CEvent::SignalMultipleEventObject()
+BOOL CEvent::Signal(void)
 {
-    BOOL fEventHandled = FALSE;
+    uint64_t uiValue = 1;
 
-    for (mapObserverIterator it = m_mObservers.begin(); it != m_mObservers.end(); it++)
+    EnterMutex();
+
+    if (!m_fSignaled)
     {
-        CObserver* pObserver = *it;
-        if (pObserver)
-        {
-            int iEventIndex = pObserver->m_iEventIndex;
-            CMultipleEvent* pMultipleEvent = pObserver->m_pMultipleEvent;
+        m_fSignaled = TRUE;
 
-            fEventHandled = pMultipleEvent->Update(iEventIndex);
+        if (m_fd >= 0 && write(m_fd, &uiValue, sizeof(uiValue)) < 0)
+        {
+            RIL_LOG_CRITICAL("CEvent::Signal() : write() failed, errno=[%d]\r\n", errno);
         }
     }
 
-    return fEventHandled;
-}
-
-BOOL CEvent::Signal(void)
-{
-    EnterMutex();
-
-    m_fSignaled = TRUE;
-
-    pthread_cond_broadcast(&m_EventCond);
-
-    BOOL fHandled = SignalMultipleEventObject();
-
     LeaveMutex();
 
     return TRUE;
@@ -379,68 +343,43 @@ BOOL CEvent::Reset()
 {
     EnterMutex();
 
-    m_fSignaled = FALSE;
+    if (m_fSignaled)
+    {
+        ClearSignal();
+    }
 
     LeaveMutex();
 
     return TRUE;
-};
+}
 
-int CEvent::Wait(UINT32 uiTimeout)
+BOOL CEvent::TryAcquire()
 {
-    int rc = WAIT_EVENT_0_SIGNALED;
-    struct timespec Time;
+    BOOL fAcquired;
 
-    do
+    if (!m_fSignaled)
     {
-        EnterMutex();
-
-        if (m_fSignaled)
-        {
-            // No need to wait
-            break;
-        }
-
-        if (uiTimeout == WAIT_FOREVER)
-        {
-            pthread_cond_wait(&m_EventCond, &m_mutex);
-        }
-        else
-        {
-            Time = msFromNowToTimespec(uiTimeout);
-
-            rc = pthread_cond_timedwait(&m_EventCond, &m_mutex, &Time);
-
-            if (rc != 0)
-            {
-                if (rc != ETIMEDOUT)
-                {
-                    RIL_LOG_CRITICAL("CEvent::Wait() : pthread_cond_timedwait(): returned %d\r\n",
-                            rc);
-                }
-            }
-        }
+        return FALSE;
     }
-    while (0);
 
-    if (!m_fManual)
+    if (m_fManual)
     {
-        m_fSignaled = FALSE;
+        // pairs with the unlock in Signal()
+        __sync_synchronize();
+        return TRUE;
     }
 
-    LeaveMutex();
+    EnterMutex();
 
-    if (rc == ETIMEDOUT)
+    fAcquired = m_fSignaled;
+    if (fAcquired)
     {
-        rc = WAIT_TIMEDOUT;
+        ClearSignal();
     }
 
-    if (rc == 0)
-    {
-        rc = WAIT_EVENT_0_SIGNALED;
-    }
+    LeaveMutex();
 
-    return rc;
+    return fAcquired;
 }
 
 BOOL CEvent::Signal(CEvent* pEvent)
@@ -473,7 +412,8 @@ UINT32 CEvent::Wait(CEvent* pEvent, UINT32 uiTimeoutInMS)
 {
     if (pEvent)
     {
-        return pEvent->Wait(uiTimeoutInMS);
+        CEvent* rgpEvents[] = { pEvent };
+        return WaitForEvents(1, rgpEvents, uiTimeoutInMS);
     }
     else
     {
@@ -484,197 +424,95 @@ UINT32 CEvent::Wait(CEvent* pEvent, UINT32 uiTimeoutInMS)
 
 UINT32 CEvent::WaitForAnyEvent(UINT32 nEvents, CEvent** rgpEvents, UINT32 uiTimeoutInMS)
 {
-    CMultipleEvent* pMultipleEvents = new CMultipleEvent(nEvents);
-    UINT32 uiRet = WAIT_TIMEDOUT;
-
-    // load the events into the MultipleEvent object
     for (UINT32 index = 0; index < nEvents; index++)
     {
-        CEvent* pEvent = (CEvent*)rgpEvents[index];
-
-        if (pEvent != NULL)
-        {
-            // synchronize with CEvent::Signal()
-            pEvent->EnterMutex();
-
-            pMultipleEvents->AddEvent(index, pEvent);
-
-            if(pEvent->m_fSignaled)
-            {
-                pMultipleEvents->Update(index);
-            }
-
-            pEvent->LeaveMutex();
-        }
-        else
+        if (NULL == rgpEvents[index])
         {
             RIL_LOG_CRITICAL("CEvent::WaitForAnyEvent() : Item %d was NULL\r\n", index);
         }
     }
 
-    uiRet = pMultipleEvents->Wait(uiTimeoutInMS);
-
-    // Reset non-manual reset event after a successful wait, if any.
-    if(uiRet < nEvents && !rgpEvents[uiRet]->m_fManual)
-    {
-        Reset(rgpEvents[uiRet]);
-    }
-
-    for (UINT32 index = 0; index < nEvents; index++)
-    {
-        CEvent* pEvent = (CEvent*)rgpEvents[index];
-
-        if (pEvent != NULL)
-        {
-            pEvent->EnterMutex();
-            pMultipleEvents->RemoveEvent(index);
-            pEvent->LeaveMutex();
-        }
-    }
-
-    delete pMultipleEvents;
-    pMultipleEvents = NULL;
-
-    return uiRet;
+    return WaitForEvents(nEvents, rgpEvents, uiTimeoutInMS);
 }
 
-UINT32 CEvent::WaitForAllEvents(UINT32 nEvents, CEvent** rgpEvents, UINT32 uiTimeoutInMS)
-{
-    // FIXME Not currently supported... or needed?
-    return WAIT_TIMEDOUT;
-}
-
-CMultipleEvent::CMultipleEvent(UINT32 nEvents)
+//
+// Poll the descriptors of the events until one of them can be consumed.
+// A descriptor can turn readable while another thread consumes the signal, so the
+// events are checked again after each wake-up.
+//
+UINT32 CEvent::WaitForEvents(UINT32 nEvents, CEvent** rgpEvents, UINT32 uiTimeoutInMS)
 {
-    pthread_cond_init(&m_MultipleEventCond, NULL);
-    m_nLastSignaledEvent = -1;
-    m_fSignaled = FALSE;
-    m_nEvents = nEvents;
+    struct pollfd rgPollFds[MAX_WAIT_EVENTS];
+    UINT32 uiStartTime = GetMonotonicTickCount();
+    UINT32 uiElapsed;
+    UINT32 nFds;
+    UINT32 index;
+    int iPollTimeout;
+    BOOL fNoFd;
 
-    m_pEvents = new CEvent*[nEvents] ;
-    if (m_pEvents != NULL)
+    if (nEvents > MAX_WAIT_EVENTS)
     {
-        for (UINT32 ii = 0; ii < nEvents; ii++)
-            m_pEvents[ii] = NULL;
+        RIL_LOG_CRITICAL("CEvent::WaitForEvents() : Too many events [%u]\r\n", nEvents);
+        return WAIT_OBJ_NULL;
     }
-};
 
-CMultipleEvent::~CMultipleEvent()
-{
-    EnterMutex();
+    for (;;)
     {
-        pthread_cond_destroy(&m_MultipleEventCond);
-        delete [] m_pEvents;
-        m_pEvents = NULL;
-    }
-    LeaveMutex();
-};
-
-void CMultipleEvent::AddEvent(int iEventIndex, CEvent* pEvent)
-{
-    assert((iEventIndex >= 0) && (iEventIndex < m_nEvents));
-
-    EnterMutex();
-    {
-        if (m_pEvents[iEventIndex])
+        for (index = 0; index < nEvents; index++)
         {
-            m_pEvents[iEventIndex]->DeleteObserver(this);
+            if (NULL != rgpEvents[index] && rgpEvents[index]->TryAcquire())
+            {
+                return index;
+            }
         }
 
-        m_pEvents[iEventIndex] = pEvent;
-
-        if (pEvent)
+        if (WAIT_FOREVER == uiTimeoutInMS)
         {
-            pEvent->CreateObserver(this, iEventIndex);
-        }
-    }
-
-    LeaveMutex();
-}
-
-void CMultipleEvent::RemoveEvent(int iEventIndex)
-{
-    assert((iEventIndex >= 0) && (iEventIndex < m_nEvents));
-
-    EnterMutex();
-    {
-        if (m_pEvents[iEventIndex])
-            m_pEvents[iEventIndex]->DeleteObserver(this);
-
-        m_pEvents[iEventIndex] = NULL;
-    }
-
-    LeaveMutex();
-}
-
-BOOL CMultipleEvent::Update(int iEventIndex)
-{
-    BOOL fHandled = FALSE;
-
-    // synchronize with the wait() function to make update() and wait()
-    // both atomic operations
-    EnterMutex();
-
-    if (!m_fSignaled)
-    {
-        m_nLastSignaledEvent = iEventIndex;
-        m_fSignaled = TRUE;
-        fHandled = TRUE;
-
-        pthread_cond_signal(&m_MultipleEventCond);
-    }
-
-    LeaveMutex();
-    return fHandled;
-}
-
-int CMultipleEvent::Wait(UINT32 uiTimeout)
-{
-    int rc = WAIT_TIMEDOUT;
-    struct timespec Time;
-
-    EnterMutex();
-
-    if (m_fSignaled)
-    {
-        rc = m_nLastSignaledEvent;
-    }
-    else if (uiTimeout == WAIT_FOREVER)
-    {
-        pthread_cond_wait(&m_MultipleEventCond, &m_mutex);
-        rc = m_nLastSignaledEvent;
-    }
-    else
-    {
-        Time = msFromNowToTimespec(uiTimeout);
-        rc = pthread_cond_timedwait(&m_MultipleEventCond, &m_mutex, &Time);
-
-        if (rc == 0)
-        {
-            rc = m_nLastSignaledEvent;
+            iPollTimeout = -1;
         }
         else
         {
-            if (rc != ETIMEDOUT)
+            uiElapsed = GetMonotonicTickCount() - uiStartTime;
+            if (uiElapsed >= uiTimeoutInMS)
             {
-                RIL_LOG_CRITICAL("CMultipleEvent::Wait() : pthread_cond_timedwait():"
-                        " returned %d\r\n", rc);
+                return WAIT_TIMEDOUT;
+            }
+            iPollTimeout = (int)(uiTimeoutInMS - uiElapsed);
+        }
+
+        nFds = 0;
+        fNoFd = FALSE;
+        for (index = 0; index < nEvents; index++)
+        {
+            CEvent* pEvent = rgpEvents[index];
 
-                // TODO Deal with these errors
-                rc = ETIMEDOUT;
+            if (NULL == pEvent)
+            {
+                continue;
+            }
 
+            if (pEvent->m_fd < 0)
+            {
+                fNoFd = TRUE;
+                continue;
             }
+
+            rgPollFds[nFds].fd = pEvent->m_fd;
+            rgPollFds[nFds].events = POLLIN;
+            rgPollFds[nFds].revents = 0;
+            nFds++;
         }
-    }
 
-    // CMultipleEvent is always auto-reset after wait()
-    m_fSignaled = FALSE;
+        // events without a descriptor are checked periodically
+        if (fNoFd && (iPollTimeout < 0 || iPollTimeout > EVENT_NO_FD_POLL_INTERVAL))
+        {
+            iPollTimeout = EVENT_NO_FD_POLL_INTERVAL;
+        }
 
-    if (rc == ETIMEDOUT)
-    {
-        rc = WAIT_TIMEDOUT;
+        if (poll(rgPollFds, nFds, iPollTimeout) < 0 && EINTR != errno)
+        {
+            RIL_LOG_CRITICAL("CEvent::WaitForEvents() : poll() failed, errno=[%d]\r\n", errno);
+            return WAIT_TIMEDOUT;
+        }
     }
-    LeaveMutex();
-
-    return rc;
 }
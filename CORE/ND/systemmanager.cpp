@@ -40,6 +40,7 @@
 #include "initializer.h"
 #include "systemcaps.h"
 #include "systemmanager.h"
+#include "channel_reactor.h"
 
 #include <cutils/properties.h>
 #include <cutils/sockets.h>
@@ -49,7 +50,7 @@
 #include <sys/un.h>
 
 // Tx Queue
-CRilQueue<CCommand*>* g_pTxQueue[RIL_CHANNEL_MAX];
+CCommandQueue* g_pTxQueue[RIL_CHANNEL_MAX];
 CEvent* g_TxQueueEvent[RIL_CHANNEL_MAX];
 
 // Rx Queue
@@ -367,6 +368,17 @@ BOOL CSystemManager::InitializeSystem()
         CTE::GetTE().SetTimeoutThresholdForRetry((UINT32)iTemp);
     }
 
+    if (repository.Read(g_szGroupRILSettings, g_szMaxPipelinedCommands, iTemp) && iTemp > 0)
+    {
+        CTE::GetTE().SetMaxPipelinedCommands((UINT32)iTemp);
+    }
+
+    // One thread reading all channels instead of one per channel
+    if (repository.Read(g_szGroupRILSettings, g_szChannelReactor, iTemp))
+    {
+        CChannelReactor::Enable(0 != iTemp);
+    }
+
     if (repository.Read(g_szGroupModem, g_szMTU, iTemp))
     {
         CTE::GetTE().SetMTU((UINT32)iTemp);
@@ -675,7 +687,8 @@ BOOL CSystemManager::CreateQueues()
     for (UINT32 i = 0; i < g_uiRilChannelCurMax && i < RIL_CHANNEL_MAX; ++i)
     {
         if (NULL == (g_TxQueueEvent[i] = new CEvent(NULL, FALSE))     ||
-            NULL == (g_pTxQueue[i] = new CRilQueue<CCommand*>(true)) ||
+            NULL == (g_pTxQueue[i] = new CCommandQueue()) ||
+            !g_pTxQueue[i]->Init() ||
             NULL == (g_RxQueueEvent[i] = new CEvent(NULL, FALSE))     ||
             NULL == (g_pRxQueue[i] = new CRilQueue<CResponse*>(true)))
         {
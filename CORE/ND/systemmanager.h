@@ -31,6 +31,7 @@
 #include "types.h"
 #include "request_info_table.h"
 #include "rilqueue.h"
+#include "cmdqueue.h"
 #include "thread_manager.h"
 #include "rilchannels.h"
 #include "initializer.h"
@@ -43,7 +44,7 @@ class CChannel;
 class CResponse;
 
 // Queue Containers and Associated Events
-extern CRilQueue<CCommand*>* g_pTxQueue[RIL_CHANNEL_MAX];
+extern CCommandQueue* g_pTxQueue[RIL_CHANNEL_MAX];
 extern CRilQueue<CResponse*>* g_pRxQueue[RIL_CHANNEL_MAX];
 extern CEvent* g_TxQueueEvent[RIL_CHANNEL_MAX];
 extern CEvent* g_RxQueueEvent[RIL_CHANNEL_MAX];
@@ -36,6 +36,10 @@
 #include "ril_result.h"
 #include "callbacks.h"
 #include "reset.h"
+#include "request_coalescer.h"
+#include "signal_filter.h"
+#include "sim_file_cache.h"
+#include "timer_wheel.h"
 #include "extract.h"
 
 CTE* CTE::m_pTEInstance = NULL;
@@ -45,7 +49,19 @@ CTE::CTE(UINT32 modemType) :
     m_uiModemType(modemType),
     m_bCSStatusCached(FALSE),
     m_bPSStatusCached(FALSE),
-    m_bIsSetupDataCallOngoing(FALSE),
+    m_pRegStatusLock(NULL),
+    m_uiRegStatusVersion(0),
+    m_uiLocationEpoch(1),
+    m_pSetupDataCallLock(NULL),
+    m_uiSetupDataCallCids(0),
+    m_uiNetworkSearchWaiters(0),
+    m_pSmsSendLock(NULL),
+    m_bSmsLinkKept(FALSE),
+    m_uiSmsSegment(0),
+    m_uiSmsMessageGeneration(0),
+    m_uiSmsMessageStartTime(0),
+    m_uiSmsSegmentStartTime(0),
+    m_uiSmsModemTime(0),
     m_bSpoofCommandsStatus(TRUE),
     m_LastModemEvent(MODEM_STATE_UNKNOWN),
     m_bModemOffInFlightMode(FALSE),
@@ -71,6 +87,7 @@ CTE::CTE(UINT32 modemType) :
     m_uiTimeoutAPIDefault(TIMEOUT_API_DEFAULT),
     m_uiTimeoutWaitForInit(TIMEOUT_WAITFORINIT),
     m_uiTimeoutThresholdForRetry(TIMEOUT_THRESHOLDFORRETRY),
+    m_uiMaxPipelinedCommands(MAX_PIPELINED_COMMANDS_DEFAULT),
     m_uiDtmfState(E_DTMF_STATE_STOP),
     m_ScreenState(SCREEN_STATE_UNKNOWN),
     m_pPrefNetTypeReqInfo(NULL),
@@ -101,6 +118,8 @@ CTE::CTE(UINT32 modemType) :
     memset(&m_sCSStatus, 0, sizeof(S_ND_REG_STATUS));
     memset(&m_sPSStatus, 0, sizeof(S_ND_GPRS_REG_STATUS));
     memset(&m_sEPSStatus, 0, sizeof(S_ND_GPRS_REG_STATUS));
+    memset(m_rguiLocationEpoch, 0, sizeof(m_rguiLocationEpoch));
+    memset(m_rguiStatusTime, 0, sizeof(m_rguiStatusTime));
 
     m_szCachedLac[0] = '\0';
     m_szCachedCid[0] = '\0';
@@ -120,6 +139,12 @@ CTE::CTE(UINT32 modemType) :
     m_pDataCleanupStatusLock = new CMutex();
 
     m_pDataChannelRefCountMutex = new CMutex();
+
+    m_pRegStatusLock = new CMutex();
+
+    m_pSetupDataCallLock = new CMutex();
+
+    m_pSmsSendLock = new CMutex();
 }
 
 CTE::~CTE()
@@ -156,6 +181,27 @@ CTE::~CTE()
         delete m_pDataChannelRefCountMutex;
         m_pDataChannelRefCountMutex = NULL;
     }
+
+    if (m_pRegStatusLock)
+    {
+        CMutex::Unlock(m_pRegStatusLock);
+        delete m_pRegStatusLock;
+        m_pRegStatusLock = NULL;
+    }
+
+    if (m_pSetupDataCallLock)
+    {
+        CMutex::Unlock(m_pSetupDataCallLock);
+        delete m_pSetupDataCallLock;
+        m_pSetupDataCallLock = NULL;
+    }
+
+    if (m_pSmsSendLock)
+    {
+        CMutex::Unlock(m_pSmsSendLock);
+        delete m_pSmsSendLock;
+        m_pSmsSendLock = NULL;
+    }
 }
 
 CTEBase* CTE::CreateModemTE(CTE* pTEInstance)
@@ -600,6 +646,10 @@ void CTE::HandleRequest(int requestId, void* pData, size_t datalen, RIL_Token hR
     {
         eRetVal = HandleRequestWhenNotRegistered(requestId, hRilToken);
     }
+    else if (CRequestCoalescer::Attach(requestId, pData, datalen, hRilToken))
+    {
+        // completed from the cache, or by the identical request in flight
+    }
     else
     {
         switch (requestId)
@@ -2210,6 +2260,15 @@ RIL_RESULT_CODE CTE::RequestSignalStrength(RIL_Token rilToken, void* pData, size
     REQUEST_DATA reqData;
     memset(&reqData, 0, sizeof(REQUEST_DATA));
 
+    // The modem notifies the changes while the screen is on, the latest one is current
+    RIL_SignalStrength_v6 sigStrength;
+    if (CSignalStrengthFilter::GetLatest(sigStrength))
+    {
+        RIL_onRequestComplete(rilToken, RIL_E_SUCCESS, &sigStrength,
+                sizeof(RIL_SignalStrength_v6));
+        return RRIL_RESULT_OK;
+    }
+
     RIL_RESULT_CODE res = m_pTEBaseInstance->CoreSignalStrength(reqData, pData, datalen);
     if (RRIL_RESULT_OK != res)
     {
@@ -2260,11 +2319,10 @@ RIL_RESULT_CODE CTE::RequestRegistrationState(RIL_Token rilToken, void* pData, s
     REQUEST_DATA reqData;
     memset(&reqData, 0, sizeof(REQUEST_DATA));
 
-    if (m_bCSStatusCached && !IsLocationUpdatesEnabled())
-    {
-        S_ND_REG_STATUS regStatus;
+    S_ND_REG_STATUS regStatus;
 
-        CopyCachedRegistrationInfo(&regStatus, FALSE);
+    if (GetCachedRegistrationInfo(&regStatus, FALSE))
+    {
         /*
          * cheat with the size here.
          * Even though the response size is sizeof(S_ND_REG_STATUS) inform
@@ -2327,11 +2385,10 @@ RIL_RESULT_CODE CTE::RequestGPRSRegistrationState(RIL_Token rilToken, void* pDat
 {
     RIL_LOG_VERBOSE("CTE::RequestGPRSRegistrationState() - Enter\r\n");
 
-    if (m_bPSStatusCached && !IsLocationUpdatesEnabled())
-    {
-        S_ND_GPRS_REG_STATUS regStatus;
+    S_ND_GPRS_REG_STATUS regStatus;
 
-        CopyCachedRegistrationInfo(&regStatus, TRUE);
+    if (GetCachedRegistrationInfo(&regStatus, TRUE))
+    {
         /*
          * cheat with the size here.
          * Even though the response size is sizeof(S_ND_GPRS_REG_STATUS) inform
@@ -2629,6 +2686,15 @@ RIL_RESULT_CODE CTE::RequestSendSms(RIL_Token rilToken, void* pData, size_t data
     REQUEST_DATA reqData;
     memset(&reqData, 0, sizeof(REQUEST_DATA));
 
+    CMutex::Lock(m_pSmsSendLock);
+
+    // the last segment of a multipart message
+    if (0 < m_uiSmsSegment)
+    {
+        m_uiSmsSegment++;
+    }
+    m_uiSmsSegmentStartTime = GetMonotonicTickCount();
+
     RIL_RESULT_CODE res = m_pTEBaseInstance->CoreSendSms(reqData, pData, datalen);
     if (RRIL_RESULT_OK != res)
     {
@@ -2657,6 +2723,13 @@ RIL_RESULT_CODE CTE::RequestSendSms(RIL_Token rilToken, void* pData, size_t data
         }
     }
 
+    if (RRIL_RESULT_OK != res && 0 < m_uiSmsSegment)
+    {
+        CloseSmsLink();
+    }
+
+    CMutex::Unlock(m_pSmsSendLock);
+
     RIL_LOG_VERBOSE("CTE::RequestSendSms() - Exit\r\n");
     return res;
 }
@@ -2678,6 +2751,17 @@ RIL_RESULT_CODE CTE::RequestSendSmsExpectMore(RIL_Token rilToken, void* pData, s
     REQUEST_DATA reqData;
     memset(&reqData, 0, sizeof(REQUEST_DATA));
 
+    CMutex::Lock(m_pSmsSendLock);
+
+    if (0 == m_uiSmsSegment)
+    {
+        m_uiSmsMessageStartTime = GetMonotonicTickCount();
+        m_uiSmsModemTime = 0;
+    }
+    m_uiSmsSegment++;
+    m_uiSmsSegmentStartTime = GetMonotonicTickCount();
+
+    // AT+CMMS=2 is only sent with the first segment
     RIL_RESULT_CODE res = m_pTEBaseInstance->CoreSendSmsExpectMore(reqData, pData, datalen);
     if (RRIL_RESULT_OK != res)
     {
@@ -2709,6 +2793,17 @@ RIL_RESULT_CODE CTE::RequestSendSmsExpectMore(RIL_Token rilToken, void* pData, s
         }
     }
 
+    if (RRIL_RESULT_OK == res)
+    {
+        m_bSmsLinkKept = TRUE;
+    }
+    else
+    {
+        CloseSmsLink();
+    }
+
+    CMutex::Unlock(m_pSmsSendLock);
+
     RIL_LOG_VERBOSE("CTE::RequestSendSmsExpectMore() - Exit\r\n");
     return res;
 }
@@ -2845,9 +2940,13 @@ RIL_RESULT_CODE CTE::RequestSetupDataCall(RIL_Token rilToken, void* pData, size_
         {
             RIL_LOG_INFO("CTE::RequestSetupDataCall() -"
                     " No Data Channel for CID %u.\r\n", uiCID);
+            res = RIL_E_GENERIC_FAILURE;
             goto Error;
         }
 
+        // before queuing, the setup can complete on the data channel thread any time
+        SetupDataCallOngoing(uiCID, TRUE);
+
         pCmd = new CCommand(pChannelData->GetRilChannel(), rilToken,
                 RIL_REQUEST_SETUP_DATA_CALL, reqData, &CTE::ParseSetupDataCall,
                 &CTE::PostSetupDataCallCmdHandler);
@@ -2875,16 +2974,15 @@ RIL_RESULT_CODE CTE::RequestSetupDataCall(RIL_Token rilToken, void* pData, size_
 Error:
     if (RRIL_RESULT_OK != res)
     {
-        m_bIsSetupDataCallOngoing = FALSE;
+        if (0 != uiCID)
+        {
+            SetupDataCallOngoing(uiCID, FALSE);
+        }
         CleanRequestData(reqData);
 
         if (pChannelData)
             pChannelData->ResetDataCallInfo();
     }
-    else
-    {
-        m_bIsSetupDataCallOngoing = TRUE;
-    }
     RIL_LOG_VERBOSE("CTE::RequestSetupDataCall() - Exit\r\n");
     return res;
 }
@@ -2906,6 +3004,25 @@ RIL_RESULT_CODE CTE::RequestSimIo(RIL_Token rilToken, void* pData, size_t datale
     REQUEST_DATA reqData;
     memset(&reqData, 0, sizeof(REQUEST_DATA));
     CCommand* pCmd = NULL;
+    S_SIM_IO_CONTEXT_DATA cacheKey;
+    RIL_SIM_IO_Response* pCachedResponse = NULL;
+    UINT32 uiCachedResponseSize = 0;
+
+    memset(&cacheKey, 0, sizeof(cacheKey));
+    if (NULL != pData && sizeof(RIL_SIM_IO_v6) == datalen)
+    {
+        CSimFileCache::PrepareRequest(*(RIL_SIM_IO_v6*)pData, cacheKey);
+
+        pCachedResponse = CSimFileCache::Lookup(cacheKey, uiCachedResponseSize);
+        if (NULL != pCachedResponse)
+        {
+            RIL_onRequestComplete(rilToken, RIL_E_SUCCESS, pCachedResponse,
+                    uiCachedResponseSize);
+            free(pCachedResponse);
+            RIL_LOG_VERBOSE("CTE::RequestSimIo() - Exit\r\n");
+            return RRIL_RESULT_OK;
+        }
+    }
 
     RIL_RESULT_CODE res = m_pTEBaseInstance->CoreSimIo(reqData, pData, datalen);
     if (RRIL_RESULT_OK != res)
@@ -2914,6 +3031,13 @@ RIL_RESULT_CODE CTE::RequestSimIo(RIL_Token rilToken, void* pData, size_t datale
     }
     else
     {
+        // keep the cache key for the response
+        if (NULL != reqData.pContextData
+                && sizeof(S_SIM_IO_CONTEXT_DATA) == reqData.cbContextData)
+        {
+            memcpy(reqData.pContextData, &cacheKey, sizeof(S_SIM_IO_CONTEXT_DATA));
+        }
+
         pCmd = new CCommand(g_pReqInfo[RIL_REQUEST_SIM_IO].uiChannel,
                 rilToken, RIL_REQUEST_SIM_IO, reqData, &CTE::ParseSimIo, &CTE::PostSimIOCmdHandler);
 
@@ -3978,12 +4102,25 @@ RIL_RESULT_CODE CTE::RequestQueryAvailableNetworks(RIL_Token rilToken, void* pDa
     REQUEST_DATA reqData;
     memset(&reqData, 0, sizeof(REQUEST_DATA));
 
-    // If a setup data call is ongoing, delay the handling of this query (1 second)
-    if (m_bIsSetupDataCallOngoing)
+    // If a setup data call is ongoing, the query is handled once the last one completes
+    CMutex::Lock(m_pSetupDataCallLock);
+    if (0 != m_uiSetupDataCallCids)
     {
-        RIL_requestTimedCallback(triggerManualNetworkSearch, (void*)rilToken, 1, 0);
+        if (m_uiNetworkSearchWaiters < MAX_NETWORK_SEARCH_WAITERS)
+        {
+            m_rgNetworkSearchWaiters[m_uiNetworkSearchWaiters++] = rilToken;
+        }
+        else
+        {
+            // too many waiting, try again later (1 second)
+            RIL_requestTimedCallback(triggerManualNetworkSearch, (void*)rilToken, 1, 0);
+        }
+
+        CMutex::Unlock(m_pSetupDataCallLock);
+        RIL_LOG_INFO("CTE::RequestQueryAvailableNetworks() - Waiting for setup data call\r\n");
         return RRIL_RESULT_OK;
     }
+    CMutex::Unlock(m_pSetupDataCallLock);
 
     RIL_RESULT_CODE res = m_pTEBaseInstance->CoreQueryAvailableNetworks(reqData, pData, datalen);
     if (RRIL_RESULT_OK != res)
@@ -4613,7 +4750,18 @@ RIL_RESULT_CODE CTE::RequestHookStrings(RIL_Token rilToken, void* pData, size_t
 
     RIL_RESULT_CODE res = m_pTEBaseInstance->CoreHookStrings(reqData,
             pData, datalen, uiRilChannel);
-    if (RRIL_RESULT_OK != res && RRIL_RESULT_OK_IMMEDIATE != res)
+    if (RRIL_RESULT_OK_IMMEDIATE == res)
+    {
+        // When a hook strings implementation returns RRIL_RESULT_OK_IMMEDIATE,
+        // the return data has to be passed through reqData.pContextData2 and
+        // the len in reqData.cbContextData2. No command is sent to the modem.
+        RIL_onRequestComplete(rilToken, RRIL_RESULT_OK, reqData.pContextData2,
+                reqData.cbContextData2);
+        free(reqData.pContextData2);
+        reqData.pContextData2 = NULL;
+        return RRIL_RESULT_OK;
+    }
+    else if (RRIL_RESULT_OK != res)
     {
         RIL_LOG_CRITICAL("CTE::RequestHookStrings() - Unable to create AT command data\r\n");
     }
@@ -4673,14 +4821,6 @@ RIL_RESULT_CODE CTE::RequestHookStrings(RIL_Token rilToken, void* pData, size_t
 
         RIL_onRequestComplete(rilToken, RRIL_RESULT_OK, NULL, 0);
     }
-    // When a hook strings implementation returns RRIL_RESULT_OK_IMMEDIATE,
-    // the return data has to be passed through reqData.pContextData2 and
-    // the len in reqData.cbContextData2
-    if (res == RRIL_RESULT_OK_IMMEDIATE)
-    {
-        RIL_onRequestComplete(rilToken, RRIL_RESULT_OK, reqData.pContextData2,
-                reqData.cbContextData2);
-    }
     RIL_LOG_VERBOSE("CTE::RequestHookStrings() - Exit\r\n");
     return res;
 }
@@ -4713,6 +4853,7 @@ RIL_RESULT_CODE CTE::RequestScreenState(RIL_Token rilToken, void* pData, size_t
     {
         case 0:
             m_ScreenState = SCREEN_STATE_OFF;
+            CSignalStrengthFilter::Invalidate();
             break;
         case 1:
             m_ScreenState = SCREEN_STATE_ON;
@@ -4723,6 +4864,8 @@ RIL_RESULT_CODE CTE::RequestScreenState(RIL_Token rilToken, void* pData, size_t
 
     if (E_MMGR_EVENT_MODEM_UP == GetLastModemEvent())
     {
+        // The registration URCs are reported with or without location from now on
+        InvalidateCachedLocation();
         m_pTEBaseInstance->CoreScreenState(reqData, pData, datalen);
     }
 
@@ -5535,6 +5678,7 @@ Error:
     if (RRIL_RESULT_OK == res)
     {
         m_enableLocationUpdates = enableLocationUpdates;
+        InvalidateCachedLocation();
     }
 
     RIL_LOG_VERBOSE("CTE::RequestSetLocationUpdates() - Exit\r\n");
@@ -7718,6 +7862,8 @@ void CTE::StoreRegistrationInfo(void* pRegStruct, int regType)
     char szLac[REG_STATUS_LENGTH] = {'\0'};
     char szCid[REG_STATUS_LENGTH] = {'\0'};
 
+    BeginRegStatusWrite();
+
     /*
      * LAC and CID reported as part of the CS and PS registration status changed URCs
      * are supposed to be the same. But there is nothing wrong in keeping it separately.
@@ -7747,6 +7893,9 @@ void CTE::StoreRegistrationInfo(void* pRegStruct, int regType)
                 sizeof(psRegStatus->szNetworkType));
         strncpy(m_sPSStatus.szReasonDenied, psRegStatus->szReasonDenied,
                 sizeof(psRegStatus->szReasonDenied));
+        m_rguiLocationEpoch[E_REG_STATUS_PS] =
+                ('\0' != psRegStatus->szLAC[0]) ? m_uiLocationEpoch : 0;
+        m_rguiStatusTime[E_REG_STATUS_PS] = GetMonotonicTickCount();
 
         CopyStringNullTerminate(szLac, psRegStatus->szLAC, sizeof(szLac));
         CopyStringNullTerminate(szCid, psRegStatus->szCID, sizeof(szCid));
@@ -7785,6 +7934,9 @@ void CTE::StoreRegistrationInfo(void* pRegStruct, int regType)
 
         strncpy(m_sCSStatus.szReasonDenied, csRegStatus->szReasonDenied,
                 sizeof(csRegStatus->szReasonDenied));
+        m_rguiLocationEpoch[E_REG_STATUS_CS] =
+                ('\0' != csRegStatus->szLAC[0]) ? m_uiLocationEpoch : 0;
+        m_rguiStatusTime[E_REG_STATUS_CS] = GetMonotonicTickCount();
 
         CopyStringNullTerminate(szLac, csRegStatus->szLAC, sizeof(szLac));
         CopyStringNullTerminate(szCid, csRegStatus->szCID, sizeof(szCid));
@@ -7821,11 +7973,16 @@ void CTE::StoreRegistrationInfo(void* pRegStruct, int regType)
                 sizeof(epsRegStatus->szNetworkType));
         strncpy(m_sEPSStatus.szReasonDenied, epsRegStatus->szReasonDenied,
                 sizeof(epsRegStatus->szReasonDenied));
+        m_rguiLocationEpoch[E_REG_STATUS_EPS] =
+                ('\0' != epsRegStatus->szLAC[0]) ? m_uiLocationEpoch : 0;
+        m_rguiStatusTime[E_REG_STATUS_EPS] = GetMonotonicTickCount();
 
         CopyStringNullTerminate(szLac, epsRegStatus->szLAC, sizeof(szLac));
         CopyStringNullTerminate(szCid, epsRegStatus->szCID, sizeof(szCid));
     }
 
+    EndRegStatusWrite();
+
     BOOL bCellInfoChanged = FALSE;
     if ((0 != strcmp(m_szCachedLac, szLac) || 0 != strcmp(m_szCachedCid, szCid)))
     {
@@ -7840,7 +7997,8 @@ void CTE::StoreRegistrationInfo(void* pRegStruct, int regType)
         int rate = GetCellInfoListRate();
         rate = (0 == rate) ? 0 : -1;
         RIL_LOG_INFO("CTEBase::StoreRegistrationInfo() - read cell info now!\r\n");
-        RIL_requestTimedCallback(triggerCellInfoList, (void*)rate, 0, 0);
+        // a burst of cell changes needs a single read, which only queues a command
+        RIL_requestTimerCallback(triggerCellInfoList, (void*)rate, 0, 0, TRUE);
     }
 
     RIL_LOG_VERBOSE("CTE::StoreRegistrationInfo() - Exit\r\n");
@@ -7848,11 +8006,137 @@ void CTE::StoreRegistrationInfo(void* pRegStruct, int regType)
 
 void CTE::CopyCachedRegistrationInfo(void* pRegStruct, BOOL bPSStatus)
 {
-    RIL_LOG_VERBOSE("CTE::CopyCachedRegistrationInfo() - Enter\r\n");
+    REG_STATUS_SNAPSHOT snapshot;
+
+    ReadRegStatus(snapshot);
+    CopyRegistrationInfo(snapshot, pRegStruct, bPSStatus);
+}
+
+//
+// The status is used if the status of the domain is known and, when the framework
+// asked for location updates, if its location was reported under the current location
+// reporting mode and is not older than allowed for the access technology: it is then
+// kept up to date by the URCs.
+//
+BOOL CTE::GetCachedRegistrationInfo(void* pRegStruct, BOOL bPSStatus)
+{
+    REG_STATUS_SNAPSHOT snapshot;
+    int location;
+    LONG regState;
+    UINT32 uiAge;
+    UINT32 uiMaxAge;
+
+    ReadRegStatus(snapshot);
+
+    if (bPSStatus)
+    {
+        if (!snapshot.bPSStatusCached)
+        {
+            return FALSE;
+        }
+        location = IsEPSStatusUsed(snapshot) ? E_REG_STATUS_EPS : E_REG_STATUS_PS;
+        regState = strtol((E_REG_STATUS_EPS == location) ? snapshot.sEPSStatus.szStat
+                : snapshot.sPSStatus.szStat, NULL, 10);
+    }
+    else
+    {
+        if (!snapshot.bCSStatusCached)
+        {
+            return FALSE;
+        }
+        location = E_REG_STATUS_CS;
+        // the emergency only states are reported 10 above the registration states
+        regState = strtol(snapshot.sCSStatus.szStat, NULL, 10) % 10;
+    }
+
+    if (IsLocationUpdatesEnabled())
+    {
+        if (!snapshot.rgbLocationValid[location])
+        {
+            RIL_LOG_VERBOSE("CTE::GetCachedRegistrationInfo() - No location in cache\r\n");
+            return FALSE;
+        }
+
+        // the access technology is only reported by +XREG and +CEREG
+        uiAge = GetMonotonicTickCount() - snapshot.rguiStatusTime[location];
+        uiMaxAge = GetLocationMaxAge(regState, (E_REG_STATUS_EPS == location) ? RADIO_TECH_LTE
+                : strtol(snapshot.sPSStatus.szNetworkType, NULL, 10));
+        if (uiAge > uiMaxAge)
+        {
+            RIL_LOG_VERBOSE("CTE::GetCachedRegistrationInfo() - Location too old [%u] ms\r\n",
+                    uiAge);
+            return FALSE;
+        }
+    }
+
+    CopyRegistrationInfo(snapshot, pRegStruct, bPSStatus);
+    return TRUE;
+}
+
+//
+// How long a reported location is trusted, in ms. The registration URCs report every
+// change of LAC/TAC or cell while camped, but they are not sent for all the cell changes
+// in connected mode:
+// - LTE reports the new cell in connected mode as well
+// - GSM and UMTS do not report the handovers of a call or of a dedicated channel, so
+//   the cell may be wrong until the next change in idle mode
+// - while not registered, the modem is searching and the status changes quickly
+//
+UINT32 CTE::GetLocationMaxAge(LONG regState, LONG act)
+{
+    if (E_REGISTRATION_REGISTERED_HOME_NETWORK != regState
+            && E_REGISTRATION_REGISTERED_ROAMING != regState)
+    {
+        return 5000;
+    }
+
+    switch (act)
+    {
+        case RADIO_TECH_LTE:
+            return 60000;
+
+        case RADIO_TECH_UMTS:
+        case RADIO_TECH_HSDPA:
+        case RADIO_TECH_HSUPA:
+        case RADIO_TECH_HSPA:
+        case RADIO_TECH_HSPAP:
+        case RADIO_TECH_GSM:
+        case RADIO_TECH_GPRS:
+        case RADIO_TECH_EDGE:
+            return 20000;
+
+        default:
+            // not reported yet
+            return 5000;
+    }
+}
+
+/*
+ * The EPS registration status is reported as the data registration state if the device
+ * is EPS registered and the current access technology is LTE.
+ *
+ * Note: When the device is EPS registered but if the current access technology is
+ * not known, then EPS registration status will be updated as the data registration
+ * state to the telephony framework. This is possible when the device is in screen
+ * off state.
+ */
+BOOL CTE::IsEPSStatusUsed(const REG_STATUS_SNAPSHOT& rSnapshot)
+{
+    LONG currentAct = strtol(rSnapshot.sPSStatus.szNetworkType, NULL, 10);
+    LONG epsRegState = strtol(rSnapshot.sEPSStatus.szStat, NULL, 10);
+
+    return (E_REGISTRATION_REGISTERED_HOME_NETWORK == epsRegState
+            || E_REGISTRATION_REGISTERED_ROAMING == epsRegState)
+            && (RADIO_TECH_LTE == currentAct || RADIO_TECH_UNKNOWN == currentAct);
+}
+
+void CTE::CopyRegistrationInfo(const REG_STATUS_SNAPSHOT& snapshot, void* pRegStruct,
+        BOOL bPSStatus)
+{
+    RIL_LOG_VERBOSE("CTE::CopyRegistrationInfo() - Enter\r\n");
 
     if (bPSStatus)
     {
-        int currentAct = GetCurrentAct();
         P_ND_GPRS_REG_STATUS psRegStatus = (P_ND_GPRS_REG_STATUS) pRegStruct;
 
         memset(psRegStatus, 0, sizeof(S_ND_GPRS_REG_STATUS));
@@ -7860,14 +8144,8 @@ void CTE::CopyCachedRegistrationInfo(void* pRegStruct, BOOL bPSStatus)
         /*
          * Copy the cached EPS registration status only if the device is EPS registered,
          * current access technology is LTE and default PDN context parameters are read.
-         *
-         * Note: When the device is EPS registered but if the current access technology is
-         * not known, then EPS registration status will be updated as the data registration
-         * state to the telephony framework. This is possible when the device is in screen
-         * off state.
          */
-        if (IsEPSRegistered() && (RADIO_TECH_LTE == currentAct
-                || RADIO_TECH_UNKNOWN == currentAct))
+        if (IsEPSStatusUsed(snapshot))
         {
             /*
              * Report the EPS registration status only after the default PDN context
@@ -7884,27 +8162,31 @@ void CTE::CopyCachedRegistrationInfo(void* pRegStruct, BOOL bPSStatus)
                 int dataState = pChannelData->GetDataState();
                 if (E_DATA_STATE_ACTIVE == dataState)
                 {
-                    RIL_LOG_VERBOSE("CTE::CopyCachedRegistrationInfo() - Default PDN ready\r\n");
-                    strncpy(psRegStatus->szStat, m_sEPSStatus.szStat, sizeof(psRegStatus->szStat));
+                    RIL_LOG_VERBOSE("CTE::CopyRegistrationInfo() - Default PDN ready\r\n");
+                    strncpy(psRegStatus->szStat, snapshot.sEPSStatus.szStat,
+                            sizeof(psRegStatus->szStat));
                     // TAC is mapped to LAC
-                    strncpy(psRegStatus->szLAC, m_sEPSStatus.szLAC, sizeof(psRegStatus->szLAC));
-                    strncpy(psRegStatus->szCID, m_sEPSStatus.szCID, sizeof(psRegStatus->szCID));
-                    strncpy(psRegStatus->szNetworkType, m_sEPSStatus.szNetworkType,
+                    strncpy(psRegStatus->szLAC, snapshot.sEPSStatus.szLAC,
+                            sizeof(psRegStatus->szLAC));
+                    strncpy(psRegStatus->szCID, snapshot.sEPSStatus.szCID,
+                            sizeof(psRegStatus->szCID));
+                    strncpy(psRegStatus->szNetworkType, snapshot.sEPSStatus.szNetworkType,
                             sizeof(psRegStatus->szNetworkType));
-                    strncpy(psRegStatus->szReasonDenied, m_sEPSStatus.szReasonDenied,
+                    strncpy(psRegStatus->szReasonDenied, snapshot.sEPSStatus.szReasonDenied,
                             sizeof(psRegStatus->szReasonDenied));
                 }
             }
         }
         else
         {
-            RIL_LOG_VERBOSE("CTE::CopyCachedRegistrationInfo() - not on LTE\r\n");
-            strncpy(psRegStatus->szStat, m_sPSStatus.szStat, sizeof(psRegStatus->szStat));
-            strncpy(psRegStatus->szLAC, m_sPSStatus.szLAC, sizeof(psRegStatus->szLAC));
-            strncpy(psRegStatus->szCID, m_sPSStatus.szCID, sizeof(psRegStatus->szCID));
-            strncpy(psRegStatus->szNetworkType, m_sPSStatus.szNetworkType,
+            RIL_LOG_VERBOSE("CTE::CopyRegistrationInfo() - not on LTE\r\n");
+            strncpy(psRegStatus->szStat, snapshot.sPSStatus.szStat,
+                    sizeof(psRegStatus->szStat));
+            strncpy(psRegStatus->szLAC, snapshot.sPSStatus.szLAC, sizeof(psRegStatus->szLAC));
+            strncpy(psRegStatus->szCID, snapshot.sPSStatus.szCID, sizeof(psRegStatus->szCID));
+            strncpy(psRegStatus->szNetworkType, snapshot.sPSStatus.szNetworkType,
                     sizeof(psRegStatus->szNetworkType));
-            strncpy(psRegStatus->szReasonDenied, m_sPSStatus.szReasonDenied,
+            strncpy(psRegStatus->szReasonDenied, snapshot.sPSStatus.szReasonDenied,
                     sizeof(psRegStatus->szReasonDenied));
         }
 
@@ -7926,7 +8208,8 @@ void CTE::CopyCachedRegistrationInfo(void* pRegStruct, BOOL bPSStatus)
 
         memset(csRegStatus, 0, sizeof(S_ND_REG_STATUS));
 
-        if (E_REGISTRATION_EMERGENCY_SERVICES_ONLY == GetCsRegistrationState(m_sCSStatus.szStat))
+        if (E_REGISTRATION_EMERGENCY_SERVICES_ONLY
+                == GetCsRegistrationState(snapshot.sCSStatus.szStat))
         {
             // Android do not manage the new value state +CREG: 8, so we use the
             // case 10 (0+10) which means no network but emergency call possible
@@ -7934,16 +8217,17 @@ void CTE::CopyCachedRegistrationInfo(void* pRegStruct, BOOL bPSStatus)
         }
         else
         {
-            strncpy(csRegStatus->szStat, m_sCSStatus.szStat, sizeof(csRegStatus->szStat));
+            strncpy(csRegStatus->szStat, snapshot.sCSStatus.szStat,
+                    sizeof(csRegStatus->szStat));
         }
 
-        strncpy(csRegStatus->szLAC, m_sCSStatus.szLAC, sizeof(csRegStatus->szLAC));
-        strncpy(csRegStatus->szCID, m_sCSStatus.szCID, sizeof(csRegStatus->szCID));
+        strncpy(csRegStatus->szLAC, snapshot.sCSStatus.szLAC, sizeof(csRegStatus->szLAC));
+        strncpy(csRegStatus->szCID, snapshot.sCSStatus.szCID, sizeof(csRegStatus->szCID));
         // Always copy the access technology received as part of XREG URC as it reports
         // access technology also during call.
-        strncpy(csRegStatus->szNetworkType, m_sPSStatus.szNetworkType,
+        strncpy(csRegStatus->szNetworkType, snapshot.sPSStatus.szNetworkType,
                 sizeof(csRegStatus->szNetworkType));
-        strncpy(csRegStatus->szReasonDenied, m_sCSStatus.szReasonDenied,
+        strncpy(csRegStatus->szReasonDenied, snapshot.sCSStatus.szReasonDenied,
                 sizeof(csRegStatus->szReasonDenied));
 
         csRegStatus->sStatusPointers.pszStat = csRegStatus->szStat;
@@ -7955,13 +8239,60 @@ void CTE::CopyCachedRegistrationInfo(void* pRegStruct, BOOL bPSStatus)
         // by memset().  They are not used in this RIL.
     }
 
-    RIL_LOG_VERBOSE("CTE::CopyCachedRegistrationInfo() - Exit\r\n");
+    RIL_LOG_VERBOSE("CTE::CopyRegistrationInfo() - Exit\r\n");
 }
 
 void CTE::ResetRegistrationCache()
 {
+    BeginRegStatusWrite();
     m_bCSStatusCached = FALSE;
     m_bPSStatusCached = FALSE;
+    EndRegStatusWrite();
+}
+
+void CTE::InvalidateCachedLocation()
+{
+    BeginRegStatusWrite();
+    m_uiLocationEpoch++;
+    EndRegStatusWrite();
+}
+
+void CTE::BeginRegStatusWrite()
+{
+    CMutex::Lock(m_pRegStatusLock);
+    m_uiRegStatusVersion++;
+    __sync_synchronize();
+}
+
+void CTE::EndRegStatusWrite()
+{
+    __sync_synchronize();
+    m_uiRegStatusVersion++;
+    CMutex::Unlock(m_pRegStatusLock);
+}
+
+void CTE::ReadRegStatus(REG_STATUS_SNAPSHOT& rSnapshot)
+{
+    UINT32 uiVersion;
+
+    do
+    {
+        uiVersion = m_uiRegStatusVersion;
+        __sync_synchronize();
+
+        rSnapshot.bCSStatusCached = m_bCSStatusCached;
+        rSnapshot.bPSStatusCached = m_bPSStatusCached;
+        memcpy(&rSnapshot.sCSStatus, &m_sCSStatus, sizeof(S_ND_REG_STATUS));
+        memcpy(&rSnapshot.sPSStatus, &m_sPSStatus, sizeof(S_ND_GPRS_REG_STATUS));
+        memcpy(&rSnapshot.sEPSStatus, &m_sEPSStatus, sizeof(S_ND_GPRS_REG_STATUS));
+        for (int i = 0; i < E_REG_STATUS_MAX; i++)
+        {
+            rSnapshot.rgbLocationValid[i] = (m_uiLocationEpoch == m_rguiLocationEpoch[i]);
+            rSnapshot.rguiStatusTime[i] = m_rguiStatusTime[i];
+        }
+
+        __sync_synchronize();
+    } while ((uiVersion & 1) || (uiVersion != m_uiRegStatusVersion));
 }
 
 bool CTE::IsRegistered()
@@ -8160,16 +8491,67 @@ UINT32 CTE::GetIncomingCallId()
     return m_pTEBaseInstance->GetIncomingCallId();
 }
 
-void CTE::SetupDataCallOngoing(BOOL bStatus)
+void CTE::SetupDataCallOngoing(UINT32 uiCID, BOOL bStatus)
 {
-    RIL_LOG_VERBOSE("CTE::SetupDataCallOngoing() - Enter / Exit\r\n");
-    m_bIsSetupDataCallOngoing = bStatus;
+    RIL_LOG_VERBOSE("CTE::SetupDataCallOngoing() - Enter\r\n");
+
+    // CIDs are data channel numbers, far below 32
+    UINT32 uiMask = (0 == uiCID || uiCID >= 32) ? 0xFFFFFFFF : (1U << uiCID);
+    BOOL bRelease = FALSE;
+
+    CMutex::Lock(m_pSetupDataCallLock);
+    if (bStatus)
+    {
+        if (uiMask != 0xFFFFFFFF)
+        {
+            m_uiSetupDataCallCids |= uiMask;
+        }
+    }
+    else if (0 != m_uiSetupDataCallCids)
+    {
+        m_uiSetupDataCallCids &= ~uiMask;
+        bRelease = (0 == m_uiSetupDataCallCids);
+    }
+    RIL_LOG_INFO("CTE::SetupDataCallOngoing() - CID=[%u] ongoing=[%d], CIDs ongoing=[0x%X]\r\n",
+            uiCID, bStatus, m_uiSetupDataCallCids);
+    CMutex::Unlock(m_pSetupDataCallLock);
+
+    if (bRelease)
+    {
+        ReleaseNetworkSearchWaiters();
+    }
+
+    RIL_LOG_VERBOSE("CTE::SetupDataCallOngoing() - Exit\r\n");
 }
 
 BOOL CTE::IsSetupDataCallOnGoing()
 {
     RIL_LOG_VERBOSE("CTE::IsSetupDataCallOnGoing() - Enter / Exit\r\n");
-    return m_bIsSetupDataCallOngoing;
+    return 0 != m_uiSetupDataCallCids;
+}
+
+//
+// Called once no setup data call is ongoing. The searches are started from the
+// framework event loop, as the last setup data call usually ends on a data channel
+// thread.
+//
+void CTE::ReleaseNetworkSearchWaiters()
+{
+    RIL_Token rgWaiters[MAX_NETWORK_SEARCH_WAITERS];
+    UINT32 uiWaiters;
+
+    CMutex::Lock(m_pSetupDataCallLock);
+    uiWaiters = m_uiNetworkSearchWaiters;
+    memcpy(rgWaiters, m_rgNetworkSearchWaiters, uiWaiters * sizeof(RIL_Token));
+    m_uiNetworkSearchWaiters = 0;
+    CMutex::Unlock(m_pSetupDataCallLock);
+
+    for (UINT32 i = 0; i < uiWaiters; i++)
+    {
+        RIL_LOG_INFO("CTE::ReleaseNetworkSearchWaiters() - Starting manual network search,"
+                " token=0x%08x\r\n", (int) rgWaiters[i]);
+        RIL_requestTimedCallback(triggerManualNetworkSearch, (void*)rgWaiters[i], 0, 0);
+    }
 }
 
 BOOL CTE::IsLocationUpdatesEnabled()
@@ -8226,17 +8608,32 @@ void CTE::SetPersonalisationSubState(int perso_substate)
 void CTE::ResetInternalStates()
 {
     RIL_LOG_VERBOSE("CTE::ResetInternalStates() - Enter / Exit\r\n");
+    BeginRegStatusWrite();
     m_bCSStatusCached = FALSE;
     m_bPSStatusCached = FALSE;
-    m_bIsSetupDataCallOngoing = FALSE;
+    memset(&m_sCSStatus, 0, sizeof(S_ND_REG_STATUS));
+    memset(&m_sPSStatus, 0, sizeof(S_ND_GPRS_REG_STATUS));
+    memset(&m_sEPSStatus, 0, sizeof(S_ND_GPRS_REG_STATUS));
+    memset(m_rguiLocationEpoch, 0, sizeof(m_rguiLocationEpoch));
+    memset(m_rguiStatusTime, 0, sizeof(m_rguiStatusTime));
+    EndRegStatusWrite();
+
+    CSignalStrengthFilter::Invalidate();
+    CSimFileCache::InvalidateAll();
+
+    SetupDataCallOngoing(0, FALSE);
+
+    // the modem is reset, nothing to close
+    CMutex::Lock(m_pSmsSendLock);
+    m_bSmsLinkKept = FALSE;
+    CloseSmsLink();
+    CMutex::Unlock(m_pSmsSendLock);
+
     m_bIsManualNetworkSearchOn = FALSE;
     m_bIsClearPendingCHLD = FALSE;
     m_bIsDataSuspended = FALSE;
     m_bRadioRequestPending = FALSE;
 
-    memset(&m_sCSStatus, 0, sizeof(S_ND_REG_STATUS));
-    memset(&m_sPSStatus, 0, sizeof(S_ND_GPRS_REG_STATUS));
-    memset(&m_sEPSStatus, 0, sizeof(S_ND_GPRS_REG_STATUS));
     m_szCachedLac[0] = '\0';
     m_szCachedCid[0] = '\0';
 }
@@ -9076,12 +9473,95 @@ void CTE::PostSendSmsCmdHandler(POST_CMD_HANDLER_DATA& rData)
         }
     }
 
+    CMutex::Lock(m_pSmsSendLock);
+
+    if (0 < m_uiSmsSegment)
+    {
+        UINT32 uiNow = GetMonotonicTickCount();
+
+        m_uiSmsModemTime += uiNow - m_uiSmsSegmentStartTime;
+        RIL_LOG_INFO("CTE::PostSendSmsCmdHandler() - Segment [%u] %s in [%u] ms\r\n",
+                m_uiSmsSegment, (RIL_E_SUCCESS == rData.uiResultCode) ? "sent" : "failed",
+                uiNow - m_uiSmsSegmentStartTime);
+
+        if (RIL_REQUEST_SEND_SMS_EXPECT_MORE == rData.requestId)
+        {
+            // Closed if the framework gives up or takes too long to send the next
+            // segment. The link itself is released by the network after a few seconds.
+            // Only the timer of the latest segment is kept.
+            CTimerWheel::Cancel(triggerCloseIdleSmsLink, (void*)m_uiSmsMessageGeneration);
+            RIL_requestTimerCallback(triggerCloseIdleSmsLink, (void*)m_uiSmsMessageGeneration,
+                    SMS_LINK_IDLE_TIMEOUT, 0);
+        }
+        else
+        {
+            RIL_LOG_INFO("CTE::PostSendSmsCmdHandler() - [%u] segments sent in [%u] ms,"
+                    " [%u] ms of it in the modem\r\n", m_uiSmsSegment,
+                    uiNow - m_uiSmsMessageStartTime, m_uiSmsModemTime);
+            CloseSmsLink();
+        }
+    }
+
+    // AT+CMMS=0 is queued before the completion so it goes ahead of the next message
+    CMutex::Unlock(m_pSmsSendLock);
+
     RIL_onRequestComplete(rData.pRilToken, (RIL_Errno) rData.uiResultCode,
                                                 rData.pData, rData.uiDataSize);
 
     RIL_LOG_VERBOSE("CTE::PostSendSmsCmdHandler() Exit\r\n");
 }
 
+void CTE::CloseIdleSmsLink(UINT32 uiGeneration)
+{
+    CMutex::Lock(m_pSmsSendLock);
+
+    // Timers left to the framework cannot be cancelled. The one of an earlier
+    // message, or of an earlier segment of this one, is ignored.
+    if (uiGeneration == m_uiSmsMessageGeneration && 0 < m_uiSmsSegment
+            && GetMonotonicTickCount() - m_uiSmsSegmentStartTime
+                    >= SMS_LINK_IDLE_TIMEOUT * 1000)
+    {
+        RIL_LOG_INFO("CTE::CloseIdleSmsLink() - No segment after [%u] for [%u] s\r\n",
+                m_uiSmsSegment, SMS_LINK_IDLE_TIMEOUT);
+        CloseSmsLink();
+    }
+
+    CMutex::Unlock(m_pSmsSendLock);
+}
+
+//
+// Ends the multipart message. Called with m_pSmsSendLock held.
+//
+void CTE::CloseSmsLink()
+{
+    CTimerWheel::Cancel(triggerCloseIdleSmsLink, (void*)m_uiSmsMessageGeneration);
+    m_uiSmsMessageGeneration++;
+    m_uiSmsSegment = 0;
+
+    if (!m_bSmsLinkKept)
+    {
+        return;
+    }
+
+    m_bSmsLinkKept = FALSE;
+
+    CCommand* pCmd = new CCommand(g_pReqInfo[RIL_REQUEST_SEND_SMS_EXPECT_MORE].uiChannel,
+            NULL, REQ_ID_NONE, "AT+CMMS=0\r");
+    if (pCmd)
+    {
+        if (!CCommand::AddCmdToQueue(pCmd))
+        {
+            RIL_LOG_CRITICAL("CTE::CloseSmsLink() - Unable to add command to queue\r\n");
+            delete pCmd;
+            pCmd = NULL;
+        }
+    }
+    else
+    {
+        RIL_LOG_CRITICAL("CTE::CloseSmsLink() - Unable to allocate memory for command\r\n");
+    }
+}
+
 void CTE::PostSetupDataCallCmdHandler(POST_CMD_HANDLER_DATA& rData)
 {
     RIL_LOG_VERBOSE("CTE::PostSetupDataCallCmdHandler - Enter\r\n");
@@ -9162,6 +9642,11 @@ void CTE::PostSimIOCmdHandler(POST_CMD_HANDLER_DATA& rData)
             {
                 m_pTEBaseInstance->SetPin2State(RIL_PINSTATE_ENABLED_VERIFIED);
             }
+
+            if (sizeof(RIL_SIM_IO_Response) <= rData.uiDataSize)
+            {
+                CSimFileCache::OnResponse(*pContextData, (RIL_SIM_IO_Response*)rData.pData);
+            }
         }
     }
 
@@ -9459,6 +9944,7 @@ void CTE::PostSetLocationUpdates(POST_CMD_HANDLER_DATA& rData)
     {
         m_enableLocationUpdates =
                 (m_enableLocationUpdates > 0) ? m_enableLocationUpdates : 0;
+        InvalidateCachedLocation();
     }
 
     RIL_LOG_VERBOSE("CTE::PostSetLocationUpdates() Exit\r\n");
@@ -10150,9 +10636,10 @@ const char* CTE::GetSignalStrengthReportingString()
     return m_pTEBaseInstance->GetSignalStrengthReportingString();
 }
 
-RIL_SignalStrength_v6* CTE::ParseXCESQ(const char*& rszPointer, const BOOL bUnsolicited)
+BOOL CTE::ParseXCESQ(const char*& rszPointer, const BOOL bUnsolicited,
+        RIL_SignalStrength_v6& rSigStrData)
 {
-    return m_pTEBaseInstance->ParseXCESQ(rszPointer, bUnsolicited);
+    return m_pTEBaseInstance->ParseXCESQ(rszPointer, bUnsolicited, rSigStrData);
 }
 
 void CTE::QueryUiccInfo()
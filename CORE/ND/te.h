@@ -635,17 +635,32 @@ public:
     RIL_RESULT_CODE ParseReadBearerQOSParams(RESPONSE_DATA& rRspData);
 
     void CopyCachedRegistrationInfo(void* pRegStruct, BOOL bPSStatus);
+
+    // Returns FALSE if the cached registration status cannot answer the request
+    BOOL GetCachedRegistrationInfo(void* pRegStruct, BOOL bPSStatus);
     void ResetRegistrationCache();
 
+    // Called when the location reporting of the registration URCs changes, the
+    // cached locations are used again once reported under the new mode
+    void InvalidateCachedLocation();
+
     // REQ_ID_QUERY_SIM_SMS_STORE_STATUS
     RIL_RESULT_CODE ParseQuerySimSmsStoreStatus(RESPONSE_DATA& rRspData);
 
     void SetIncomingCallStatus(UINT32 uiCallId, UINT32 uiStatus);
     UINT32 GetIncomingCallId();
 
-    void SetupDataCallOngoing(BOOL bStatus);
+    // Track the setup data calls per context ID, several can be ongoing on their
+    // own data channels. A CID of 0 ends all of them.
+    void SetupDataCallOngoing(UINT32 uiCID, BOOL bStatus);
     BOOL IsSetupDataCallOnGoing();
 
+    // Multipart SMS. The relay link is kept open with AT+CMMS=2 from the first segment
+    // sent with RIL_REQUEST_SEND_SMS_EXPECT_MORE until the last one is sent, or until
+    // no segment followed for SMS_LINK_IDLE_TIMEOUT seconds.
+    BOOL IsSmsLinkKept() { return m_bSmsLinkKept; }
+    void CloseIdleSmsLink(UINT32 uiGeneration);
+
     BOOL IsLocationUpdatesEnabled();
 
     RIL_RadioState GetRadioState();
@@ -748,6 +763,11 @@ public:
          m_uiTimeoutThresholdForRetry = uiThresholdForRetry;
     }
     UINT32 GetTimeoutThresholdForRetry() { return m_uiTimeoutThresholdForRetry; };
+    void SetMaxPipelinedCommands(UINT32 uiMaxCommands)
+    {
+         m_uiMaxPipelinedCommands = uiMaxCommands;
+    }
+    UINT32 GetMaxPipelinedCommands() { return m_uiMaxPipelinedCommands; };
 
     BOOL IsSetupDataCallAllowed(int& retryTime);
 
@@ -1147,7 +1167,8 @@ public:
     // Returns the signal strength reporting string used to enable signal strength URC
     const char* GetSignalStrengthReportingString();
 
-    RIL_SignalStrength_v6* ParseXCESQ(const char*& rszPointer, const BOOL bUnsolicited);
+    BOOL ParseXCESQ(const char*& rszPointer, const BOOL bUnsolicited,
+            RIL_SignalStrength_v6& rSigStrData);
 
     // Resets the sim card status cache
     void ResetCardStatus(BOOL bForceReset);
@@ -1182,10 +1203,70 @@ private:
     S_ND_GPRS_REG_STATUS m_sPSStatus;
     S_ND_REG_STATUS m_sCSStatus;
     S_ND_GPRS_REG_STATUS m_sEPSStatus;
+
+    enum { E_REG_STATUS_CS, E_REG_STATUS_PS, E_REG_STATUS_EPS, E_REG_STATUS_MAX };
+
+    /*
+     * The registration status above is written under m_pRegStatusLock by the threads
+     * parsing the registration URCs and responses, and read without lock by the
+     * requests: m_uiRegStatusVersion is odd while it is being written.
+     */
+    CMutex* m_pRegStatusLock;
+    volatile UINT32 m_uiRegStatusVersion;
+
+    // Location reporting epoch, and epoch in which each status was last stored with
+    // a location (0 if it was stored without)
+    UINT32 m_uiLocationEpoch;
+    UINT32 m_rguiLocationEpoch[E_REG_STATUS_MAX];
+
+    // Time each status was last stored, see GetLocationMaxAge()
+    UINT32 m_rguiStatusTime[E_REG_STATUS_MAX];
+
+    struct REG_STATUS_SNAPSHOT
+    {
+        BOOL bCSStatusCached;
+        BOOL bPSStatusCached;
+        S_ND_REG_STATUS sCSStatus;
+        S_ND_GPRS_REG_STATUS sPSStatus;
+        S_ND_GPRS_REG_STATUS sEPSStatus;
+        BOOL rgbLocationValid[E_REG_STATUS_MAX];
+        UINT32 rguiStatusTime[E_REG_STATUS_MAX];
+    };
+
+    void BeginRegStatusWrite();
+    void EndRegStatusWrite();
+    void ReadRegStatus(REG_STATUS_SNAPSHOT& rSnapshot);
+    BOOL IsEPSStatusUsed(const REG_STATUS_SNAPSHOT& rSnapshot);
+    static UINT32 GetLocationMaxAge(LONG regState, LONG act);
+    void CopyRegistrationInfo(const REG_STATUS_SNAPSHOT& snapshot, void* pRegStruct,
+            BOOL bPSStatus);
+
     CellInfoCache m_CellInfoCache;
 
-    // Flag used to store setup data call status
-    BOOL m_bIsSetupDataCallOngoing;
+    enum { MAX_NETWORK_SEARCH_WAITERS = 4 };
+
+    void ReleaseNetworkSearchWaiters();
+
+    // Context IDs with a setup data call ongoing, one bit per CID. Manual network
+    // searches received meanwhile wait for the last one to complete.
+    CMutex* m_pSetupDataCallLock;
+    UINT32 m_uiSetupDataCallCids;
+    RIL_Token m_rgNetworkSearchWaiters[MAX_NETWORK_SEARCH_WAITERS];
+    UINT32 m_uiNetworkSearchWaiters;
+
+    enum { SMS_LINK_IDLE_TIMEOUT = 10 };   // seconds, longer than a framework retry
+
+    void CloseSmsLink();
+
+    // Multipart SMS, see IsSmsLinkKept(). The framework sends the segments one at a
+    // time, the lock is for the idle timer.
+    CMutex* m_pSmsSendLock;
+    BOOL m_bSmsLinkKept;
+    UINT32 m_uiSmsSegment;              // segments requested of the message, 0 if none
+    UINT32 m_uiSmsMessageGeneration;    // bumped each time a message ends, keys the idle timer
+    UINT32 m_uiSmsMessageStartTime;
+    UINT32 m_uiSmsSegmentStartTime;
+    UINT32 m_uiSmsModemTime;            // time spent sending the segments of the message
 
     // Flag used to store spoof commands status
     BOOL m_bSpoofCommandsStatus;
@@ -1286,10 +1367,12 @@ private:
     static const UINT32 TIMEOUT_API_DEFAULT            = 10000;
     static const UINT32 TIMEOUT_WAITFORINIT            = 10000;
     static const UINT32 TIMEOUT_THRESHOLDFORRETRY      = 10000;
+    static const UINT32 MAX_PIPELINED_COMMANDS_DEFAULT = 1;   // no pipelining
     UINT32 m_uiTimeoutCmdInit;
     UINT32 m_uiTimeoutAPIDefault;
     UINT32 m_uiTimeoutWaitForInit;
     UINT32 m_uiTimeoutThresholdForRetry;
+    UINT32 m_uiMaxPipelinedCommands;
 
     UINT32 m_uiDtmfState;
     CMutex* m_pDtmfStateAccess;
@@ -34,6 +34,8 @@
 #include <cutils/properties.h>
 #include "ril_result.h"
 #include "initializer.h"
+#include "signal_filter.h"
+#include "netlink_ifconfig.h"
 
 #define AT_MAXARGS 20
 #define WAIT_TIMEOUT_DTMF_STOP 20000
@@ -2783,8 +2785,10 @@ RIL_RESULT_CODE CTEBase::CoreSendSmsExpectMore(REQUEST_DATA& rReqData,
         szSMSAddress = szNoAddress;
     }
 
+    // The relay link is kept open until the last segment is sent with AT+CMGS,
+    // the following segments do not need to set it again.
     if (!PrintStringNullTerminate(rReqData.szCmd1, sizeof(rReqData.szCmd1),
-            "AT+CMMS=1;+CMGS=%u\r", nPDULength))
+            m_cte.IsSmsLinkKept() ? "AT+CMGS=%u\r" : "AT+CMMS=2;+CMGS=%u\r", nPDULength))
     {
         RIL_LOG_CRITICAL("CTEBase::CoreSendSmsExpectMore() - Cannot create CMGS command\r\n");
         goto Error;
@@ -10039,8 +10043,8 @@ RIL_RESULT_CODE CTEBase::ParseUnsolicitedSignalStrength(RESPONSE_DATA& rRspData)
 
     res = RRIL_RESULT_OK;
 
-    RIL_onUnsolicitedResponse(RIL_UNSOL_SIGNAL_STRENGTH, (void*)pSigStrData,
-            sizeof(RIL_SignalStrength_v6));
+    // queried to refresh the framework, reported whatever the last report was
+    CSignalStrengthFilter::OnSignalStrength(*pSigStrData, TRUE);
 
 Error:
     free(pSigStrData);
@@ -10736,7 +10740,7 @@ void CTEBase::HandleSetupDataCallSuccess(UINT32 uiCID, void* pRilToken)
     dataCallResp.status = PDP_FAIL_ERROR_UNSPECIFIED;
     dataCallResp.suggestedRetryTime = -1;
 
-    m_cte.SetupDataCallOngoing(FALSE);
+    m_cte.SetupDataCallOngoing(uiCID, FALSE);
 
     pChannelData = CChannel_Data::GetChnlFromContextID(uiCID);
     if (NULL == pChannelData)
@@ -10820,7 +10824,7 @@ void CTEBase::HandleSetupDataCallFailure(UINT32 uiCID, void* pRilToken, UINT32 u
     int state;
     int failCause = PDP_FAIL_ERROR_UNSPECIFIED;
 
-    m_cte.SetupDataCallOngoing(FALSE);
+    m_cte.SetupDataCallOngoing(uiCID, FALSE);
 
     CChannel_Data* pChannelData = CChannel_Data::GetChnlFromContextID(uiCID);
     if (NULL == pChannelData)
@@ -10846,7 +10850,7 @@ void CTEBase::HandleSetupDataCallFailure(UINT32 uiCID, void* pRilToken, UINT32 u
              * @TODO: Delay the completion of ril request till the
              * data call is deactivated successfully?
              */
-            RIL_requestTimedCallback(triggerDeactivateDataCall, (void*)uiCID, 0, 0);
+            RIL_requestTimerCallback(triggerDeactivateDataCall, (void*)uiCID, 0, 0, TRUE);
             break;
         default:
             DataConfigDown(uiCID);
@@ -10909,7 +10913,6 @@ BOOL CTEBase::DataConfigUp(char* pszNetworkInterfaceName, CChannel_Data* pChanne
 BOOL CTEBase::DataConfigUpIpV4(char* pszNetworkInterfaceName, CChannel_Data* pChannelData)
 {
     BOOL bRet = FALSE;
-    int s = -1;
     char szIpAddr[MAX_BUFFER_SIZE] = {'\0'};
     char szGatewayAddr[MAX_IPADDR_SIZE] = {'\0'};
 
@@ -10925,43 +10928,19 @@ BOOL CTEBase::DataConfigUpIpV4(char* pszNetworkInterfaceName, CChannel_Data* pCh
             "  szIpAddr=[%s]\r\n",
             pszNetworkInterfaceName, szIpAddr);
 
-    //  Open socket for ifconfig command
-    s = socket(AF_INET, SOCK_DGRAM, 0);
-    if (s < 0)
+    //  ifconfig rmnetX <ip address> mtu <mtu> up
+    //  The /32 prefix is the one SIOCSIFADDR gives on a point to point interface.
     {
-        RIL_LOG_CRITICAL("CTEBase::DataConfigUpIpV4() : cannot open control socket\n");
-        goto Error;
-    }
-
-    //  Code in this function is from system/core/toolbox/ifconfig.c
-    //  also from system/core/toolbox/route.c
-
-    //  ifconfig rmnetX <ip address>
-    {
-        struct ifreq ifr;
-        memset(&ifr, 0, sizeof(struct ifreq));
-        strncpy(ifr.ifr_name, pszNetworkInterfaceName, IFNAMSIZ-1);
-        ifr.ifr_name[IFNAMSIZ-1] = '\0';  //  KW fix
-
-        RIL_LOG_INFO("CTEBase::DataConfigUpIpV4() : Setting flags\r\n");
-        if (!setflags(s, &ifr, IFF_UP | IFF_POINTOPOINT | IFF_NOARP, 0))
-        {
-            //goto Error;
-            RIL_LOG_CRITICAL("CTEBase::DataConfigUpIpV4() : Error setting flags\r\n");
-        }
+        CNetlinkIfConfig ifConfig(pszNetworkInterfaceName);
 
-        RIL_LOG_INFO("CTEBase::DataConfigUpIpV4() : Setting addr\r\n");
-        if (!setaddr(s, &ifr, szIpAddr)) // ipaddr
+        RIL_LOG_INFO("CTEBase::DataConfigUpIpV4() : Setting flags, mtu and addr\r\n");
+        ifConfig.SetLink(IFF_UP | IFF_POINTOPOINT | IFF_NOARP, 0);
+        ifConfig.SetMtu(CTE::GetTE().GetMTU());
+        ifConfig.AddAddress(AF_INET, szIpAddr, 32);
+        if (!ifConfig.Commit())
         {
             //goto Error;
-            RIL_LOG_CRITICAL("CTEBase::DataConfigUpIpV4() : Error setting addr\r\n");
-        }
-
-        RIL_LOG_INFO("CTEBase::DataConfigUpIpV4() : Setting mtu\r\n");
-        if (!setmtu(s, &ifr))
-        {
-            //goto Error;
-            RIL_LOG_CRITICAL("CTEBase::DataConfigUpIpV4() : Error setting mtu\r\n");
+            RIL_LOG_CRITICAL("CTEBase::DataConfigUpIpV4() : Error configuring interface\r\n");
         }
     }
 
@@ -10988,11 +10967,6 @@ BOOL CTEBase::DataConfigUpIpV4(char* pszNetworkInterfaceName, CChannel_Data* pCh
     bRet = TRUE;
 
 Error:
-    if (s >= 0)
-    {
-        close(s);
-    }
-
     RIL_LOG_INFO("CTEBase::DataConfigUpIpV4() EXIT  bRet=[%d]\r\n", bRet);
     return bRet;
 }
@@ -11000,7 +10974,6 @@ Error:
 BOOL CTEBase::DataConfigUpIpV6(char* pszNetworkInterfaceName, CChannel_Data* pChannelData)
 {
     BOOL bRet = FALSE;
-    int s = -1;
     char szIpAddr2[MAX_IPADDR_SIZE] = {'\0'};
     char szIpAddrOut[50];
     struct in6_addr ifIdAddr;
@@ -11019,19 +10992,6 @@ BOOL CTEBase::DataConfigUpIpV6(char* pszNetworkInterfaceName, CChannel_Data* pCh
             "  szIpAddr2=[%s]\r\n",
             pszNetworkInterfaceName, szIpAddr2);
 
-    //  Open socket for ifconfig command (note this is ipv6 socket)
-    s = socket(AF_INET6, SOCK_DGRAM, 0);
-    if (s < 0)
-    {
-        RIL_LOG_CRITICAL("CTEBase::DataConfigUpIpV6() : cannot open control socket\n");
-        goto Error;
-    }
-
-    struct ifreq ifr;
-    memset(&ifr, 0, sizeof(struct ifreq));
-    strncpy(ifr.ifr_name, pszNetworkInterfaceName, IFNAMSIZ-1);
-    ifr.ifr_name[IFNAMSIZ-1] = '\0';  //  KW fix
-
     inet_pton(AF_INET6, szIpAddr2, &ifIdAddr);
     inet_pton(AF_INET6, "FE80::", &ifPrefixAddr);
 
@@ -11044,26 +11004,19 @@ BOOL CTEBase::DataConfigUpIpV6(char* pszNetworkInterfaceName, CChannel_Data* pCh
     inet_ntop(AF_INET6, &ifOutAddr, szIpAddrOut, sizeof(szIpAddrOut));
     strncpy(szIpAddr2, szIpAddrOut, sizeof(szIpAddrOut));
 
-    RIL_LOG_INFO("CTEBase::DataConfigUpIpV6() : Setting flags\r\n");
-    if (!setflags(s, &ifr, IFF_UP | IFF_POINTOPOINT | IFF_NOARP, 0))
+    RIL_LOG_INFO("CTEBase::DataConfigUpIpV6() : Setting flags, mtu and addr :%s\r\n",
+            szIpAddr2);
     {
-        //goto Error;
-        RIL_LOG_CRITICAL("CTEBase::DataConfigUpIpV6(): Error setting flags\r\n");
-    }
-
-    RIL_LOG_INFO("CTEBase::DataConfigUpIpV6() : Setting addr :%s\r\n",szIpAddr2);
-    if (!setaddr6(s, &ifr, szIpAddr2))
-    {
-        //goto Error;
-        RIL_LOG_CRITICAL("CTEBase::DataConfigUpIpV6() : Error setting addr %s\r\n",
-                                                                szIpAddr2);
-    }
+        CNetlinkIfConfig ifConfig(pszNetworkInterfaceName);
 
-    RIL_LOG_INFO("CTEBase::DataConfigUpV6() : Setting mtu\r\n");
-    if (!setmtu(s, &ifr))
-    {
-        //goto Error;
-        RIL_LOG_CRITICAL("CTEBase::DataConfigUpV6() : Error setting mtu\r\n");
+        ifConfig.SetLink(IFF_UP | IFF_POINTOPOINT | IFF_NOARP, 0);
+        ifConfig.SetMtu(CTE::GetTE().GetMTU());
+        ifConfig.AddAddress(AF_INET6, szIpAddr2, 64);
+        if (!ifConfig.Commit())
+        {
+            //goto Error;
+            RIL_LOG_CRITICAL("CTEBase::DataConfigUpIpV6() : Error configuring interface\r\n");
+        }
     }
 
     //  Before setting interface UP, need to deactivate DAD on interface.
@@ -11131,11 +11084,6 @@ BOOL CTEBase::DataConfigUpIpV6(char* pszNetworkInterfaceName, CChannel_Data* pCh
     bRet = TRUE;
 
 Error:
-    if (s >= 0)
-    {
-        close(s);
-    }
-
     RIL_LOG_INFO("CTEBase::DataConfigUpIpV6() EXIT  bRet=[%d]\r\n", bRet);
     return bRet;
 }
@@ -11144,8 +11092,6 @@ BOOL CTEBase::DataConfigUpIpV4V6(char* pszNetworkInterfaceName,
                                             CChannel_Data* pChannelData)
 {
     BOOL bRet = FALSE;
-    int s = -1;
-    int s6 =-1;
     char szIpAddrOut[50];
     struct in6_addr ifIdAddr;
     struct in6_addr ifPrefixAddr;
@@ -11166,31 +11112,6 @@ BOOL CTEBase::DataConfigUpIpV4V6(char* pszNetworkInterfaceName,
             " szIpAddr2=[%s]\r\n",
             pszNetworkInterfaceName, szIpAddr, szIpAddr2);
 
-    //  Open socket for ifconfig and setFlags commands
-    s = socket(AF_INET, SOCK_DGRAM, 0);
-    s6 = socket(AF_INET6, SOCK_DGRAM, 0);
-    if (s < 0 || s6 < 0)
-    {
-        RIL_LOG_CRITICAL("CTEBase::DataConfigUpIpV4V6() : cannot open control socket\n");
-        goto Error;
-    }
-
-    struct ifreq ifr;
-    memset(&ifr, 0, sizeof(struct ifreq));
-    strncpy(ifr.ifr_name, pszNetworkInterfaceName, IFNAMSIZ-1);
-    ifr.ifr_name[IFNAMSIZ-1] = '\0';  //  KW fix
-
-    RIL_LOG_INFO("CTEBase::DataConfigUpIpV4V6() : Setting addr\r\n");
-    if (!setaddr(s, &ifr, szIpAddr))
-    {
-        //goto Error;
-        RIL_LOG_CRITICAL("CTEBase::DataConfigUpIpV4V6() : Error setting add\r\n");
-    }
-
-    memset(&ifr, 0, sizeof(struct ifreq));
-    strncpy(ifr.ifr_name, pszNetworkInterfaceName, IFNAMSIZ-1);
-    ifr.ifr_name[IFNAMSIZ-1] = '\0';  //  KW fix
-
     // Set link local address to start the SLAAC process
     inet_pton(AF_INET6, szIpAddr2, &ifIdAddr);
     inet_pton(AF_INET6, "FE80::", &ifPrefixAddr);
@@ -11203,21 +11124,18 @@ BOOL CTEBase::DataConfigUpIpV4V6(char* pszNetworkInterfaceName,
     inet_ntop(AF_INET6, &ifOutAddr, szIpAddrOut, sizeof(szIpAddrOut));
     strncpy(szIpAddr2, szIpAddrOut, sizeof(szIpAddrOut));
 
-    RIL_LOG_INFO("CTEBase::DataConfigUpIpV4V6() : Setting flags\r\n");
-    if (!setflags(s, &ifr, IFF_UP | IFF_POINTOPOINT | IFF_NOARP, 0))
-    {
-        RIL_LOG_CRITICAL("CTEBase::DataConfigUpIpV4V6() : Error setting flags\r\n");
-    }
-
-    if (!setaddr6(s6, &ifr, szIpAddr2))
+    RIL_LOG_INFO("CTEBase::DataConfigUpIpV4V6() : Setting flags, mtu and addrs\r\n");
     {
-        RIL_LOG_CRITICAL("CTEBase::DataConfigUpIpV4V6() : Error setting add\r\n");
-    }
+        CNetlinkIfConfig ifConfig(pszNetworkInterfaceName);
 
-    RIL_LOG_INFO("CTEBase::DataConfigUpV4V6() : Setting mtu\r\n");
-    if (!setmtu(s, &ifr))
-    {
-        RIL_LOG_CRITICAL("CTEBase::DataConfigUpV4V6() : Error setting mtu\r\n");
+        ifConfig.SetLink(IFF_UP | IFF_POINTOPOINT | IFF_NOARP, 0);
+        ifConfig.SetMtu(CTE::GetTE().GetMTU());
+        ifConfig.AddAddress(AF_INET, szIpAddr, 32);
+        ifConfig.AddAddress(AF_INET6, szIpAddr2, 64);
+        if (!ifConfig.Commit())
+        {
+            RIL_LOG_CRITICAL("CTEBase::DataConfigUpIpV4V6() : Error configuring interface\r\n");
+        }
     }
 
     //  Before setting interface UP, need to deactivate DAD on interface.
@@ -11303,16 +11221,6 @@ BOOL CTEBase::DataConfigUpIpV4V6(char* pszNetworkInterfaceName,
     bRet = TRUE;
 
 Error:
-    if (s >= 0)
-    {
-        close(s);
-    }
-
-    if (s6 >= 0)
-    {
-        close(s6);
-    }
-
     RIL_LOG_INFO("CTEBase::DataConfigUpIpV4V6() EXIT  bRet=[%d]\r\n", bRet);
     return bRet;
 }
@@ -11765,9 +11673,10 @@ void CTEBase::QuerySignalStrength()
     }
 }
 
-RIL_SignalStrength_v6* CTEBase::ParseXCESQ(const char*& /*rszPointer*/, const BOOL /*bUnsolicited*/)
+BOOL CTEBase::ParseXCESQ(const char*& /*rszPointer*/, const BOOL /*bUnsolicited*/,
+        RIL_SignalStrength_v6& /*rSigStrData*/)
 {
-    return NULL;
+    return FALSE;
 }
 
 void CTEBase::QueryUiccInfo()
@@ -35,6 +35,7 @@
 #include "te.h"
 #include "util.h"
 #include "data_util.h"
+#include "netlink_ifconfig.h"
 
 extern char* g_szDataPort1;
 extern char* g_szDataPort2;
@@ -58,6 +59,11 @@ extern int m_dataProfilePathAssignation[NUMBER_OF_APN_PROFILE];
 // used by 6360 and 7160 modems.
 UINT32 g_uiHSIChannel[RIL_MAX_NUM_IPC_CHANNEL] = {0};
 
+CChannel_Data* volatile CChannel_Data::m_rgpChannelByCID[E_MAX_CID + 1];
+CChannel_Data::IFNAME_SLOT CChannel_Data::m_rgIfNameIndex[E_IFNAME_SLOTS];
+volatile UINT32 CChannel_Data::m_uiIfNameSequence = 0;
+UINT32 CChannel_Data::m_uiFreeChannels = 0;
+
 CChannel_Data::CChannel_Data(UINT32 uiChannel)
 :   CChannel(uiChannel),
     m_dataFailCause(PDP_FAIL_NONE),
@@ -81,6 +87,21 @@ CChannel_Data::~CChannel_Data()
 {
     RIL_LOG_VERBOSE("CChannel_Data::~CChannel_Data() - Enter\r\n");
 
+    CMutex* pLock = CSystemManager::GetInstance().GetDataChannelAccessorMutex();
+
+    // the lock is gone if the system manager is deleted first
+    if (NULL != pLock)
+    {
+        CMutex::Lock(pLock);
+    }
+
+    RemoveFromIndex();
+
+    if (NULL != pLock)
+    {
+        CMutex::Unlock(pLock);
+    }
+
     delete[] m_paInitCmdStrings;
     m_paInitCmdStrings = NULL;
 
@@ -196,30 +217,40 @@ CChannel_Data* CChannel_Data::GetChnlFromIfName(const char * ifName)
 {
     RIL_LOG_VERBOSE("CChannel_Data::GetChnlFromIfName() - Enter\r\n");
 
-    CMutex::Lock(CSystemManager::GetInstance().GetDataChannelAccessorMutex());
-
-    extern CChannel* g_pRilChannel[RIL_CHANNEL_MAX];
     CChannel_Data* pChannelData = NULL;
+    UINT32 uiSequence;
 
-    for (UINT32 i = RIL_CHANNEL_DATA1; i < g_uiRilChannelCurMax && i < RIL_CHANNEL_MAX; i++)
+    if (NULL == ifName || '\0' == ifName[0])
     {
-        if (NULL == g_pRilChannel[i]) // could be NULL if reserved channel
-            continue;
+        goto Error;
+    }
 
-        CChannel_Data* pTemp = static_cast<CChannel_Data*>(g_pRilChannel[i]);
-        if (pTemp)
+    // Retry if the interface names were written while they were read
+    do
+    {
+        uiSequence = m_uiIfNameSequence;
+        __sync_synchronize();
+
+        pChannelData = NULL;
+        if (0 == (uiSequence & 1))
         {
-            char szTempName[MAX_INTERFACE_NAME_SIZE];
-            pTemp->GetInterfaceName(szTempName, MAX_INTERFACE_NAME_SIZE);
-            if (!strncmp(szTempName, ifName, MAX_INTERFACE_NAME_SIZE)) {
-                pChannelData = pTemp;
-                break;
+            for (UINT32 uiSlot = GetIfNameSlot(ifName);
+                    NULL != m_rgIfNameIndex[uiSlot].pChannel;
+                    uiSlot = (uiSlot + 1) & (E_IFNAME_SLOTS - 1))
+            {
+                if (0 == strncmp(m_rgIfNameIndex[uiSlot].szInterfaceName, ifName,
+                        MAX_INTERFACE_NAME_SIZE))
+                {
+                    pChannelData = m_rgIfNameIndex[uiSlot].pChannel;
+                    break;
+                }
             }
         }
-    }
 
-    CMutex::Unlock(CSystemManager::GetInstance().GetDataChannelAccessorMutex());
+        __sync_synchronize();
+    } while ((uiSequence & 1) || uiSequence != m_uiIfNameSequence);
 
+Error:
     RIL_LOG_VERBOSE("CChannel_Data::GetChnlFromIfName() - Exit\r\n");
     return pChannelData;
 }
@@ -231,27 +262,13 @@ CChannel_Data* CChannel_Data::GetChnlFromContextID(UINT32 uiContextID)
 {
     RIL_LOG_VERBOSE("CChannel_Data::GetChnlFromContextID() - Enter\r\n");
 
-    CMutex::Lock(CSystemManager::GetInstance().GetDataChannelAccessorMutex());
-
-    extern CChannel* g_pRilChannel[RIL_CHANNEL_MAX];
     CChannel_Data* pChannelData = NULL;
 
-    for (UINT32 i = RIL_CHANNEL_DATA1; i < g_uiRilChannelCurMax && i < RIL_CHANNEL_MAX; i++)
+    if (0 < uiContextID && uiContextID <= E_MAX_CID)
     {
-        if (NULL == g_pRilChannel[i]) // could be NULL if reserved channel
-            continue;
-
-        CChannel_Data* pTemp = static_cast<CChannel_Data*>(g_pRilChannel[i]);
-        if (pTemp && pTemp->GetContextID() == uiContextID)
-        {
-            pChannelData = pTemp;
-            break;
-        }
+        pChannelData = m_rgpChannelByCID[uiContextID];
     }
 
-Error:
-    CMutex::Unlock(CSystemManager::GetInstance().GetDataChannelAccessorMutex());
-
     RIL_LOG_VERBOSE("CChannel_Data::GetChnlFromContextID() - Exit\r\n");
     return pChannelData;
 }
@@ -361,6 +378,7 @@ int CChannel_Data::GetFreeHSIChannel(UINT32 uiCID, int sIndex, int eIndex)
     if (sIndex < 0 || eIndex > RIL_MAX_NUM_IPC_CHANNEL)
     {
         RIL_LOG_VERBOSE("CChannel_Data::GetFreeHSIChannel() - Index error\r\n");
+        CMutex::Unlock(CSystemManager::GetInstance().GetDataChannelAccessorMutex());
         return -1;
     }
 
@@ -425,26 +443,26 @@ CChannel_Data* CChannel_Data::GetFreeChnl(UINT32& outCID)
     extern CChannel* g_pRilChannel[RIL_CHANNEL_MAX];
     CChannel_Data* pChannelData = NULL;
 
-    for (UINT32 i = RIL_CHANNEL_DATA1; i < g_uiRilChannelCurMax && i < RIL_CHANNEL_MAX; i++)
+    UINT32 uiFree = m_uiFreeChannels;
+
+    while (0 != uiFree)
     {
-        if (NULL == g_pRilChannel[i]) // could be NULL if reserved channel
+        UINT32 i = RIL_CHANNEL_DATA1 + __builtin_ctz(uiFree);
+
+        uiFree &= uiFree - 1;
+        if (NULL == g_pRilChannel[i]) // not created yet
             continue;
 
-        CChannel_Data* pTemp = static_cast<CChannel_Data*>(g_pRilChannel[i]);
-        if (pTemp && pTemp->GetContextID() == 0)
-        {
-            //  We found a free data channel.
-            pChannelData = pTemp;
-            outCID = (i - RIL_CHANNEL_DATA1) + 1;
+        //  We found a free data channel.
+        pChannelData = static_cast<CChannel_Data*>(g_pRilChannel[i]);
+        outCID = (i - RIL_CHANNEL_DATA1) + 1;
 
-            RIL_LOG_INFO("CChannel_Data::GetFreeChnl() - ****** Setting chnl=[%d] to CID=[%d]"
-                    " ******\r\n", i, outCID);
-            pChannelData->SetContextID(outCID);
-            break;
-        }
+        RIL_LOG_INFO("CChannel_Data::GetFreeChnl() - ****** Setting chnl=[%d] to CID=[%d]"
+                " ******\r\n", i, outCID);
+        pChannelData->SetContextID(outCID);
+        break;
     }
 
-Error:
     if (NULL == pChannelData)
     {
         // Error, all channels full!
@@ -465,45 +483,23 @@ CChannel_Data* CChannel_Data::GetChnlFromRilChannelNumber(UINT32 index)
 {
     RIL_LOG_VERBOSE("CChannel_Data::GetChnlFromRilChannelNumber() - Enter\r\n");
 
-    CMutex::Lock(CSystemManager::GetInstance().GetDataChannelAccessorMutex());
-
     extern CChannel* g_pRilChannel[RIL_CHANNEL_MAX];
     CChannel_Data* pChannelData = NULL;
 
-    for (UINT32 i = RIL_CHANNEL_DATA1; i < g_uiRilChannelCurMax && i < RIL_CHANNEL_MAX; i++)
+    // could be NULL if reserved channel
+    if (RIL_CHANNEL_DATA1 <= index && index < g_uiRilChannelCurMax && index < RIL_CHANNEL_MAX)
     {
-        if (NULL == g_pRilChannel[i]) // could be NULL if reserved channel
-            continue;
-
-        CChannel_Data* pTemp = static_cast<CChannel_Data*>(g_pRilChannel[i]);
-        if (pTemp && pTemp->GetRilChannel() == index)
-        {
-            pChannelData = pTemp;
-            break;
-        }
+        pChannelData = static_cast<CChannel_Data*>(g_pRilChannel[index]);
     }
 
-Error:
-    CMutex::Unlock(CSystemManager::GetInstance().GetDataChannelAccessorMutex());
-
     RIL_LOG_VERBOSE("CChannel_Data::GetChnlFromRilChannelNumber() - Exit\r\n");
     return pChannelData;
 }
 
-
-
 UINT32 CChannel_Data::GetContextID() const
 {
-    RIL_LOG_VERBOSE("CChannel_Data::GetContextID() - Enter\r\n");
-
-    CMutex::Lock(CSystemManager::GetInstance().GetDataChannelAccessorMutex());
-
-    UINT32 nCID = m_uiContextID;
-
-    CMutex::Unlock(CSystemManager::GetInstance().GetDataChannelAccessorMutex());
-
-    RIL_LOG_VERBOSE("CChannel_Data::GetContextID() - Exit\r\n");
-    return nCID;
+    // read without the lock, the context ID is only written with it held
+    return m_uiContextID;
 }
 
 
@@ -516,6 +512,7 @@ BOOL CChannel_Data::SetContextID(UINT32 dwContextID)
 
     CMutex::Lock(CSystemManager::GetInstance().GetDataChannelAccessorMutex());
 
+    UpdateIndex(dwContextID);
     m_uiContextID = dwContextID;
 
     CMutex::Unlock(CSystemManager::GetInstance().GetDataChannelAccessorMutex());
@@ -524,6 +521,105 @@ BOOL CChannel_Data::SetContextID(UINT32 dwContextID)
     return TRUE;
 }
 
+//
+//  Moves this channel to its new context ID in the index. Called with the data channel
+//  accessor mutex held, before m_uiContextID is changed.
+//
+void CChannel_Data::UpdateIndex(UINT32 uiNewCID)
+{
+    UINT32 uiBit = 1U << (m_uiRilChannel - RIL_CHANNEL_DATA1);
+
+    if (0 < m_uiContextID && m_uiContextID <= E_MAX_CID
+            && this == m_rgpChannelByCID[m_uiContextID])
+    {
+        m_rgpChannelByCID[m_uiContextID] = NULL;
+    }
+
+    if (0 == uiNewCID)
+    {
+        m_uiFreeChannels |= uiBit;
+    }
+    else
+    {
+        m_uiFreeChannels &= ~uiBit;
+
+        if (uiNewCID <= E_MAX_CID)
+        {
+            m_rgpChannelByCID[uiNewCID] = this;
+        }
+        else
+        {
+            RIL_LOG_CRITICAL("CChannel_Data::UpdateIndex() - chnl=[%u] CID=[%u] cannot be"
+                    " looked up\r\n", m_uiRilChannel, uiNewCID);
+        }
+    }
+}
+
+//
+//  Removes this channel from the index when it is deleted
+//
+void CChannel_Data::RemoveFromIndex()
+{
+    if (0 < m_uiContextID && m_uiContextID <= E_MAX_CID
+            && this == m_rgpChannelByCID[m_uiContextID])
+    {
+        m_rgpChannelByCID[m_uiContextID] = NULL;
+    }
+
+    m_uiFreeChannels &= ~(1U << (m_uiRilChannel - RIL_CHANNEL_DATA1));
+
+    m_szInterfaceName[0] = '\0';
+    RebuildIfNameIndex();
+}
+
+//
+//  Rewrites the interface names of the index from the data channels. Called with the data
+//  channel accessor mutex held when a name changes, there are too few of them to bother
+//  removing one from the open addressing.
+//
+void CChannel_Data::RebuildIfNameIndex()
+{
+    extern CChannel* g_pRilChannel[RIL_CHANNEL_MAX];
+
+    m_uiIfNameSequence++;
+    __sync_synchronize();
+
+    memset(m_rgIfNameIndex, 0, sizeof(m_rgIfNameIndex));
+
+    for (UINT32 i = RIL_CHANNEL_DATA1; i < g_uiRilChannelCurMax && i < RIL_CHANNEL_MAX; i++)
+    {
+        CChannel_Data* pTemp = static_cast<CChannel_Data*>(g_pRilChannel[i]);
+        if (NULL == pTemp || '\0' == pTemp->m_szInterfaceName[0])
+            continue;
+
+        UINT32 uiSlot = GetIfNameSlot(pTemp->m_szInterfaceName);
+        while (NULL != m_rgIfNameIndex[uiSlot].pChannel)
+        {
+            uiSlot = (uiSlot + 1) & (E_IFNAME_SLOTS - 1);
+        }
+
+        CopyStringNullTerminate(m_rgIfNameIndex[uiSlot].szInterfaceName,
+                pTemp->m_szInterfaceName, MAX_INTERFACE_NAME_SIZE);
+        m_rgIfNameIndex[uiSlot].pChannel = pTemp;
+    }
+
+    __sync_synchronize();
+    m_uiIfNameSequence++;
+}
+
+UINT32 CChannel_Data::GetIfNameSlot(const char* pszInterfaceName)
+{
+    // FNV-1a
+    UINT32 uiHash = 2166136261U;
+
+    for (UINT32 i = 0; i < MAX_INTERFACE_NAME_SIZE && '\0' != pszInterfaceName[i]; i++)
+    {
+        uiHash = (uiHash ^ (UINT8)pszInterfaceName[i]) * 16777619U;
+    }
+
+    return uiHash & (E_IFNAME_SLOTS - 1);
+}
+
 void CChannel_Data::ResetDataCallInfo()
 {
     RIL_LOG_VERBOSE("CChannel_Data::ResetDataCallInfo() - Enter\r\n");
@@ -545,7 +641,7 @@ void CChannel_Data::ResetDataCallInfo()
     m_isRoutingEnabled = FALSE;
     m_szApn[0] = '\0';
     m_szPdpType[0] = '\0';
-    m_szInterfaceName[0] = '\0';
+    SetInterfaceName("");
     m_szIpAddr[0] = '\0';
     m_szIpAddr2[0] = '\0';
     m_szDNS1[0] = '\0';
@@ -640,8 +736,13 @@ void CChannel_Data::SetInterfaceName(const char* pInterfaceName)
 {
     RIL_LOG_VERBOSE("CChannel_Data::SetInterfaceName() - Enter\r\n");
 
+    CMutex::Lock(CSystemManager::GetInstance().GetDataChannelAccessorMutex());
+
     strncpy(m_szInterfaceName, pInterfaceName, MAX_INTERFACE_NAME_SIZE-1);
     m_szInterfaceName[MAX_INTERFACE_NAME_SIZE-1] = '\0';
+    RebuildIfNameIndex();
+
+    CMutex::Unlock(CSystemManager::GetInstance().GetDataChannelAccessorMutex());
 
     RIL_LOG_VERBOSE("CChannel_Data::SetInterfaceName() - Exit\r\n");
 }
@@ -954,7 +1055,6 @@ void CChannel_Data::RemoveInterface(BOOL bKeepInterfaceUp)
     struct gsm_netconfig netconfig;
     int fd = GetFD();
     int ret = -1;
-    int s = -1;
     UINT32 uiRilChannel = GetRilChannel();
     BOOL bIsHSIDirect = IsHSIDirect();
     int state = GetDataState();
@@ -1002,31 +1102,11 @@ void CChannel_Data::RemoveInterface(BOOL bKeepInterfaceUp)
          */
         RIL_LOG_INFO("CChannel_Data::RemoveInterface() : Bring down hsi network interface\r\n");
 
-        // Open socket for ifconfig and setFlags commands
-        s = socket(AF_INET, SOCK_DGRAM, 0);
-        if (s < 0)
-        {
-            RIL_LOG_CRITICAL("CChannel_Data::RemoveInterface() : cannot open control socket "
-                    "(error %d / '%s')\n", errno, strerror(errno));
-            goto Error;
-        }
+        CNetlinkIfConfig ifConfig(szNetworkInterfaceName);
 
-        struct ifreq ifr;
-        memset(&ifr, 0, sizeof(struct ifreq));
-        strncpy(ifr.ifr_name, szNetworkInterfaceName, IFNAMSIZ-1);
-        ifr.ifr_name[IFNAMSIZ-1] = '\0';
-
-        // set ipv4 address to 0.0.0.0 to unset ipv4 address,
-        // ipv6 addresses are automatically cleared
-        if (!setaddr(s, &ifr, "0.0.0.0"))
-        {
-            RIL_LOG_CRITICAL("CChannel_Data::RemoveInterface() : Error removing addr\r\n");
-        }
-
-        if (!setflags(s, &ifr, 0, IFF_UP))
-        {
-            RIL_LOG_CRITICAL("CChannel_Data::RemoveInterface() : Error setting flags\r\n");
-        }
+        // unset ipv4 address, ipv6 addresses are automatically cleared
+        ifConfig.DeleteIpV4Address();
+        ifConfig.SetLink(0, IFF_UP);
 
         if (bKeepInterfaceUp)
         {
@@ -1036,22 +1116,18 @@ void CChannel_Data::RemoveInterface(BOOL bKeepInterfaceUp)
              * Previous 'down' is needed to remove all 'manual' routes that might still use this
              * interface.
              */
-            if (!setflags(s, &ifr, IFF_UP, 0))
-            {
-                RIL_LOG_CRITICAL("CChannel_Data::RemoveInterface() : Error setting flags\r\n");
-            }
+            ifConfig.SetLink(IFF_UP, 0);
         }
 
-        if (close(s) < 0)
+        if (!ifConfig.Commit())
         {
-            RIL_LOG_CRITICAL("CChannel_Data::RemoveInterface() : could not close control socket "
-                    "(error %d / '%s')\n", errno, strerror(errno));
+            RIL_LOG_CRITICAL("CChannel_Data::RemoveInterface() : Error bringing down"
+                    " interface\r\n");
         }
     }
 
     RIL_LOG_INFO("[RIL STATE] PDP CONTEXT DEACTIVATION chnl=%u\r\n", uiRilChannel);
 
-Error:
     if (!bIsHSIDirect)
     {
         if (E_DATA_STATE_IDLE != state
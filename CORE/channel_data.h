@@ -94,6 +94,10 @@ public:
     //
     // helper functions to convert ContextID, Dlci and Channel
     //
+    // The lookups read an index of the data channels without taking the data channel
+    // accessor mutex, the index is updated when a context ID or an interface name is
+    // set.
+    //
     static CChannel_Data* GetChnlFromContextID(UINT32 dwContextID);
     static CChannel_Data* GetChnlFromIfName(const char * ifName);
     static CChannel_Data* GetChnlFromRilChannelNumber(UINT32 index);
@@ -131,8 +135,33 @@ public:
     int GetRefCount() { return m_refCount; }
 
 private:
+    enum
+    {
+        // The context ID is set to the data channel number, CID n is on the channel
+        // RIL_CHANNEL_DATA1 + n - 1
+        E_MAX_CID = RIL_CHANNEL_MAX - RIL_CHANNEL_DATA1,
+        E_IFNAME_SLOTS = 16                 // power of 2, more than the data channels
+    };
+
+    struct IFNAME_SLOT
+    {
+        char szInterfaceName[MAX_INTERFACE_NAME_SIZE];
+        CChannel_Data* pChannel;            // NULL if the slot is empty
+    };
+
+    // Called with the data channel accessor mutex held
+    void UpdateIndex(UINT32 uiNewCID);
+    void RemoveFromIndex();
+    static void RebuildIfNameIndex();
+    static UINT32 GetIfNameSlot(const char* pszInterfaceName);
+
+    static CChannel_Data* volatile m_rgpChannelByCID[E_MAX_CID + 1];
+    static IFNAME_SLOT m_rgIfNameIndex[E_IFNAME_SLOTS];
+    static volatile UINT32 m_uiIfNameSequence;  // odd while the interface names are written
+    static UINT32 m_uiFreeChannels;     // bit n set if RIL_CHANNEL_DATA1 + n has no context
+
     int m_dataFailCause;
-    UINT32 m_uiContextID;
+    volatile UINT32 m_uiContextID;
     int m_dataState;
 
     char m_szApn[MAX_BUFFER_SIZE];
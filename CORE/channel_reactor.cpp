@@ -0,0 +1,400 @@
+////////////////////////////////////////////////////////////////////////////
+// channel_reactor.cpp
+//
+// Copyright 2009 Intrinsyc Software International, Inc.  All rights reserved.
+// Patents pending in the United States of America and other jurisdictions.
+//
+//
+// Description:
+//    Implementation of the single thread reading all the channels.
+//
+//    Channel ports are watched with EPOLLONESHOT: once a channel is reported
+//    readable, it is read until its port is empty then watched again, unless
+//    its reading got blocked in the meantime (see CChannelBase::BlockReadThread).
+//    A port that hangs up or fails is no longer watched and a cleanup is
+//    requested, as the response thread does when its port gets closed.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+
+#include "types.h"
+#include "rillog.h"
+#include "sync_ops.h"
+#include "thread_ops.h"
+#include "thread_manager.h"
+#include "systemmanager.h"
+#include "reset.h"
+#include "te.h"
+#include "channelbase.h"
+#include "channel_reactor.h"
+
+// Time given to the reactor thread to exit once the last channel is removed
+static const UINT32 REACTOR_THREAD_EXIT_TIMEOUT = 15000;
+
+BOOL CChannelReactor::m_bEnabled = FALSE;
+CMutex* CChannelReactor::m_pLock = NULL;
+CThread* CChannelReactor::m_pThread = NULL;
+int CChannelReactor::m_iEpollFd = -1;
+UINT32 CChannelReactor::m_nChannels = 0;
+CChannelBase* CChannelReactor::m_rgpChannels[RIL_CHANNEL_MAX];
+int CChannelReactor::m_rgiFds[RIL_CHANNEL_MAX];
+
+///////////////////////////////////////////////////////////////////////////////
+//
+// Channels are added from the thread starting the channel threads, before any
+// other thread can use the reactor: the lock is created there and kept.
+//
+BOOL CChannelReactor::AddChannel(CChannelBase* pChannel)
+{
+    BOOL bRet = FALSE;
+    UINT32 uiChannel;
+
+    if (NULL == pChannel || pChannel->GetRilChannel() >= RIL_CHANNEL_MAX)
+    {
+        RIL_LOG_CRITICAL("CChannelReactor::AddChannel() - Invalid channel\r\n");
+        return FALSE;
+    }
+    uiChannel = pChannel->GetRilChannel();
+
+    if (NULL == m_pLock)
+    {
+        m_pLock = new CMutex();
+        if (NULL == m_pLock)
+        {
+            RIL_LOG_CRITICAL("CChannelReactor::AddChannel() - Cannot allocate lock\r\n");
+            return FALSE;
+        }
+    }
+
+    CMutex::Lock(m_pLock);
+
+    if (0 == m_nChannels)
+    {
+        for (UINT32 i = 0; i < RIL_CHANNEL_MAX; i++)
+        {
+            m_rgpChannels[i] = NULL;
+            m_rgiFds[i] = -1;
+        }
+
+        if (!Start())
+        {
+            goto Error;
+        }
+    }
+
+    if (NULL != m_rgpChannels[uiChannel])
+    {
+        RIL_LOG_CRITICAL("CChannelReactor::AddChannel() - chnl=[%u] already added\r\n",
+                uiChannel);
+        goto Error;
+    }
+
+    m_rgpChannels[uiChannel] = pChannel;
+    m_nChannels++;
+
+    if (!pChannel->IsReadThreadBlocked() && !Watch(uiChannel))
+    {
+        m_rgpChannels[uiChannel] = NULL;
+        m_nChannels--;
+        goto Error;
+    }
+
+    RIL_LOG_INFO("CChannelReactor::AddChannel() - chnl=[%u] fd=[%d] [%u] channels\r\n",
+            uiChannel, pChannel->GetFD(), m_nChannels);
+    bRet = TRUE;
+
+Error:
+    CMutex::Unlock(m_pLock);
+
+    if (bRet)
+    {
+        // stands for the response thread of the channel
+        CThreadManager::RegisterThread();
+    }
+
+    return bRet;
+}
+
+BOOL CChannelReactor::RemoveChannel(CChannelBase* pChannel)
+{
+    CThread* pThread = NULL;
+    int iEpollFd = -1;
+    UINT32 uiChannel;
+    BOOL bRet = TRUE;
+
+    if (NULL == m_pLock || NULL == pChannel || pChannel->GetRilChannel() >= RIL_CHANNEL_MAX)
+    {
+        return FALSE;
+    }
+    uiChannel = pChannel->GetRilChannel();
+
+    CMutex::Lock(m_pLock);
+
+    if (pChannel == m_rgpChannels[uiChannel])
+    {
+        Unwatch(uiChannel);
+        m_rgpChannels[uiChannel] = NULL;
+
+        m_nChannels--;
+        if (0 == m_nChannels)
+        {
+            pThread = m_pThread;
+            m_pThread = NULL;
+            iEpollFd = m_iEpollFd;
+            m_iEpollFd = -1;
+        }
+    }
+
+    CMutex::Unlock(m_pLock);
+
+    // the thread exits on the cancel wait pipe, the lock must not be held meanwhile
+    if (NULL != pThread)
+    {
+        if (THREAD_WAIT_TIMEOUT == CThread::Wait(pThread, REACTOR_THREAD_EXIT_TIMEOUT))
+        {
+            RIL_LOG_CRITICAL("CChannelReactor::RemoveChannel() - Timed out waiting on reactor"
+                    " thread!\r\n");
+            bRet = FALSE;
+        }
+        else
+        {
+            close(iEpollFd);
+        }
+
+        delete pThread;
+        pThread = NULL;
+    }
+
+    return bRet;
+}
+
+void CChannelReactor::Rearm(CChannelBase* pChannel)
+{
+    UINT32 uiChannel;
+
+    if (NULL == m_pLock || NULL == pChannel || pChannel->GetRilChannel() >= RIL_CHANNEL_MAX)
+    {
+        return;
+    }
+    uiChannel = pChannel->GetRilChannel();
+
+    CMutex::Lock(m_pLock);
+
+    if (pChannel == m_rgpChannels[uiChannel] && !pChannel->IsReadThreadBlocked())
+    {
+        Watch(uiChannel);
+    }
+
+    CMutex::Unlock(m_pLock);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Called with the lock held
+BOOL CChannelReactor::Start()
+{
+    struct epoll_event event;
+
+    m_iEpollFd = epoll_create(RIL_CHANNEL_MAX + 1);
+    if (m_iEpollFd < 0)
+    {
+        RIL_LOG_CRITICAL("CChannelReactor::Start() - epoll_create() failed, errno=[%d]\r\n",
+                errno);
+        return FALSE;
+    }
+
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.u32 = E_CANCEL_WAIT_PIPE;
+    if (epoll_ctl(m_iEpollFd, EPOLL_CTL_ADD, CSystemManager::GetInstance().GetCancelWaitPipeFd(),
+            &event) < 0)
+    {
+        RIL_LOG_CRITICAL("CChannelReactor::Start() - Cannot watch cancel wait pipe,"
+                " errno=[%d]\r\n", errno);
+        goto Error;
+    }
+
+    m_pThread = new CThread(ReactorThreadProc, NULL, THREAD_FLAGS_JOINABLE, 0);
+    if (NULL == m_pThread || !CThread::IsInitialized(m_pThread))
+    {
+        RIL_LOG_CRITICAL("CChannelReactor::Start() - Unable to launch reactor thread\r\n");
+        delete m_pThread;
+        m_pThread = NULL;
+        goto Error;
+    }
+
+    // same priority as the response threads it replaces
+    CThread::SetPriority(m_pThread, THREAD_PRIORITY_LEVEL_HIGH);
+
+    return TRUE;
+
+Error:
+    close(m_iEpollFd);
+    m_iEpollFd = -1;
+    return FALSE;
+}
+
+//
+// Called with the lock held. The port of a channel can have been reopened since
+// it was last watched, in which case the old descriptor is dropped.
+//
+BOOL CChannelReactor::Watch(UINT32 uiChannel)
+{
+    struct epoll_event event;
+    int fd = m_rgpChannels[uiChannel]->GetFD();
+    int iOp;
+
+    if (m_iEpollFd < 0 || fd < 0)
+    {
+        RIL_LOG_CRITICAL("CChannelReactor::Watch() - chnl=[%u] Port is not open\r\n",
+                uiChannel);
+        return FALSE;
+    }
+
+    if (m_rgiFds[uiChannel] != fd)
+    {
+        Unwatch(uiChannel);
+    }
+
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN | EPOLLONESHOT;
+    event.data.u32 = uiChannel;
+    iOp = (m_rgiFds[uiChannel] < 0) ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+
+    if (epoll_ctl(m_iEpollFd, iOp, fd, &event) < 0)
+    {
+        RIL_LOG_CRITICAL("CChannelReactor::Watch() - chnl=[%u] epoll_ctl() failed,"
+                " errno=[%d]\r\n", uiChannel, errno);
+        return FALSE;
+    }
+
+    m_rgiFds[uiChannel] = fd;
+    return TRUE;
+}
+
+// Called with the lock held
+void CChannelReactor::Unwatch(UINT32 uiChannel)
+{
+    if (m_rgiFds[uiChannel] >= 0)
+    {
+        epoll_ctl(m_iEpollFd, EPOLL_CTL_DEL, m_rgiFds[uiChannel], NULL);
+        m_rgiFds[uiChannel] = -1;
+    }
+}
+
+void CChannelReactor::HandleChannel(UINT32 uiChannel, UINT32 uiEvents)
+{
+    CChannelBase* pChannel;
+    BOOL bDataRead = FALSE;
+    BOOL bHangUp = (0 != (uiEvents & (EPOLLHUP | EPOLLERR)));
+
+    CMutex::Lock(m_pLock);
+    pChannel = m_rgpChannels[uiChannel];
+    CMutex::Unlock(m_pLock);
+
+    // a blocked channel is watched again when it gets unblocked
+    if (NULL == pChannel || pChannel->IsReadThreadBlocked())
+    {
+        return;
+    }
+
+    // A port that hung up reads 0 bytes, on which ReadAvailableData() sleeps before
+    // trying again. It is not read, the cleanup reopens it.
+    if (!bHangUp && !pChannel->ReadAvailableData(bDataRead))
+    {
+        RIL_LOG_CRITICAL("CChannelReactor::HandleChannel() - chnl=[%u] Stop reading\r\n",
+                uiChannel);
+        return;
+    }
+
+    CMutex::Lock(m_pLock);
+    if (pChannel == m_rgpChannels[uiChannel])
+    {
+        if (bHangUp)
+        {
+            // it would be reported again right away, it is watched again once reopened
+            Unwatch(uiChannel);
+        }
+        else if (!pChannel->IsReadThreadBlocked())
+        {
+            Watch(uiChannel);
+        }
+    }
+    CMutex::Unlock(m_pLock);
+
+    if (bHangUp)
+    {
+        if (CTE::GetTE().IsPlatformShutDownRequested() || CTE::GetTE().GetSpoofCommandsStatus())
+        {
+            return;
+        }
+
+        RIL_LOG_CRITICAL("CChannelReactor::HandleChannel() - chnl=[%u] Port hung up,"
+                " events=[0x%x], requesting cleanup\r\n", uiChannel, uiEvents);
+        DO_REQUEST_CLEAN_UP(1, "Port hung up");
+    }
+}
+
+void* CChannelReactor::ReactorThreadProc(void* /*pArg*/)
+{
+    struct epoll_event rgEvents[RIL_CHANNEL_MAX + 1];
+    int iEpollFd;
+    int nEvents;
+    BOOL bCancel = FALSE;
+
+    RIL_LOG_INFO("CChannelReactor::ReactorThreadProc() - Enter\r\n");
+
+    // the descriptor is only closed once this thread exited
+    CMutex::Lock(m_pLock);
+    iEpollFd = m_iEpollFd;
+    CMutex::Unlock(m_pLock);
+
+    while (!bCancel)
+    {
+        nEvents = epoll_wait(iEpollFd, rgEvents, RIL_CHANNEL_MAX + 1, -1);
+        if (nEvents < 0)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+
+            RIL_LOG_CRITICAL("CChannelReactor::ReactorThreadProc() - epoll_wait() failed,"
+                    " errno=[%d]\r\n", errno);
+            DO_REQUEST_CLEAN_UP(2, "epoll_wait failed", strerror(errno));
+            break;
+        }
+
+        // as in CFile::WaitForEvent(), the cancel wait pipe wins over the data
+        for (int i = 0; i < nEvents; i++)
+        {
+            if (E_CANCEL_WAIT_PIPE == rgEvents[i].data.u32)
+            {
+                bCancel = TRUE;
+            }
+        }
+
+        if (bCancel)
+        {
+            if (!CTE::GetTE().IsPlatformShutDownRequested()
+                    && !CTE::GetTE().GetSpoofCommandsStatus())
+            {
+                RIL_LOG_CRITICAL("CChannelReactor::ReactorThreadProc() - Cancel wait pipe"
+                        " signalled\r\n");
+                DO_REQUEST_CLEAN_UP(1, "Cancel wait pipe signalled");
+            }
+            break;
+        }
+
+        for (int i = 0; i < nEvents; i++)
+        {
+            HandleChannel(rgEvents[i].data.u32, rgEvents[i].events);
+        }
+    }
+
+    RIL_LOG_INFO("CChannelReactor::ReactorThreadProc() - Exit\r\n");
+    return NULL;
+}
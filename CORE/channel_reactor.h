@@ -0,0 +1,65 @@
+////////////////////////////////////////////////////////////////////////////
+// channel_reactor.h
+//
+// Copyright 2009 Intrinsyc Software International, Inc.  All rights reserved.
+// Patents pending in the United States of America and other jurisdictions.
+//
+//
+// Description:
+//    Optional replacement of the per channel response threads by a single
+//    thread reading all channels. It waits on the channel ports and the cancel
+//    wait pipe with epoll and reads each readable channel in turn. A channel is
+//    only read by this thread and is not watched again until its data was
+//    processed, so responses of a channel are processed in order.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef RRIL_CHANNEL_REACTOR_H
+#define RRIL_CHANNEL_REACTOR_H
+
+#include "types.h"
+#include "rilchannels.h"
+
+class CChannelBase;
+class CMutex;
+class CThread;
+
+class CChannelReactor
+{
+public:
+    // Use the reactor for the channels started from now on
+    static void Enable(BOOL bEnable) { m_bEnabled = bEnable; }
+    static BOOL IsEnabled() { return m_bEnabled; }
+
+    // Start reading a channel, the reactor thread is started with the first one
+    static BOOL AddChannel(CChannelBase* pChannel);
+
+    // Stop reading a channel, the reactor thread is stopped with the last one
+    static BOOL RemoveChannel(CChannelBase* pChannel);
+
+    // Watch a channel again once its reading got unblocked
+    static void Rearm(CChannelBase* pChannel);
+
+private:
+    enum
+    {
+        E_CANCEL_WAIT_PIPE = RIL_CHANNEL_MAX    // epoll data of the cancel wait pipe
+    };
+
+    static BOOL Start();
+    static BOOL Watch(UINT32 uiChannel);
+    static void Unwatch(UINT32 uiChannel);
+    static void HandleChannel(UINT32 uiChannel, UINT32 uiEvents);
+
+    static void* ReactorThreadProc(void* pArg);
+
+    static BOOL m_bEnabled;
+    static CMutex* m_pLock;
+    static CThread* m_pThread;
+    static int m_iEpollFd;
+    static UINT32 m_nChannels;
+    static CChannelBase* m_rgpChannels[RIL_CHANNEL_MAX];
+    static int m_rgiFds[RIL_CHANNEL_MAX];       // fd being watched, -1 if none
+};
+
+#endif // RRIL_CHANNEL_REACTOR_H
@@ -26,10 +26,25 @@
 #include "reset.h"
 #include "repository.h"
 #include "channelbase.h"
+#include "channel_reactor.h"
 #include "te.h"
 
 extern char* g_szSIMID;
 
+// Longest init command line built by merging init commands, 0 disables merging
+static const int DEFAULT_MAX_INIT_CMD_LINE_LENGTH = 128;
+
+// Extended commands which must not run twice: they send or store something, use up
+// a PIN attempt, or start a procedure again. They are never merged, since all the
+// commands of a merged line that fails are sent again.
+static const char* const g_rgpszUnmergeableInitCmds[] =
+{
+    "+CFUN", "+COPS", "+CGDATA", "+CHLD", "+CUSD",
+    "+CPIN", "+CLCK", "+CPWD",
+    "+CMGS", "+CMSS", "+CMGW", "+CMGD",
+    "+CSIM", "+CRSM", "+CGLA", "+CCHO", "+CCHC"
+};
+
 CChannelBase::CChannelBase(UINT32 uiChannel)
   : m_uiRilChannel(uiChannel),
     m_bTimeoutWaitingForResponse(0),
@@ -192,6 +207,13 @@ BOOL CChannelBase::AddSilo(CSilo* pSilo)
 
     if (SILO_MAX > m_SiloContainer.nSilos)
     {
+        if (!m_RspPrefixTrie.AddTable(pSilo, pSilo->GetATRspTable())
+                || !m_RspPrefixTrie.AddTable(pSilo, pSilo->GetATRspTableExt()))
+        {
+            RIL_LOG_CRITICAL("CChannelBase::AddSilo() : Unable to add silo response table\r\n");
+            goto Done;
+        }
+
         m_SiloContainer.rgpSilos[m_SiloContainer.nSilos++] = pSilo;
     }
     else
@@ -278,6 +300,20 @@ BOOL CChannelBase::StartChannelThreads()
         goto Done;
     }
 
+    //  The reactor thread reads all the channels if enabled
+    if (CChannelReactor::IsEnabled())
+    {
+        if (!CChannelReactor::AddChannel(this))
+        {
+            RIL_LOG_CRITICAL("CChannelBase::StartChannelThreads() -"
+                    " Unable to add channel to reactor\r\n");
+            goto Done;
+        }
+
+        bResult = TRUE;
+        goto Done;
+    }
+
     //  Launch response thread.
     m_pReadThread = new CThread(ChannelResponseThreadStart, (void*)this, THREAD_FLAGS_JOINABLE, 0);
     if (!m_pReadThread)
@@ -344,18 +380,33 @@ BOOL CChannelBase::StopChannelThreads()
                 " exited!\r\n");
     }
 
-    RIL_LOG_INFO("CChannelBase::StopChannelThreads() : INFO : Wait for Response Thread!\r\n");
-
-    if (THREAD_WAIT_TIMEOUT == CThread::Wait(m_pReadThread, uiThreadTime))
+    if (NULL == m_pReadThread)
     {
-        RIL_LOG_CRITICAL("CChannelBase::StopChannelThreads() : We timed out waiting on response"
-                " thread!\r\n");
-        bResult = FALSE;
+        RIL_LOG_INFO("CChannelBase::StopChannelThreads() : INFO : Remove from reactor!\r\n");
+
+        if (!CChannelReactor::RemoveChannel(this))
+        {
+            RIL_LOG_CRITICAL("CChannelBase::StopChannelThreads() : Could not remove channel"
+                    " from reactor!\r\n");
+            bResult = FALSE;
+        }
     }
     else
     {
-        RIL_LOG_INFO("CChannelBase::StopChannelThreads() : INFO : Response Thread has successfully"
-                " exited!\r\n");
+        RIL_LOG_INFO("CChannelBase::StopChannelThreads() : INFO : Wait for Response Thread!"
+                "\r\n");
+
+        if (THREAD_WAIT_TIMEOUT == CThread::Wait(m_pReadThread, uiThreadTime))
+        {
+            RIL_LOG_CRITICAL("CChannelBase::StopChannelThreads() : We timed out waiting on"
+                    " response thread!\r\n");
+            bResult = FALSE;
+        }
+        else
+        {
+            RIL_LOG_INFO("CChannelBase::StopChannelThreads() : INFO : Response Thread has"
+                    " successfully exited!\r\n");
+        }
     }
 
     if (m_pCmdThread)
@@ -557,13 +608,21 @@ BOOL CChannelBase::SendModemConfigurationCommands(eComInitIndex eInitIndex)
     char*        szInit;
     const UINT32 szInitLen = MAX_BUFFER_SIZE;
     BOOL         bRetVal  = FALSE;
-    CCommand*    pCmd = NULL;
-    BOOL         bLastCmd;
     CRepository  repository;
     char         szTemp[MAX_BUFFER_SIZE];
+    char*        szLine = NULL;             // commands merged into one command line
+    char*        szSeparateCmds = NULL;     // same commands, '|' separated
+    UINT32       uiNumCmds = 0;
+    BOOL         bLineMergeable = FALSE;
+    BOOL         bMergeable;
+    int          iMaxLineLength;
+    char*        pszStart;
+    char*        pszEnd;
 
     szInit = new char[szInitLen];
-    if (!szInit)
+    szLine = new char[MAX_BUFFER_SIZE];
+    szSeparateCmds = new char[MAX_BUFFER_SIZE];
+    if (!szInit || !szLine || !szSeparateCmds)
     {
         RIL_LOG_CRITICAL("CChannelBase::SendModemConfigurationCommands() : Out of memory\r\n");
         goto Done;
@@ -825,10 +884,19 @@ BOOL CChannelBase::SendModemConfigurationCommands(eComInitIndex eInitIndex)
         goto Done;
     }
 
-    // Now go through the string and break it up into individual commands separated by a '|'
-    char  szCmd[MAX_BUFFER_SIZE];
-    char* pszStart;
-    char* pszEnd;
+    // Now go through the string and break it up into individual commands separated by a '|'.
+    // Consecutive extended commands are merged into one command line, as in
+    // AT+A;+B;+C, which costs a single round-trip.
+    if (!repository.Read(g_szGroupRILSettings, g_szMaxInitCmdLineLength, iMaxLineLength)
+            || iMaxLineLength < 0)
+    {
+        iMaxLineLength = DEFAULT_MAX_INIT_CMD_LINE_LENGTH;
+    }
+    else if (iMaxLineLength > MAX_BUFFER_SIZE)
+    {
+        iMaxLineLength = MAX_BUFFER_SIZE;
+    }
+
     pszStart = szInit;
     for (;;)
     {
@@ -838,41 +906,40 @@ BOOL CChannelBase::SendModemConfigurationCommands(eComInitIndex eInitIndex)
         {
             // If we found a termination char, terminate the command there
             *pszEnd = '\0';
-            bLastCmd = FALSE;
-        }
-        else
-        {
-            bLastCmd = TRUE;
         }
 
         if ('\0' != pszStart[0])
         {
-            // Send the command
-            if (!PrintStringNullTerminate(szCmd, MAX_BUFFER_SIZE, "AT%s\r", pszStart))
-            {
-                RIL_LOG_CRITICAL("CChannelBase::SendModemConfigurationCommands() - Could not"
-                        " make command.\r\n");
-                goto Done;
-            }
-            pCmd = new CCommand(m_uiRilChannel,
-                                0,
-                                REQ_ID_NONE,
-                                szCmd);
+            bMergeable = IsMergeableInitCommand(pszStart);
 
-            if (pCmd)
+            // "AT" + line + ';' + command + '\r'. szSeparateCmds is as long as szLine.
+            if (0 < uiNumCmds && bLineMergeable && bMergeable
+                    && strlen(szLine) + strlen(pszStart) + 4 <= (UINT32)iMaxLineLength)
             {
-                CContext* pContext = new CContextInitString(eInitIndex, m_uiRilChannel, bLastCmd);
-                pCmd->SetContext(pContext);
-                pCmd->SetTimeout(CTE::GetTE().GetTimeoutCmdInit());
-                pCmd->SetHighPriority();
-                pCmd->SetInitCommand();
+                ConcatenateStringNullTerminate(szSeparateCmds, MAX_BUFFER_SIZE, "|");
+                ConcatenateStringNullTerminate(szSeparateCmds, MAX_BUFFER_SIZE, pszStart);
+                ConcatenateStringNullTerminate(szLine, MAX_BUFFER_SIZE, ";");
+                ConcatenateStringNullTerminate(szLine, MAX_BUFFER_SIZE, pszStart);
+                uiNumCmds++;
             }
-
-            if (!pCmd || !CCommand::AddCmdToQueue(pCmd))
+            else
             {
-                RIL_LOG_CRITICAL("CChannelBase::SendModemConfigurationCommands() - Could not queue"
-                        " command.\r\n");
-                goto Done;
+                // Send the current command line, it is not the last one
+                if (0 < uiNumCmds && !QueueInitCommand(m_uiRilChannel, eInitIndex, szLine,
+                        uiNumCmds, FALSE, (1 < uiNumCmds) ? szSeparateCmds : NULL, FALSE))
+                {
+                    goto Done;
+                }
+
+                if (!CopyStringNullTerminate(szLine, pszStart, MAX_BUFFER_SIZE)
+                        || !CopyStringNullTerminate(szSeparateCmds, pszStart, MAX_BUFFER_SIZE))
+                {
+                    RIL_LOG_CRITICAL("CChannelBase::SendModemConfigurationCommands() - Could not"
+                            " make command.\r\n");
+                    goto Done;
+                }
+                uiNumCmds = 1;
+                bLineMergeable = bMergeable;
             }
         }
 
@@ -886,6 +953,12 @@ BOOL CChannelBase::SendModemConfigurationCommands(eComInitIndex eInitIndex)
         pszStart = pszEnd+1;
     }
 
+    if (0 < uiNumCmds && !QueueInitCommand(m_uiRilChannel, eInitIndex, szLine, uiNumCmds,
+            TRUE, (1 < uiNumCmds) ? szSeparateCmds : NULL, FALSE))
+    {
+        goto Done;
+    }
+
     bRetVal = TRUE;
 
 Done:
@@ -904,24 +977,86 @@ Done:
 
     delete[] szInit;
     szInit = NULL;
-    delete pCmd;
-    pCmd = NULL;
+    delete[] szLine;
+    szLine = NULL;
+    delete[] szSeparateCmds;
+    szSeparateCmds = NULL;
     RIL_LOG_VERBOSE("CChannelBase::SendModemConfigurationCommands() - Exit\r\n");
 
     return bRetVal;
 }
 
+BOOL CChannelBase::QueueInitCommand(UINT32 uiChannel, eComInitIndex eInitIndex,
+        const char* pszCmdLine, UINT32 uiNumCmds, BOOL bLastCmd, const char* pszSeparateCmds,
+        BOOL bFront)
+{
+    char szCmd[MAX_BUFFER_SIZE];
+    CCommand* pCmd = NULL;
+    CContext* pContext = NULL;
+
+    if (!PrintStringNullTerminate(szCmd, MAX_BUFFER_SIZE, "AT%s\r", pszCmdLine))
+    {
+        RIL_LOG_CRITICAL("CChannelBase::QueueInitCommand() - Could not make command.\r\n");
+        return FALSE;
+    }
+
+    pCmd = new CCommand(uiChannel, 0, REQ_ID_NONE, szCmd);
+    if (NULL != pCmd)
+    {
+        pContext = new CContextInitString(eInitIndex, uiChannel, bLastCmd, pszSeparateCmds);
+        pCmd->SetContext(pContext);
+        // each merged command gets the time of a single one
+        pCmd->SetTimeout(CTE::GetTE().GetTimeoutCmdInit() * uiNumCmds);
+        pCmd->SetHighPriority();
+        pCmd->SetInitCommand();
+    }
+
+    if (NULL == pCmd || !CCommand::AddCmdToQueue(pCmd, bFront))
+    {
+        RIL_LOG_CRITICAL("CChannelBase::QueueInitCommand() - Could not queue command.\r\n");
+        delete pCmd;
+        pCmd = NULL;
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+//
+// Only extended commands (+XXX) can be followed by another command after a ';'.
+// Basic commands (E0, V1, S0=0, &C0), lines already holding several commands and
+// commands which are not safe to repeat are sent as they are.
+//
+BOOL CChannelBase::IsMergeableInitCommand(const char* pszCmd)
+{
+    const UINT32 uiNameLen = strcspn(pszCmd, "=?");
+
+    if (('+' != pszCmd[0]) || (NULL != strchr(pszCmd, ';')))
+    {
+        return FALSE;
+    }
+
+    for (UINT32 i = 0; i < sizeof(g_rgpszUnmergeableInitCmds) / sizeof(char*); i++)
+    {
+        if (uiNameLen == strlen(g_rgpszUnmergeableInitCmds[i])
+                && 0 == strncmp(pszCmd, g_rgpszUnmergeableInitCmds[i], uiNameLen))
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
 
 
 
 UINT32 CChannelBase::ResponseThread()
 {
     RIL_LOG_VERBOSE("CChannelBase::ResponseThread() chnl=[%d] - Enter\r\n", m_uiRilChannel);
-    const UINT32 uiRespDataBufSize = 1024;
-    char         szData[uiRespDataBufSize];
-    UINT32       uiRead;
     UINT32       uiNumEvents;
     UINT32       uiReadError = 0;
+    BOOL         bDataRead = FALSE;
     const UINT32 MAX_READERROR = 3;
 
     CThreadManager::RegisterThread();
@@ -992,82 +1127,124 @@ UINT32 CChannelBase::ResponseThread()
         RIL_LOG_VERBOSE("CChannelBase::ResponseThread() chnl=[%d] - Data received\r\n",
                 m_uiRilChannel);
 
-        BOOL bFirstRead = TRUE;
-        do
+        if (!ReadAvailableData(bDataRead))
         {
-            if (!ReadFromPort(szData, uiRespDataBufSize, uiRead))
-            {
-                if (CTE::GetTE().GetSpoofCommandsStatus())
-                {
-                    // If we are in spoof mode, this means that the modem is not ready.
-                    //  Don't report error in this case. Simply end the thread.
-                    return 0;
-                }
+            //  exit thread
+            return 0;
+        }
 
-                RIL_LOG_CRITICAL("CChannelBase::ResponseThread() chnl=[%d] -"
-                        "Read failed\r\n", m_uiRilChannel);
+        if (bDataRead)
+        {
+            uiReadError = 0;
+        }
+    }
 
-                if (m_bPossibleInvalidFD)
-                {
-                    //  We could be closing and opening the DLC port. (For AT timeout case)
-                    RIL_LOG_CRITICAL("CChannelBase::ResponseThread() chnl=[%d] - "
-                            "m_bPossibleInvalidFD = TRUE\r\n");
-                    Sleep(50);
-                    break;
-                }
-                else
-                {
-                    // read() < 0, call DO_REQUEST_CLEAN_UP()
-                    DO_REQUEST_CLEAN_UP(); // Reason saved in 'ReadFromPort'
-                    //  exit thread
-                    return 0;
-                }
-            }
+Done:
+    RIL_LOG_INFO("CChannelBase::ResponseThread() chnl=[%d] - Exit\r\n", m_uiRilChannel);
+    return 0;
+}
 
-            if (!uiRead)
+//
+//  Read everything the port has and hand it to ProcessModemData(). Called by the
+//  response thread or the channel reactor once the port is readable.
+//  rbDataRead is set if anything was read. Returns FALSE if reading the channel
+//  must stop.
+//
+BOOL CChannelBase::ReadAvailableData(BOOL& rbDataRead)
+{
+    const UINT32 uiRespDataBufSize = 1024;
+    char*        pRxWindow = NULL;
+    UINT32       uiRxWindowSize = 0;
+    UINT32       uiRead;
+
+    rbDataRead = FALSE;
+
+    BOOL bFirstRead = TRUE;
+    do
+    {
+        // read straight into the channel receive buffer
+        CMutex::Lock(m_pResponseObjectAccessMutex);
+        BOOL bWindow = m_RxBuffer.GetWriteWindow(uiRespDataBufSize, pRxWindow,
+                uiRxWindowSize);
+        CMutex::Unlock(m_pResponseObjectAccessMutex);
+        if (!bWindow)
+        {
+            RIL_LOG_CRITICAL("CChannelBase::ReadAvailableData() chnl=[%d] -"
+                    " No room in receive buffer\r\n", m_uiRilChannel);
+            DO_REQUEST_CLEAN_UP(1, "Out of memory");
+            return FALSE;
+        }
+
+        if (!ReadFromPort(pRxWindow, uiRxWindowSize, uiRead))
+        {
+            if (CTE::GetTE().GetSpoofCommandsStatus())
             {
-                if (bFirstRead)
-                {
-                    if (CTE::GetTE().GetSpoofCommandsStatus())
-                    {
-                        // If we are in "spoof" mode this means that a call to DO_REQUEST_CLEAN_UP()
-                        // was done. In this case, we must exit the thread to end the RRIL.
-                        return 0;
-                    }
+                // If we are in spoof mode, this means that the modem is not ready.
+                //  Don't report error in this case. Simply end the thread.
+                return FALSE;
+            }
 
-                    RIL_LOG_CRITICAL("CChannelBase::ResponseThread() chnl=[%d] -"
-                            "Data available but uiRead is 0!\r\n", m_uiRilChannel);
-                    Sleep(100);
-                }
+            RIL_LOG_CRITICAL("CChannelBase::ReadAvailableData() chnl=[%d] -"
+                    "Read failed\r\n", m_uiRilChannel);
+
+            if (m_bPossibleInvalidFD)
+            {
+                //  We could be closing and opening the DLC port. (For AT timeout case)
+                RIL_LOG_CRITICAL("CChannelBase::ReadAvailableData() chnl=[%d] - "
+                        "m_bPossibleInvalidFD = TRUE\r\n");
+                Sleep(50);
                 break;
             }
             else
             {
-                uiReadError = 0;
+                // read() < 0, call DO_REQUEST_CLEAN_UP()
+                DO_REQUEST_CLEAN_UP(); // Reason saved in 'ReadFromPort'
+                //  exit thread
+                return FALSE;
             }
+        }
 
-            // If the thread is blocked don't take into account the data
-            // This can occur if the thread was blocked when we are running WaitForAvailableData
-            if (m_bReadThreadBlocked)
+        if (!uiRead)
+        {
+            if (bFirstRead)
             {
-                break;
-            }
+                if (CTE::GetTE().GetSpoofCommandsStatus())
+                {
+                    // If we are in "spoof" mode this means that a call to DO_REQUEST_CLEAN_UP()
+                    // was done. In this case, we must exit the thread to end the RRIL.
+                    return FALSE;
+                }
 
-            if (!ProcessModemData(szData, uiRead))
-            {
-                RIL_LOG_CRITICAL("CChannelBase::ResponseThread() - chnl=[%d] ProcessModemData"
-                        " failed?!\r\n", m_uiRilChannel);
-                break;
+                RIL_LOG_CRITICAL("CChannelBase::ReadAvailableData() chnl=[%d] -"
+                        "Data available but uiRead is 0!\r\n", m_uiRilChannel);
+                Sleep(100);
             }
+            break;
+        }
+        else
+        {
+            rbDataRead = TRUE;
+        }
 
-            bFirstRead = FALSE;
-            // Loop until there is nothing left in the buffer to read
-        } while (uiRead != 0);
-    }
+        // If the thread is blocked don't take into account the data
+        // This can occur if the thread was blocked when we are running WaitForAvailableData
+        if (m_bReadThreadBlocked)
+        {
+            break;
+        }
 
-Done:
-    RIL_LOG_INFO("CChannelBase::ResponseThread() chnl=[%d] - Exit\r\n", m_uiRilChannel);
-    return 0;
+        if (!ProcessModemData(pRxWindow, uiRead))
+        {
+            RIL_LOG_CRITICAL("CChannelBase::ReadAvailableData() - chnl=[%d] ProcessModemData"
+                    " failed?!\r\n", m_uiRilChannel);
+            break;
+        }
+
+        bFirstRead = FALSE;
+        // Loop until there is nothing left in the buffer to read
+    } while (uiRead != 0);
+
+    return TRUE;
 }
 
 
@@ -1094,37 +1271,49 @@ BOOL CChannelBase::LockCommandQueue(UINT32 uiTimeout)
 //
 //  Iterate through each silo in this channel to ParseNotification.
 //
+//  Called at the beginning of CResponse::ParseUnsolicitedResponse().
+//
+//  Parameters:
+//    [in]      pResponse  = Pointer to CResponse class
+//    [in/out]  rszPointer = Pointer to string response buffer.
+//    [in/out]  fGotoError = Set to TRUE if we wish to stop response chain and goto
+//    Error in CResponse::ParseUnsolicitedResponse().
+//
+//  Return values:
+//    TRUE  if response is handled by a silo parser.
+//    FALSE if no silo handles the response, handling will continue in the framework.
+//
 BOOL CChannelBase::ParseUnsolicitedResponse(CResponse* const pResponse,
                                                const char*& rszPointer,
                                                BOOL& fGotoError)
 {
     //RIL_LOG_VERBOSE("CChannelBase::ParseUnsolicitedResponse() - Enter\r\n");
-    BOOL bResult = TRUE;
-    int count = m_SiloContainer.nSilos;
+    CSilo* pSilo = NULL;
+    PFN_ATRSP_PARSE fctParser = NULL;
 
-    for (int i = 0; i < count; ++i)
+    if (NULL == pResponse)
     {
-        CSilo* pSilo = NULL;
-        pSilo = m_SiloContainer.rgpSilos[i];
+        RIL_LOG_CRITICAL("CChannelBase::ParseUnsolicitedResponse() chnl=[%d] - pResponse is"
+                " NULL\r\n", m_uiRilChannel);
+        fGotoError = TRUE;
+        return FALSE;
+    }
 
-        if (pSilo)
-        {
-            if (pSilo->ParseUnsolicitedResponse(pResponse, rszPointer, fGotoError))
-            {
-                //  we're done.
-                goto Done;
-            }
-            else if (fGotoError)
-            {
-                //  done, but need to goto error.
-                break;
-            }
-        }
+    if (!m_RspPrefixTrie.Find(rszPointer, pSilo, fctParser, rszPointer))
+    {
+        return FALSE;
     }
 
-    bResult = FALSE;
-Done:
-    return bResult;
+    // Call the function pointer
+    if (!(pSilo->*fctParser)(pResponse, rszPointer))
+    {
+        // There was a problem parsing the response, goto error
+        fGotoError = TRUE;
+        return FALSE;
+    }
+
+    // We found the response and parsed it correctly
+    return TRUE;
 }
 
 BOOL CChannelBase::InitPort()
@@ -1139,9 +1328,8 @@ BOOL CChannelBase::ClosePort()
 
 BOOL CChannelBase::WriteToPort(const char* pData, UINT32 uiBytesToWrite, UINT32& ruiBytesWritten)
 {
-    RIL_LOG_INFO("CChannelBase::WriteToPort() - INFO: chnl=[%d] TX [%s]\r\n",
-                       m_uiRilChannel,
-                       CRLFExpandedString(pData,uiBytesToWrite).GetString());
+    RIL_LOG_INFO("CChannelBase::WriteToPort() - INFO: chnl=[%d] TX [%R]\r\n",
+                       m_uiRilChannel, pData, uiBytesToWrite);
 
     return m_Port.Write(pData, uiBytesToWrite, ruiBytesWritten);
 }
@@ -1170,5 +1358,6 @@ BOOL CChannelBase::BlockReadThread()
 BOOL CChannelBase::UnblockReadThread()
 {
     m_bReadThreadBlocked = FALSE;
+    CChannelReactor::Rearm(this);
     return CEvent::Signal(m_pBlockReadThreadEvent);
 }
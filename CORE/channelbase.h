@@ -18,6 +18,8 @@
 #include "command.h"
 #include "systemcaps.h"
 #include "initializer.h"
+#include "rsp_prefix_trie.h"
+#include "rxbuffer.h"
 
 // forward declarations
 class CSilo;
@@ -69,6 +71,13 @@ public:
     char* GetBasicInitCmd() { return m_szChannelBasicInitCmd; }
     char* GetUnlockInitCmd() { return m_szChannelUnlockInitCmd; }
 
+    // Queue an init command line given without its "AT" prefix. pszSeparateCmds is
+    // NULL, or the '|' separated commands merged into the line, sent one by one if
+    // the merged line fails.
+    static BOOL QueueInitCommand(UINT32 uiChannel, eComInitIndex eInitIndex,
+            const char* pszCmdLine, UINT32 uiNumCmds, BOOL bLastCmd,
+            const char* pszSeparateCmds, BOOL bFront);
+
     // Public port interface
     virtual BOOL OpenPort() = 0;
     BOOL InitPort();
@@ -82,6 +91,10 @@ public:
 
     BOOL BlockReadThread();
     BOOL UnblockReadThread();
+    BOOL IsReadThreadBlocked() const { return m_bReadThreadBlocked; }
+
+    // Read and process the data available on the port, see ResponseThread()
+    BOOL ReadAvailableData(BOOL& rbDataRead);
 
     //  Public interfaces to notify all silos.
     BOOL ParseUnsolicitedResponse(CResponse*
@@ -131,6 +144,9 @@ protected:
 
     char* GetTESpecificInitCommands(eComInitIndex eInitIndex);
 
+    // Whether an init command can be merged with its neighbours into one command line
+    static BOOL IsMergeableInitCommand(const char* pszCmd);
+
 protected:
     //  Member variables
     UINT32 m_uiRilChannel;
@@ -154,6 +170,9 @@ protected:
 
     SILO_CONTAINER m_SiloContainer;
 
+    // Response prefixes of all silos, in silo order
+    CRspPrefixTrie m_RspPrefixTrie;
+
     CPort m_Port;
 
     //  When closing and opening the port (in case of AT command timeout),
@@ -163,6 +182,9 @@ protected:
     CMutex* m_pPossibleInvalidFDMutex;
     CMutex* m_pResponseObjectAccessMutex;
 
+    // Received data not yet framed into responses, see m_pResponseObjectAccessMutex
+    CRxBuffer m_RxBuffer;
+
     // channel init command strings
     char m_szChannelBasicInitCmd[MAX_BUFFER_SIZE];
     char m_szChannelUnlockInitCmd[MAX_BUFFER_SIZE];
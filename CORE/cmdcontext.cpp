@@ -16,6 +16,8 @@
 //       just set a flag or trigger an event.
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "types.h"
 #include "rril.h"
@@ -70,8 +72,79 @@ void CContextEvent::Execute(BOOL bRes, UINT32 uiErrorCode)
 
 
 // CContextInitString
+CContextInitString::CContextInitString(eComInitIndex eInitIndex, UINT32 uiChannel,
+        BOOL bFinalCmd, const char* pszSeparateCmds)
+    : m_eInitIndex(eInitIndex), m_uiChannel(uiChannel), m_bFinalCmd(bFinalCmd),
+      m_pszSeparateCmds(NULL)
+{
+    if (NULL != pszSeparateCmds)
+    {
+        m_pszSeparateCmds = strdup(pszSeparateCmds);
+    }
+}
+
+CContextInitString::~CContextInitString()
+{
+    free(m_pszSeparateCmds);
+    m_pszSeparateCmds = NULL;
+}
+
+//
+// The modem stops at the first failing command of a line, so the commands of a
+// failed merged line are sent again one by one ahead of the remaining init
+// commands. Its answer does not tell which command failed: those before it ran
+// already and run again, CChannelBase::IsMergeableInitCommand only lets commands
+// which are safe to repeat into a merged line. Only the last one of them keeps
+// the final command role.
+//
+BOOL CContextInitString::SendSeparately()
+{
+    char* rgpszCmds[MAX_BUFFER_SIZE / 2];
+    UINT32 uiNumCmds = 0;
+    char* pszCmd = m_pszSeparateCmds;
+    char* pszEnd;
+
+    while (NULL != pszCmd && uiNumCmds < MAX_BUFFER_SIZE / 2)
+    {
+        pszEnd = strchr(pszCmd, '|');
+        if (NULL != pszEnd)
+        {
+            *pszEnd = '\0';
+        }
+
+        rgpszCmds[uiNumCmds++] = pszCmd;
+        pszCmd = (NULL != pszEnd) ? pszEnd + 1 : NULL;
+    }
+
+    // queued at the front, so in reverse order
+    for (UINT32 i = uiNumCmds; i > 0; i--)
+    {
+        if (!CChannelBase::QueueInitCommand(m_uiChannel, m_eInitIndex, rgpszCmds[i - 1], 1,
+                m_bFinalCmd && (i == uiNumCmds), NULL, TRUE))
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
 void CContextInitString::Execute(BOOL bRes, UINT32 uiErrorCode)
 {
+    if (!bRes && NULL != m_pszSeparateCmds)
+    {
+        RIL_LOG_WARNING("CContextInitString::Execute() - chnl=[%u] Merged init commands"
+                " failed, sending them separately\r\n", m_uiChannel);
+
+        if (SendSeparately())
+        {
+            return;
+        }
+
+        RIL_LOG_CRITICAL("CContextInitString::Execute() - chnl=[%u] Cannot queue init"
+                " commands\r\n", m_uiChannel);
+    }
+
     if (m_bFinalCmd)
     {
         RIL_LOG_INFO("CContextInitString::Execute() - Last command for init index [%d] on channel"
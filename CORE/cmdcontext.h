@@ -75,16 +75,21 @@ private:
 class CContextInitString : public CContext
 {
 public:
-    CContextInitString(eComInitIndex eInitIndex, UINT32 uiChannel, BOOL bFinalCmd)
-        : m_eInitIndex(eInitIndex), m_uiChannel(uiChannel), m_bFinalCmd(bFinalCmd) {}
-    virtual ~CContextInitString() {}
+    // pszSeparateCmds: commands merged into the init command line, see
+    // CChannelBase::QueueInitCommand
+    CContextInitString(eComInitIndex eInitIndex, UINT32 uiChannel, BOOL bFinalCmd,
+            const char* pszSeparateCmds = NULL);
+    virtual ~CContextInitString();
 
     virtual void Execute(BOOL, UINT32);
 
 private:
+    BOOL SendSeparately();
+
     eComInitIndex m_eInitIndex;
     UINT32 m_uiChannel;
     BOOL m_bFinalCmd;
+    char* m_pszSeparateCmds;
 };
 
 
@@ -0,0 +1,441 @@
+////////////////////////////////////////////////////////////////////////////
+// cmdqueue.cpp
+//
+// Copyright 2009 Intrinsyc Software International, Inc.  All rights reserved.
+// Patents pending in the United States of America and other jurisdictions.
+//
+//
+// Description:
+//    Implementation of the lock-free channel command queue.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#include "types.h"
+#include "rillog.h"
+#include "command.h"
+#include "cmdqueue.h"
+
+// Lane sizes must be powers of 2. Init strings are queued as high priority
+// commands in one go, so that lane needs the most room after the normal one.
+// These are the sizes of the lock-free rings only, a lane never refuses a
+// command: the overflow list takes what does not fit. The front lane does not
+// use its ring.
+const UINT32 CCommandQueue::m_rguiLaneCapacity[E_LANE_COUNT] =
+{
+    1,      // E_LANE_FRONT
+    128,    // E_LANE_HIGH
+    256     // E_LANE_NORMAL
+};
+
+///////////////////////////////////////////////////////////////////////////////
+CCommandQueue::CLane::CLane() :
+    m_pSlots(NULL),
+    m_uiMask(0),
+    m_uiTail(0),
+    m_uiHead(0),
+    m_cOverflow(false),
+    m_nOverflow(0),
+    m_bLifo(FALSE)
+{
+}
+
+CCommandQueue::CLane::~CLane()
+{
+    delete[] m_pSlots;
+    m_pSlots = NULL;
+}
+
+BOOL CCommandQueue::CLane::Init(UINT32 uiCapacity, BOOL bLifo)
+{
+    m_pSlots = new SLOT[uiCapacity];
+    if (NULL == m_pSlots)
+    {
+        RIL_LOG_CRITICAL("CCommandQueue::CLane::Init() - Cannot allocate %u slots\r\n",
+                uiCapacity);
+        return FALSE;
+    }
+
+    for (UINT32 i = 0; i < uiCapacity; i++)
+    {
+        m_pSlots[i].uiSeq = i;
+        m_pSlots[i].pCmd = NULL;
+    }
+
+    m_uiMask = uiCapacity - 1;
+    m_uiTail = 0;
+    m_uiHead = 0;
+    m_bLifo = bLifo;
+
+    return TRUE;
+}
+
+BOOL CCommandQueue::CLane::Push(CCommand* pCmd)
+{
+    if (m_bLifo)
+    {
+        if (!m_cOverflow.Enqueue(pCmd, 0, TRUE))
+        {
+            return FALSE;
+        }
+
+        __sync_add_and_fetch(&m_nOverflow, 1);
+        return TRUE;
+    }
+
+    // Commands queued after one that overflowed must not overtake it
+    if (0 == m_nOverflow && PushSlot(pCmd))
+    {
+        return TRUE;
+    }
+
+    if (!m_cOverflow.Enqueue(pCmd))
+    {
+        return FALSE;
+    }
+
+    if (1 == __sync_add_and_fetch(&m_nOverflow, 1))
+    {
+        RIL_LOG_WARNING("CCommandQueue::CLane::Push() - Ring of %u commands is full,"
+                " queuing to the overflow list\r\n", m_uiMask + 1);
+    }
+
+    return TRUE;
+}
+
+BOOL CCommandQueue::CLane::PushSlot(CCommand* pCmd)
+{
+    UINT32 uiPos = m_uiTail;
+
+    for (;;)
+    {
+        SLOT& rSlot = m_pSlots[uiPos & m_uiMask];
+        INT32 iDiff = (INT32)(rSlot.uiSeq - uiPos);
+
+        if (0 == iDiff)
+        {
+            // Slot is free for this position, try to claim it
+            if (__sync_bool_compare_and_swap(&m_uiTail, uiPos, uiPos + 1))
+            {
+                rSlot.pCmd = pCmd;
+                // publish the command before the sequence
+                __sync_synchronize();
+                rSlot.uiSeq = uiPos + 1;
+                return TRUE;
+            }
+        }
+        else if (iDiff < 0)
+        {
+            // The consumer has not freed this slot yet: lane is full
+            return FALSE;
+        }
+
+        uiPos = m_uiTail;
+    }
+}
+
+BOOL CCommandQueue::CLane::Pop(CCommand*& rpCmd)
+{
+    // The ring only holds commands queued before those of the overflow list
+    if (PopSlot(rpCmd))
+    {
+        return TRUE;
+    }
+
+    if (0 != m_nOverflow && m_cOverflow.Dequeue(rpCmd))
+    {
+        __sync_sub_and_fetch(&m_nOverflow, 1);
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+BOOL CCommandQueue::CLane::PopSlot(CCommand*& rpCmd)
+{
+    for (;;)
+    {
+        SLOT& rSlot = m_pSlots[m_uiHead & m_uiMask];
+
+        if (rSlot.uiSeq != m_uiHead + 1)
+        {
+            // Nothing published at the head
+            return FALSE;
+        }
+
+        __sync_synchronize();
+        rpCmd = rSlot.pCmd;
+        rSlot.pCmd = NULL;
+        __sync_synchronize();
+
+        // hand the slot back to producers for the next lap
+        rSlot.uiSeq = m_uiHead + m_uiMask + 1;
+        m_uiHead++;
+
+        // skip commands removed by Remove()
+        if (NULL != rpCmd)
+        {
+            return TRUE;
+        }
+    }
+}
+
+BOOL CCommandQueue::CLane::IsEmpty()
+{
+    for (UINT32 uiPos = m_uiHead; ; uiPos++)
+    {
+        SLOT& rSlot = m_pSlots[uiPos & m_uiMask];
+
+        if (rSlot.uiSeq != uiPos + 1)
+        {
+            return (0 == m_nOverflow);
+        }
+
+        __sync_synchronize();
+        if (NULL != rSlot.pCmd)
+        {
+            return FALSE;
+        }
+    }
+}
+
+int CCommandQueue::CLane::Snapshot(CCommand** ppCmdArray, int nMax)
+{
+    int nCount = 0;
+
+    for (UINT32 uiPos = m_uiHead; nCount < nMax; uiPos++)
+    {
+        SLOT& rSlot = m_pSlots[uiPos & m_uiMask];
+
+        if (rSlot.uiSeq != uiPos + 1)
+        {
+            break;
+        }
+
+        __sync_synchronize();
+        if (NULL != rSlot.pCmd)
+        {
+            ppCmdArray[nCount++] = rSlot.pCmd;
+        }
+    }
+
+    if (0 != m_nOverflow && nCount < nMax)
+    {
+        CCommand** ppOverflow = NULL;
+        int nOverflow = 0;
+
+        m_cOverflow.GetAllQueuedObjects(ppOverflow, nOverflow);
+        for (int i = 0; i < nOverflow && nCount < nMax; i++)
+        {
+            ppCmdArray[nCount++] = ppOverflow[i];
+        }
+
+        delete[] ppOverflow;
+    }
+
+    return nCount;
+}
+
+BOOL CCommandQueue::CLane::Remove(CCommand* pCmd)
+{
+    for (UINT32 uiPos = m_uiHead; ; uiPos++)
+    {
+        SLOT& rSlot = m_pSlots[uiPos & m_uiMask];
+
+        if (rSlot.uiSeq != uiPos + 1)
+        {
+            break;
+        }
+
+        // Published slots are only modified by the consumer
+        __sync_synchronize();
+        if (pCmd == rSlot.pCmd)
+        {
+            rSlot.pCmd = NULL;
+            return TRUE;
+        }
+    }
+
+    if (0 != m_nOverflow && m_cOverflow.DequeueByObj(pCmd))
+    {
+        __sync_sub_and_fetch(&m_nOverflow, 1);
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+CCommandQueue::CCommandQueue() :
+    m_iCount(0)
+{
+}
+
+CCommandQueue::~CCommandQueue()
+{
+    MakeEmpty();
+}
+
+BOOL CCommandQueue::Init()
+{
+    for (int i = 0; i < E_LANE_COUNT; i++)
+    {
+        if (!m_rgLanes[i].Init(m_rguiLaneCapacity[i], E_LANE_FRONT == i))
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+// Insert command into the queue.
+// A command already present in the queue is not queued twice.
+BOOL CCommandQueue::Enqueue(CCommand* pCmd, BOOL bHighPriority, BOOL bFront)
+{
+    int iLane = bFront ? E_LANE_FRONT : (bHighPriority ? E_LANE_HIGH : E_LANE_NORMAL);
+
+    if (NULL == pCmd)
+    {
+        return FALSE;
+    }
+
+    if (!pCmd->MarkQueued())
+    {
+        RIL_LOG_WARNING("CCommandQueue::Enqueue() - Existing object found in queue\r\n");
+        return TRUE;
+    }
+
+    if (!m_rgLanes[iLane].Push(pCmd))
+    {
+        RIL_LOG_CRITICAL("CCommandQueue::Enqueue() - Cannot queue to lane %d\r\n", iLane);
+        pCmd->ClearQueued();
+        return FALSE;
+    }
+
+    __sync_add_and_fetch(&m_iCount, 1);
+    return TRUE;
+}
+
+// Test if the queue is logically empty.
+BOOL CCommandQueue::IsEmpty()
+{
+    for (int i = 0; i < E_LANE_COUNT; i++)
+    {
+        if (!m_rgLanes[i].IsEmpty())
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+// Return and remove the next command to send.
+BOOL CCommandQueue::Dequeue(CCommand*& rpCmd)
+{
+    for (int i = 0; i < E_LANE_COUNT; i++)
+    {
+        if (m_rgLanes[i].Pop(rpCmd))
+        {
+            __sync_sub_and_fetch(&m_iCount, 1);
+            rpCmd->ClearQueued();
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+// Return and remove the next command to send only if it passes the filter.
+// The order of the queue is kept: a command that does not pass stops the search.
+BOOL CCommandQueue::DequeueIf(CCommand*& rpCmd, PFN_CMD_FILTER pfnFilter)
+{
+    CCommand* pHead = NULL;
+
+    for (int i = 0; i < E_LANE_COUNT; i++)
+    {
+        if (0 == m_rgLanes[i].Snapshot(&pHead, 1))
+        {
+            continue;
+        }
+
+        // Only the consumer moves the head, so Pop() returns the command seen above
+        if (!pfnFilter(pHead) || !m_rgLanes[i].Pop(rpCmd))
+        {
+            return FALSE;
+        }
+
+        __sync_sub_and_fetch(&m_iCount, 1);
+        rpCmd->ClearQueued();
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+// Make the queue logically empty, deleting the queued commands.
+void CCommandQueue::MakeEmpty()
+{
+    CCommand* pCmd = NULL;
+
+    while (Dequeue(pCmd))
+    {
+        delete pCmd;
+        pCmd = NULL;
+    }
+}
+
+//  Return all commands in the queue, in dequeue order.
+//  Note that the caller must free the allocated array.
+void CCommandQueue::GetAllQueuedObjects(CCommand**& rpCmdArray, int& rnNumOfCommands)
+{
+    RIL_LOG_VERBOSE("CCommandQueue::GetAllQueuedObjects() - ENTER\r\n");
+
+    int nMax = 0;
+
+    rnNumOfCommands = 0;
+    rpCmdArray = NULL;
+
+    if (IsEmpty())
+    {
+        RIL_LOG_VERBOSE("CCommandQueue::GetAllQueuedObjects() - Empty!  EXIT\r\n");
+        return;
+    }
+
+    for (int i = 0; i < E_LANE_COUNT; i++)
+    {
+        nMax += m_rguiLaneCapacity[i] + m_rgLanes[i].GetOverflowCount();
+    }
+
+    rpCmdArray = new CCommand*[nMax];
+    if (NULL == rpCmdArray)
+    {
+        RIL_LOG_CRITICAL("CCommandQueue::GetAllQueuedObjects() - Cannot allocate memory for %d"
+                " command pointers\r\n", nMax);
+        return;
+    }
+
+    for (int i = 0; i < E_LANE_COUNT; i++)
+    {
+        rnNumOfCommands += m_rgLanes[i].Snapshot(rpCmdArray + rnNumOfCommands,
+                nMax - rnNumOfCommands);
+    }
+
+    RIL_LOG_VERBOSE("CCommandQueue::GetAllQueuedObjects() - count = [%d]\r\n", rnNumOfCommands);
+}
+
+//  Remove the given command from the queue.
+BOOL CCommandQueue::DequeueByObj(CCommand*& rpCmd)
+{
+    for (int i = 0; i < E_LANE_COUNT; i++)
+    {
+        if (m_rgLanes[i].Remove(rpCmd))
+        {
+            __sync_sub_and_fetch(&m_iCount, 1);
+            rpCmd->ClearQueued();
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
@@ -0,0 +1,113 @@
+////////////////////////////////////////////////////////////////////////////
+// cmdqueue.h
+//
+// Copyright 2009 Intrinsyc Software International, Inc.  All rights reserved.
+// Patents pending in the United States of America and other jurisdictions.
+//
+//
+// Description:
+//    Lock-free command queue used as the Tx queue of a channel.
+//    Any thread may enqueue; only the channel command thread may dequeue,
+//    inspect or remove commands. Each lane is a fixed size ring buffer;
+//    commands queued while it is full go to a locked overflow list so that
+//    enqueuing never fails for lack of room. The rarely used front lane is
+//    LIFO and only uses the list.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef RRIL_CMDQUEUE_H
+#define RRIL_CMDQUEUE_H
+
+#include "types.h"
+#include "rilqueue.h"
+
+class CCommand;
+
+class CCommandQueue
+{
+public:
+    typedef BOOL (*PFN_CMD_FILTER)(CCommand* pCmd);
+
+    CCommandQueue();
+    ~CCommandQueue();
+
+    BOOL Init();
+
+    // Producer API (any thread)
+    BOOL Enqueue(CCommand* pCmd, BOOL bHighPriority = FALSE, BOOL bFront = FALSE);
+
+    // Number of queued commands, a snapshot for statistics only (any thread)
+    int GetCount() const    { return m_iCount; }
+
+    // Consumer API (channel command thread only)
+    BOOL IsEmpty();
+    BOOL Dequeue(CCommand*& rpCmd);
+    BOOL DequeueIf(CCommand*& rpCmd, PFN_CMD_FILTER pfnFilter);
+    void MakeEmpty();
+    void GetAllQueuedObjects(CCommand**& rpCmdArray, int& rnNumOfCommands);
+    BOOL DequeueByObj(CCommand*& rpCmd);
+
+private:
+    // disallow copy constructor and assignment operator
+    CCommandQueue(const CCommandQueue& rQueue);
+    const CCommandQueue& operator= (const CCommandQueue& rQueue);
+
+    // Single ring buffer. A slot is free for position p when its sequence is p,
+    // and holds a published command for position p when its sequence is p + 1.
+    // A removed command leaves a NULL in its slot which the consumer skips.
+    // Once the ring is full, commands are appended to the overflow list and keep
+    // going there until the consumer has emptied it, so the lane stays FIFO.
+    // A LIFO lane leaves the ring empty and pushes to the head of the list.
+    class CLane
+    {
+    public:
+        CLane();
+        ~CLane();
+
+        BOOL Init(UINT32 uiCapacity, BOOL bLifo = FALSE);
+        BOOL Push(CCommand* pCmd);
+        BOOL Pop(CCommand*& rpCmd);
+        BOOL IsEmpty();
+        int  Snapshot(CCommand** ppCmdArray, int nMax);
+        BOOL Remove(CCommand* pCmd);
+        int  GetOverflowCount() const   { return m_nOverflow; }
+
+    private:
+        BOOL PushSlot(CCommand* pCmd);
+        BOOL PopSlot(CCommand*& rpCmd);
+
+        struct SLOT
+        {
+            volatile UINT32     uiSeq;
+            CCommand* volatile  pCmd;
+        };
+
+        SLOT*           m_pSlots;
+        UINT32          m_uiMask;
+        volatile UINT32 m_uiTail;   // next position to claim, shared by producers
+        UINT32          m_uiHead;   // next position to consume, owned by the consumer
+
+        CRilQueue<CCommand*> m_cOverflow;
+        volatile int    m_nOverflow;
+        BOOL            m_bLifo;
+    };
+
+    // Commands queued with bFront go first, then high priority, then the rest.
+    // As with CRilQueue, of two commands queued with bFront the last one queued is
+    // sent first: callers queue a sequence to send at once in reverse. The other
+    // lanes are FIFO.
+    enum
+    {
+        E_LANE_FRONT,
+        E_LANE_HIGH,
+        E_LANE_NORMAL,
+        E_LANE_COUNT
+    };
+
+    static const UINT32 m_rguiLaneCapacity[E_LANE_COUNT];
+
+    CLane m_rgLanes[E_LANE_COUNT];
+    volatile int m_iCount;
+};
+
+#endif // RRIL_CMDQUEUE_H
@@ -15,6 +15,7 @@
 #include "sync_ops.h"
 #include "cmdcontext.h"
 #include "command.h"
+#include "latency_stats.h"
 
 CCommand::CCommand( UINT32 uiChannel,
                     RIL_Token token,
@@ -33,13 +34,18 @@ CCommand::CCommand( UINT32 uiChannel,
     m_fAlwaysParse(FALSE),
     m_fHighPriority(FALSE),
     m_fIsInitCommand(FALSE),
+    m_fPipelined(FALSE),
     m_pContext(NULL),
     m_pContextData(NULL),
     m_cbContextData(0),
     m_pContextData2(NULL),
     m_cbContextData2(0),
-    m_callId(-1)
+    m_callId(-1),
+    m_iQueued(0)
 {
+    memset(m_rguiStageTime, 0, sizeof(m_rguiStageTime));
+    StampStage(E_CMD_STAGE_CREATED);
+
     if (uiChannel < g_uiRilChannelCurMax)
     {
         m_uiChannel = uiChannel;
@@ -81,13 +87,18 @@ CCommand::CCommand( UINT32 uiChannel,
     m_fAlwaysParse(FALSE),
     m_fHighPriority(FALSE),
     m_fIsInitCommand(FALSE),
+    m_fPipelined(FALSE),
     m_pContext(NULL),
     m_pContextData(NULL),
     m_cbContextData(0),
     m_pContextData2(NULL),
     m_cbContextData2(0),
-    m_callId(-1)
+    m_callId(-1),
+    m_iQueued(0)
 {
+    memset(m_rguiStageTime, 0, sizeof(m_rguiStageTime));
+    StampStage(E_CMD_STAGE_CREATED);
+
     if (uiChannel < g_uiRilChannelCurMax)
     {
         m_uiChannel = uiChannel;
@@ -140,13 +151,18 @@ CCommand::CCommand( UINT32 uiChannel,
     m_fAlwaysParse(reqData.fForceParse),
     m_fHighPriority(FALSE),
     m_fIsInitCommand(FALSE),
+    m_fPipelined(FALSE),
     m_pContext(NULL),
     m_pContextData(reqData.pContextData),
     m_cbContextData(reqData.cbContextData),
     m_pContextData2(reqData.pContextData2),
     m_cbContextData2(reqData.cbContextData2),
-    m_callId(-1)
+    m_callId(-1),
+    m_iQueued(0)
 {
+    memset(m_rguiStageTime, 0, sizeof(m_rguiStageTime));
+    StampStage(E_CMD_STAGE_CREATED);
+
     if (uiChannel < g_uiRilChannelCurMax)
     {
         m_uiChannel = uiChannel;
@@ -207,6 +223,15 @@ void CCommand::FreeContextData()
     }
 }
 
+void CCommand::StampStage(CMD_STAGE eStage)
+{
+    // Only the first time counts, e.g. the first of several send attempts
+    if (0 == m_rguiStageTime[eStage])
+    {
+        m_rguiStageTime[eStage] = GetMonotonicTickCount();
+    }
+}
+
 BOOL CCommand::AddCmdToQueue(CCommand*& rpCmd, BOOL bFront /*=false*/)
 {
     RIL_LOG_VERBOSE("CCommand::AddCmdToQueue() - Enter\r\n");
@@ -225,9 +250,20 @@ BOOL CCommand::AddCmdToQueue(CCommand*& rpCmd, BOOL bFront /*=false*/)
             rpCmd->SetTimeout(reqInfo.uiTimeout);
         }
 
+        // Only plain single AT command queries are sent back to back with others
+        if (reqInfo.bPipelined && NULL != rpCmd->GetATCmd1() && NULL == rpCmd->GetATCmd2()
+                && !rpCmd->IsInitCommand())
+        {
+            rpCmd->SetPipelined(TRUE);
+        }
+
         UINT32 nChannel = rpCmd->GetChannel();
-        if (g_pTxQueue[nChannel]->Enqueue(rpCmd, (UINT32)(rpCmd->IsHighPriority()), bFront ))
+        rpCmd->StampStage(E_CMD_STAGE_QUEUED);
+        if (g_pTxQueue[nChannel]->Enqueue(rpCmd, rpCmd->IsHighPriority(), bFront))
         {
+            CLatencyStats::SampleQueueDepth(nChannel, CLatencyStats::E_QUEUE_TX,
+                    g_pTxQueue[nChannel]->GetCount());
+
             // signal Tx thread
             (void) CEvent::Signal(g_TxQueueEvent[nChannel]);
 
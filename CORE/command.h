@@ -23,6 +23,18 @@
 class CContext;
 class CTE;
 
+// Lifecycle stages of a command, stamped for the latency statistics
+enum CMD_STAGE
+{
+    E_CMD_STAGE_CREATED,    // request handler built the command
+    E_CMD_STAGE_QUEUED,     // added to the channel Tx queue
+    E_CMD_STAGE_SENT,       // first AT command written to the port
+    E_CMD_STAGE_RESPONDED,  // final response read from the Rx queue
+    E_CMD_STAGE_PARSED,     // response parse function returned
+    E_CMD_STAGE_COMPLETED,  // post command handler returned
+    E_CMD_STAGE_COUNT
+};
+
 typedef RIL_RESULT_CODE (CTE::*PFN_TE_PARSE) (RESPONSE_DATA& rRspData);
 typedef void (CTE::*PFN_TE_POSTCMDHANDLER) (POST_CMD_HANDLER_DATA& rRspData);
 
@@ -81,11 +93,13 @@ public:
     BOOL                IsAlwaysParse()     { return m_fAlwaysParse; };
     BOOL                IsHighPriority()    { return m_fHighPriority; };
     BOOL                IsInitCommand()     { return m_fIsInitCommand; };
+    BOOL                IsPipelined()       { return m_fPipelined; };
 
     void SetTimeout(UINT32 uiTimeout)       { m_uiTimeout = uiTimeout;  };
     void SetAlwaysParse()                   { m_fAlwaysParse = TRUE;    };
     void SetHighPriority()                  { m_fHighPriority = TRUE; };
     void SetInitCommand()                   { m_fIsInitCommand = TRUE; };
+    void SetPipelined(BOOL bPipelined)      { m_fPipelined = bPipelined; };
     void SetContext(CContext*& pContext)    { m_pContext = pContext; pContext = NULL; };
     void SetContextData(void* pData)        { m_pContextData = pData; };
     void SetContextDataSize(UINT32 nSize)   { m_cbContextData = nSize; };
@@ -94,9 +108,18 @@ public:
 
     void FreeContextData();
 
+    void StampStage(CMD_STAGE eStage);
+    UINT32 GetStageTime(CMD_STAGE eStage)   { return m_rguiStageTime[eStage]; };
+
     static BOOL AddCmdToQueue(CCommand*& pCmd, BOOL bFront = false);
 
 private:
+    friend class CCommandQueue;
+
+    // Tx queue membership flag, used by CCommandQueue to reject duplicates
+    BOOL MarkQueued()   { return __sync_bool_compare_and_swap(&m_iQueued, 0, 1); };
+    void ClearQueued()  { __sync_lock_release(&m_iQueued); };
+
 
     UINT32              m_uiChannel;
     RIL_Token           m_token;
@@ -109,12 +132,15 @@ private:
     BOOL                m_fAlwaysParse;
     BOOL                m_fHighPriority;
     BOOL                m_fIsInitCommand;
+    BOOL                m_fPipelined;
     CContext*           m_pContext;
     void*               m_pContextData;
     UINT32              m_cbContextData;
     void*               m_pContextData2;
     UINT32              m_cbContextData2;
     int                 m_callId;
+    volatile int        m_iQueued;
+    UINT32              m_rguiStageTime[E_CMD_STAGE_COUNT];
 };
 
 #endif
@@ -0,0 +1,423 @@
+////////////////////////////////////////////////////////////////////////////
+// latency_stats.cpp
+//
+// Copyright 2009 Intrinsyc Software International, Inc.  All rights reserved.
+// Patents pending in the United States of America and other jurisdictions.
+//
+//
+// Description:
+//    Implementation of the request latency histograms and queue depth gauges.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <string.h>
+
+#include "types.h"
+#include "rillog.h"
+#include "sync_ops.h"
+#include "command.h"
+#include "request_id.h"
+#include "request_info.h"
+#include "repository.h"
+#include "response.h"
+#include "systemmanager.h"
+#include "latency_stats.h"
+
+// Size of the report written to the log by Dump()
+static const UINT32 DUMP_REPORT_SIZE = 8192;
+
+CMutex* CLatencyStats::m_pLock = NULL;
+CLatencyStats::CHANNEL_STATS CLatencyStats::m_rgChannelStats[RIL_CHANNEL_MAX];
+CLatencyHistogram* CLatencyStats::m_pRequestStats = NULL;
+int CLatencyStats::m_iRequestStatsCount = 0;
+UINT32 CLatencyStats::m_uiDumpInterval = 0;
+
+///////////////////////////////////////////////////////////////////////////////
+void CLatencyHistogram::Reset()
+{
+    memset(m_rguiBuckets, 0, sizeof(m_rguiBuckets));
+    m_uiCount = 0;
+    m_uiMax = 0;
+}
+
+UINT32 CLatencyHistogram::GetBucket(UINT32 uiValue)
+{
+    UINT32 uiExponent;
+
+    if (uiValue < E_LINEAR_BUCKETS)
+    {
+        return uiValue;
+    }
+
+    uiExponent = 31 - __builtin_clz(uiValue);
+    if (uiExponent > E_MAX_EXPONENT)
+    {
+        return E_BUCKET_COUNT - 1;
+    }
+
+    // the two bits below the leading one select the sub-bucket
+    return E_LINEAR_BUCKETS + (uiExponent - 3) * E_SUB_BUCKETS
+            + ((uiValue >> (uiExponent - 2)) & (E_SUB_BUCKETS - 1));
+}
+
+UINT32 CLatencyHistogram::GetBucketUpperBound(UINT32 uiBucket)
+{
+    UINT32 uiExponent;
+    UINT32 uiSub;
+
+    if (uiBucket < E_LINEAR_BUCKETS)
+    {
+        return uiBucket;
+    }
+
+    uiExponent = 3 + (uiBucket - E_LINEAR_BUCKETS) / E_SUB_BUCKETS;
+    uiSub = (uiBucket - E_LINEAR_BUCKETS) % E_SUB_BUCKETS;
+
+    return ((E_SUB_BUCKETS + uiSub + 1) << (uiExponent - 2)) - 1;
+}
+
+void CLatencyHistogram::Add(UINT32 uiValue)
+{
+    m_rguiBuckets[GetBucket(uiValue)]++;
+    m_uiCount++;
+
+    if (uiValue > m_uiMax)
+    {
+        m_uiMax = uiValue;
+    }
+}
+
+UINT32 CLatencyHistogram::GetPercentile(UINT32 uiPercent) const
+{
+    UINT32 uiRank;
+    UINT32 uiSeen = 0;
+
+    if (0 == m_uiCount)
+    {
+        return 0;
+    }
+
+    // nearest-rank: the smallest bucket holding at least uiPercent % of the samples
+    uiRank = (UINT32)(((unsigned long long)m_uiCount * uiPercent + 99) / 100);
+    if (0 == uiRank)
+    {
+        uiRank = 1;
+    }
+
+    for (UINT32 i = 0; i < E_BUCKET_COUNT; i++)
+    {
+        uiSeen += m_rguiBuckets[i];
+        if (uiSeen >= uiRank)
+        {
+            UINT32 uiBound = GetBucketUpperBound(i);
+            return (uiBound < m_uiMax) ? uiBound : m_uiMax;
+        }
+    }
+
+    return m_uiMax;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+BOOL CLatencyStats::Init()
+{
+    CRepository repository;
+    int iTemp = 0;
+
+    if (NULL != m_pLock)
+    {
+        return TRUE;
+    }
+
+    if (repository.Read(g_szGroupLogging, g_szLatencyStatsDumpInterval, iTemp) && iTemp > 0)
+    {
+        m_uiDumpInterval = (UINT32)iTemp;
+    }
+
+    // one histogram per ril request ID, per internal request ID and one for the rest
+    m_iRequestStatsCount = REQ_ID_TOTAL + INTERNAL_REQ_ID_TOTAL + 1;
+    m_pRequestStats = new CLatencyHistogram[m_iRequestStatsCount];
+    if (NULL == m_pRequestStats)
+    {
+        RIL_LOG_CRITICAL("CLatencyStats::Init() - Cannot allocate %d histograms\r\n",
+                m_iRequestStatsCount);
+        goto Error;
+    }
+
+    m_pLock = new CMutex();
+    if (NULL == m_pLock)
+    {
+        RIL_LOG_CRITICAL("CLatencyStats::Init() - Cannot allocate lock\r\n");
+        goto Error;
+    }
+
+    RIL_LOG_INFO("CLatencyStats::Init() - Dump interval [%u] s\r\n", m_uiDumpInterval);
+    return TRUE;
+
+Error:
+    delete[] m_pRequestStats;
+    m_pRequestStats = NULL;
+    m_iRequestStatsCount = 0;
+    return FALSE;
+}
+
+void CLatencyStats::Destroy()
+{
+    CMutex* pLock = m_pLock;
+
+    if (NULL == pLock)
+    {
+        return;
+    }
+
+    CMutex::Lock(pLock);
+    m_pLock = NULL;
+    delete[] m_pRequestStats;
+    m_pRequestStats = NULL;
+    m_iRequestStatsCount = 0;
+    CMutex::Unlock(pLock);
+
+    delete pLock;
+}
+
+int CLatencyStats::GetRequestIndex(int reqId)
+{
+    if (reqId >= 0 && reqId < REQ_ID_TOTAL)
+    {
+        return reqId;
+    }
+
+    if (reqId >= INTERNAL_REQ_ID_START && reqId < INTERNAL_REQ_ID_START + INTERNAL_REQ_ID_TOTAL)
+    {
+        return REQ_ID_TOTAL + reqId - INTERNAL_REQ_ID_START;
+    }
+
+    // REQ_ID_NONE: init strings, silo commands without a request...
+    return REQ_ID_TOTAL + INTERNAL_REQ_ID_TOTAL;
+}
+
+const char* CLatencyStats::GetRequestName(int iIndex)
+{
+    const char* pszName = NULL;
+
+    if (iIndex < REQ_ID_TOTAL)
+    {
+        if (NULL != g_pReqInfo)
+        {
+            pszName = g_pReqInfo[iIndex].szName;
+        }
+    }
+    else if (iIndex < REQ_ID_TOTAL + INTERNAL_REQ_ID_TOTAL)
+    {
+        pszName = g_ReqInternal[iIndex - REQ_ID_TOTAL].reqInfo.szName;
+    }
+    else
+    {
+        pszName = "Other";
+    }
+
+    return (NULL == pszName || '\0' == pszName[0]) ? "Unknown" : pszName;
+}
+
+void CLatencyStats::AddInterval(CLatencyHistogram& rHistogram, CCommand* pCmd, int iFrom, int iTo)
+{
+    UINT32 uiFrom = pCmd->GetStageTime((CMD_STAGE)iFrom);
+    UINT32 uiTo = pCmd->GetStageTime((CMD_STAGE)iTo);
+
+    // a stage the command never reached (e.g. no response on timeout) is not stamped
+    if (0 != uiFrom && 0 != uiTo && uiTo >= uiFrom)
+    {
+        rHistogram.Add(uiTo - uiFrom);
+    }
+}
+
+void CLatencyStats::Record(CCommand* pCmd, UINT32 uiChannel)
+{
+    if (NULL == m_pLock || NULL == pCmd || uiChannel >= RIL_CHANNEL_MAX)
+    {
+        return;
+    }
+
+    CMutex::Lock(m_pLock);
+
+    if (NULL != m_pRequestStats)
+    {
+        CLatencyHistogram* pHistograms = m_rgChannelStats[uiChannel].rgHistograms;
+
+        AddInterval(pHistograms[E_INTERVAL_QUEUE], pCmd, E_CMD_STAGE_QUEUED, E_CMD_STAGE_SENT);
+        AddInterval(pHistograms[E_INTERVAL_MODEM], pCmd, E_CMD_STAGE_SENT,
+                E_CMD_STAGE_RESPONDED);
+        AddInterval(pHistograms[E_INTERVAL_PARSE], pCmd, E_CMD_STAGE_RESPONDED,
+                E_CMD_STAGE_PARSED);
+        AddInterval(pHistograms[E_INTERVAL_COMPLETE], pCmd, E_CMD_STAGE_PARSED,
+                E_CMD_STAGE_COMPLETED);
+
+        AddInterval(m_pRequestStats[GetRequestIndex(pCmd->GetRequestID())], pCmd,
+                E_CMD_STAGE_CREATED, E_CMD_STAGE_COMPLETED);
+    }
+
+    CMutex::Unlock(m_pLock);
+}
+
+void CLatencyStats::SampleQueueDepth(UINT32 uiChannel, QUEUE eQueue, int iDepth)
+{
+    int* piMaxDepth;
+    int iMax;
+
+    if (uiChannel >= RIL_CHANNEL_MAX || eQueue >= E_QUEUE_COUNT)
+    {
+        return;
+    }
+
+    // lock-free so that the Tx/Rx paths never wait on a report being written
+    piMaxDepth = &m_rgChannelStats[uiChannel].rgiMaxDepth[eQueue];
+    iMax = *piMaxDepth;
+    while (iDepth > iMax)
+    {
+        if (__sync_bool_compare_and_swap(piMaxDepth, iMax, iDepth))
+        {
+            break;
+        }
+        iMax = *piMaxDepth;
+    }
+}
+
+UINT32 CLatencyStats::FormatHistogram(const CLatencyHistogram& rHistogram, char* pszBuffer,
+        UINT32 uiBufferSize)
+{
+    int iLen = snprintf(pszBuffer, uiBufferSize, "%u:%u/%u/%u/%u", rHistogram.GetCount(),
+            rHistogram.GetPercentile(50), rHistogram.GetPercentile(90),
+            rHistogram.GetPercentile(99), rHistogram.GetMax());
+
+    return (iLen < 0) ? 0 : (UINT32)iLen;
+}
+
+//
+//  The report is plain text, one line per channel then one per request ID that
+//  was completed at least once. Latencies are in ms, given as
+//  "count:p50/p90/p99/max". Queue depths are given as "current/high-water".
+//
+UINT32 CLatencyStats::GetReport(char* pszBuffer, UINT32 uiBufferSize)
+{
+    UINT32 uiLen = 0;
+    char szQueue[32];
+    char szModem[32];
+    char szParse[32];
+    char szComplete[32];
+    char szTotal[32];
+
+    if (NULL == pszBuffer || 0 == uiBufferSize)
+    {
+        return 0;
+    }
+    pszBuffer[0] = '\0';
+
+    if (NULL == m_pLock)
+    {
+        return 0;
+    }
+
+    CMutex::Lock(m_pLock);
+
+    for (UINT32 i = 0; i < g_uiRilChannelCurMax && i < RIL_CHANNEL_MAX; i++)
+    {
+        const CHANNEL_STATS& rStats = m_rgChannelStats[i];
+        int iTxDepth = (NULL != g_pTxQueue[i]) ?
+                g_pTxQueue[i]->GetCount() : 0;
+        int iRxDepth = (NULL != g_pRxQueue[i]) ?
+                g_pRxQueue[i]->GetCount() : 0;
+        int iWritten;
+
+        if (0 == rStats.rgHistograms[E_INTERVAL_MODEM].GetCount()
+                && 0 == rStats.rgHistograms[E_INTERVAL_QUEUE].GetCount())
+        {
+            continue;
+        }
+
+        FormatHistogram(rStats.rgHistograms[E_INTERVAL_QUEUE], szQueue, sizeof(szQueue));
+        FormatHistogram(rStats.rgHistograms[E_INTERVAL_MODEM], szModem, sizeof(szModem));
+        FormatHistogram(rStats.rgHistograms[E_INTERVAL_PARSE], szParse, sizeof(szParse));
+        FormatHistogram(rStats.rgHistograms[E_INTERVAL_COMPLETE], szComplete,
+                sizeof(szComplete));
+
+        iWritten = snprintf(pszBuffer + uiLen, uiBufferSize - uiLen,
+                "chnl=[%u] tx=[%d/%d] rx=[%d/%d] queue=[%s] modem=[%s] parse=[%s]"
+                " complete=[%s]\n", i, iTxDepth, rStats.rgiMaxDepth[E_QUEUE_TX], iRxDepth,
+                rStats.rgiMaxDepth[E_QUEUE_RX], szQueue, szModem, szParse, szComplete);
+        if (iWritten < 0 || (UINT32)iWritten >= uiBufferSize - uiLen)
+        {
+            goto Truncated;
+        }
+        uiLen += iWritten;
+    }
+
+    for (int i = 0; i < m_iRequestStatsCount; i++)
+    {
+        int iWritten;
+
+        if (0 == m_pRequestStats[i].GetCount())
+        {
+            continue;
+        }
+
+        FormatHistogram(m_pRequestStats[i], szTotal, sizeof(szTotal));
+
+        iWritten = snprintf(pszBuffer + uiLen, uiBufferSize - uiLen, "%s=[%s]\n",
+                GetRequestName(i), szTotal);
+        if (iWritten < 0 || (UINT32)iWritten >= uiBufferSize - uiLen)
+        {
+            goto Truncated;
+        }
+        uiLen += iWritten;
+    }
+
+    CMutex::Unlock(m_pLock);
+    return uiLen;
+
+Truncated:
+    // drop the partial line
+    pszBuffer[uiLen] = '\0';
+    CMutex::Unlock(m_pLock);
+    RIL_LOG_WARNING("CLatencyStats::GetReport() - Report truncated at %u bytes\r\n", uiLen);
+    return uiLen;
+}
+
+void CLatencyStats::Dump()
+{
+    char* pszReport = NULL;
+    char* pszLine = NULL;
+    char* pszEnd = NULL;
+
+    if (NULL == m_pLock)
+    {
+        return;
+    }
+
+    pszReport = new char[DUMP_REPORT_SIZE];
+    if (NULL == pszReport)
+    {
+        RIL_LOG_CRITICAL("CLatencyStats::Dump() - Cannot allocate report buffer\r\n");
+        return;
+    }
+
+    // format under the lock, log outside of it
+    GetReport(pszReport, DUMP_REPORT_SIZE);
+
+    RIL_LOG_INFO("CLatencyStats::Dump() - Latency in ms as count:p50/p90/p99/max,"
+            " queue depth as current/max\r\n");
+
+    for (pszLine = pszReport; '\0' != *pszLine; pszLine = pszEnd + 1)
+    {
+        pszEnd = strchr(pszLine, '\n');
+        if (NULL == pszEnd)
+        {
+            RIL_LOG_INFO("CLatencyStats::Dump() - %s\r\n", pszLine);
+            break;
+        }
+
+        *pszEnd = '\0';
+        RIL_LOG_INFO("CLatencyStats::Dump() - %s\r\n", pszLine);
+    }
+
+    delete[] pszReport;
+}
@@ -0,0 +1,116 @@
+////////////////////////////////////////////////////////////////////////////
+// latency_stats.h
+//
+// Copyright 2009 Intrinsyc Software International, Inc.  All rights reserved.
+// Patents pending in the United States of America and other jurisdictions.
+//
+//
+// Description:
+//    Request latency histograms and queue depth gauges. Commands are stamped
+//    at each stage of their life (see CMD_STAGE) and the time spent between
+//    stages is aggregated per channel, the total time per request ID.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef RRIL_LATENCY_STATS_H
+#define RRIL_LATENCY_STATS_H
+
+#include "types.h"
+#include "rilchannels.h"
+
+class CCommand;
+class CMutex;
+
+//
+// Log-linear histogram of millisecond values. Values below 8 ms have a bucket
+// each; above that every power of two is split into 4 buckets, so a reported
+// percentile is at most 25% above the real value.
+//
+class CLatencyHistogram
+{
+public:
+    CLatencyHistogram() { Reset(); }
+
+    void Reset();
+    void Add(UINT32 uiValue);
+
+    UINT32 GetCount() const     { return m_uiCount; }
+    UINT32 GetMax() const       { return m_uiMax; }
+    UINT32 GetPercentile(UINT32 uiPercent) const;
+
+private:
+    enum
+    {
+        E_LINEAR_BUCKETS = 8,
+        E_SUB_BUCKETS = 4,
+        E_MAX_EXPONENT = 21,    // values from 2^22 ms (70 min) share the last bucket
+        E_BUCKET_COUNT = E_LINEAR_BUCKETS + (E_MAX_EXPONENT - 2) * E_SUB_BUCKETS
+    };
+
+    static UINT32 GetBucket(UINT32 uiValue);
+    static UINT32 GetBucketUpperBound(UINT32 uiBucket);
+
+    UINT32 m_rguiBuckets[E_BUCKET_COUNT];
+    UINT32 m_uiCount;
+    UINT32 m_uiMax;
+};
+
+class CLatencyStats
+{
+public:
+    enum QUEUE
+    {
+        E_QUEUE_TX,
+        E_QUEUE_RX,
+        E_QUEUE_COUNT
+    };
+
+    static BOOL Init();
+    static void Destroy();
+
+    // Account a command that went through CChannel::SendCommand()
+    static void Record(CCommand* pCmd, UINT32 uiChannel);
+
+    // Update the high-water mark of a channel queue
+    static void SampleQueueDepth(UINT32 uiChannel, QUEUE eQueue, int iDepth);
+
+    // Write the report, one line per channel and per request ID seen so far.
+    // Returns the length of the report.
+    static UINT32 GetReport(char* pszBuffer, UINT32 uiBufferSize);
+
+    // Write the report to the log
+    static void Dump();
+
+    // Period of the log dump in seconds, 0 if disabled
+    static UINT32 GetDumpInterval() { return m_uiDumpInterval; }
+
+private:
+    enum INTERVAL
+    {
+        E_INTERVAL_QUEUE,       // queued -> sent
+        E_INTERVAL_MODEM,       // sent -> responded
+        E_INTERVAL_PARSE,       // responded -> parsed
+        E_INTERVAL_COMPLETE,    // parsed -> completed
+        E_INTERVAL_COUNT
+    };
+
+    struct CHANNEL_STATS
+    {
+        CLatencyHistogram rgHistograms[E_INTERVAL_COUNT];
+        int rgiMaxDepth[E_QUEUE_COUNT];
+    };
+
+    static void AddInterval(CLatencyHistogram& rHistogram, CCommand* pCmd, int iFrom, int iTo);
+    static int GetRequestIndex(int reqId);
+    static const char* GetRequestName(int iIndex);
+    static UINT32 FormatHistogram(const CLatencyHistogram& rHistogram, char* pszBuffer,
+            UINT32 uiBufferSize);
+
+    static CMutex* m_pLock;
+    static CHANNEL_STATS m_rgChannelStats[RIL_CHANNEL_MAX];
+    static CLatencyHistogram* m_pRequestStats;
+    static int m_iRequestStatsCount;
+    static UINT32 m_uiDumpInterval;
+};
+
+#endif // RRIL_LATENCY_STATS_H
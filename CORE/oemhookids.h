@@ -386,6 +386,21 @@ const int RIL_OEM_HOOK_STRING_IMS_SRVCC_PARAM = 0x000000B7;
 
 ///////////////////////////////////////////////////////////////////////////////
 
+//
+//  RIL_OEM_HOOK_STRING_GET_LATENCY_STATS
+//  Command ID = 0x000000B8
+//
+//  This command returns the command latency statistics gathered since start-up,
+//  one line per channel then one line per request ID. Latencies are in ms given
+//  as "count:p50/p90/p99/max", queue depths as "current/max".
+//
+//  "data" = NULL
+//  "response" = A string containing the statistics report.
+//
+const int RIL_OEM_HOOK_STRING_GET_LATENCY_STATS = 0x000000B8;
+
+///////////////////////////////////////////////////////////////////////////////
+
 typedef struct TAG_OEM_HOOK_RAW_UNSOL_THERMAL_ALARM_IND
 {
     int nCommand; //  Command ID
@@ -285,8 +285,9 @@ BOOL CPort::OpenSocket(const char* pszSocketName)
 {
     RIL_LOG_VERBOSE("CPort::OpenSocket() - Enter\r\n");
 
-    // TODO : Pull this from repository
-    const char szSocketInit[] = "gsm";
+    CRepository repository;
+    char szSocketInit[MAX_BUFFER_SIZE] = "gsm";
+    int iTemp = 0;
 
     UINT32 uiBytesWritten = 0;
     UINT32 uiBytesRead = 0;
@@ -294,8 +295,26 @@ BOOL CPort::OpenSocket(const char* pszSocketName)
 
     BOOL fRet = FALSE;
 
-    const UINT32 uiRetries = 30;
-    const UINT32 uiInterval = 2000;
+    UINT32 uiRetries = 30;
+    UINT32 uiInterval = 2000;
+
+    // An empty init string disables the handshake, for peers only speaking AT
+    // such as a modem simulator.
+    if (!repository.Read(g_szGroupRILSettings, g_szSocketInit, szSocketInit,
+            MAX_BUFFER_SIZE))
+    {
+        CopyStringNullTerminate(szSocketInit, "gsm", MAX_BUFFER_SIZE);
+    }
+
+    if (repository.Read(g_szGroupRILSettings, g_szOpenPortRetries, iTemp) && iTemp > 0)
+    {
+        uiRetries = (UINT32)iTemp;
+    }
+
+    if (repository.Read(g_szGroupRILSettings, g_szOpenPortInterval, iTemp) && iTemp >= 0)
+    {
+        uiInterval = (UINT32)iTemp;
+    }
 
     for (UINT32 uiAttempts = 0; uiAttempts < uiRetries; uiAttempts++)
     {
@@ -311,7 +330,7 @@ BOOL CPort::OpenSocket(const char* pszSocketName)
         Sleep(uiInterval);
     }
 
-    if (fRet)
+    if (fRet && '\0' != szSocketInit[0])
     {
         if (Write(szSocketInit, strlen(szSocketInit), uiBytesWritten))
         {
@@ -59,8 +59,17 @@ extern const char   g_szTimeoutWaitForXIREG[];
 extern const char   g_szGroupRILSettings[];
 
 extern const char   g_szTimeoutThresholdForRetry[];
+extern const char   g_szMaxPipelinedCommands[];
+extern const char   g_szRequestCacheTTL[];
+extern const char   g_szChannelReactor[];
 extern const char   g_szOpenPortRetries[];
 extern const char   g_szOpenPortInterval[];
+extern const char   g_szSocketInit[];
+extern const char   g_szMaxInitCmdLineLength[];
+extern const char   g_szSignalHysteresisGW[];
+extern const char   g_szSignalHysteresisLTE[];
+extern const char   g_szSignalMinInterval[];
+extern const char   g_szSimFileCacheEnabled[];
 extern const char   g_szPinCacheMode[];
 
 /////////////////////////////////////////////////
@@ -116,6 +125,7 @@ extern const char   g_szGroupLogging[];
 
 extern const char   g_szCallDropReporting[];
 extern const char   g_szLogLevel[];
+extern const char   g_szLatencyStatsDumpInterval[];
 
 //////////////////////////////////////////////////////////////////////////
 
@@ -144,6 +154,11 @@ public:
     static BOOL Init();
     static BOOL Close();
 
+    // Re-parses the repository file and atomically replaces the in-memory
+    // snapshot served by Read(). Readers still holding the previous snapshot
+    // keep using it until they are done.
+    static BOOL Reload();
+
 public:
     // APIs to read from and write to the NVM
     // if successful, return 0
@@ -154,48 +169,62 @@ public:
                                                                                       int iMaxVal);
 
 private:
-    // file access and manipulation
-    BOOL  OpenRepositoryFile(void);
-    void  CloseRepositoryFile(void);
-    int   ReadLine(char* szBuf = NULL, bool bRemoveCRAndLF = true);
-    void  RemoveComment(char* szIn);
-    char* SkipSpace(char* szIn);
-    void  RemoveTrailingSpaces(char* szIn);
-    char* SkipAlphaNum(char* szIn);
-    int   DumpLines(int iFd, int iFrom, int iTo);
-    void  ResetFile(void);
-    int   GotoLine(int iLine);
-
-    // marker location utilities
-    int LocateGroup(const char* szGroup);
-    int LocateKey(const char* szKey, char* szOut = NULL);
-    int ExtractValue(char* szIn, char* szRes, UINT32 iMaxLen);
-
-    // locking/unlocking access to the NVM file
-    int ReaderLock();
-    int ReaderUnlock();
+    // One "key value" line of the repository. Names point into the snapshot
+    // buffer and are not NUL-terminated; values are.
+    struct CRepEntry
+    {
+        UINT32      uiHash;         // hash of group and key names, 0 if slot is free
+        const char* pszGroup;
+        UINT32      uiGroupLen;
+        const char* pszKey;
+        UINT32      uiKeyLen;
+        const char* pszValue;
+    };
 
-private:
-    struct CRepLock
+    // Immutable parsed image of the repository file
+    struct CRepSnapshot
     {
-        pthread_mutex_t stLock;         // master lock
-        pthread_cond_t  stRead;         // lock for reader threads
-        UINT32          iReaders;       // # reader threads accessing the file
-        UINT32          iReadWaiters;   // # reader threads waiting to access the file
+        char*       pBuffer;        // file content, parsed in place
+        size_t      uiBufferSize;
+        BOOL        bMapped;        // TRUE if pBuffer is a private mapping of the file
+        CRepEntry*  pEntries;       // open-addressed hash table
+        UINT32      uiMask;         // table size - 1 (table size is a power of 2)
+        UINT32      uiRefs;         // # readers holding this snapshot
     };
 
-    static struct CRepLock m_stLock;
+    // snapshot building and lookup
+    static CRepSnapshot* LoadSnapshot(void);
+    static BOOL  MapRepositoryFile(CRepSnapshot* pSnapshot);
+    static BOOL  ParseSnapshot(CRepSnapshot* pSnapshot);
+    static void  DestroySnapshot(CRepSnapshot* pSnapshot);
+    static void  InsertEntry(CRepSnapshot* pSnapshot, const char* pszGroup, UINT32 uiGroupLen,
+                                                      const char* pszKey, UINT32 uiKeyLen,
+                                                      const char* pszValue);
+    static const CRepEntry* FindEntry(const CRepSnapshot* pSnapshot, const char* szGroup,
+                                                                     const char* szKey);
+    static UINT32 Hash(const char* pszGroup, UINT32 uiGroupLen, const char* pszKey,
+                                                                UINT32 uiKeyLen);
+
+    // line manipulation
+    static void  RemoveComment(char* szIn);
+    static char* SkipSpace(char* szIn);
+    static void  RemoveTrailingSpaces(char* szIn);
+    static char* SkipAlphaNum(char* szIn);
+
+    // reference counting of the current snapshot
+    static CRepSnapshot* AcquireSnapshot();
+    static void ReleaseSnapshot(CRepSnapshot* pSnapshot);
+
+private:
+    static pthread_mutex_t m_stLock;            // protects m_pSnapshot and uiRefs
+    static CRepSnapshot*   m_pSnapshot;         // snapshot served to readers
 
 private:
     // constants
-    static const int END_OF_FILE  = -1;
     static const int MAX_INT_LEN  = 20;     // arbitrary number, long enough to hold a
                                             // string-representation of a 32-bit int
-    static const int MAX_LINE_LEN = 256;    // maximum length for a line in the NVM file
 
 private:
-    int m_iFd;                                    // file descriptor
-    int m_iLine;                                  // current line in file
     static bool m_bInitialized;                   // TRUE if repository initialized, FALSE otherwise
     static char  m_cRepoPath[MAX_MODEM_NAME_LEN]; // repository path
 };
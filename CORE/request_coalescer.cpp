@@ -0,0 +1,464 @@
+////////////////////////////////////////////////////////////////////////////
+// request_coalescer.cpp
+//
+// Copyright 2009 Intrinsyc Software International, Inc.  All rights reserved.
+// Patents pending in the United States of America and other jurisdictions.
+//
+//
+// Description:
+//    Implementation of the coalescing of identical RIL requests.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "types.h"
+#include "rillog.h"
+#include "sync_ops.h"
+#include "util.h"
+#include "repository.h"
+#include "rildmain.h"
+#include "request_coalescer.h"
+
+// A request in flight for longer than this is not joined anymore, and its entry
+// can be reused
+static const UINT32 MAX_INFLIGHT_AGE = 60000;  // ms
+
+// Default lifetime of a cached result
+static const UINT32 DEFAULT_CACHE_TTL = 1000;  // ms
+
+// Requests that can be coalesced. They are queries with no payload, or a payload
+// holding no pointer, as the payload is compared byte by byte.
+const CRequestCoalescer::POLICY CRequestCoalescer::m_rgPolicies[] =
+{
+    { RIL_REQUEST_SIGNAL_STRENGTH, E_RESPONSE_FLAT, RIL_UNSOL_SIGNAL_STRENGTH },
+    { RIL_REQUEST_VOICE_REGISTRATION_STATE, E_RESPONSE_STRINGS,
+            RIL_UNSOL_RESPONSE_VOICE_NETWORK_STATE_CHANGED },
+    { RIL_REQUEST_DATA_REGISTRATION_STATE, E_RESPONSE_STRINGS,
+            RIL_UNSOL_RESPONSE_VOICE_NETWORK_STATE_CHANGED },
+    { RIL_REQUEST_OPERATOR, E_RESPONSE_STRINGS,
+            RIL_UNSOL_RESPONSE_VOICE_NETWORK_STATE_CHANGED },
+    { RIL_REQUEST_QUERY_NETWORK_SELECTION_MODE, E_RESPONSE_FLAT,
+            RIL_UNSOL_RESPONSE_VOICE_NETWORK_STATE_CHANGED },
+    // the list of calls is only shared with requests arriving while it is read
+    { RIL_REQUEST_GET_CURRENT_CALLS, E_RESPONSE_NOT_CACHED,
+            RIL_UNSOL_RESPONSE_CALL_STATE_CHANGED },
+    { 0, E_RESPONSE_NOT_CACHED, 0 }
+};
+
+CMutex* CRequestCoalescer::m_pLock = NULL;
+CRequestCoalescer::INFLIGHT CRequestCoalescer::m_rgInflight[E_MAX_INFLIGHT];
+CRequestCoalescer::CACHED CRequestCoalescer::m_rgCached[E_MAX_CACHED];
+volatile int CRequestCoalescer::m_iInflightCount = 0;
+UINT32 CRequestCoalescer::m_uiCacheTTL = DEFAULT_CACHE_TTL;
+
+///////////////////////////////////////////////////////////////////////////////
+BOOL CRequestCoalescer::Init()
+{
+    CRepository repository;
+    int iTemp = 0;
+
+    if (NULL != m_pLock)
+    {
+        return TRUE;
+    }
+
+    if (repository.Read(g_szGroupRILSettings, g_szRequestCacheTTL, iTemp) && iTemp >= 0)
+    {
+        m_uiCacheTTL = (UINT32)iTemp;
+    }
+
+    memset(m_rgInflight, 0, sizeof(m_rgInflight));
+    memset(m_rgCached, 0, sizeof(m_rgCached));
+    m_iInflightCount = 0;
+
+    m_pLock = new CMutex();
+    if (NULL == m_pLock)
+    {
+        RIL_LOG_CRITICAL("CRequestCoalescer::Init() - Cannot allocate lock\r\n");
+        return FALSE;
+    }
+
+    RIL_LOG_INFO("CRequestCoalescer::Init() - Cache TTL [%u] ms\r\n", m_uiCacheTTL);
+    return TRUE;
+}
+
+void CRequestCoalescer::Destroy()
+{
+    CMutex* pLock = m_pLock;
+
+    if (NULL == pLock)
+    {
+        return;
+    }
+
+    CMutex::Lock(pLock);
+    m_pLock = NULL;
+    for (int i = 0; i < E_MAX_CACHED; i++)
+    {
+        FreeCached(m_rgCached[i]);
+    }
+    CMutex::Unlock(pLock);
+
+    delete pLock;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+BOOL CRequestCoalescer::Attach(int reqId, const void* pData, size_t datalen,
+        RIL_Token hRilToken)
+{
+    const POLICY* pPolicy = GetPolicy(reqId);
+    INFLIGHT* pFree = NULL;
+    INFLIGHT* pStale = NULL;
+    RIL_Token rghStaleFollowers[E_MAX_FOLLOWERS];
+    UINT32 nStaleFollowers = 0;
+    void* pResponse = NULL;
+    size_t responseLen = 0;
+    BOOL bCacheHit = FALSE;
+    BOOL bAttached = FALSE;
+    UINT32 uiHash;
+    UINT32 uiNow;
+
+    if (NULL == pPolicy || NULL == m_pLock)
+    {
+        return FALSE;
+    }
+
+    uiHash = GetHash(reqId, pData, datalen);
+
+    CMutex::Lock(m_pLock);
+    uiNow = GetMonotonicTickCount();
+
+    for (int i = 0; i < E_MAX_CACHED && m_uiCacheTTL > 0; i++)
+    {
+        CACHED& rCached = m_rgCached[i];
+
+        if (pPolicy != rCached.pPolicy || uiHash != rCached.uiHash)
+        {
+            continue;
+        }
+
+        if (uiNow - rCached.uiTime < m_uiCacheTTL)
+        {
+            // complete with a copy, the cached one may go while the lock is released
+            pResponse = CopyResponse(pPolicy->eType, rCached.pResponse, rCached.responseLen);
+            if (NULL != pResponse || 0 == rCached.responseLen)
+            {
+                responseLen = rCached.responseLen;
+                bCacheHit = TRUE;
+            }
+        }
+        else
+        {
+            FreeCached(rCached);
+        }
+        break;
+    }
+
+    for (int i = 0; i < E_MAX_INFLIGHT && !bCacheHit; i++)
+    {
+        INFLIGHT& rInflight = m_rgInflight[i];
+
+        if (NULL == rInflight.hLeader)
+        {
+            if (NULL == pFree)
+            {
+                pFree = &rInflight;
+            }
+        }
+        else if (uiNow - rInflight.uiStartTime >= MAX_INFLIGHT_AGE)
+        {
+            // its leader was most likely never completed, the slot can be reused
+            if (NULL == pStale)
+            {
+                pStale = &rInflight;
+            }
+        }
+        else if (pPolicy == rInflight.pPolicy && uiHash == rInflight.uiHash
+                && rInflight.bJoinable
+                && rInflight.nFollowers < E_MAX_FOLLOWERS)
+        {
+            rInflight.rghFollowers[rInflight.nFollowers++] = hRilToken;
+            bAttached = TRUE;
+            break;
+        }
+    }
+
+    if (NULL == pFree)
+    {
+        pFree = pStale;
+    }
+
+    // lead a new entry; without a free one the request just goes on its own
+    if (!bCacheHit && !bAttached && NULL != pFree)
+    {
+        if (NULL != pFree->hLeader)
+        {
+            RIL_LOG_WARNING("CRequestCoalescer::Attach() - Reclaiming the entry of token"
+                    " 0x%08x, in flight for %u ms\r\n", (int) pFree->hLeader,
+                    uiNow - pFree->uiStartTime);
+            nStaleFollowers = pFree->nFollowers;
+            memcpy(rghStaleFollowers, pFree->rghFollowers,
+                    nStaleFollowers * sizeof(RIL_Token));
+            m_iInflightCount--;
+        }
+
+        pFree->pPolicy = pPolicy;
+        pFree->uiHash = uiHash;
+        pFree->hLeader = hRilToken;
+        pFree->uiStartTime = uiNow;
+        pFree->bJoinable = TRUE;
+        pFree->nFollowers = 0;
+        m_iInflightCount++;
+    }
+
+    CMutex::Unlock(m_pLock);
+
+    // nothing would complete them anymore
+    for (UINT32 i = 0; i < nStaleFollowers; i++)
+    {
+        RIL_onRequestComplete(rghStaleFollowers[i], RIL_E_GENERIC_FAILURE, NULL, 0);
+    }
+
+    if (bCacheHit)
+    {
+        RIL_LOG_INFO("CRequestCoalescer::Attach() - REQID=%d token=0x%08x completed from"
+                " cache\r\n", reqId, (int) hRilToken);
+        RIL_onRequestComplete(hRilToken, RIL_E_SUCCESS, pResponse, responseLen);
+        free(pResponse);
+        pResponse = NULL;
+    }
+    else if (bAttached)
+    {
+        RIL_LOG_INFO("CRequestCoalescer::Attach() - REQID=%d token=0x%08x attached to the"
+                " request in flight\r\n", reqId, (int) hRilToken);
+    }
+
+    return bCacheHit || bAttached;
+}
+
+void CRequestCoalescer::OnRequestComplete(RIL_Token hRilToken, RIL_Errno eErrNo,
+        void* pResponse, size_t responseLen)
+{
+    RIL_Token rghFollowers[E_MAX_FOLLOWERS];
+    UINT32 nFollowers = 0;
+
+    // most requests are not coalesced, do not take the lock for them
+    if (NULL == m_pLock || 0 == m_iInflightCount)
+    {
+        return;
+    }
+
+    CMutex::Lock(m_pLock);
+
+    for (int i = 0; i < E_MAX_INFLIGHT; i++)
+    {
+        INFLIGHT& rInflight = m_rgInflight[i];
+
+        if (hRilToken != rInflight.hLeader)
+        {
+            continue;
+        }
+
+        // a result made out of date by a notification is not kept
+        if (RIL_E_SUCCESS == eErrNo && rInflight.bJoinable)
+        {
+            StoreResult(rInflight.pPolicy, rInflight.uiHash, pResponse, responseLen);
+        }
+
+        nFollowers = rInflight.nFollowers;
+        memcpy(rghFollowers, rInflight.rghFollowers, nFollowers * sizeof(RIL_Token));
+
+        rInflight.hLeader = NULL;
+        rInflight.nFollowers = 0;
+        m_iInflightCount--;
+        break;
+    }
+
+    CMutex::Unlock(m_pLock);
+
+    // the response stays valid until the caller returns
+    for (UINT32 i = 0; i < nFollowers; i++)
+    {
+        RIL_onRequestComplete(rghFollowers[i], eErrNo, pResponse, responseLen);
+    }
+}
+
+void CRequestCoalescer::OnUnsolicitedResponse(int unsolResponseID)
+{
+    BOOL bAll = (RIL_UNSOL_RESPONSE_RADIO_STATE_CHANGED == unsolResponseID);
+
+    if (NULL == m_pLock)
+    {
+        return;
+    }
+
+    CMutex::Lock(m_pLock);
+
+    for (int i = 0; i < E_MAX_INFLIGHT; i++)
+    {
+        INFLIGHT& rInflight = m_rgInflight[i];
+
+        if (NULL != rInflight.hLeader
+                && (bAll || unsolResponseID == rInflight.pPolicy->unsolResponseID))
+        {
+            // its result may predate the change: complete it, but let no one join
+            rInflight.bJoinable = FALSE;
+        }
+    }
+
+    for (int i = 0; i < E_MAX_CACHED; i++)
+    {
+        CACHED& rCached = m_rgCached[i];
+
+        if (NULL != rCached.pPolicy
+                && (bAll || unsolResponseID == rCached.pPolicy->unsolResponseID))
+        {
+            FreeCached(rCached);
+        }
+    }
+
+    CMutex::Unlock(m_pLock);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+const CRequestCoalescer::POLICY* CRequestCoalescer::GetPolicy(int reqId)
+{
+    for (const POLICY* pPolicy = m_rgPolicies; 0 != pPolicy->reqId; pPolicy++)
+    {
+        if (reqId == pPolicy->reqId)
+        {
+            return pPolicy;
+        }
+    }
+
+    return NULL;
+}
+
+// FNV-1a hash of the request ID and payload
+UINT32 CRequestCoalescer::GetHash(int reqId, const void* pData, size_t datalen)
+{
+    const UINT8* pByte = (const UINT8*)pData;
+    UINT32 uiHash = 2166136261U;
+
+    uiHash = (uiHash ^ (UINT32)reqId) * 16777619U;
+    uiHash = (uiHash ^ (UINT32)datalen) * 16777619U;
+
+    for (size_t i = 0; NULL != pByte && i < datalen; i++)
+    {
+        uiHash = (uiHash ^ pByte[i]) * 16777619U;
+    }
+
+    return uiHash;
+}
+
+// Copy a response in a single allocation, strings included
+void* CRequestCoalescer::CopyResponse(RESPONSE_TYPE eType, const void* pResponse,
+        size_t responseLen)
+{
+    char* pCopy = NULL;
+
+    if (NULL == pResponse || 0 == responseLen)
+    {
+        return NULL;
+    }
+
+    if (E_RESPONSE_STRINGS == eType)
+    {
+        const char* const* ppszSrc = (const char* const*)pResponse;
+        size_t nStrings = responseLen / sizeof(char*);
+        size_t size = responseLen;
+        char** ppszDst;
+        char* pText;
+
+        for (size_t i = 0; i < nStrings; i++)
+        {
+            size += (NULL == ppszSrc[i]) ? 0 : strlen(ppszSrc[i]) + 1;
+        }
+
+        pCopy = (char*)malloc(size);
+        if (NULL == pCopy)
+        {
+            return NULL;
+        }
+
+        ppszDst = (char**)pCopy;
+        pText = pCopy + responseLen;
+        for (size_t i = 0; i < nStrings; i++)
+        {
+            if (NULL == ppszSrc[i])
+            {
+                ppszDst[i] = NULL;
+            }
+            else
+            {
+                size_t len = strlen(ppszSrc[i]) + 1;
+                memcpy(pText, ppszSrc[i], len);
+                ppszDst[i] = pText;
+                pText += len;
+            }
+        }
+    }
+    else
+    {
+        pCopy = (char*)malloc(responseLen);
+        if (NULL == pCopy)
+        {
+            return NULL;
+        }
+        memcpy(pCopy, pResponse, responseLen);
+    }
+
+    return pCopy;
+}
+
+void CRequestCoalescer::StoreResult(const POLICY* pPolicy, UINT32 uiHash, const void* pResponse,
+        size_t responseLen)
+{
+    CACHED* pSlot = NULL;
+    void* pCopy = NULL;
+
+    if (0 == m_uiCacheTTL || E_RESPONSE_NOT_CACHED == pPolicy->eType)
+    {
+        return;
+    }
+
+    pCopy = CopyResponse(pPolicy->eType, pResponse, responseLen);
+    if (NULL == pCopy && NULL != pResponse && 0 != responseLen)
+    {
+        return;
+    }
+
+    // replace the same result, else a free slot, else the oldest one
+    for (int i = 0; i < E_MAX_CACHED; i++)
+    {
+        CACHED& rCached = m_rgCached[i];
+
+        if (pPolicy == rCached.pPolicy && uiHash == rCached.uiHash)
+        {
+            pSlot = &rCached;
+            break;
+        }
+        else if (NULL == pSlot || (NULL != pSlot->pPolicy
+                && (NULL == rCached.pPolicy || (INT32)(rCached.uiTime - pSlot->uiTime) < 0)))
+        {
+            pSlot = &rCached;
+        }
+    }
+
+    FreeCached(*pSlot);
+    pSlot->pPolicy = pPolicy;
+    pSlot->uiHash = uiHash;
+    pSlot->uiTime = GetMonotonicTickCount();
+    pSlot->pResponse = pCopy;
+    pSlot->responseLen = (NULL == pCopy) ? 0 : responseLen;
+}
+
+void CRequestCoalescer::FreeCached(CACHED& rCached)
+{
+    free(rCached.pResponse);
+    rCached.pResponse = NULL;
+    rCached.responseLen = 0;
+    rCached.pPolicy = NULL;
+}
@@ -0,0 +1,100 @@
+////////////////////////////////////////////////////////////////////////////
+// request_coalescer.h
+//
+// Copyright 2009 Intrinsyc Software International, Inc.  All rights reserved.
+// Patents pending in the United States of America and other jurisdictions.
+//
+//
+// Description:
+//    Coalescing of identical RIL requests. A query arriving while an identical
+//    one (same request ID and payload) is being processed is attached to it and
+//    completed with its response, instead of sending the same AT command again.
+//    Responses of some queries are also kept for a short time and used to
+//    complete the next identical queries straight away.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef RRIL_REQUEST_COALESCER_H
+#define RRIL_REQUEST_COALESCER_H
+
+#include "types.h"
+#include "rril.h"
+
+class CMutex;
+
+class CRequestCoalescer
+{
+public:
+    static BOOL Init();
+    static void Destroy();
+
+    // Called before handling a request. Returns TRUE if the request was completed
+    // from the cache or attached to an identical request being processed, in which
+    // case it must not be handled.
+    static BOOL Attach(int reqId, const void* pData, size_t datalen, RIL_Token hRilToken);
+
+    // Called after a request was completed, completes the requests attached to it
+    static void OnRequestComplete(RIL_Token hRilToken, RIL_Errno eErrNo, void* pResponse,
+            size_t responseLen);
+
+    // Called for each notification, drops the results it makes out of date
+    static void OnUnsolicitedResponse(int unsolResponseID);
+
+private:
+    enum RESPONSE_TYPE
+    {
+        E_RESPONSE_NOT_CACHED,
+        E_RESPONSE_FLAT,        // response holds no pointer
+        E_RESPONSE_STRINGS      // response is an array of strings
+    };
+
+    struct POLICY
+    {
+        int reqId;
+        RESPONSE_TYPE eType;
+        int unsolResponseID;    // notification making a result out of date
+    };
+
+    enum
+    {
+        E_MAX_INFLIGHT = 16,
+        E_MAX_FOLLOWERS = 8,
+        E_MAX_CACHED = 8
+    };
+
+    struct INFLIGHT
+    {
+        const POLICY* pPolicy;
+        UINT32 uiHash;
+        RIL_Token hLeader;      // NULL if the slot is free
+        UINT32 uiStartTime;
+        BOOL bJoinable;         // FALSE once a notification made the result out of date
+        RIL_Token rghFollowers[E_MAX_FOLLOWERS];
+        UINT32 nFollowers;
+    };
+
+    struct CACHED
+    {
+        const POLICY* pPolicy;  // NULL if the slot is free
+        UINT32 uiHash;
+        UINT32 uiTime;
+        void* pResponse;
+        size_t responseLen;
+    };
+
+    static const POLICY* GetPolicy(int reqId);
+    static UINT32 GetHash(int reqId, const void* pData, size_t datalen);
+    static void* CopyResponse(RESPONSE_TYPE eType, const void* pResponse, size_t responseLen);
+    static void StoreResult(const POLICY* pPolicy, UINT32 uiHash, const void* pResponse,
+            size_t responseLen);
+    static void FreeCached(CACHED& rCached);
+
+    static const POLICY m_rgPolicies[];
+    static CMutex* m_pLock;
+    static INFLIGHT m_rgInflight[E_MAX_INFLIGHT];
+    static CACHED m_rgCached[E_MAX_CACHED];
+    static volatile int m_iInflightCount;
+    static UINT32 m_uiCacheTTL;
+};
+
+#endif // RRIL_REQUEST_COALESCER_H
@@ -69,13 +69,13 @@ const REQ_INFO g_ReqInfoDefault[] =
     // RIL_REQUEST_LAST_CALL_FAIL_CAUSE 18
     { "LastCallFailCause", RIL_CHANNEL_ATCMD, 0 },
     // RIL_REQUEST_SIGNAL_STRENGTH 19
-    { "SignalStrength", RIL_CHANNEL_DLC2, 0 },
+    { "SignalStrength", RIL_CHANNEL_DLC2, 0, TRUE },
     // RIL_REQUEST_VOICE_REGISTRATION_STATE 20
-    { "RegistrationState", RIL_CHANNEL_DLC2, 0 },
+    { "RegistrationState", RIL_CHANNEL_DLC2, 0, TRUE },
     // RIL_REQUEST_DATA_REGISTRATION_STATE 21
-    { "GprsRegistrationState", RIL_CHANNEL_DLC2, 0 },
+    { "GprsRegistrationState", RIL_CHANNEL_DLC2, 0, TRUE },
     // RIL_REQUEST_OPERATOR 22
-    { "Operator", RIL_CHANNEL_DLC8, 0 },
+    { "Operator", RIL_CHANNEL_DLC8, 0, TRUE },
     // RIL_REQUEST_RADIO_POWER 23
     { "RadioPower", RIL_CHANNEL_ATCMD, 0 },
     // RIL_REQUEST_DTMF 24
@@ -121,7 +121,7 @@ const REQ_INFO g_ReqInfoDefault[] =
     // RIL_REQUEST_CHANGE_BARRING_PASSWORD 44
     { "ChangeBarringPassword", RIL_CHANNEL_DLC8, 0 },
     // RIL_REQUEST_QUERY_NETWORK_SELECTION_MODE 45
-    { "QueryNetworkSelectionMode", RIL_CHANNEL_DLC2, 0 },
+    { "QueryNetworkSelectionMode", RIL_CHANNEL_DLC2, 0, TRUE },
     // RIL_REQUEST_SET_NETWORK_SELECTION_AUTOMATIC 46
     { "SetNetworkSelectionAutomatic", RIL_CHANNEL_DLC2, 0 },
     // RIL_REQUEST_SET_NETWORK_SELECTION_MANUAL 47
@@ -145,7 +145,7 @@ const REQ_INFO g_ReqInfoDefault[] =
     // RIL_REQUEST_LAST_DATA_CALL_FAIL_CAUSE 56
     { "LastPdpFailCause", RIL_CHANNEL_DLC2, 0 },
     // RIL_REQUEST_DATA_CALL_LIST 57
-    { "PdpContextList", RIL_CHANNEL_ATCMD, 0 },
+    { "PdpContextList", RIL_CHANNEL_ATCMD, 0, TRUE },
     // RIL_REQUEST_RESET_RADIO 58
     { "ResetRadio", RIL_CHANNEL_ATCMD, 0 },
     // RIL_REQUEST_OEM_HOOK_RAW 59
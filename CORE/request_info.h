@@ -21,6 +21,7 @@ struct REQ_INFO
     const char* szName; // request name used for setting request params in repository.txt
     UINT32 uiChannel;
     UINT32 uiTimeout;
+    BOOL bPipelined;    // read-only query that may be pipelined with others on its channel
 };
 
 // Struct used for internal requests only. The values for internal request ids must
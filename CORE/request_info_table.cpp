@@ -98,6 +98,8 @@ void CRequestInfoTable::GetRequestInfo(int requestID, REQ_INFO& rReqInfo)
             {
                 rReqInfo.uiTimeout = (UINT32)iTemp;
             }
+
+            rReqInfo.bPipelined = g_ReqInternal[index].reqInfo.bPipelined;
         }
     }
     // Request from ril
@@ -108,6 +110,8 @@ void CRequestInfoTable::GetRequestInfo(int requestID, REQ_INFO& rReqInfo)
 
         memset(&rReqInfo, 0, sizeof(rReqInfo));
 
+        rReqInfo.bPipelined = g_pReqInfo[requestID].bPipelined;
+
         if (repository.Read(g_szGroupRequestTimeouts, g_pReqInfo[requestID].szName, iTemp))
         {
             rReqInfo.uiTimeout = (UINT32)iTemp;
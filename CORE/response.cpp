@@ -43,12 +43,18 @@ const char* pszAborted       = "ABORTED";
 
 ///////////////////////////////////////////////////////////////////////////////
 CResponse::CResponse(CChannel* pChannel) :
+    m_szBuffer(NULL),
+    m_uiUsed(0),
+    m_bOwnBuffer(FALSE),
     m_uiResultCode(RRIL_RESULT_OK),
     m_uiErrorCode(0),
     m_pData(NULL),
     m_uiDataSize(0),
     m_pChannel(pChannel),
     m_uiResponseEndMarker(0),
+    m_uiScanned(0),
+    m_uiLineStart(0),
+    m_bHeadNotUnsolicited(FALSE),
     m_uiFlags(0)
 {
     CopyStringNullTerminate(m_szNewLine, "\r\n", sizeof(m_szNewLine));
@@ -62,6 +68,70 @@ CResponse::~CResponse()
     {
         FreeData();
     }
+
+    ClearView();
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  The scan state is kept: the new window must start with the same data,
+//  e.g. the receive buffer after more data was read into it.
+//
+void CResponse::SetView(char* pBuffer, UINT32 uiSize)
+{
+    if (m_bOwnBuffer)
+    {
+        delete[] m_szBuffer;
+        m_bOwnBuffer = FALSE;
+    }
+
+    m_szBuffer = pBuffer;
+    m_uiUsed = (NULL == pBuffer) ? 0 : uiSize;
+}
+
+//
+//  Copy the response text out of the receive buffer so that it can be handed
+//  to another thread.
+//
+BOOL CResponse::Detach()
+{
+    char* pBuffer = NULL;
+
+    if (m_bOwnBuffer || NULL == m_szBuffer)
+    {
+        return TRUE;
+    }
+
+    pBuffer = new char[m_uiUsed + 1];
+    if (NULL == pBuffer)
+    {
+        RIL_LOG_CRITICAL("CResponse::Detach() - Cannot allocate %u bytes\r\n", m_uiUsed + 1);
+        return FALSE;
+    }
+
+    memcpy(pBuffer, m_szBuffer, m_uiUsed);
+    pBuffer[m_uiUsed] = '\0';
+
+    m_szBuffer = pBuffer;
+    m_bOwnBuffer = TRUE;
+    return TRUE;
+}
+
+void CResponse::ClearView()
+{
+    if (m_bOwnBuffer)
+    {
+        delete[] m_szBuffer;
+    }
+
+    m_szBuffer = NULL;
+    m_uiUsed = 0;
+    m_bOwnBuffer = FALSE;
+
+    m_uiScanned = 0;
+    m_uiLineStart = 0;
+    m_bHeadNotUnsolicited = FALSE;
 }
 
 
@@ -79,31 +149,15 @@ BOOL CResponse::IsCompleteResponse()
         m_szBuffer[m_uiUsed] = '\0';
 
         // data in the buffer; check the type of data received
-        if (IsUnsolicitedResponse())
-        {
-            bRet = TRUE;
-        }
-        else if (IsExtendedError(pszCMEError))
-        {
-            bRet = TRUE;
-        }
-        else if (IsExtendedError(pszCMSError))
+        if (!m_bHeadNotUnsolicited && IsUnsolicitedResponse())
         {
             bRet = TRUE;
         }
-        else if (IsOkResponse())
+        else if (IsFinalResultResponse())
         {
             bRet = TRUE;
         }
-        else if (IsErrorResponse())
-        {
-            bRet = TRUE;
-        }
-        else if (IsConnectResponse())
-        {
-            bRet = TRUE;
-        }
-        else if (IsAbortedResponse())
+        else if (IsSMSPromptResponse())
         {
             bRet = TRUE;
         }
@@ -125,6 +179,7 @@ BOOL CResponse::IsUnsolicitedResponse()
 {
     BOOL bRet = FALSE;
     BOOL bGotoError = FALSE;
+    BOOL bHandled = FALSE;
     const char* szPointer = m_szBuffer;
 
     RIL_LOG_VERBOSE("CResponse::IsUnsolicitedResponse() : Enter\r\n");
@@ -134,7 +189,14 @@ BOOL CResponse::IsUnsolicitedResponse()
 
     SetUnsolicitedFlag(FALSE);
 
-    m_pChannel->ParseUnsolicitedResponse(this, szPointer, bGotoError);
+    bHandled = m_pChannel->ParseUnsolicitedResponse(this, szPointer, bGotoError);
+
+    if (!bHandled && !bGotoError && m_uiLineStart > (UINT32)(szPointer - m_szBuffer))
+    {
+        // No prefix matches the first line and that line is complete, so more
+        // data cannot turn this into a notification.
+        m_bHeadNotUnsolicited = TRUE;
+    }
 
     if (IsUnsolicitedFlag())
     {
@@ -142,8 +204,8 @@ BOOL CResponse::IsUnsolicitedResponse()
         if (!FindAndSkipRspEnd(szPointer, m_szNewLine, szPointer))
         {
             RIL_LOG_CRITICAL("CResponse::IsUnsolicitedResponse() - chnl=[%d] no CRLF at end of"
-                    " response: \"%s\"\r\n", m_pChannel->GetRilChannel(),
-                    CRLFExpandedString(szPointer, strlen(szPointer)).GetString());
+                    " response: \"%R\"\r\n", m_pChannel->GetRilChannel(),
+                    szPointer, (int)strlen(szPointer));
         }
         else
         {
@@ -158,192 +220,158 @@ Error:
 
 
 //
+//  Look for a final result code one complete line at a time. The scan resumes
+//  where the previous call stopped, so every received byte is only searched
+//  once however many reads the response is split across.
 //
-//
-BOOL CResponse::IsExtendedError(const char* pszToken)
+BOOL CResponse::IsFinalResultResponse()
 {
     BOOL bRet = FALSE;
-    const char* szPointer = m_szBuffer;
+    const char* pNewLine = NULL;
+    UINT32 uiLineEnd;
 
-    RIL_LOG_VERBOSE("CResponse::IsExtendedError() : Enter\r\n");
+    RIL_LOG_VERBOSE("CResponse::IsFinalResultResponse() : Enter\r\n");
 
-    if (FindAndSkipString(szPointer, pszToken, szPointer))
+    if (m_uiScanned > m_uiUsed)
     {
-        RIL_LOG_INFO("chnl=[%d] Got %s response\r\n", m_pChannel->GetRilChannel(), pszToken);
+        // data was cut behind the scan, start over
+        m_uiScanned = 0;
+        m_uiLineStart = 0;
+    }
 
-        // get error code
-        UINT32 nCode;
-        if (!RetrieveErrorCode(szPointer, nCode, pszToken))
+    while (m_uiScanned < m_uiUsed)
+    {
+        pNewLine = (const char*)memchr(m_szBuffer + m_uiScanned, '\n', m_uiUsed - m_uiScanned);
+        if (NULL == pNewLine)
         {
-            RIL_LOG_CRITICAL("CResponse::IsExtendedError() - chnl=[%d] could not extract error"
-                    " code\r\n", m_pChannel->GetRilChannel());
-            // treat as unrecognized - discard everything until the CR LF or end of buffer
-            if (!SkipRspEnd(szPointer, m_szNewLine, szPointer))
-            {
-                // no CR LF - discard everything
-                m_uiResponseEndMarker = m_uiUsed;
-            }
-            else
-            {
-                m_uiResponseEndMarker = szPointer - m_szBuffer;
-            }
-            SetUnrecognizedFlag(TRUE);
-            bRet = TRUE;
-            goto Error;
+            m_uiScanned = m_uiUsed;
+            break;
         }
 
-        if (!SkipRspEnd(szPointer, m_szNewLine, szPointer))
-        {
-            RIL_LOG_CRITICAL("CResponse::IsExtendedError() - chnl=[%d] no CRLF at end of response:"
-                    " \"%s\"\r\n",
-                    m_pChannel->GetRilChannel(),
-                    CRLFExpandedString(szPointer, strlen(szPointer)).GetString());
-            goto Error;
-        }
-        m_uiResponseEndMarker = szPointer - m_szBuffer;
-        bRet = TRUE;
-    }
-
-Error:
-    RIL_LOG_VERBOSE("CResponse::IsExtendedError() : Exit[%d]\r\n", bRet);
-    return bRet;
-}
+        uiLineEnd = pNewLine - m_szBuffer;
+        m_uiScanned = uiLineEnd + 1;
 
+        bRet = IsFinalResultLine(m_szBuffer + m_uiLineStart, uiLineEnd - m_uiLineStart);
+        m_uiLineStart = m_uiScanned;
 
-//
-//
-//
-BOOL CResponse::IsCorruptResponse()
-{
-    BOOL bRet = FALSE;
-    const char* szDummy = NULL;
-
-    RIL_LOG_VERBOSE("CResponse::IsCorruptResponse() : Enter\r\n");
-
-    if (IsCorruptFlag())
-    {
-        RIL_LOG_INFO("CResponse::IsCorruptResponse() : chnl=[%d] Attempting to filter corrupt"
-                " response\r\n", m_pChannel->GetRilChannel());
-        SetCorruptFlag(FALSE);
-
-        // heuristic used is to parse everything up to the first CR.
-        const char* szPointer = m_szBuffer;
-        if (FindAndSkipString(szPointer, "\r", szPointer))
+        if (bRet)
         {
-            // if the CR is followed by a LF, then consume that, too.
-            if (SkipString(szPointer, "\n", szPointer))
-            {
-                //  If next item is \r, then stop here
-                if (SkipString(szPointer+1, "\r", szDummy))
-                {
-
-
-                    // treat as unrecognized
-                    SetUnrecognizedFlag(TRUE);
-                    m_uiResponseEndMarker = szPointer - m_szBuffer;
-                    bRet = TRUE;
-                }
-            }
+            m_uiResponseEndMarker = m_uiScanned;
+            break;
         }
     }
 
-    RIL_LOG_VERBOSE("CResponse::IsCorruptResponse() : Exit[%d]\r\n", bRet);
+    RIL_LOG_VERBOSE("CResponse::IsFinalResultResponse() : Exit [%d]\r\n", bRet);
     return bRet;
 }
 
 
 //
+//  Check whether a complete line, without its LF, is a final result code.
 //
-//
-BOOL CResponse::IsOkResponse()
+BOOL CResponse::IsFinalResultLine(const char* pszLine, UINT32 uiLength)
 {
-    const char* szPointer = m_szBuffer;
-    char szToken[MAX_BUFFER_SIZE] = {0};
-    BOOL bRet;
+    const char* szPointer = pszLine;
+    const char* pszEnd = pszLine + uiLength;
+    UINT32 uiTokenLength;
 
-    RIL_LOG_VERBOSE("CResponse::IsOkResponse() : Enter\r\n");
+    // ignore the CR and any padding; a lost CR or LF around the code is tolerated
+    while (pszEnd > szPointer && '\r' == *(pszEnd - 1))
+    {
+        pszEnd--;
+    }
+    while (szPointer < pszEnd && ('\r' == *szPointer || ' ' == *szPointer))
+    {
+        szPointer++;
+    }
+    uiLength = pszEnd - szPointer;
 
-    // look for "OK" in response data
-    snprintf(szToken, MAX_BUFFER_SIZE-1, "%s%s%s", m_szNewLine, pszOkResponse, m_szNewLine);
-    szToken[MAX_BUFFER_SIZE-1] = '\0';  //  KW fix
-    bRet = FindAndSkipString(szPointer, szToken, szPointer);
+    if (IsToken(szPointer, uiLength, pszOkResponse)
+            || IsToken(szPointer, uiLength, pszConnectResponse)
+            || IsToken(szPointer, uiLength, pszAborted))
+    {
+        SetUnsolicitedFlag(FALSE);
+        m_uiResultCode = RIL_E_SUCCESS;
+        return TRUE;
+    }
 
-    if (!bRet)
+    if (IsToken(szPointer, uiLength, pszErrorResponse))
     {
-        //  Maybe we have just OK<cr><lf> due to modem missing a character
-        snprintf(szToken, MAX_BUFFER_SIZE-1, "%s%s", pszOkResponse, m_szNewLine);
-        szToken[MAX_BUFFER_SIZE-1] = '\0';  //  KW fix
-        bRet = FindAndSkipString(szPointer, szToken, szPointer);
+        SetUnsolicitedFlag(FALSE);
+        m_uiResultCode = RIL_E_GENERIC_FAILURE;
+        return TRUE;
     }
 
-    if (!bRet)
+    uiTokenLength = strlen(pszCMEError);
+    if (uiLength >= uiTokenLength && 0 == strncmp(szPointer, pszCMEError, uiTokenLength))
     {
-        // No "OK" in buffer - is this an SMS intermediate prompt?
-        // look for SMS token from the beginning of the buffer only
-        bRet = SkipRspStart(szPointer, m_szNewLine, szPointer) &&
-               SkipString(szPointer, pszSMSResponse, szPointer);
+        IsExtendedError(szPointer + uiTokenLength, pszCMEError);
+        return TRUE;
     }
 
-    if (bRet)
+    uiTokenLength = strlen(pszCMSError);
+    if (uiLength >= uiTokenLength && 0 == strncmp(szPointer, pszCMSError, uiTokenLength))
     {
-        SetUnsolicitedFlag(FALSE);
-        m_uiResponseEndMarker = szPointer - m_szBuffer;
-        m_uiResultCode = RIL_E_SUCCESS;
+        IsExtendedError(szPointer + uiTokenLength, pszCMSError);
+        return TRUE;
     }
 
-Error:
-    RIL_LOG_VERBOSE("CResponse::IsOkResponse() : Exit [%d]\r\n", bRet);
-    return bRet;
+    return FALSE;
 }
 
 
 //
 //
 //
-BOOL CResponse::IsErrorResponse()
+BOOL CResponse::IsToken(const char* szPointer, UINT32 uiLength, const char* pszToken)
+{
+    return (uiLength == strlen(pszToken) && 0 == strncmp(szPointer, pszToken, uiLength));
+}
+
+
+//
+//  Extract the code of an extended error line. Returns FALSE and marks the
+//  response unrecognized if there is no valid code.
+//
+BOOL CResponse::IsExtendedError(const char* szPointer, const char* pszToken)
 {
-    const char* szPointer = m_szBuffer;
-    char szToken[MAX_BUFFER_SIZE] = {0};
     BOOL bRet = FALSE;
+    UINT32 nCode;
 
-    RIL_LOG_VERBOSE("CResponse::IsErrorResponse() : Enter\r\n");
+    RIL_LOG_VERBOSE("CResponse::IsExtendedError() : Enter\r\n");
 
-    // look for "ERROR" in response data
-    snprintf(szToken, MAX_BUFFER_SIZE-1, "%s%s%s", m_szNewLine, pszErrorResponse, m_szNewLine);
-    szToken[MAX_BUFFER_SIZE-1] = '\0';  //  KW fix
-    bRet = FindAndSkipString(szPointer, szToken, szPointer);
+    RIL_LOG_INFO("chnl=[%d] Got %s response\r\n", m_pChannel->GetRilChannel(), pszToken);
 
-    if (bRet)
+    if (!RetrieveErrorCode(szPointer, nCode, pszToken))
     {
-        // found ERROR response
-        RIL_RESULT_CODE resCode;
-        SetUnsolicitedFlag(FALSE);
-        m_uiResultCode = RIL_E_GENERIC_FAILURE;
-
-        m_uiResponseEndMarker = szPointer - m_szBuffer;
-        bRet = TRUE;
+        RIL_LOG_CRITICAL("CResponse::IsExtendedError() - chnl=[%d] could not extract error"
+                " code\r\n", m_pChannel->GetRilChannel());
+        // treat as unrecognized - the line is discarded
+        SetUnrecognizedFlag(TRUE);
+        goto Error;
     }
 
+    bRet = TRUE;
+
 Error:
-    RIL_LOG_VERBOSE("CResponse::IsErrorResponse() : Exit [%d]\r\n", bRet);
+    RIL_LOG_VERBOSE("CResponse::IsExtendedError() : Exit[%d]\r\n", bRet);
     return bRet;
 }
 
+
 //
+//  The SMS intermediate prompt is not followed by a line end, so it is only
+//  looked for at the start of the buffer.
 //
-//
-BOOL CResponse::IsConnectResponse()
+BOOL CResponse::IsSMSPromptResponse()
 {
     const char* szPointer = m_szBuffer;
-    char szToken[MAX_BUFFER_SIZE] = {0};
     BOOL bRet;
 
-    RIL_LOG_VERBOSE("CResponse::IsConnectResponse() : Enter\r\n");
+    RIL_LOG_VERBOSE("CResponse::IsSMSPromptResponse() : Enter\r\n");
 
-    // look for "CONNECT" in response data
-    snprintf(szToken, MAX_BUFFER_SIZE-1, "%s%s%s", m_szNewLine, pszConnectResponse, m_szNewLine);
-    szToken[MAX_BUFFER_SIZE-1] = '\0';  //  KW fix
-    bRet = FindAndSkipString(szPointer, szToken, szPointer);
+    bRet = SkipRspStart(szPointer, m_szNewLine, szPointer) &&
+           SkipString(szPointer, pszSMSResponse, szPointer);
 
     if (bRet)
     {
@@ -352,41 +380,53 @@ BOOL CResponse::IsConnectResponse()
         m_uiResultCode = RIL_E_SUCCESS;
     }
 
-Error:
-    RIL_LOG_VERBOSE("CResponse::IsConnectResponse() : Exit [%d]\r\n", bRet);
+    RIL_LOG_VERBOSE("CResponse::IsSMSPromptResponse() : Exit [%d]\r\n", bRet);
     return bRet;
 }
 
+
 //
 //
 //
-BOOL CResponse::IsAbortedResponse()
+BOOL CResponse::IsCorruptResponse()
 {
-    const char* szPointer = m_szBuffer;
-    char szToken[MAX_BUFFER_SIZE] = {0};
-    BOOL bRet;
-
-    RIL_LOG_VERBOSE("CResponse::IsAbortedResponse() : Enter\r\n");
+    BOOL bRet = FALSE;
+    const char* szDummy = NULL;
 
-    // look for "ABORTED" in response data
-    snprintf(szToken, MAX_BUFFER_SIZE-1, "%s%s%s", m_szNewLine, pszAborted, m_szNewLine);
-    szToken[MAX_BUFFER_SIZE-1] = '\0';  //  KW fix
-    bRet = FindAndSkipString(szPointer, szToken, szPointer);
+    RIL_LOG_VERBOSE("CResponse::IsCorruptResponse() : Enter\r\n");
 
-    if (bRet)
+    if (IsCorruptFlag())
     {
-        SetUnsolicitedFlag(FALSE);
-        m_uiResponseEndMarker = szPointer - m_szBuffer;
-        m_uiResultCode = RIL_E_SUCCESS;
+        RIL_LOG_INFO("CResponse::IsCorruptResponse() : chnl=[%d] Attempting to filter corrupt"
+                " response\r\n", m_pChannel->GetRilChannel());
+        SetCorruptFlag(FALSE);
+
+        // heuristic used is to parse everything up to the first CR.
+        const char* szPointer = m_szBuffer;
+        if (FindAndSkipString(szPointer, "\r", szPointer))
+        {
+            // if the CR is followed by a LF, then consume that, too.
+            if (SkipString(szPointer, "\n", szPointer))
+            {
+                //  If next item is \r, then stop here
+                if (SkipString(szPointer+1, "\r", szDummy))
+                {
+
+
+                    // treat as unrecognized
+                    SetUnrecognizedFlag(TRUE);
+                    m_uiResponseEndMarker = szPointer - m_szBuffer;
+                    bRet = TRUE;
+                }
+            }
+        }
     }
 
-Error:
-    RIL_LOG_VERBOSE("CResponse::IsAbortedResponse() : Exit [%d]\r\n", bRet);
+    RIL_LOG_VERBOSE("CResponse::IsCorruptResponse() : Exit[%d]\r\n", bRet);
     return bRet;
 }
 
 
-
 //
 //
 //
@@ -420,10 +460,37 @@ BOOL CResponse::TransferData(CResponse*& rpRspIn, CResponse*& rpRspOut)
     iRemainder = rpRspOut->m_uiUsed - rpRspOut->m_uiResponseEndMarker;
     if (iRemainder > 0)
     {
-        rpRspIn->Append(rpRspOut->m_szBuffer + rpRspOut->m_uiResponseEndMarker, iRemainder);
+        // the remainder stays where it is, the next response starts right after this one
+        rpRspIn->SetView(rpRspOut->m_szBuffer + rpRspOut->m_uiResponseEndMarker, iRemainder);
         rpRspOut->m_uiUsed -= iRemainder;
+
+        // carry over what has already been scanned past the end of this response
+        if (rpRspOut->m_uiScanned > rpRspOut->m_uiResponseEndMarker)
+        {
+            rpRspIn->m_uiScanned = rpRspOut->m_uiScanned - rpRspOut->m_uiResponseEndMarker;
+        }
+        if (rpRspOut->m_uiLineStart > rpRspOut->m_uiResponseEndMarker)
+        {
+            rpRspIn->m_uiLineStart = rpRspOut->m_uiLineStart - rpRspOut->m_uiResponseEndMarker;
+        }
+
+        if (rpRspOut->m_bOwnBuffer && !rpRspIn->Detach())
+        {
+            RIL_LOG_CRITICAL("CResponse::TransferData() : Out of memory\r\n");
+            delete rpRspIn;
+            rpRspIn = rpRspOut;
+            rpRspIn->m_uiUsed += iRemainder;
+            rpRspOut = NULL;
+            goto Error;
+        }
+    }
+
+    // A window into the receive buffer is not terminated here: the byte after it
+    // is the start of the remainder. Detach() terminates the copy.
+    if (rpRspOut->m_bOwnBuffer)
+    {
+        rpRspOut->m_szBuffer[rpRspOut->m_uiUsed] = '\0';
     }
-    rpRspOut->m_szBuffer[rpRspOut->m_uiUsed] = '\0';
 
     bRet = TRUE;
 Error:
@@ -565,9 +632,8 @@ BOOL CResponse::ParseResponse(CCommand*& rpCmd)
         if (RIL_E_SUCCESS != resCode)
         {
             RIL_LOG_CRITICAL("CResponse::ParseResponse() - chnl=[%d] Error parsing response:"
-                    " \"%s\"; resCode = 0x%x\r\n", m_pChannel->GetRilChannel(),
-                    CRLFExpandedString(m_szBuffer, strlen(m_szBuffer)).GetString(),
-                    resCode);
+                    " \"%R\"; resCode = 0x%x\r\n", m_pChannel->GetRilChannel(),
+                    m_szBuffer, (int)strlen(m_szBuffer), resCode);
 
             SetResultCode(resCode);
             SetUnsolicitedFlag(FALSE);
@@ -24,7 +24,7 @@ class CChannel;
 // Class handling the response to an AT command
 //
 
-class CResponse : public CSelfExpandBuffer
+class CResponse
 {
 public:
     CResponse(CChannel* pChannel);
@@ -38,6 +38,15 @@ private:
 public:
     static BOOL TransferData(CResponse*& rpRspIn, CResponse*& rpRspOut);
 
+    // The response text is a window into the channel receive buffer until
+    // Detach() copies it out; only owned text may outlive the next read.
+    void SetView(char* pBuffer, UINT32 uiSize);
+    BOOL Detach();
+    void ClearView();
+
+    const char* Data() const    { return m_szBuffer; };
+    UINT32      Size() const    { return m_uiUsed; };
+
     // For unsolicited responses, set fCpyMem to FALSE. This ensures our internal string pointers
     // are correct in the memory we return to upper layers. The framework already ensures this
     // memory will be freed.
@@ -126,13 +135,17 @@ private:
     };
 
     BOOL IsUnsolicitedResponse();
-    BOOL IsExtendedError(const char* pszToken);
+    BOOL IsFinalResultResponse();
+    BOOL IsFinalResultLine(const char* pszLine, UINT32 uiLength);
+    static BOOL IsToken(const char* szPointer, UINT32 uiLength, const char* pszToken);
+    BOOL IsExtendedError(const char* szPointer, const char* pszToken);
+    BOOL IsSMSPromptResponse();
     BOOL IsCorruptResponse();
-    BOOL IsOkResponse();
-    BOOL IsErrorResponse();
     BOOL RetrieveErrorCode(const char*& rszPointer,  UINT32& nCode, const char* pszToken);
-    BOOL IsConnectResponse();
-    BOOL IsAbortedResponse();
+
+    char*     m_szBuffer;
+    UINT32    m_uiUsed;
+    BOOL      m_bOwnBuffer;
 
     char      m_szNewLine[3];
     UINT32    m_uiResultCode;
@@ -142,6 +155,13 @@ private:
     CChannel* m_pChannel;
     UINT32    m_uiResponseEndMarker;
 
+    // Final result scan state, kept between reads: everything before
+    // m_uiScanned has been searched for a line end and m_uiLineStart is the
+    // start of the line not completed yet.
+    UINT32    m_uiScanned;
+    UINT32    m_uiLineStart;
+    BOOL      m_bHeadNotUnsolicited;
+
     //  internal flags.
     UINT32     m_uiFlags;
 };
@@ -19,8 +19,16 @@
 #define SIMID_MAX_LENGTH 6
 #define SIMID_DEFAULT_VALUE "none"
 
+#include <stdarg.h>
+
 #include "types.h"
 
+//
+// On top of the printf conversions, the log functions take "%R" for raw modem
+// data: it consumes a (const char*, int length) pair and prints the bytes with
+// CR, LF and non-printable characters expanded, like CRLFExpandedString. The
+// expansion only happens if the message is actually written out.
+//
 #define RIL_LOG_VERBOSE(format, ...)    CRilLog::Verbose(format, ## __VA_ARGS__)
 #define RIL_LOG_INFO(format, ...)       CRilLog::Info(format, ## __VA_ARGS__)
 #define RIL_LOG_WARNING(format, ...)    CRilLog::Warning(format, ## __VA_ARGS__)
@@ -38,6 +46,9 @@ public:
     static inline BOOL IsFullLogBuild() { return m_bFullLogBuild; }
 
 private:
+    static void Log(UINT8 uiLevel, const char* szFormatString, va_list argList);
+    static void Output(UINT8 uiLevel, const char* szLogText);
+
     static const UINT32 m_uiMaxLogBufferSize = 1024;
     enum
     {
@@ -32,6 +32,7 @@ class CRilQueue
 
     void GetAllQueuedObjects(Object*& rpObjArray, int& rnNumOfObjects);
     BOOL DequeueByObj(Object& rObj);
+    int GetCount();
 
   private:
     // disallow copy constructor and assignment operator
@@ -333,6 +334,23 @@ Error:
     RIL_LOG_VERBOSE("CRilQueue::GetAllQueuedObjects() - EXIT\r\n");
 }
 
+//  Return the number of objects in the queue.
+template <class Object>
+int CRilQueue<Object>::GetCount()
+{
+    int nCount = 0;
+
+    CMutex::Lock(&m_cMutex);
+
+    for (ListNode* node = m_pFront; node != NULL; node = node->m_pNext)
+    {
+        nCount++;
+    }
+
+    CMutex::Unlock(&m_cMutex);
+    return nCount;
+}
+
 //  Remove item with matching object from the queue.
 template <class Object>
 BOOL CRilQueue<Object>::DequeueByObj(Object& rObj)
@@ -83,6 +83,8 @@ const int ISIM_APP_INDEX = 1;
 
 const UINT32 MAX_APP_LABEL_SIZE = 33; // including null termination
 const UINT32 MAX_AID_SIZE = 33; // Hex string length including null termination
+const UINT32 MAX_SIM_PATH_SIZE = 33; // Hex string length including null termination
+const UINT32 MAX_SIM_IO_DATA_SIZE = 511; // Hex string of a record including null termination
 
 ///////////////////////////////////////////////////////////////////////////////
 // Radio off reasons
@@ -204,6 +206,16 @@ typedef struct
 {
     int command;
     int fileId;
+
+    // filled by CSimFileCache::PrepareRequest()
+    BOOL bCached;
+    int p1;
+    int p2;
+    int p3;
+    char szPath[MAX_SIM_PATH_SIZE];
+    char szAid[MAX_AID_SIZE];
+    char szData[MAX_SIM_IO_DATA_SIZE];  // data written by an update
+    UINT32 uiGeneration;
 } S_SIM_IO_CONTEXT_DATA;
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,202 @@
+////////////////////////////////////////////////////////////////////////////
+// rsp_prefix_trie.cpp
+//
+// Copyright 2009 Intrinsyc Software International, Inc.  All rights reserved.
+// Patents pending in the United States of America and other jurisdictions.
+//
+//
+// Description:
+//    Implements the unsolicited response prefix trie.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "types.h"
+#include "rillog.h"
+#include "rsp_prefix_trie.h"
+
+CRspPrefixTrie::CRspPrefixTrie() :
+    m_pNodes(NULL),
+    m_uiNodes(0),
+    m_uiMaxNodes(0),
+    m_pEntries(NULL),
+    m_uiEntries(0),
+    m_uiMaxEntries(0)
+{
+}
+
+CRspPrefixTrie::~CRspPrefixTrie()
+{
+    free(m_pNodes);
+    m_pNodes = NULL;
+
+    free(m_pEntries);
+    m_pEntries = NULL;
+}
+
+INT32 CRspPrefixTrie::AddNode(char cChar)
+{
+    if (m_uiNodes == m_uiMaxNodes)
+    {
+        UINT32 uiMax = (0 == m_uiMaxNodes) ? 64 : 2 * m_uiMaxNodes;
+        NODE* pNodes = (NODE*)realloc(m_pNodes, uiMax * sizeof(NODE));
+        if (NULL == pNodes)
+        {
+            RIL_LOG_CRITICAL("CRspPrefixTrie::AddNode() - Cannot allocate %u nodes\r\n", uiMax);
+            return -1;
+        }
+
+        m_pNodes = pNodes;
+        m_uiMaxNodes = uiMax;
+    }
+
+    m_pNodes[m_uiNodes].cChar = cChar;
+    m_pNodes[m_uiNodes].iFirstChild = -1;
+    m_pNodes[m_uiNodes].iNextSibling = -1;
+    m_pNodes[m_uiNodes].iEntry = -1;
+
+    return (INT32)m_uiNodes++;
+}
+
+INT32 CRspPrefixTrie::AddEntry(CSilo* pSilo, PFN_ATRSP_PARSE pfnParser, UINT32 uiLen)
+{
+    if (m_uiEntries == m_uiMaxEntries)
+    {
+        UINT32 uiMax = (0 == m_uiMaxEntries) ? 32 : 2 * m_uiMaxEntries;
+        ENTRY* pEntries = (ENTRY*)realloc(m_pEntries, uiMax * sizeof(ENTRY));
+        if (NULL == pEntries)
+        {
+            RIL_LOG_CRITICAL("CRspPrefixTrie::AddEntry() - Cannot allocate %u entries\r\n",
+                    uiMax);
+            return -1;
+        }
+
+        m_pEntries = pEntries;
+        m_uiMaxEntries = uiMax;
+    }
+
+    m_pEntries[m_uiEntries].pSilo = pSilo;
+    m_pEntries[m_uiEntries].pfnParser = pfnParser;
+    m_pEntries[m_uiEntries].uiLen = uiLen;
+
+    return (INT32)m_uiEntries++;
+}
+
+BOOL CRspPrefixTrie::AddTable(CSilo* pSilo, const ATRSPTABLE* pRspTable)
+{
+    if (NULL == pRspTable)
+    {
+        return TRUE;
+    }
+
+    if (0 == m_uiNodes && AddNode('\0') < 0)
+    {
+        return FALSE;
+    }
+
+    for (int nRow = 0; ; ++nRow)
+    {
+        const char* szATRsp = pRspTable[nRow].szATResponse;
+
+        // Check for a valid pointer
+        if (NULL == szATRsp)
+        {
+            RIL_LOG_INFO("CRspPrefixTrie::AddTable() - Prefix String pointer is NULL\r\n");
+            break;
+        }
+
+        // Check for the end of the AT response table
+        if ('\0' == szATRsp[0])
+        {
+            break;
+        }
+
+        INT32 iNode = 0;
+        for (const char* p = szATRsp; '\0' != *p; ++p)
+        {
+            INT32 iChild;
+            for (iChild = m_pNodes[iNode].iFirstChild;
+                 iChild >= 0 && m_pNodes[iChild].cChar != *p;
+                 iChild = m_pNodes[iChild].iNextSibling);
+
+            if (iChild < 0)
+            {
+                iChild = AddNode(*p);
+                if (iChild < 0)
+                {
+                    return FALSE;
+                }
+
+                m_pNodes[iChild].iNextSibling = m_pNodes[iNode].iFirstChild;
+                m_pNodes[iNode].iFirstChild = iChild;
+            }
+
+            iNode = iChild;
+        }
+
+        // An identical prefix added earlier keeps precedence
+        if (m_pNodes[iNode].iEntry < 0)
+        {
+            INT32 iEntry = AddEntry(pSilo, pRspTable[nRow].pfnATParseRsp, strlen(szATRsp));
+            if (iEntry < 0)
+            {
+                return FALSE;
+            }
+
+            m_pNodes[iNode].iEntry = iEntry;
+        }
+    }
+
+    return TRUE;
+}
+
+BOOL CRspPrefixTrie::Find(const char* szStr, CSilo*& rpSilo, PFN_ATRSP_PARSE& rpfnParser,
+        const char*& rszEnd) const
+{
+    INT32 iBest = -1;
+    INT32 iNode = 0;
+
+    if (NULL == szStr || 0 == m_uiNodes)
+    {
+        return FALSE;
+    }
+
+    //  Skip over any spaces
+    szStr += strspn(szStr, " ");
+    rszEnd = szStr;
+
+    // Walk the input once; every node passed is a matching prefix
+    for (const char* p = szStr; '\0' != *p; ++p)
+    {
+        INT32 iChild;
+        for (iChild = m_pNodes[iNode].iFirstChild;
+             iChild >= 0 && m_pNodes[iChild].cChar != *p;
+             iChild = m_pNodes[iChild].iNextSibling);
+
+        if (iChild < 0)
+        {
+            break;
+        }
+
+        iNode = iChild;
+
+        INT32 iEntry = m_pNodes[iNode].iEntry;
+        if (iEntry >= 0 && (iBest < 0 || iEntry < iBest))
+        {
+            iBest = iEntry;
+        }
+    }
+
+    if (iBest < 0)
+    {
+        return FALSE;
+    }
+
+    rpSilo = m_pEntries[iBest].pSilo;
+    rpfnParser = m_pEntries[iBest].pfnParser;
+    rszEnd = szStr + m_pEntries[iBest].uiLen;
+
+    return TRUE;
+}
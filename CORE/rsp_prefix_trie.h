@@ -0,0 +1,68 @@
+////////////////////////////////////////////////////////////////////////////
+// rsp_prefix_trie.h
+//
+// Copyright 2009 Intrinsyc Software International, Inc.  All rights reserved.
+// Patents pending in the United States of America and other jurisdictions.
+//
+//
+// Description:
+//    Prefix trie built from the silo ATRSPTABLEs of a channel, used to find
+//    the parser of an unsolicited response in a single pass over its prefix.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef RRIL_RSP_PREFIX_TRIE_H
+#define RRIL_RSP_PREFIX_TRIE_H
+
+#include "types.h"
+#include "silo.h"
+
+class CRspPrefixTrie
+{
+public:
+    CRspPrefixTrie();
+    ~CRspPrefixTrie();
+
+    //  Adds the rows of pRspTable, up to the "" end marker, for pSilo.
+    //  When several rows match a response, the row added first wins, as with a
+    //  linear scan of the tables in silo order.
+    BOOL AddTable(CSilo* pSilo, const ATRSPTABLE* pRspTable);
+
+    //  Finds the parser for the response at szStr (leading spaces are skipped).
+    //  On success, rszEnd points after the matched prefix.
+    BOOL Find(const char* szStr, CSilo*& rpSilo, PFN_ATRSP_PARSE& rpfnParser,
+            const char*& rszEnd) const;
+
+private:
+    //  Prevent assignment: Declared but not implemented.
+    CRspPrefixTrie(const CRspPrefixTrie& rhs);  // Copy Constructor
+    CRspPrefixTrie& operator=(const CRspPrefixTrie& rhs);  //  Assignment operator
+
+    struct NODE
+    {
+        char    cChar;
+        INT32   iFirstChild;
+        INT32   iNextSibling;
+        INT32   iEntry;         // entry ending at this node, -1 if none
+    };
+
+    struct ENTRY
+    {
+        CSilo*          pSilo;
+        PFN_ATRSP_PARSE pfnParser;
+        UINT32          uiLen;
+    };
+
+    INT32 AddNode(char cChar);
+    INT32 AddEntry(CSilo* pSilo, PFN_ATRSP_PARSE pfnParser, UINT32 uiLen);
+
+    NODE*   m_pNodes;       // m_pNodes[0] is the root
+    UINT32  m_uiNodes;
+    UINT32  m_uiMaxNodes;
+
+    ENTRY*  m_pEntries;     // in insertion order, the lowest index wins
+    UINT32  m_uiEntries;
+    UINT32  m_uiMaxEntries;
+};
+
+#endif // RRIL_RSP_PREFIX_TRIE_H
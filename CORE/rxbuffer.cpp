@@ -0,0 +1,137 @@
+////////////////////////////////////////////////////////////////////////////
+// rxbuffer.cpp
+//
+// Copyright 2009 Intrinsyc Software International, Inc.  All rights reserved.
+// Patents pending in the United States of America and other jurisdictions.
+//
+//
+// Description:
+//    Implementation of the per-channel receive buffer.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+
+#include "types.h"
+#include "rillog.h"
+#include "rxbuffer.h"
+
+///////////////////////////////////////////////////////////////////////////////
+CRxBuffer::CRxBuffer() :
+    m_pBuffer(NULL),
+    m_uiCapacity(0),
+    m_uiHead(0),
+    m_uiTail(0)
+{
+}
+
+CRxBuffer::~CRxBuffer()
+{
+    delete[] m_pBuffer;
+    m_pBuffer = NULL;
+}
+
+//
+//  Make room for uiSize more bytes (plus the NULL terminator) at the tail.
+//  The unframed data is moved back to the start first; the buffer only grows
+//  when a single response does not fit.
+//
+BOOL CRxBuffer::Reserve(UINT32 uiSize)
+{
+    UINT32 uiUsed = m_uiTail - m_uiHead;
+    UINT32 uiNewCapacity;
+    char* pNewBuffer = NULL;
+
+    if (m_uiCapacity - m_uiTail > uiSize)
+    {
+        return TRUE;
+    }
+
+    if (m_uiCapacity - uiUsed > uiSize)
+    {
+        memmove(m_pBuffer, m_pBuffer + m_uiHead, uiUsed);
+        m_uiHead = 0;
+        m_uiTail = uiUsed;
+        return TRUE;
+    }
+
+    uiNewCapacity = (0 == m_uiCapacity) ? m_uiInitialCapacity : m_uiCapacity;
+    while (uiNewCapacity - uiUsed <= uiSize)
+    {
+        uiNewCapacity *= 2;
+    }
+
+    pNewBuffer = new char[uiNewCapacity];
+    if (NULL == pNewBuffer)
+    {
+        RIL_LOG_CRITICAL("CRxBuffer::Reserve() - Cannot allocate %u bytes\r\n", uiNewCapacity);
+        return FALSE;
+    }
+
+    if (uiUsed > 0)
+    {
+        memcpy(pNewBuffer, m_pBuffer + m_uiHead, uiUsed);
+    }
+
+    delete[] m_pBuffer;
+    m_pBuffer = pNewBuffer;
+    m_uiCapacity = uiNewCapacity;
+    m_uiHead = 0;
+    m_uiTail = uiUsed;
+
+    return TRUE;
+}
+
+BOOL CRxBuffer::GetWriteWindow(UINT32 uiMinSize, char*& rpWindow, UINT32& ruiWindowSize)
+{
+    if (0 == uiMinSize || !Reserve(uiMinSize))
+    {
+        rpWindow = NULL;
+        ruiWindowSize = 0;
+        return FALSE;
+    }
+
+    rpWindow = m_pBuffer + m_uiTail;
+    ruiWindowSize = m_uiCapacity - m_uiTail - 1;
+    return TRUE;
+}
+
+BOOL CRxBuffer::Commit(const char* pData, UINT32 uiSize)
+{
+    if (NULL == pData || 0 == uiSize)
+    {
+        return FALSE;
+    }
+
+    if (NULL != m_pBuffer && pData == m_pBuffer + m_uiTail
+            && m_uiCapacity - m_uiTail > uiSize)
+    {
+        // read straight into the write window
+        m_uiTail += uiSize;
+        return TRUE;
+    }
+
+    // data from elsewhere, or the window was reset by a Flush() during the read
+    if (!Reserve(uiSize))
+    {
+        return FALSE;
+    }
+
+    memmove(m_pBuffer + m_uiTail, pData, uiSize);
+    m_uiTail += uiSize;
+    return TRUE;
+}
+
+void CRxBuffer::Consume(UINT32 uiSize)
+{
+    if (uiSize >= m_uiTail - m_uiHead)
+    {
+        // everything framed, start over at the beginning for free
+        m_uiHead = 0;
+        m_uiTail = 0;
+    }
+    else
+    {
+        m_uiHead += uiSize;
+    }
+}
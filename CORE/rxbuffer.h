@@ -0,0 +1,63 @@
+////////////////////////////////////////////////////////////////////////////
+// rxbuffer.h
+//
+// Copyright 2009 Intrinsyc Software International, Inc.  All rights reserved.
+// Patents pending in the United States of America and other jurisdictions.
+//
+//
+// Description:
+//    Per-channel receive buffer. The response thread reads modem data
+//    directly into the free space at the tail; responses are framed in place
+//    and consumed from the head. Instead of wrapping around, the unframed
+//    remainder slides back to the start of the buffer when the tail runs out
+//    of room, so that a response is always one contiguous NULL-terminable
+//    window for the string based parsers.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef RRIL_RXBUFFER_H
+#define RRIL_RXBUFFER_H
+
+#include "types.h"
+
+class CRxBuffer
+{
+public:
+    CRxBuffer();
+    ~CRxBuffer();
+
+private:
+    //  Prevent assignment: Declared but not implemented.
+    CRxBuffer(const CRxBuffer& rhs);  // Copy Constructor
+    CRxBuffer& operator=(const CRxBuffer& rhs);  //  Assignment operator
+
+public:
+    // Get at least uiMinSize bytes of free space at the tail to read into.
+    // One more byte is always kept past the window for a NULL terminator.
+    BOOL GetWriteWindow(UINT32 uiMinSize, char*& rpWindow, UINT32& ruiWindowSize);
+
+    // Add uiSize bytes of received data. When pData is the current write window
+    // the data is already in place and nothing is copied.
+    BOOL Commit(const char* pData, UINT32 uiSize);
+
+    // Release the first uiSize bytes of unframed data.
+    void Consume(UINT32 uiSize);
+
+    // Drop all unframed data. The storage is kept for reuse.
+    void Flush()                { m_uiHead = 0; m_uiTail = 0; }
+
+    char*   Data() const        { return m_pBuffer + m_uiHead; }
+    UINT32  Size() const        { return m_uiTail - m_uiHead; }
+
+private:
+    BOOL Reserve(UINT32 uiSize);
+
+    static const UINT32 m_uiInitialCapacity = 4096;
+
+    char*   m_pBuffer;
+    UINT32  m_uiCapacity;
+    UINT32  m_uiHead;   // start of unframed data
+    UINT32  m_uiTail;   // end of received data
+};
+
+#endif // RRIL_RXBUFFER_H
@@ -39,17 +39,10 @@ public:
     CSilo(CChannel* pChannel, CSystemCapabilities* pSysCaps);
     virtual ~CSilo();
 
-    //  Called at beginning of CResponse::ParseUnsolicitedResponse().
-    //  [in] pResponse = Pointer to CResponse class
-    //  [in/out] rszPointer = Pointer to string response buffer.
-    //  [in/out] fGotoError = Set to TRUE if we wish to stop response chain and goto Error in
-    //  CResponse::ParseUnsolicitedResponse().
-    //  Return values:
-    //  TRUE if response is handled by this hook, then handling still stop.
-    //  FALSE if response is not handled by this hook, and handling will continue to other silos,
-    //  then framework.
-    virtual BOOL ParseUnsolicitedResponse(CResponse* const pResponse, const char*& rszPointer,
-            BOOL& fGotoError);
+    //  Response tables registered with the channel URC dispatcher by CChannelBase::AddSilo().
+    //  Each table ends with an empty response string.
+    const ATRSPTABLE* GetATRspTable() const { return m_pATRspTable; }
+    const ATRSPTABLE* GetATRspTableExt() const { return m_pATRspTableExt; }
 
     // Functions to get silo-specific init strings
     virtual char* GetBasicInitString() { return NULL; }
@@ -68,8 +61,7 @@ protected:
     ATRSPTABLE* m_pATRspTable;
     ATRSPTABLE* m_pATRspTableExt;
 
-    // Stub function that is never called but used by ParseUnsolicitedResponse to mark
-    // the end of the parse tables.
+    // Stub function that is never called but used to mark the end of the parse tables.
     BOOL ParseNULL(CResponse* const pResponse, const char*& rszPointer);
 
     // General function to skip this response and flag as unrecognized.
@@ -80,10 +72,6 @@ protected:
     char m_szUnlockInitString[MAX_BUFFER_SIZE];
     char m_szURCInitString[MAX_BUFFER_SIZE];
     char m_szURCUnlockInitString[MAX_BUFFER_SIZE];
-
-private:
-    // helper functions
-    PFN_ATRSP_PARSE FindParser(ATRSPTABLE* pRspTable, const char*& pszStr);
 };
 
 #endif // RRIL_SILO_H
@@ -0,0 +1,664 @@
+////////////////////////////////////////////////////////////////////////////
+// timer_wheel.cpp
+//
+// Copyright 2009 Intrinsyc Software International, Inc.  All rights reserved.
+// Patents pending in the United States of America and other jurisdictions.
+//
+//
+// Description:
+//    Implementation of the hierarchical timer wheel.
+//
+//    Level 0 has one slot per 10 ms tick, level n one slot per 64^n ticks. A
+//    timer goes in the lowest level its delay fits in and moves down a level
+//    each time the level below wraps (cascade). The timer thread only
+//    processes the ticks where a slot expires or cascades, found from the
+//    occupancy bitmaps, and sleeps in between.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "types.h"
+#include "rillog.h"
+#include "sync_ops.h"
+#include "thread_ops.h"
+#include "timer_wheel.h"
+
+// Delays longer than the wheel are clamped to its span
+static const UINT32 MAX_DELAY_TICKS = (1U << 24) - 1;
+
+CMutex* CTimerWheel::m_pLock = NULL;
+CEvent* CTimerWheel::m_pWakeEvent = NULL;
+CThread* CTimerWheel::m_pThread = NULL;
+volatile BOOL CTimerWheel::m_bStop = FALSE;
+
+CTimerWheel::TIMER CTimerWheel::m_rgTimers[E_MAX_TIMERS];
+CTimerWheel::TIMER* CTimerWheel::m_rgpSlots[E_LEVELS][E_SLOTS];
+unsigned long long CTimerWheel::m_rgullOccupied[E_LEVELS];
+UINT32 CTimerWheel::m_uiCurrentTick = 0;
+UINT32 CTimerWheel::m_uiWakeTick = 0;
+BOOL CTimerWheel::m_bWakeScheduled = FALSE;
+UINT32 CTimerWheel::m_uiGeneration = 0;
+
+UINT32 CTimerWheel::m_uiPending = 0;
+UINT32 CTimerWheel::m_uiMaxPending = 0;
+UINT32 CTimerWheel::m_uiScheduled = 0;
+UINT32 CTimerWheel::m_uiCoalesced = 0;
+UINT32 CTimerWheel::m_uiRescheduled = 0;
+UINT32 CTimerWheel::m_uiCancelled = 0;
+UINT32 CTimerWheel::m_uiFired = 0;
+UINT32 CTimerWheel::m_uiOverflows = 0;
+UINT32 CTimerWheel::m_uiWakeUps = 0;
+CLatencyHistogram CTimerWheel::m_slippage;
+
+///////////////////////////////////////////////////////////////////////////////
+BOOL CTimerWheel::Init()
+{
+    if (NULL != m_pLock)
+    {
+        return TRUE;
+    }
+
+    memset(m_rgTimers, 0, sizeof(m_rgTimers));
+    memset(m_rgpSlots, 0, sizeof(m_rgpSlots));
+    memset(m_rgullOccupied, 0, sizeof(m_rgullOccupied));
+    m_uiCurrentTick = MsToTicks(GetNowMs());
+    m_bWakeScheduled = FALSE;
+    m_bStop = FALSE;
+
+    m_pLock = new CMutex();
+    m_pWakeEvent = new CEvent();
+    if (NULL == m_pLock || NULL == m_pWakeEvent)
+    {
+        RIL_LOG_CRITICAL("CTimerWheel::Init() - Cannot allocate memory\r\n");
+        goto Error;
+    }
+
+    m_pThread = new CThread(TimerThreadProc, NULL, THREAD_FLAGS_JOINABLE, 0);
+    if (NULL == m_pThread || !CThread::IsInitialized(m_pThread))
+    {
+        RIL_LOG_CRITICAL("CTimerWheel::Init() - Cannot create timer thread\r\n");
+        delete m_pThread;
+        m_pThread = NULL;
+        goto Error;
+    }
+
+    return TRUE;
+
+Error:
+    delete m_pWakeEvent;
+    m_pWakeEvent = NULL;
+    delete m_pLock;
+    m_pLock = NULL;
+    return FALSE;
+}
+
+//
+// Pending timers are dropped
+//
+void CTimerWheel::Destroy()
+{
+    if (NULL == m_pThread)
+    {
+        return;
+    }
+
+    m_bStop = TRUE;
+    CEvent::Signal(m_pWakeEvent);
+    CThread::Wait(m_pThread, WAIT_FOREVER);
+
+    delete m_pThread;
+    m_pThread = NULL;
+    delete m_pWakeEvent;
+    m_pWakeEvent = NULL;
+    delete m_pLock;
+    m_pLock = NULL;
+}
+
+unsigned long long CTimerWheel::GetNowMs()
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (unsigned long long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+//
+// Ticks wrap around, they are only ever compared through their difference
+//
+UINT32 CTimerWheel::MsToTicks(unsigned long long ullMs)
+{
+    return (UINT32)(ullMs / E_TICK_MS);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+CTimerWheel::TIMER* CTimerWheel::FindTimer(TIMER_ID timerId)
+{
+    TIMER* pTimer = &m_rgTimers[timerId % E_MAX_TIMERS];
+
+    if (NULL == pTimer->pfnCallback || timerId != pTimer->timerId)
+    {
+        return NULL;
+    }
+
+    return pTimer;
+}
+
+CTimerWheel::TIMER* CTimerWheel::AllocTimer()
+{
+    for (UINT32 i = 0; i < E_MAX_TIMERS; i++)
+    {
+        TIMER* pTimer = &m_rgTimers[i];
+
+        if (NULL == pTimer->pfnCallback)
+        {
+            // the generation makes a stale ID miss the timer reusing its entry
+            m_uiGeneration++;
+            pTimer->timerId = m_uiGeneration * E_MAX_TIMERS + i;
+            if (TIMER_ID_INVALID == pTimer->timerId)
+            {
+                m_uiGeneration++;
+                pTimer->timerId = m_uiGeneration * E_MAX_TIMERS + i;
+            }
+
+            m_uiPending++;
+            if (m_uiPending > m_uiMaxPending)
+            {
+                m_uiMaxPending = m_uiPending;
+            }
+            return pTimer;
+        }
+    }
+
+    return NULL;
+}
+
+void CTimerWheel::FreeTimer(TIMER* pTimer)
+{
+    pTimer->pfnCallback = NULL;
+    pTimer->pParam = NULL;
+    m_uiPending--;
+}
+
+void CTimerWheel::Insert(TIMER* pTimer)
+{
+    UINT32 uiDelta = pTimer->uiExpiry - m_uiCurrentTick;
+    int iLevel = 0;
+    int iSlot;
+
+    if ((INT32)uiDelta < 0)
+    {
+        pTimer->uiExpiry = m_uiCurrentTick;
+        uiDelta = 0;
+    }
+
+    while (iLevel < E_LEVELS - 1 && uiDelta >= (1U << (E_SLOT_BITS * (iLevel + 1))))
+    {
+        iLevel++;
+    }
+    iSlot = (pTimer->uiExpiry >> (E_SLOT_BITS * iLevel)) & E_SLOT_MASK;
+
+    pTimer->iLevel = iLevel;
+    pTimer->iSlot = iSlot;
+    pTimer->pPrev = NULL;
+    pTimer->pNext = m_rgpSlots[iLevel][iSlot];
+    if (NULL != pTimer->pNext)
+    {
+        pTimer->pNext->pPrev = pTimer;
+    }
+    m_rgpSlots[iLevel][iSlot] = pTimer;
+    m_rgullOccupied[iLevel] |= 1ULL << iSlot;
+}
+
+void CTimerWheel::Remove(TIMER* pTimer)
+{
+    if (NULL != pTimer->pPrev)
+    {
+        pTimer->pPrev->pNext = pTimer->pNext;
+    }
+    else
+    {
+        m_rgpSlots[pTimer->iLevel][pTimer->iSlot] = pTimer->pNext;
+    }
+
+    if (NULL != pTimer->pNext)
+    {
+        pTimer->pNext->pPrev = pTimer->pPrev;
+    }
+
+    if (NULL == m_rgpSlots[pTimer->iLevel][pTimer->iSlot])
+    {
+        m_rgullOccupied[pTimer->iLevel] &= ~(1ULL << pTimer->iSlot);
+    }
+
+    pTimer->pPrev = NULL;
+    pTimer->pNext = NULL;
+}
+
+//
+// The expiry is rounded up to the next tick, and is at least the tick after the
+// current one as the current tick may already have been processed.
+//
+void CTimerWheel::SetExpiry(TIMER* pTimer, unsigned long long ullNowMs, UINT32 uiDelayMs)
+{
+    UINT32 uiDelta;
+
+    pTimer->ullDueMs = ullNowMs + uiDelayMs;
+    pTimer->uiExpiry = MsToTicks(pTimer->ullDueMs + E_TICK_MS - 1);
+
+    uiDelta = pTimer->uiExpiry - m_uiCurrentTick;
+    if ((INT32)uiDelta < 1)
+    {
+        pTimer->uiExpiry = m_uiCurrentTick + 1;
+    }
+    else if (uiDelta > MAX_DELAY_TICKS)
+    {
+        RIL_LOG_CRITICAL("CTimerWheel::SetExpiry() - Delay of [%u]ms clamped\r\n", uiDelayMs);
+        pTimer->uiExpiry = m_uiCurrentTick + MAX_DELAY_TICKS;
+    }
+}
+
+//
+// Next tick where a level 0 slot expires or a higher level slot cascades
+//
+BOOL CTimerWheel::GetNextTick(UINT32& ruiTick)
+{
+    BOOL bFound = FALSE;
+    UINT32 uiMinDelta = 0;
+
+    for (int iLevel = 0; iLevel < E_LEVELS; iLevel++)
+    {
+        unsigned long long ullBits = m_rgullOccupied[iLevel];
+        UINT32 uiShift = E_SLOT_BITS * iLevel;
+        UINT32 uiLevelTick = m_uiCurrentTick >> uiShift;
+        UINT32 uiFirst;
+        UINT32 uiDelta;
+
+        if (0 == ullBits)
+        {
+            continue;
+        }
+
+        // rotate so that bit 0 is the slot after the current one
+        uiFirst = (uiLevelTick + 1) & E_SLOT_MASK;
+        if (0 != uiFirst)
+        {
+            ullBits = (ullBits >> uiFirst) | (ullBits << (E_SLOTS - uiFirst));
+        }
+
+        uiDelta = ((uiLevelTick + __builtin_ctzll(ullBits) + 1) << uiShift) - m_uiCurrentTick;
+        if (!bFound || uiDelta < uiMinDelta)
+        {
+            uiMinDelta = uiDelta;
+            bFound = TRUE;
+        }
+    }
+
+    ruiTick = m_uiCurrentTick + uiMinDelta;
+    return bFound;
+}
+
+UINT32 CTimerWheel::ProcessTick(UINT32 uiTick, EXPIRED* pExpired)
+{
+    UINT32 nExpired = 0;
+    TIMER* pTimer;
+    TIMER* pNext;
+    int iSlot;
+
+    m_uiCurrentTick = uiTick;
+
+    // cascade the slots of the levels that wrapped into the lower levels
+    for (int iLevel = 1; iLevel < E_LEVELS && 0 == (uiTick & E_SLOT_MASK); iLevel++)
+    {
+        iSlot = (uiTick >> (E_SLOT_BITS * iLevel)) & E_SLOT_MASK;
+        pTimer = m_rgpSlots[iLevel][iSlot];
+        m_rgpSlots[iLevel][iSlot] = NULL;
+        m_rgullOccupied[iLevel] &= ~(1ULL << iSlot);
+
+        for (; NULL != pTimer; pTimer = pNext)
+        {
+            pNext = pTimer->pNext;
+            Insert(pTimer);
+        }
+
+        if (0 != iSlot)
+        {
+            break;
+        }
+    }
+
+    iSlot = uiTick & E_SLOT_MASK;
+    for (pTimer = m_rgpSlots[0][iSlot]; NULL != pTimer; pTimer = pNext)
+    {
+        pNext = pTimer->pNext;
+
+        if ((INT32)(pTimer->uiExpiry - uiTick) <= 0)
+        {
+            pExpired[nExpired].pfnCallback = pTimer->pfnCallback;
+            pExpired[nExpired].pParam = pTimer->pParam;
+            pExpired[nExpired].ullDueMs = pTimer->ullDueMs;
+            nExpired++;
+
+            Remove(pTimer);
+            FreeTimer(pTimer);
+        }
+    }
+
+    return nExpired;
+}
+
+//
+// Process the ticks up to uiNow, collecting the expired timers into pExpired
+// (room for E_MAX_TIMERS). Returns the number of expired timers.
+//
+UINT32 CTimerWheel::Advance(UINT32 uiNow, EXPIRED* pExpired)
+{
+    UINT32 nExpired = 0;
+    UINT32 uiNext;
+
+    while (GetNextTick(uiNext) && (INT32)(uiNext - uiNow) <= 0)
+    {
+        nExpired += ProcessTick(uiNext, pExpired + nExpired);
+    }
+
+    // nothing happens in between, skip to now
+    if ((INT32)(uiNow - m_uiCurrentTick) > 0)
+    {
+        m_uiCurrentTick = uiNow;
+    }
+
+    return nExpired;
+}
+
+void CTimerWheel::WakeUpIfEarlier(UINT32 uiExpiry)
+{
+    if (!m_bWakeScheduled || (INT32)(uiExpiry - m_uiWakeTick) < 0)
+    {
+        m_uiWakeTick = uiExpiry;
+        m_bWakeScheduled = TRUE;
+        CEvent::Signal(m_pWakeEvent);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+TIMER_ID CTimerWheel::Schedule(RIL_TimedCallback pfnCallback, void* pParam, UINT32 uiDelayMs,
+        BOOL bCoalesce)
+{
+    TIMER_ID timerId = TIMER_ID_INVALID;
+    unsigned long long ullNowMs;
+    UINT32 uiNow;
+    UINT32 uiNext;
+    TIMER* pTimer = NULL;
+
+    if (NULL == m_pThread || NULL == pfnCallback)
+    {
+        return TIMER_ID_INVALID;
+    }
+
+    CMutex::Lock(m_pLock);
+
+    ullNowMs = GetNowMs();
+    uiNow = MsToTicks(ullNowMs);
+
+    // the timer thread may have slept through many ticks, catch up unless
+    // something is due in between, in which case it is about to run
+    if (!GetNextTick(uiNext) || (INT32)(uiNext - uiNow) > 0)
+    {
+        if ((INT32)(uiNow - m_uiCurrentTick) > 0)
+        {
+            m_uiCurrentTick = uiNow;
+        }
+    }
+
+    if (bCoalesce)
+    {
+        for (UINT32 i = 0; i < E_MAX_TIMERS; i++)
+        {
+            TIMER* pPending = &m_rgTimers[i];
+
+            if (pfnCallback == pPending->pfnCallback && pParam == pPending->pParam)
+            {
+                TIMER newTimer;
+
+                SetExpiry(&newTimer, ullNowMs, uiDelayMs);
+                if ((INT32)(newTimer.uiExpiry - pPending->uiExpiry) < 0)
+                {
+                    Remove(pPending);
+                    pPending->uiExpiry = newTimer.uiExpiry;
+                    pPending->ullDueMs = newTimer.ullDueMs;
+                    Insert(pPending);
+                    WakeUpIfEarlier(pPending->uiExpiry);
+                }
+
+                m_uiCoalesced++;
+                timerId = pPending->timerId;
+                goto Done;
+            }
+        }
+    }
+
+    pTimer = AllocTimer();
+    if (NULL == pTimer)
+    {
+        RIL_LOG_CRITICAL("CTimerWheel::Schedule() - No timer left, [%u] pending\r\n",
+                m_uiPending);
+        m_uiOverflows++;
+        goto Done;
+    }
+
+    pTimer->pfnCallback = pfnCallback;
+    pTimer->pParam = pParam;
+    SetExpiry(pTimer, ullNowMs, uiDelayMs);
+    Insert(pTimer);
+    WakeUpIfEarlier(pTimer->uiExpiry);
+
+    m_uiScheduled++;
+    timerId = pTimer->timerId;
+
+Done:
+    CMutex::Unlock(m_pLock);
+    return timerId;
+}
+
+BOOL CTimerWheel::Reschedule(TIMER_ID timerId, UINT32 uiDelayMs)
+{
+    BOOL bRet = FALSE;
+    TIMER* pTimer;
+
+    if (NULL == m_pThread)
+    {
+        return FALSE;
+    }
+
+    CMutex::Lock(m_pLock);
+
+    pTimer = FindTimer(timerId);
+    if (NULL != pTimer)
+    {
+        Remove(pTimer);
+        SetExpiry(pTimer, GetNowMs(), uiDelayMs);
+        Insert(pTimer);
+        WakeUpIfEarlier(pTimer->uiExpiry);
+
+        m_uiRescheduled++;
+        bRet = TRUE;
+    }
+
+    CMutex::Unlock(m_pLock);
+    return bRet;
+}
+
+BOOL CTimerWheel::Cancel(TIMER_ID timerId)
+{
+    BOOL bRet = FALSE;
+    TIMER* pTimer;
+
+    if (NULL == m_pThread)
+    {
+        return FALSE;
+    }
+
+    CMutex::Lock(m_pLock);
+
+    pTimer = FindTimer(timerId);
+    if (NULL != pTimer)
+    {
+        Remove(pTimer);
+        FreeTimer(pTimer);
+
+        m_uiCancelled++;
+        bRet = TRUE;
+    }
+
+    CMutex::Unlock(m_pLock);
+    return bRet;
+}
+
+UINT32 CTimerWheel::Cancel(RIL_TimedCallback pfnCallback, void* pParam)
+{
+    UINT32 nCancelled = 0;
+
+    if (NULL == m_pThread || NULL == pfnCallback)
+    {
+        return 0;
+    }
+
+    CMutex::Lock(m_pLock);
+
+    for (UINT32 i = 0; i < E_MAX_TIMERS; i++)
+    {
+        TIMER* pTimer = &m_rgTimers[i];
+
+        if (pfnCallback == pTimer->pfnCallback && pParam == pTimer->pParam)
+        {
+            Remove(pTimer);
+            FreeTimer(pTimer);
+            nCancelled++;
+        }
+    }
+
+    m_uiCancelled += nCancelled;
+
+    CMutex::Unlock(m_pLock);
+    return nCancelled;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+void* CTimerWheel::TimerThreadProc(void* /*pArg*/)
+{
+    EXPIRED rgExpired[E_MAX_TIMERS];
+    unsigned long long ullNowMs;
+    UINT32 uiNow;
+    UINT32 uiNext;
+    UINT32 uiTimeout;
+    UINT32 nExpired;
+
+    RIL_LOG_INFO("CTimerWheel::TimerThreadProc() - Enter\r\n");
+
+    while (!m_bStop)
+    {
+        CMutex::Lock(m_pLock);
+
+        ullNowMs = GetNowMs();
+        uiNow = MsToTicks(ullNowMs);
+        nExpired = Advance(uiNow, rgExpired);
+        m_uiWakeUps++;
+
+        if (GetNextTick(uiNext))
+        {
+            // sleep until the start of that tick
+            uiTimeout = (uiNext - uiNow) * E_TICK_MS - (UINT32)(ullNowMs % E_TICK_MS);
+            m_uiWakeTick = uiNext;
+            m_bWakeScheduled = TRUE;
+        }
+        else
+        {
+            uiTimeout = WAIT_FOREVER;
+            m_bWakeScheduled = FALSE;
+        }
+
+        CMutex::Unlock(m_pLock);
+
+        for (UINT32 i = 0; i < nExpired; i++)
+        {
+            ullNowMs = GetNowMs();
+
+            CMutex::Lock(m_pLock);
+            m_slippage.Add((ullNowMs > rgExpired[i].ullDueMs) ?
+                    (UINT32)(ullNowMs - rgExpired[i].ullDueMs) : 0);
+            m_uiFired++;
+            CMutex::Unlock(m_pLock);
+
+            rgExpired[i].pfnCallback(rgExpired[i].pParam);
+        }
+
+        // the callbacks took some time, look again before sleeping
+        if (0 == nExpired)
+        {
+            CEvent::Wait(m_pWakeEvent, uiTimeout);
+        }
+    }
+
+    RIL_LOG_INFO("CTimerWheel::TimerThreadProc() - Exit\r\n");
+    return NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Slippage is the delay between the requested expiry and the callback call,
+//  in ms as "count:p50/p90/p99/max".
+//
+UINT32 CTimerWheel::GetReport(char* pszBuffer, UINT32 uiBufferSize)
+{
+    int iLen;
+
+    if (NULL == pszBuffer || 0 == uiBufferSize)
+    {
+        return 0;
+    }
+    pszBuffer[0] = '\0';
+
+    if (NULL == m_pThread)
+    {
+        return 0;
+    }
+
+    CMutex::Lock(m_pLock);
+
+    iLen = snprintf(pszBuffer, uiBufferSize, "timers pending=%u/%u scheduled=%u coalesced=%u"
+            " rescheduled=%u cancelled=%u fired=%u overflows=%u wakeups=%u"
+            " slippage=%u:%u/%u/%u/%u\n", m_uiPending, m_uiMaxPending, m_uiScheduled,
+            m_uiCoalesced, m_uiRescheduled, m_uiCancelled, m_uiFired, m_uiOverflows,
+            m_uiWakeUps, m_slippage.GetCount(), m_slippage.GetPercentile(50),
+            m_slippage.GetPercentile(90), m_slippage.GetPercentile(99), m_slippage.GetMax());
+
+    CMutex::Unlock(m_pLock);
+
+    if (iLen < 0)
+    {
+        return 0;
+    }
+
+    return ((UINT32)iLen < uiBufferSize) ? (UINT32)iLen : uiBufferSize - 1;
+}
+
+void CTimerWheel::Dump()
+{
+    char szReport[256];
+    char* pszEnd;
+
+    if (0 == GetReport(szReport, sizeof(szReport)))
+    {
+        return;
+    }
+
+    pszEnd = strchr(szReport, '\n');
+    if (NULL != pszEnd)
+    {
+        *pszEnd = '\0';
+    }
+
+    RIL_LOG_INFO("CTimerWheel::Dump() - %s\r\n", szReport);
+}
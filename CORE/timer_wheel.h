@@ -0,0 +1,139 @@
+////////////////////////////////////////////////////////////////////////////
+// timer_wheel.h
+//
+// Copyright 2009 Intrinsyc Software International, Inc.  All rights reserved.
+// Patents pending in the United States of America and other jurisdictions.
+//
+//
+// Description:
+//    Hierarchical timer wheel serving RIL_requestTimerCallback. The timed
+//    callbacks that are safe to run outside of the framework event loop are
+//    kept in one wheel and run on a single timer thread, which only wakes up
+//    for the next expiry. Timers can be cancelled, rescheduled, and identical
+//    ones (same callback and parameter) coalesced.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef RRIL_TIMER_WHEEL_H
+#define RRIL_TIMER_WHEEL_H
+
+#include "types.h"
+#include "rril.h"
+#include "latency_stats.h"
+
+class CMutex;
+class CEvent;
+class CThread;
+
+typedef UINT32 TIMER_ID;
+
+#define TIMER_ID_INVALID    0
+
+class CTimerWheel
+{
+public:
+    // Start the timer thread. Until then, Schedule() fails and callbacks are
+    // left to the framework.
+    static BOOL Init();
+    static void Destroy();
+
+    static BOOL IsStarted() { return NULL != m_pThread; }
+
+    // Run pfnCallback(pParam) on the timer thread after uiDelayMs. If bCoalesce is
+    // set and the same callback is already pending with the same parameter, no timer
+    // is added: the pending one fires at the earlier of the two expiries and its ID
+    // is returned. Only coalesce callbacks whose parameter is not allocated memory.
+    // Returns TIMER_ID_INVALID if the wheel is not started or full.
+    static TIMER_ID Schedule(RIL_TimedCallback pfnCallback, void* pParam, UINT32 uiDelayMs,
+            BOOL bCoalesce = FALSE);
+
+    // Move a pending timer to uiDelayMs from now. Returns FALSE if it already fired.
+    static BOOL Reschedule(TIMER_ID timerId, UINT32 uiDelayMs);
+
+    // Cancel a pending timer. Returns FALSE if it already fired or is running.
+    static BOOL Cancel(TIMER_ID timerId);
+
+    // Cancel the pending timers of pfnCallback with pParam, returns how many.
+    static UINT32 Cancel(RIL_TimedCallback pfnCallback, void* pParam);
+
+    // Write the timer counters and the expiry slippage, returns the report length.
+    static UINT32 GetReport(char* pszBuffer, UINT32 uiBufferSize);
+
+    // Write the report to the log
+    static void Dump();
+
+private:
+    enum
+    {
+        E_TICK_MS = 10,
+        E_SLOT_BITS = 6,
+        E_SLOTS = 1 << E_SLOT_BITS,
+        E_SLOT_MASK = E_SLOTS - 1,
+        E_LEVELS = 4,           // 64^4 ticks of 10 ms, about 46 hours
+        E_MAX_TIMERS = 64
+    };
+
+    struct TIMER
+    {
+        RIL_TimedCallback pfnCallback;  // NULL if the timer is free
+        void* pParam;
+        TIMER_ID timerId;
+        UINT32 uiExpiry;                // tick
+        unsigned long long ullDueMs;    // requested expiry, for the slippage
+        int iLevel;
+        int iSlot;
+        TIMER* pPrev;
+        TIMER* pNext;
+    };
+
+    struct EXPIRED
+    {
+        RIL_TimedCallback pfnCallback;
+        void* pParam;
+        unsigned long long ullDueMs;
+    };
+
+    static unsigned long long GetNowMs();
+    static UINT32 MsToTicks(unsigned long long ullMs);
+
+    static TIMER* FindTimer(TIMER_ID timerId);
+    static TIMER* AllocTimer();
+    static void FreeTimer(TIMER* pTimer);
+    static void Insert(TIMER* pTimer);
+    static void Remove(TIMER* pTimer);
+    static void SetExpiry(TIMER* pTimer, unsigned long long ullNowMs, UINT32 uiDelayMs);
+
+    static BOOL GetNextTick(UINT32& ruiTick);
+    static UINT32 ProcessTick(UINT32 uiTick, EXPIRED* pExpired);
+    static UINT32 Advance(UINT32 uiNow, EXPIRED* pExpired);
+    static void WakeUpIfEarlier(UINT32 uiExpiry);
+
+    static void* TimerThreadProc(void* pArg);
+
+    static CMutex* m_pLock;
+    static CEvent* m_pWakeEvent;
+    static CThread* m_pThread;
+    static volatile BOOL m_bStop;
+
+    static TIMER m_rgTimers[E_MAX_TIMERS];
+    static TIMER* m_rgpSlots[E_LEVELS][E_SLOTS];
+    static unsigned long long m_rgullOccupied[E_LEVELS];   // one bit per non-empty slot
+    static UINT32 m_uiCurrentTick;      // last tick processed
+    static UINT32 m_uiWakeTick;         // tick the thread sleeps until
+    static BOOL m_bWakeScheduled;       // FALSE if the thread sleeps until signaled
+    static UINT32 m_uiGeneration;
+
+    // counters
+    static UINT32 m_uiPending;
+    static UINT32 m_uiMaxPending;
+    static UINT32 m_uiScheduled;
+    static UINT32 m_uiCoalesced;
+    static UINT32 m_uiRescheduled;
+    static UINT32 m_uiCancelled;
+    static UINT32 m_uiFired;
+    static UINT32 m_uiOverflows;
+    static UINT32 m_uiWakeUps;
+    static CLatencyHistogram m_slippage;
+};
+
+#endif // RRIL_TIMER_WHEEL_H
@@ -16,6 +16,7 @@
 #include "rillog.h"
 #include "rril.h"
 #include "sync_ops.h"
+#include "codec.h"
 
 #define MIN(a, b)  (((a) < (b)) ? (a) : (b))
 
@@ -71,18 +72,12 @@ struct CHARMAP {
 // Function declarations
 //
 
-// conversion functions
-BYTE SemiByteCharsToByte(const char chHigh, const char chLow);
-BOOL GSMHexToGSM(const char* sIn, const UINT32 cbIn, BYTE* sOut,
-              const UINT32 cbOut, UINT32& rcbUsed);
-BOOL GSMToGSMHex(const BYTE* sIn, const UINT32 cbIn, char* sOut,
-              const UINT32 cbOut, UINT32& rcbUsed);
-char* ConvertUCS2ToUTF8(const char* pHexBuffer, const UINT32 hexBufferLength);
-
 BOOL IsElementarySimFile(UINT32 dwFileID);
 
 void Sleep(UINT32 dwTimeInMS);
 UINT32 GetTickCount();
+// Milliseconds since boot, not affected by wall clock changes
+UINT32 GetMonotonicTickCount();
 
 
 //
@@ -938,15 +933,9 @@ protected:
     UINT32  m_nCapacity;
 };
 
-BOOL convertGsmToUtf8HexString(BYTE* pAlphaBuffer, int offset, const int length,
-        char* pszUtf8HexString, const int maxUtf8HexStringLength);
-
 // convert an Integer into a byte array in Big Endian format
 void convertIntToByteArray(unsigned char* outByteArray, int value);
 
 // convert an Integer into a byte array in Big Endian format starting at 'position'
 void convertIntToByteArrayAt(unsigned char* outByteArray, int value, int position);
 
-// Utility function to translate Hexadecimal array (characters) onto byte array (numeric values)
-BOOL extractByteArrayFromString(const char* szHexArray, const UINT32 uiLength, UINT8* szByteArray);
-
@@ -0,0 +1,63 @@
+#
+# Copyright 2011 Intrinsyc Software International, Inc.  All rights reserved.
+#
+# Native test tools: the fake modem and RIL_Env recording stub, for running
+# the RIL without a modem (host and target), and the host regression checks
+# and benchmarks of the UTIL helpers.
+#
+
+LOCAL_PATH:= $(call my-dir)
+
+include $(CLEAR_VARS)
+LOCAL_SRC_FILES := fake_modem.cpp
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/../../CORE
+LOCAL_MODULE := fake-modem
+LOCAL_MODULE_TAGS := optional
+include $(BUILD_HOST_EXECUTABLE)
+
+include $(CLEAR_VARS)
+LOCAL_SRC_FILES := fake_modem.cpp
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/../../CORE
+LOCAL_MODULE := fake-modem
+LOCAL_MODULE_TAGS := optional
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+LOCAL_SRC_FILES := ril_env_stub.cpp
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/../../CORE hardware/ril/include
+LOCAL_LDLIBS := -ldl -lpthread
+LOCAL_MODULE := ril-env-stub
+LOCAL_MODULE_TAGS := optional
+include $(BUILD_HOST_EXECUTABLE)
+
+include $(CLEAR_VARS)
+LOCAL_SRC_FILES := ril_env_stub.cpp
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/../../CORE hardware/ril/include
+LOCAL_SHARED_LIBRARIES := libdl
+LOCAL_MODULE := ril-env-stub
+LOCAL_MODULE_TAGS := optional
+include $(BUILD_EXECUTABLE)
+
+include $(CLEAR_VARS)
+LOCAL_SRC_FILES := extract_bench.cpp bench_harness.cpp ../../UTIL/ND/extract.cpp
+LOCAL_C_INCLUDES := \
+    $(LOCAL_PATH)/../../CORE \
+    $(LOCAL_PATH)/../../CORE/ND \
+    $(LOCAL_PATH)/../../UTIL/ND \
+    $(LOCAL_PATH)/../../INC \
+    hardware/ril/include
+LOCAL_MODULE := extract-bench
+LOCAL_MODULE_TAGS := optional
+include $(BUILD_HOST_EXECUTABLE)
+
+include $(CLEAR_VARS)
+LOCAL_SRC_FILES := codec_bench.cpp bench_harness.cpp ../../UTIL/ND/codec.cpp
+LOCAL_C_INCLUDES := \
+    $(LOCAL_PATH)/../../CORE \
+    $(LOCAL_PATH)/../../CORE/ND \
+    $(LOCAL_PATH)/../../UTIL/ND \
+    $(LOCAL_PATH)/../../INC \
+    hardware/ril/include
+LOCAL_MODULE := codec-bench
+LOCAL_MODULE_TAGS := optional
+include $(BUILD_HOST_EXECUTABLE)
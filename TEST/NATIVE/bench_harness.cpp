@@ -0,0 +1,223 @@
+////////////////////////////////////////////////////////////////////////////
+// bench_harness.cpp
+//
+// Copyright 2009 Intrinsyc Software International, Inc.  All rights reserved.
+// Patents pending in the United States of America and other jurisdictions.
+//
+//
+// Description:
+//    Common part of the host regression checks and benchmarks of the UTIL
+//    helpers.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include <new>
+
+#include "types.h"
+#include "rillog.h"
+#include "bench_harness.h"
+
+static const UINT32 BENCH_ROUNDS = 5;
+static const UINT32 MAX_REPORTED_FAILURES = 20;
+
+static UINT64 g_ullAllocations = 0;
+static UINT32 g_nChecks = 0;
+static UINT32 g_nFailures = 0;
+
+// Count the allocations. No exception specification, so that this builds as
+// C++98 as well as with the current host compilers.
+void* operator new(size_t size)
+{
+    g_ullAllocations++;
+    void* p = malloc(size ? size : 1);
+    if (NULL == p)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p)
+{
+    free(p);
+}
+
+void operator delete[](void* p)
+{
+    free(p);
+}
+
+#if __cplusplus >= 201402L
+void operator delete(void* p, size_t /*size*/)
+{
+    free(p);
+}
+
+void operator delete[](void* p, size_t /*size*/)
+{
+    free(p);
+}
+#endif
+
+// The helpers log their results and bad parameters, keep the output clean
+void CRilLog::Verbose(const char* const /*szFormatString*/, ...)
+{
+}
+
+void CRilLog::Info(const char* const /*szFormatString*/, ...)
+{
+}
+
+void CRilLog::Warning(const char* const /*szFormatString*/, ...)
+{
+}
+
+void CRilLog::Critical(const char* const /*szFormatString*/, ...)
+{
+}
+
+BOOL BenchParseOptions(int argc, char** argv, BENCH_OPTIONS& rOptions)
+{
+    int opt = 0;
+
+    rOptions.nIterations = 20000;
+    rOptions.iGate = -1;
+    rOptions.uiSeed = 1;
+
+    while (-1 != (opt = getopt(argc, argv, "n:g:s:")))
+    {
+        switch (opt)
+        {
+            case 'n':
+                rOptions.nIterations = (UINT32)strtoul(optarg, NULL, 10);
+                break;
+
+            case 'g':
+                rOptions.iGate = atoi(optarg);
+                break;
+
+            case 's':
+                rOptions.uiSeed = (UINT32)strtoul(optarg, NULL, 10);
+                break;
+
+            default:
+                fprintf(stderr, "Usage: %s [-n <iterations>] [-g <percent>] [-s <seed>]\n",
+                        argv[0]);
+                return FALSE;
+        }
+    }
+
+    if (0 == rOptions.nIterations)
+    {
+        rOptions.nIterations = 1;
+    }
+
+    srand(rOptions.uiSeed);
+    return TRUE;
+}
+
+BOOL BenchCheck(BOOL bOk)
+{
+    g_nChecks++;
+
+    if (!bOk)
+    {
+        g_nFailures++;
+    }
+
+    return bOk;
+}
+
+BOOL BenchReportFailure()
+{
+    return g_nFailures <= MAX_REPORTED_FAILURES;
+}
+
+BOOL BenchChecksPassed(const char* pszWhat)
+{
+    printf("%s: %u checks, %u failures\n", pszWhat, g_nChecks, g_nFailures);
+    return 0 == g_nFailures;
+}
+
+UINT64 BenchAllocations()
+{
+    return g_ullAllocations;
+}
+
+static UINT64 NowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (UINT64)ts.tv_sec * 1000000000ULL + (UINT64)ts.tv_nsec;
+}
+
+UINT64 BenchMeasure(BENCH_KERNEL pfnKernel, const void* pContext, UINT32 nIterations,
+        UINT64& rullAllocations)
+{
+    UINT64 ullBest = ~0ULL;
+    UINT64 ullAllocations = g_ullAllocations;
+    volatile UINT32 uiSink = 0;
+
+    for (UINT32 uiRound = 0; uiRound < BENCH_ROUNDS; uiRound++)
+    {
+        UINT64 ullStart = NowNs();
+
+        for (UINT32 i = 0; i < nIterations; i++)
+        {
+            uiSink = uiSink + pfnKernel(pContext);
+        }
+
+        UINT64 ullElapsed = NowNs() - ullStart;
+        if (ullElapsed < ullBest)
+        {
+            ullBest = ullElapsed;
+        }
+    }
+
+    rullAllocations = (g_ullAllocations - ullAllocations)
+            / ((UINT64)BENCH_ROUNDS * nIterations);
+    return ullBest / nIterations;
+}
+
+void BenchPrintHeader(const char* pszColumn)
+{
+    printf("%-26s %12s %12s %8s %10s %10s\n", pszColumn, "original ns", "current ns", "ratio",
+            "orig alloc", "cur alloc");
+}
+
+BOOL BenchCompare(const char* pszName, BENCH_KERNEL pfnRef, BENCH_KERNEL pfnCur,
+        const void* pContext, const BENCH_OPTIONS& rOptions)
+{
+    BOOL bRet = TRUE;
+    UINT64 ullRefAllocations = 0;
+    UINT64 ullCurAllocations = 0;
+    UINT64 ullRef = BenchMeasure(pfnRef, pContext, rOptions.nIterations, ullRefAllocations);
+    UINT64 ullCur = BenchMeasure(pfnCur, pContext, rOptions.nIterations, ullCurAllocations);
+
+    printf("%-26s %12llu %12llu %8.2f %10llu %10llu\n", pszName, ullRef, ullCur,
+            (0 == ullRef) ? 0.0 : (double)ullCur / (double)ullRef,
+            ullRefAllocations, ullCurAllocations);
+
+    if (ullCurAllocations > ullRefAllocations)
+    {
+        printf("FAIL %s: more allocations than the original\n", pszName);
+        bRet = FALSE;
+    }
+
+    if (rOptions.iGate >= 0 && ullCur * 100 > ullRef * (100 + rOptions.iGate))
+    {
+        printf("FAIL %s: more than %d%% slower than the original\n", pszName, rOptions.iGate);
+        bRet = FALSE;
+    }
+
+    return bRet;
+}
@@ -0,0 +1,59 @@
+////////////////////////////////////////////////////////////////////////////
+// bench_harness.h
+//
+// Copyright 2009 Intrinsyc Software International, Inc.  All rights reserved.
+// Patents pending in the United States of America and other jurisdictions.
+//
+//
+// Description:
+//  Common part of the host regression checks and benchmarks of the UTIL
+//  helpers: command line, check counters, allocation counting, timing and
+//  the comparison of a current implementation against the original one.
+//
+//  Linking it also replaces the global operator new and delete (to count
+//  allocations) and stubs out CRilLog, so the helpers can be linked alone.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "types.h"
+
+typedef unsigned long long UINT64;
+
+struct BENCH_OPTIONS
+{
+    UINT32 nIterations;     // calls per timing round
+    int iGate;              // allowed slowdown in percent, -1 for none
+    UINT32 uiSeed;          // seed of the random inputs
+};
+
+// Parses [-n <iterations>] [-g <percent>] [-s <seed>] and seeds rand().
+// Returns FALSE after printing the usage if the command line is wrong.
+BOOL BenchParseOptions(int argc, char** argv, BENCH_OPTIONS& rOptions);
+
+// Counts a check, returns bOk. A failed check is counted as a failure.
+BOOL BenchCheck(BOOL bOk);
+
+// Returns TRUE if the last failure is among the first ones, which are worth printing
+BOOL BenchReportFailure();
+
+// Prints the check counters, returns TRUE if there was no failure
+BOOL BenchChecksPassed(const char* pszWhat);
+
+// Allocations made so far with operator new and new[]
+UINT64 BenchAllocations();
+
+// Best of a few rounds of nIterations calls of pfnKernel(pContext), in ns per
+// call. rullAllocations is the number of allocations per call. The results of
+// the kernel are summed so the calls are not optimized out.
+typedef UINT32 (*BENCH_KERNEL)(const void* pContext);
+UINT64 BenchMeasure(BENCH_KERNEL pfnKernel, const void* pContext, UINT32 nIterations,
+        UINT64& rullAllocations);
+
+// Times the original and the current kernels and prints a row of the table.
+// Returns FALSE if the current one allocates more, or is slower than the
+// gate allows.
+void BenchPrintHeader(const char* pszColumn);
+BOOL BenchCompare(const char* pszName, BENCH_KERNEL pfnRef, BENCH_KERNEL pfnCur,
+        const void* pContext, const BENCH_OPTIONS& rOptions);
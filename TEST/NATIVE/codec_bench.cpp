@@ -0,0 +1,928 @@
+////////////////////////////////////////////////////////////////////////////
+// codec_bench.cpp
+//
+// Copyright 2009 Intrinsyc Software International, Inc.  All rights reserved.
+// Patents pending in the United States of America and other jurisdictions.
+//
+//
+// Description:
+//    Round trip checks and throughput benchmark of the hex, UCS2 and GSM
+//    conversions (UTIL/ND/codec.cpp), against a copy of the routines they
+//    replaced in util.cpp.
+//
+//    The checks are exhaustive where the input space allows it:
+//      - every byte through GSMToGSMHex and back through GSMHexToGSM,
+//        with every output buffer size
+//      - every pair of characters through SemiByteCharsToByte and
+//        extractByteArrayFromString, checked against an independent
+//        decoder: upper and lower case digits decode, anything else is
+//        rejected by extractByteArrayFromString
+//      - every UCS2 code unit, in upper and lower case hex, through
+//        ConvertUCS2HexToUTF8 and ConvertUCS2ToUTF8, checked against an
+//        independent UTF-8 encoder and the original routine
+//      - truncation of ConvertUCS2HexToUTF8 at every output buffer size
+//      - every GSM septet, plain and escaped, and random SIM alpha
+//        identifiers in the three UCS2 codings, against the original
+//
+//    Exits non-zero if a check fails, if a conversion allocates more than
+//    the original one, or with -g <percent> if it is slower than the
+//    original one by more than that.
+//
+//    Usage: codec-bench [-n <iterations>] [-g <percent>] [-s <seed>]
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "types.h"
+#include "rillog.h"
+#include "codec.h"
+#include "bench_harness.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// Original routines, as they were in util.cpp
+/////////////////////////////////////////////////////////////////////////////
+
+static const unsigned short g_rgusRefGsmToUnicode[128] = {
+  '@', 0xa3,  '$', 0xa5, 0xe8, 0xe9, 0xf9, 0xec, 0xf2, 0xc7, '\n', 0xd8, 0xf8, '\r', 0xc5, 0xe5,
+0x394,  '_',0x3a6,0x393,0x39b,0x3a9,0x3a0,0x3a8,0x3a3,0x398,0x39e,    0, 0xc6, 0xe6, 0xdf, 0xc9,
+  ' ',  '!',  '"',  '#', 0xa4,  '%',  '&', '\'',  '(',  ')',  '*',  '+',  ',',  '-',  '.',  '/',
+  '0',  '1',  '2',  '3',  '4',  '5',  '6',  '7',  '8',  '9',  ':',  ';',  '<',  '=',  '>',  '?',
+ 0xa1,  'A',  'B',  'C',  'D',  'E',  'F',  'G',  'H',  'I',  'J',  'K',  'L',  'M',  'N',  'O',
+  'P',  'Q',  'R',  'S',  'T',  'U',  'V',  'W',  'X',  'Y',  'Z', 0xc4, 0xd6,0x147, 0xdc, 0xa7,
+ 0xbf,  'a',  'b',  'c',  'd',  'e',  'f',  'g',  'h',  'i',  'j',  'k',  'l',  'm',  'n',  'o',
+  'p',  'q',  'r',  's',  't',  'u',  'v',  'w',  'x',  'y',  'z', 0xe4, 0xf6, 0xf1, 0xfc, 0xe0,
+};
+
+static const unsigned short g_rgusRefGsmExtendToUnicode[128] = {
+    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,'\f',   0,   0,   0,   0,   0,
+    0,   0,   0,   0, '^',   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,   0,   0,   0,   0,   0,   0,   0, '{', '}',   0,   0,   0,   0,   0,'\\',
+    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0, '[', '~', ']',   0,
+  '|',   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,   0,   0,   0,   0,0x20ac, 0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+};
+
+static const char g_rgchRefSemiByteToCharMap[16] =
+        { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'};
+
+static BYTE RefSemiByteCharsToByte(const char chHigh, const char chLow)
+{
+    BYTE bRet;
+
+    if ('0' <= chHigh && '9' >= chHigh)
+    {
+        bRet = (chHigh - '0') << 4;
+    }
+    else
+    {
+        bRet = (0x0a + chHigh - 'A') << 4;
+    }
+
+    if ('0' <= chLow && '9' >= chLow)
+    {
+        bRet |= (chLow - '0');
+    }
+    else
+    {
+        bRet |= (0x0a + chLow - 'A');
+    }
+    return bRet;
+}
+
+static BOOL RefGSMHexToGSM(const char* sIn, const UINT32 cbIn, BYTE* sOut,
+        const UINT32 cbOut, UINT32& rcbUsed)
+{
+    const char* pchIn = sIn;
+    const char* pchInEnd = sIn + cbIn;
+    BYTE* pchOut = sOut;
+    BYTE* pchOutEnd = sOut + cbOut;
+
+    while (pchIn < pchInEnd - 1 && pchOut < pchOutEnd)
+    {
+        *pchOut++ = RefSemiByteCharsToByte(*pchIn, *(pchIn + 1));
+        pchIn += 2;
+    }
+
+    rcbUsed = pchOut - sOut;
+    return TRUE;
+}
+
+static BOOL RefGSMToGSMHex(const BYTE* sIn, const UINT32 cbIn, char* sOut, const UINT32 cbOut,
+        UINT32& rcbUsed)
+{
+    const BYTE* pchIn = sIn;
+    const BYTE* pchInEnd = sIn + cbIn;
+    char* pchOut = sOut;
+    char* pchOutEnd = sOut + cbOut;
+
+    while (pchIn < pchInEnd && pchOut < pchOutEnd - 1)
+    {
+        *pchOut = g_rgchRefSemiByteToCharMap[((*pchIn) & 0xf0) >> 4];
+        pchOut++;
+        *pchOut = g_rgchRefSemiByteToCharMap[(*pchIn) & 0x0f];
+        pchOut++;
+
+        pchIn++;
+    }
+
+    rcbUsed = pchOut - sOut;
+    return TRUE;
+}
+
+static BOOL RefExtractByteArrayFromString(const char* szHexArray, const UINT32 uiLength,
+        UINT8* szByteArray)
+{
+    char szOneByte[3];
+    UINT32 uiVal = 0;
+    UINT32 uiCount = 0;
+
+    for (UINT32 i = 0; i < uiLength - 1; i += 2)
+    {
+        szOneByte[0] = szHexArray[i];
+        szOneByte[1] = szHexArray[i + 1];
+        szOneByte[2] = '\0';
+        int ret = sscanf(szOneByte, "%02x", &uiVal);
+        if (ret == EOF) return FALSE;
+
+        szByteArray[uiCount] = (UINT8)uiVal;
+
+        uiCount++;
+    }
+
+    return TRUE;
+}
+
+static int RefUtf8Write(unsigned char* utf8, int offset, int v)
+{
+    int result;
+
+    if (v < 128)
+    {
+        result = 1;
+        if (utf8)
+            utf8[offset] = (unsigned char) v;
+    }
+    else if (v < 0x800)
+    {
+        result = 2;
+        if (utf8)
+        {
+            utf8[offset+0] = (unsigned char)(0xc0 | (v >> 6));
+            utf8[offset+1] = (unsigned char)(0x80 | (v & 0x3f));
+        }
+    }
+    else if (v < 0x10000)
+    {
+        result = 3;
+        if (utf8)
+        {
+            utf8[offset+0] = (unsigned char)(0xe0 | (v >> 12));
+            utf8[offset+1] = (unsigned char)(0x80 | ((v >> 6) & 0x3f));
+            utf8[offset+2] = (unsigned char)(0x80 | (v & 0x3f));
+        }
+    }
+    else {
+        result = 4;
+        if (utf8)
+        {
+            utf8[offset+0] = (unsigned char)(0xf0 | ((v >> 18) & 0x7));
+            utf8[offset+1] = (unsigned char)(0x80 | ((v >> 12) & 0x3f));
+            utf8[offset+2] = (unsigned char)(0x80 | ((v >> 6) & 0x3f));
+            utf8[offset+3] = (unsigned char)(0x80 | (v & 0x3f));
+        }
+    }
+    return  result;
+}
+
+static int RefUcs2ToUtf8(const unsigned char* ucs2, int ucs2len, unsigned char* buf)
+{
+    int nn;
+    int result = 0;
+
+    for (nn = 0; nn < ucs2len && ucs2[0] != 0xFF; ucs2 += 2, nn++)
+    {
+        int c = (ucs2[0] << 8) | ucs2[1];
+        result += RefUtf8Write(buf, result, c);
+    }
+    return result;
+}
+
+static char* RefConvertUCS2ToUTF8(const char* pHexBuffer, const UINT32 hexBufferLength)
+{
+    BYTE* pByteBuffer = NULL;
+    UINT32 byteBufferUsed = 0;
+    char* pUtf8Buffer = NULL;
+    int utf8Count = 0;
+
+    if (NULL == pHexBuffer || 0 >= hexBufferLength)
+    {
+        return NULL;
+    }
+
+    if (0 != hexBufferLength % 2)
+    {
+        return NULL;
+    }
+
+    pByteBuffer = new BYTE[(hexBufferLength / 2) + 1];
+    memset(pByteBuffer, 0, ((hexBufferLength / 2) + 1));
+
+    RefGSMHexToGSM(pHexBuffer, hexBufferLength, pByteBuffer, (hexBufferLength / 2) + 1,
+            byteBufferUsed);
+
+    pByteBuffer[byteBufferUsed] = '\0';
+
+    utf8Count = RefUcs2ToUtf8(pByteBuffer, byteBufferUsed / 2, NULL);
+
+    pUtf8Buffer = new char[utf8Count + 1];
+    RefUcs2ToUtf8(pByteBuffer, byteBufferUsed / 2, (unsigned char*) pUtf8Buffer);
+
+    pUtf8Buffer[utf8Count] = '\0';
+
+    RIL_LOG_INFO("ConvertUCS2ToUTF8 - utf8Count: %d\r\n", utf8Count);
+    delete[] pByteBuffer;
+    return pUtf8Buffer;
+}
+
+static int RefUtf8FromGsm8(const BYTE* pSrcBuffer, int length, char* pUtf8Buffer)
+{
+    int  result  = 0;
+    int  escaped = 0;
+
+    for (; length > 0; length--)
+    {
+        int c = *pSrcBuffer++;
+
+        if (c == 0xFF)
+            break;
+
+        if (c == 0x1b)
+        {
+            if (escaped)
+            {
+                c = 0x20;
+                escaped = 0;
+            }
+            else
+            {
+                escaped = 1;
+                continue;
+            }
+        }
+        else
+        {
+            if (c >= 0x80)
+            {
+                c = 0x20;
+                escaped = 0;
+            }
+            else if (escaped)
+            {
+                c = g_rgusRefGsmExtendToUnicode[c];
+            }
+            else
+            {
+                c = g_rgusRefGsmToUnicode[c];
+            }
+        }
+
+        result += RefUtf8Write((unsigned char*) pUtf8Buffer, result, c);
+    }
+
+    return  result;
+}
+
+static int RefGetUtf8Count(BYTE* pAlphaBuffer, int base, int len, int offset)
+{
+    int utf8Count = 0;
+
+    while (len > 0)
+    {
+        int c = pAlphaBuffer[offset];
+        if (c >= 0x80)
+        {
+            utf8Count += RefUtf8Write(NULL, utf8Count, base + (c & 0x7F));
+            offset++;
+            len--;
+        }
+        else
+        {
+            int count;
+            for (count = 0; count < len && pAlphaBuffer[offset+count] < 0x80; count++);
+
+            utf8Count += RefUtf8FromGsm8(pAlphaBuffer, count, NULL);
+            offset += count;
+            len -= count;
+        }
+    }
+
+    return utf8Count;
+}
+
+static BOOL RefConvertGsmToUtf8HexString(BYTE* pAlphaBuffer, int offset, const int length,
+        char* pszUtf8HexString, const int maxUtf8HexStringLength)
+{
+    BOOL bRet = FALSE;
+    BOOL bIsUCS2 = FALSE;
+    int utf8Count = 0;
+    int len = 0;
+    int base = 0;
+
+    if (NULL == pAlphaBuffer || 0 > length
+            || NULL == pszUtf8HexString || 0 > maxUtf8HexStringLength)
+        goto Error;
+
+    if (pAlphaBuffer[offset] == 0x80)
+    {
+        int ucs2Len = (length - 1) / 2;
+
+        pAlphaBuffer += 1;
+        utf8Count = RefUcs2ToUtf8(pAlphaBuffer, ucs2Len, NULL);
+
+        if (utf8Count > maxUtf8HexStringLength)
+        {
+            goto Error;
+        }
+
+        utf8Count = RefUcs2ToUtf8(pAlphaBuffer, ucs2Len, (unsigned char*) pszUtf8HexString);
+    }
+    else
+    {
+        if (length >= 3 && pAlphaBuffer[offset] == 0x81)
+        {
+            len = pAlphaBuffer[offset + 1] & 0xFF;
+            if (len > length - 3)
+            {
+                len = length - 3;
+            }
+
+            base = ((pAlphaBuffer[offset + 2] & 0xFF) << 7);
+            offset += 3;
+            bIsUCS2 = TRUE;
+        }
+        else if (length >= 4 && pAlphaBuffer[offset] == 0x82)
+        {
+            len = pAlphaBuffer[offset + 1] & 0xFF;
+            if (len > length - 4)
+            {
+                len = length - 4;
+            }
+
+            base = ((pAlphaBuffer[offset + 2] & 0xFF) << 8) |
+                    (pAlphaBuffer[offset + 3] & 0xFF);
+            offset += 4;
+            bIsUCS2 = TRUE;
+        }
+
+        if (bIsUCS2)
+        {
+            utf8Count = RefGetUtf8Count(pAlphaBuffer, base, len, offset);
+
+            if (utf8Count < maxUtf8HexStringLength)
+            {
+                utf8Count = 0;
+                while (len > 0)
+                {
+                    int  c = pAlphaBuffer[offset];
+                    if (c >= 0x80)
+                    {
+                        utf8Count += RefUtf8Write((unsigned char*) pszUtf8HexString, utf8Count,
+                                base + (c & 0x7F));
+                        offset++;
+                        len--;
+                    }
+                    else
+                    {
+                        int count;
+                        for (count = 0; count < len && pAlphaBuffer[offset+count] < 0x80;
+                                count++);
+
+                        utf8Count += RefUtf8FromGsm8(pAlphaBuffer, count,
+                                pszUtf8HexString + utf8Count);
+                        offset += count;
+                        len -= count;
+                    }
+                }
+            }
+        }
+        else
+        {
+            utf8Count = RefUtf8FromGsm8(pAlphaBuffer + offset, length, NULL);
+
+            if (utf8Count < maxUtf8HexStringLength)
+            {
+                utf8Count = RefUtf8FromGsm8(pAlphaBuffer + offset, length, pszUtf8HexString);
+            }
+            else
+            {
+                goto Error;
+            }
+        }
+    }
+
+    bRet = TRUE;
+Error:
+    RIL_LOG_INFO("convertGsmToUtf8HexString - utf8Count: %d, "
+            "maxUtf8HexStringLength: %d\r\n", utf8Count, maxUtf8HexStringLength);
+
+    if (NULL != pszUtf8HexString)
+    {
+        pszUtf8HexString[(utf8Count < maxUtf8HexStringLength) ? utf8Count
+                : maxUtf8HexStringLength] = '\0';
+    }
+
+    return bRet;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Independent decoders the checks compare against
+/////////////////////////////////////////////////////////////////////////////
+
+// Value of a hex digit, -1 if it is not one
+static int HexValue(char c)
+{
+    if ('0' <= c && '9' >= c)
+    {
+        return c - '0';
+    }
+
+    if ('a' <= c && 'f' >= c)
+    {
+        return c - 'a' + 10;
+    }
+
+    if ('A' <= c && 'F' >= c)
+    {
+        return c - 'A' + 10;
+    }
+
+    return -1;
+}
+
+// UTF-8 of a code unit of the basic multilingual plane, returns the length
+static UINT32 EncodeUtf8(UINT32 uiCode, char* pszOut)
+{
+    if (uiCode < 0x80)
+    {
+        pszOut[0] = (char)uiCode;
+        return 1;
+    }
+
+    if (uiCode < 0x800)
+    {
+        pszOut[0] = (char)(0xC0 + (uiCode / 64));
+        pszOut[1] = (char)(0x80 + (uiCode % 64));
+        return 2;
+    }
+
+    pszOut[0] = (char)(0xE0 + (uiCode / 4096));
+    pszOut[1] = (char)(0x80 + ((uiCode / 64) % 64));
+    pszOut[2] = (char)(0x80 + (uiCode % 64));
+    return 3;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Checks
+/////////////////////////////////////////////////////////////////////////////
+
+static void Check(BOOL bOk, const char* pszWhat, UINT32 uiValue)
+{
+    if (!BenchCheck(bOk) && BenchReportFailure())
+    {
+        printf("FAIL %s (0x%X)\n", pszWhat, uiValue);
+    }
+}
+
+static void CheckHexRoundTrip()
+{
+    BYTE rgbAll[256];
+    char szHex[2 * 256 + 1];
+    BYTE rgbBack[256];
+    UINT32 uiUsed = 0;
+
+    for (UINT32 b = 0; b < 256; b++)
+    {
+        char szExpected[3];
+        BYTE bByte = (BYTE)b;
+
+        snprintf(szExpected, sizeof(szExpected), "%02X", b);
+        GSMToGSMHex(&bByte, 1, szHex, 2, uiUsed);
+        Check(2 == uiUsed && 0 == memcmp(szHex, szExpected, 2), "GSMToGSMHex byte", b);
+
+        GSMHexToGSM(szHex, 2, rgbBack, 1, uiUsed);
+        Check(1 == uiUsed && bByte == rgbBack[0], "GSMHexToGSM byte", b);
+
+        rgbAll[b] = bByte;
+    }
+
+    // every output size, the output stops on whole bytes like the original
+    for (UINT32 cbOut = 0; cbOut <= sizeof(szHex); cbOut++)
+    {
+        char szRef[sizeof(szHex)];
+        UINT32 uiRefUsed = 0;
+
+        memset(szHex, 0, sizeof(szHex));
+        memset(szRef, 0, sizeof(szRef));
+        GSMToGSMHex(rgbAll, 256, szHex, cbOut, uiUsed);
+        RefGSMToGSMHex(rgbAll, 256, szRef, cbOut, uiRefUsed);
+        Check(uiUsed == uiRefUsed && 0 == memcmp(szHex, szRef, sizeof(szHex)),
+                "GSMToGSMHex output size", cbOut);
+    }
+
+    GSMToGSMHex(rgbAll, 256, szHex, sizeof(szHex), uiUsed);
+    for (UINT32 cbIn = 0; cbIn <= 2 * 256; cbIn++)
+    {
+        for (UINT32 cbOut = 0; cbOut <= 256; cbOut += (cbIn == 2 * 256) ? 1 : 64)
+        {
+            BYTE rgbRef[256];
+            UINT32 uiRefUsed = 0;
+
+            memset(rgbBack, 0, sizeof(rgbBack));
+            memset(rgbRef, 0, sizeof(rgbRef));
+            GSMHexToGSM(szHex, cbIn, rgbBack, cbOut, uiUsed);
+            RefGSMHexToGSM(szHex, cbIn, rgbRef, cbOut, uiRefUsed);
+            Check(uiUsed == uiRefUsed && 0 == memcmp(rgbBack, rgbRef, sizeof(rgbBack)),
+                    "GSMHexToGSM sizes", (cbIn << 16) | cbOut);
+        }
+    }
+
+    Check(0 == memcmp(rgbBack, rgbAll, sizeof(rgbAll)), "hex round trip", 0);
+}
+
+static void CheckHexPairs()
+{
+    for (UINT32 uiHigh = 1; uiHigh < 256; uiHigh++)
+    {
+        for (UINT32 uiLow = 1; uiLow < 256; uiLow++)
+        {
+            char szPair[3] = { (char)uiHigh, (char)uiLow, '\0' };
+            int iHigh = HexValue(szPair[0]);
+            int iLow = HexValue(szPair[1]);
+            BOOL bValid = (iHigh >= 0 && iLow >= 0);
+            BYTE bExpected = (BYTE)(((iHigh < 0 ? 0 : iHigh) << 4) | (iLow < 0 ? 0 : iLow));
+            BYTE bByte = 0;
+            BYTE bDecoded = SemiByteCharsToByte(szPair[0], szPair[1]);
+
+            // an invalid digit decodes as 0
+            Check(bExpected == bDecoded, "SemiByteCharsToByte", (uiHigh << 8) | uiLow);
+
+            Check(bValid == extractByteArrayFromString(szPair, 2, &bByte),
+                    "extractByteArrayFromString accepts exactly hex", (uiHigh << 8) | uiLow);
+
+            if (bValid)
+            {
+                Check(bExpected == bByte, "extractByteArrayFromString value",
+                        (uiHigh << 8) | uiLow);
+            }
+
+            // upper case digits decode as they always did
+            if (bValid && !(uiHigh >= 'a' && uiHigh <= 'f') && !(uiLow >= 'a' && uiLow <= 'f'))
+            {
+                Check(RefSemiByteCharsToByte(szPair[0], szPair[1]) == bDecoded,
+                        "SemiByteCharsToByte against original", (uiHigh << 8) | uiLow);
+            }
+        }
+    }
+}
+
+static void CheckExtractByteArray()
+{
+    static const char szValid[] = "0123456789ABCDEFabcdef00FF7e";
+    const UINT32 uiLength = sizeof(szValid) - 1;
+    BYTE rgbOut[sizeof(szValid)];
+    BYTE rgbRef[sizeof(szValid)];
+    char szInput[sizeof(szValid)];
+
+    Check(extractByteArrayFromString(szValid, uiLength, rgbOut), "valid string", 0);
+    RefExtractByteArrayFromString(szValid, uiLength, rgbRef);
+    Check(0 == memcmp(rgbOut, rgbRef, uiLength / 2), "valid string against original", 0);
+
+    Check(!extractByteArrayFromString(szValid, 0, rgbOut), "zero length rejected", 0);
+    Check(!extractByteArrayFromString(NULL, 2, rgbOut), "NULL input rejected", 0);
+
+    // one bad character at every position
+    for (UINT32 uiPos = 0; uiPos < uiLength; uiPos++)
+    {
+        for (UINT32 c = 1; c < 256; c++)
+        {
+            if (HexValue((char)c) >= 0)
+            {
+                continue;
+            }
+
+            memcpy(szInput, szValid, sizeof(szValid));
+            szInput[uiPos] = (char)c;
+            Check(!extractByteArrayFromString(szInput, uiLength, rgbOut),
+                    "non hex rejected", (uiPos << 8) | c);
+        }
+    }
+}
+
+static void CheckUcs2()
+{
+    char szExpected[8];
+    char szOut[8];
+    static const char* const rgpszFormats[] = { "%04X", "%04x" };
+
+    for (UINT32 uiCode = 0; uiCode < 0x10000; uiCode++)
+    {
+        UINT32 uiExpected = 0;
+
+        // a 0xFF high byte is SIM padding, it ends the string
+        if (0xFF00 != (uiCode & 0xFF00))
+        {
+            uiExpected = EncodeUtf8(uiCode, szExpected);
+        }
+        szExpected[uiExpected] = '\0';
+
+        for (UINT32 i = 0; i < 2; i++)
+        {
+            char szHex[5];
+            UINT32 uiLen = 0;
+            char* pszAlloc = NULL;
+
+            snprintf(szHex, sizeof(szHex), rgpszFormats[i], uiCode);
+
+            uiLen = ConvertUCS2HexToUTF8(szHex, 4, szOut, sizeof(szOut));
+            Check(uiLen == uiExpected && 0 == strcmp(szOut, szExpected),
+                    "ConvertUCS2HexToUTF8", uiCode);
+
+            pszAlloc = ConvertUCS2ToUTF8(szHex, 4);
+            Check(NULL != pszAlloc && 0 == strcmp(pszAlloc, szExpected), "ConvertUCS2ToUTF8",
+                    uiCode);
+            delete[] pszAlloc;
+
+            // the original only took upper case digits
+            if (0 == i)
+            {
+                pszAlloc = RefConvertUCS2ToUTF8(szHex, 4);
+                Check(NULL != pszAlloc && 0 == strcmp(pszAlloc, szExpected),
+                        "ConvertUCS2ToUTF8 against original", uiCode);
+                delete[] pszAlloc;
+            }
+        }
+    }
+}
+
+static void CheckUcs2Truncation()
+{
+    // 1, 2 and 3 byte characters, then padding
+    static const char szHex[] = "0041" "00E9" "20AC" "0042" "03A9" "4E2D" "0043" "FFFF";
+    static const char szFull[] = "A\xC3\xA9\xE2\x82\xAC" "B\xCE\xA9\xE4\xB8\xAD" "C";
+    const UINT32 uiFullLength = sizeof(szFull) - 1;
+    char szOut[sizeof(szFull) + 4];
+
+    for (UINT32 cbOut = 1; cbOut <= sizeof(szOut); cbOut++)
+    {
+        UINT32 uiLen = ConvertUCS2HexToUTF8(szHex, sizeof(szHex) - 1, szOut, cbOut);
+        BOOL bOk = (uiLen < cbOut) && (strlen(szOut) == uiLen)
+                && (0 == memcmp(szOut, szFull, uiLen));
+
+        // only whole characters, and all of them once they fit
+        bOk = bOk && (uiLen == uiFullLength || 0 == ((BYTE)szFull[uiLen] & 0x80)
+                || 0xC0 == ((BYTE)szFull[uiLen] & 0xC0));
+        bOk = bOk && (cbOut <= uiFullLength || uiLen == uiFullLength);
+        Check(bOk, "ConvertUCS2HexToUTF8 truncation", cbOut);
+    }
+
+    Check(0 == ConvertUCS2HexToUTF8(szHex, 3, szOut, sizeof(szOut)) && '\0' == szOut[0],
+            "odd hex length rejected", 0);
+}
+
+static void CompareAlpha(BYTE* pbAlpha, int iOffset, int iLength, int iMax, UINT32 uiWhat)
+{
+    char szOut[1024];
+    char szRef[1024];
+    BOOL bRet = FALSE;
+    BOOL bRef = FALSE;
+
+    memset(szOut, 0x55, sizeof(szOut));
+    memset(szRef, 0x55, sizeof(szRef));
+    bRet = convertGsmToUtf8HexString(pbAlpha, iOffset, iLength, szOut, iMax);
+    bRef = RefConvertGsmToUtf8HexString(pbAlpha, iOffset, iLength, szRef, iMax);
+    Check(bRet == bRef && 0 == strcmp(szOut, szRef), "convertGsmToUtf8HexString", uiWhat);
+}
+
+static void CheckGsm(UINT32 nRandom)
+{
+    BYTE rgbAlpha[256];
+
+    for (UINT32 c = 0; c < 256; c++)
+    {
+        rgbAlpha[0] = (BYTE)c;
+        CompareAlpha(rgbAlpha, 0, 1, 16, c);
+
+        rgbAlpha[0] = 0x1B;
+        rgbAlpha[1] = (BYTE)c;
+        CompareAlpha(rgbAlpha, 0, 2, 16, 0x1B00 | c);
+    }
+
+    for (UINT32 i = 0; i < nRandom; i++)
+    {
+        int iLength = 1 + rand() % 64;
+        int iMax = rand() % 160;
+
+        for (int j = 0; j < iLength + 4; j++)
+        {
+            rgbAlpha[j] = (BYTE)rand();
+        }
+
+        // plain GSM, or one of the UCS2 codings of 3GPP TS 31.102 annex A
+        switch (rand() % 4)
+        {
+            case 0:
+                for (int j = 0; j < iLength; j++)
+                {
+                    rgbAlpha[j] &= 0x7F;
+                }
+                break;
+
+            case 1:
+                rgbAlpha[0] = 0x80;
+                break;
+
+            case 2:
+                rgbAlpha[0] = 0x81;
+                break;
+
+            default:
+                rgbAlpha[0] = 0x82;
+                break;
+        }
+
+        CompareAlpha(rgbAlpha, 0, iLength, iMax, i);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Benchmark
+/////////////////////////////////////////////////////////////////////////////
+
+static BYTE g_rgbBytes[256];
+static char g_szBytesHex[2 * 256 + 1];
+static char g_szUcs2Hex[4 * 64 + 1];
+static BYTE g_rgbAlpha[1 + 2 * 32];
+
+static UINT32 RefDecode(const void* /*pContext*/)
+{
+    BYTE rgbOut[256];
+    UINT32 uiUsed = 0;
+    RefGSMHexToGSM(g_szBytesHex, 2 * 256, rgbOut, sizeof(rgbOut), uiUsed);
+    return rgbOut[uiUsed - 1];
+}
+
+static UINT32 CurDecode(const void* /*pContext*/)
+{
+    BYTE rgbOut[256];
+    UINT32 uiUsed = 0;
+    GSMHexToGSM(g_szBytesHex, 2 * 256, rgbOut, sizeof(rgbOut), uiUsed);
+    return rgbOut[uiUsed - 1];
+}
+
+static UINT32 RefEncode(const void* /*pContext*/)
+{
+    char szOut[2 * 256];
+    UINT32 uiUsed = 0;
+    RefGSMToGSMHex(g_rgbBytes, 256, szOut, sizeof(szOut), uiUsed);
+    return szOut[uiUsed - 1];
+}
+
+static UINT32 CurEncode(const void* /*pContext*/)
+{
+    char szOut[2 * 256];
+    UINT32 uiUsed = 0;
+    GSMToGSMHex(g_rgbBytes, 256, szOut, sizeof(szOut), uiUsed);
+    return szOut[uiUsed - 1];
+}
+
+static UINT32 RefExtract(const void* /*pContext*/)
+{
+    BYTE rgbOut[256];
+    RefExtractByteArrayFromString(g_szBytesHex, 2 * 256, rgbOut);
+    return rgbOut[255];
+}
+
+static UINT32 CurExtract(const void* /*pContext*/)
+{
+    BYTE rgbOut[256];
+    extractByteArrayFromString(g_szBytesHex, 2 * 256, rgbOut);
+    return rgbOut[255];
+}
+
+static UINT32 RefUcs2(const void* /*pContext*/)
+{
+    char* psz = RefConvertUCS2ToUTF8(g_szUcs2Hex, sizeof(g_szUcs2Hex) - 1);
+    UINT32 uiRet = (BYTE)psz[0];
+    delete[] psz;
+    return uiRet;
+}
+
+static UINT32 CurUcs2(const void* /*pContext*/)
+{
+    char* psz = ConvertUCS2ToUTF8(g_szUcs2Hex, sizeof(g_szUcs2Hex) - 1);
+    UINT32 uiRet = (BYTE)psz[0];
+    delete[] psz;
+    return uiRet;
+}
+
+static UINT32 CurUcs2Buffer(const void* /*pContext*/)
+{
+    char szOut[3 * 64 + 1];
+    return ConvertUCS2HexToUTF8(g_szUcs2Hex, sizeof(g_szUcs2Hex) - 1, szOut, sizeof(szOut));
+}
+
+static UINT32 RefAlpha(const void* /*pContext*/)
+{
+    char szOut[256];
+    RefConvertGsmToUtf8HexString(g_rgbAlpha, 0, sizeof(g_rgbAlpha), szOut, sizeof(szOut));
+    return (BYTE)szOut[0];
+}
+
+static UINT32 CurAlpha(const void* /*pContext*/)
+{
+    char szOut[256];
+    convertGsmToUtf8HexString(g_rgbAlpha, 0, sizeof(g_rgbAlpha), szOut, sizeof(szOut));
+    return (BYTE)szOut[0];
+}
+
+struct BENCH
+{
+    const char* pszName;
+    BENCH_KERNEL pfnRef;
+    BENCH_KERNEL pfnCur;
+};
+
+static const BENCH g_rgBenches[] =
+{
+    { "hex decode 256 B",           RefDecode,  CurDecode },
+    { "hex encode 256 B",           RefEncode,  CurEncode },
+    { "extractByteArray 256 B",     RefExtract, CurExtract },
+    { "UCS2 64 chars, new[]",       RefUcs2,    CurUcs2 },
+    { "UCS2 64 chars, buffer",      RefUcs2,    CurUcs2Buffer },
+    { "SIM alpha UCS2 32 chars",    RefAlpha,   CurAlpha }
+};
+
+static void InitBenchData()
+{
+    UINT32 uiUsed = 0;
+
+    for (UINT32 i = 0; i < 256; i++)
+    {
+        g_rgbBytes[i] = (BYTE)(i * 7 + 3);
+    }
+    RefGSMToGSMHex(g_rgbBytes, 256, g_szBytesHex, sizeof(g_szBytesHex), uiUsed);
+    g_szBytesHex[uiUsed] = '\0';
+
+    // mixed latin, greek and CJK text
+    for (UINT32 i = 0; i < 64; i++)
+    {
+        static const UINT32 rguiCodes[] = { 0x0048, 0x00E9, 0x03A9, 0x4E2D };
+        snprintf(&g_szUcs2Hex[4 * i], 5, "%04X", rguiCodes[i % 4] + i);
+    }
+
+    g_rgbAlpha[0] = 0x80;
+    for (UINT32 i = 0; i < 32; i++)
+    {
+        g_rgbAlpha[1 + 2 * i] = (BYTE)(0x04 + (i % 2));
+        g_rgbAlpha[2 + 2 * i] = (BYTE)(0x10 + i);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    BENCH_OPTIONS options;
+    BOOL bFailed = FALSE;
+
+    if (!BenchParseOptions(argc, argv, options))
+    {
+        return 2;
+    }
+
+    CheckHexRoundTrip();
+    CheckHexPairs();
+    CheckExtractByteArray();
+    CheckUcs2();
+    CheckUcs2Truncation();
+    CheckGsm(100000);
+
+    bFailed = !BenchChecksPassed("round trip");
+
+    InitBenchData();
+    BenchPrintHeader("conversion");
+
+    for (UINT32 i = 0; i < sizeof(g_rgBenches) / sizeof(g_rgBenches[0]); i++)
+    {
+        if (!BenchCompare(g_rgBenches[i].pszName, g_rgBenches[i].pfnRef,
+                g_rgBenches[i].pfnCur, NULL, options))
+        {
+            bFailed = TRUE;
+        }
+    }
+
+    return bFailed ? 1 : 0;
+}
@@ -0,0 +1,752 @@
+////////////////////////////////////////////////////////////////////////////
+// extract_bench.cpp
+//
+// Copyright 2009 Intrinsyc Software International, Inc.  All rights reserved.
+// Patents pending in the United States of America and other jurisdictions.
+//
+//
+// Description:
+//    Regression check and benchmark of the AT response extract helpers
+//    (UTIL/ND/extract.cpp) against a copy of their original implementation.
+//
+//    The check calls both implementations at every offset of a set of
+//    recorded modem responses (+CLCC with several calls, a 20 operator
+//    +COPS=?, +XCELLINFO, a +CMT PDU, a +CRSM hex blob) and on random
+//    strings, and compares results, end pointers and outputs. The benchmark
+//    runs parser-like kernels over the same responses with each
+//    implementation and reports ns/op and allocations/op.
+//
+//    Exits non-zero if a result differs, if the current helpers allocate
+//    more than the original ones, or with -g <percent> if a kernel is slower
+//    than the original one by more than that.
+//
+//    Usage: extract-bench [-n <iterations>] [-g <percent>] [-s <seed>]
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "types.h"
+#include "extract.h"
+#include "bench_harness.h"
+
+static const UINT32 OUTPUT_SIZE = 1024;     // what the parsers usually pass
+static const UINT32 MAX_ARGS = 32;
+static const UINT32 FUZZ_LENGTH = 48;
+
+/////////////////////////////////////////////////////////////////////////////
+// Original implementation, as it was before the hot path changes
+/////////////////////////////////////////////////////////////////////////////
+
+static BOOL RefSkipSpaces(const char* szStart, const char*& rszEnd)
+{
+    BOOL fRet = FALSE;
+
+    UINT32 nSize = strspn(szStart, " ");
+
+    if (nSize > 0)
+    {
+        rszEnd = szStart + nSize;
+        fRet = TRUE;
+    }
+
+    return fRet;
+}
+
+static BOOL RefFindAndSkipString(const char* szStart, const char* szSkip, const char*& rszEnd)
+{
+    BOOL fRet = FALSE;
+
+    RefSkipSpaces(szStart, szStart);
+
+    rszEnd = strstr(szStart, szSkip);
+
+    if (rszEnd)
+    {
+        rszEnd += strlen(szSkip);
+        fRet = TRUE;
+    }
+    else
+    {
+        rszEnd = szStart;
+    }
+
+    return fRet;
+}
+
+static BOOL RefSkipString(const char* szStart, const char* szSkip, const char*& rszEnd)
+{
+    BOOL fRet = FALSE;
+    UINT32 dwResult;
+
+    RefSkipSpaces(szStart, szStart);
+
+    dwResult = strncmp(szStart, szSkip, strlen(szSkip));
+
+    if (!dwResult)
+    {
+        rszEnd = szStart + strlen(szSkip);
+        fRet = TRUE;
+    }
+    else
+    {
+        rszEnd = szStart;
+    }
+
+    return fRet;
+}
+
+static BOOL RefFindAndSkipRspEnd(const char* szStart, const char* szSkip, const char*& rszEnd)
+{
+    RefSkipSpaces(szStart, szStart);
+    return RefFindAndSkipString(szStart, szSkip, rszEnd);
+}
+
+static UINT32 RefFindRspArgs(const char* pszCmdStr, const char* pszEndLine, char** aPtrArgs,
+        UINT32 uinMaxArgs)
+{
+    const char* pszCurPtr = pszCmdStr;
+    const char* pszPrevPtr = pszCmdStr;
+    const char* pszEndPtr = NULL;
+    UINT32 uinPtrArg = 0;
+
+    if ((pszCmdStr == NULL) || (pszEndLine == NULL) || (aPtrArgs == NULL))
+    {
+        return 0;
+    }
+
+    if (!RefFindAndSkipRspEnd(pszCurPtr, pszEndLine, pszEndPtr))
+    {
+        return 0;
+    }
+
+    uinPtrArg = 0;
+    while ((uinPtrArg < uinMaxArgs)
+            && (RefFindAndSkipString(pszCurPtr, ",", pszCurPtr))
+            && (pszCurPtr < pszEndPtr))
+    {
+        aPtrArgs[uinPtrArg] = (char*)pszPrevPtr;
+        uinPtrArg++;
+        pszPrevPtr = pszCurPtr;
+    }
+
+    if ((uinPtrArg < uinMaxArgs - 1) && (uinPtrArg > 0))
+    {
+        aPtrArgs[uinPtrArg] = (char*)pszPrevPtr;
+        uinPtrArg++;
+    }
+    return uinPtrArg;
+}
+
+static BOOL RefExtractUInt32(const char* szStart, UINT32& rnValue, const char*& rszEnd)
+{
+    BOOL fRet = FALSE;
+
+    RefSkipSpaces(szStart, szStart);
+
+    UINT32 nTemp = 0;
+    const char* szWalk = szStart;
+
+    while (('0' <= *szWalk) && ('9' >= *szWalk))
+    {
+        nTemp *= 10;
+        nTemp += ((UINT32)*szWalk++ - '0');
+        fRet = TRUE;
+    }
+
+    RefSkipString(szWalk, " ", szWalk);
+
+    if (fRet)
+    {
+        rszEnd  = szWalk;
+        rnValue = nTemp;
+    }
+    else
+    {
+        rszEnd = szStart;
+    }
+
+    return fRet;
+}
+
+static BOOL RefExtractQuotedString(const char* szStart, char* szOutput, const UINT32 cbOutput,
+        const char*& rszEnd)
+{
+    BOOL fRet = FALSE;
+    const char* szWalk = NULL;
+    UINT32 nLen = 0;
+
+    RefSkipSpaces(szStart, szStart);
+
+    memset(szOutput, 0, cbOutput);
+    rszEnd = szStart;
+
+    if ((RefSkipString(szStart, "\"", szWalk)))
+    {
+        if (RefFindAndSkipString(szWalk, "\"", rszEnd))
+        {
+            nLen = rszEnd - szWalk - 1;
+
+            if (cbOutput > nLen)
+            {
+                strncpy(szOutput, szWalk, nLen);
+                fRet = TRUE;
+            }
+        }
+    }
+
+    return fRet;
+}
+
+static BOOL RefExtractUnquotedString(const char* szStart, const char* szDelimiter,
+        char* szOutput, const UINT32 cbOutput, const char*& rszEnd)
+{
+    BOOL fRet = FALSE;
+    UINT32 nLen = 0;
+
+    RefSkipSpaces(szStart, szStart);
+
+    memset(szOutput, 0, cbOutput);
+    rszEnd = szStart;
+
+    if (RefFindAndSkipString(szStart, szDelimiter, rszEnd))
+    {
+        nLen = rszEnd - szStart - strlen(szDelimiter);
+
+        if (cbOutput > nLen)
+        {
+            strncpy(szOutput, szStart, nLen);
+            rszEnd -= strlen(szDelimiter);
+            fRet = TRUE;
+        }
+    }
+
+    return fRet;
+}
+
+static BOOL RefExtractUnquotedString(const char* szStart, const char cDelimiter,
+        char* szOutput, const UINT32 cbOutput, const char*& rszEnd)
+{
+    char tmp[2] = {cDelimiter, '\0'};
+
+    RefSkipSpaces(szStart, szStart);
+
+    return RefExtractUnquotedString(szStart, tmp, szOutput, cbOutput, rszEnd);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// The two implementations behind one table, for the kernels
+/////////////////////////////////////////////////////////////////////////////
+
+struct EXTRACT_API
+{
+    const char* pszName;
+    BOOL (*pfnFindAndSkipString)(const char*, const char*, const char*&);
+    BOOL (*pfnSkipString)(const char*, const char*, const char*&);
+    UINT32 (*pfnFindRspArgs)(const char*, const char*, char**, UINT32);
+    BOOL (*pfnExtractUInt32)(const char*, UINT32&, const char*&);
+    BOOL (*pfnExtractQuotedString)(const char*, char*, const UINT32, const char*&);
+    BOOL (*pfnExtractUnquotedString)(const char*, const char*, char*, const UINT32,
+            const char*&);
+};
+
+static BOOL CurExtractUnquotedString(const char* szStart, const char* szDelimiter,
+        char* szOutput, const UINT32 cbOutput, const char*& rszEnd)
+{
+    return ExtractUnquotedString(szStart, szDelimiter, szOutput, cbOutput, rszEnd);
+}
+
+static const EXTRACT_API g_ref =
+{
+    "original",
+    RefFindAndSkipString,
+    RefSkipString,
+    RefFindRspArgs,
+    RefExtractUInt32,
+    RefExtractQuotedString,
+    RefExtractUnquotedString
+};
+
+static const EXTRACT_API g_cur =
+{
+    "current",
+    FindAndSkipString,
+    SkipString,
+    FindRspArgs,
+    ExtractUInt32,
+    ExtractQuotedString,
+    CurExtractUnquotedString
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// Recorded responses
+/////////////////////////////////////////////////////////////////////////////
+
+static const char g_szClcc[] =
+    "\r\n+CLCC: 1,0,0,0,0,\"+15145551234\",145,\"Alice\"\r\n"
+    "+CLCC: 2,1,1,0,0,\"5145556789\",129,\"\"\r\n"
+    "+CLCC: 3,0,4,0,1,\"0033155512345\",129\r\n"
+    "+CLCC: 4,1,5,0,1,\"\",128\r\n"
+    "\r\nOK\r\n";
+
+static const char g_szCops[] =
+    "\r\n+COPS: (2,\"Operator 01\",\"OP01\",\"30201\",2),(1,\"Operator 02\",\"OP02\","
+    "\"30202\",0),(1,\"Operator 03\",\"OP03\",\"30203\",2),(3,\"Operator 04\",\"OP04\","
+    "\"30204\",7),(1,\"Operator 05\",\"OP05\",\"30205\",0),(1,\"Operator 06\",\"OP06\","
+    "\"30206\",2),(3,\"Operator 07\",\"OP07\",\"30207\",2),(1,\"Operator 08\",\"OP08\","
+    "\"30208\",7),(1,\"Operator 09\",\"OP09\",\"30209\",0),(1,\"Operator 10\",\"OP10\","
+    "\"30210\",2),(1,\"Operator 11\",\"OP11\",\"310410\",7),(3,\"Operator 12\",\"OP12\","
+    "\"310260\",2),(1,\"Operator 13\",\"OP13\",\"20801\",0),(1,\"Operator 14\",\"OP14\","
+    "\"20810\",2),(1,\"Operator 15\",\"OP15\",\"23410\",7),(3,\"Operator 16\",\"OP16\","
+    "\"26201\",2),(1,\"Operator 17\",\"OP17\",\"22210\",0),(1,\"Operator 18\",\"OP18\","
+    "\"21407\",2),(1,\"Operator 19\",\"OP19\",\"50501\",7),(1,\"Operator 20\",\"OP20\","
+    "\"44010\",2),,(0,1,2,3,4),(0,1,2)\r\n"
+    "\r\nOK\r\n";
+
+static const char g_szXcellinfo[] =
+    "\r\n+XCELLINFO: 0,302,220,\"ABCD\",\"0000C3F1\",42,\"3C\",\"0066\",1,0\r\n"
+    "+XCELLINFO: 1,\"ABCD\",\"0000C3F2\",37,\"3D\",\"0067\"\r\n"
+    "+XCELLINFO: 1,\"ABCE\",\"0000C3F3\",22,\"3E\",\"0068\"\r\n"
+    "+XCELLINFO: 3,310,10712,-23,-83,-12,101\r\n"
+    "+XCELLINFO: 3,315,10712,-30,-95,-18,110\r\n"
+    "+XCELLINFO: 3,482,10737,-41,-101,-20,118\r\n"
+    "\r\nOK\r\n";
+
+static const char g_szCmt[] =
+    "\r\n+CMT: ,159\r\n"
+    "07911326040000F0640B911326880736F40000A90008050003FF0201D4F29C0E8ACD1A"
+    "4E37D82DAF83C2F4F3C0C9A783CCE532680E7DD3E93270D91E1697D36F50FA0DD2D7E2"
+    "E170DA0D7A97E5A0F9DB5D06C1DF6E1A485E9683C4E9B7BB0C9A86D7DF6E10FB0D4AD7"
+    "E3F23A281E6E87DD6F38DA4D9F8361B72B1C8683C2F4F3C0C9A783CCE532680E7DD3E9"
+    "3270D91E1697D36F50FA0DD2D7E2E170DA0D7A97E5A0F9DB5D06C1DF6E1A485E96\r\n";
+
+static const char g_szCrsm[] =
+    "\r\n+CRSM: 144,0,\"622C8202412183026F3AA5038001718A01058B036F0603800200C8880140"
+    "8101019000000000000000000000000000000000FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF"
+    "FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF"
+    "07915155125740F9040B915155255155F40000212090315134400A31D98C56B3DD7039FFFFFFFFFFFF"
+    "FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF"
+    "FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF\"\r\n"
+    "\r\nOK\r\n";
+
+struct RECORDED
+{
+    const char* pszName;
+    const char* pszRsp;
+    UINT32 (*pfnKernel)(const EXTRACT_API& rApi, const char* pszRsp);
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// Kernels, shaped after the parsers in te_base.cpp and te_xmm*.cpp. Each
+// returns a checksum of what it extracted.
+/////////////////////////////////////////////////////////////////////////////
+
+static UINT32 Checksum(const char* psz)
+{
+    UINT32 uiSum = 0;
+
+    while ('\0' != *psz)
+    {
+        uiSum = uiSum * 31 + (UINT8)*psz++;
+    }
+
+    return uiSum;
+}
+
+static UINT32 ParseClcc(const EXTRACT_API& rApi, const char* pszRsp)
+{
+    char szNumber[OUTPUT_SIZE];
+    char szAlpha[OUTPUT_SIZE];
+    UINT32 uiSum = 0;
+    UINT32 rgui[6];
+
+    while (rApi.pfnFindAndSkipString(pszRsp, "+CLCC: ", pszRsp))
+    {
+        if (!rApi.pfnExtractUInt32(pszRsp, rgui[0], pszRsp)
+                || !rApi.pfnSkipString(pszRsp, ",", pszRsp)
+                || !rApi.pfnExtractUInt32(pszRsp, rgui[1], pszRsp)
+                || !rApi.pfnSkipString(pszRsp, ",", pszRsp)
+                || !rApi.pfnExtractUInt32(pszRsp, rgui[2], pszRsp)
+                || !rApi.pfnSkipString(pszRsp, ",", pszRsp)
+                || !rApi.pfnExtractUInt32(pszRsp, rgui[3], pszRsp)
+                || !rApi.pfnSkipString(pszRsp, ",", pszRsp)
+                || !rApi.pfnExtractUInt32(pszRsp, rgui[4], pszRsp))
+        {
+            return 0;
+        }
+
+        uiSum += rgui[0] + rgui[1] + rgui[2] + rgui[3] + rgui[4];
+
+        if (rApi.pfnSkipString(pszRsp, ",", pszRsp)
+                && rApi.pfnExtractQuotedString(pszRsp, szNumber, sizeof(szNumber), pszRsp)
+                && rApi.pfnSkipString(pszRsp, ",", pszRsp)
+                && rApi.pfnExtractUInt32(pszRsp, rgui[5], pszRsp))
+        {
+            uiSum += Checksum(szNumber) + rgui[5];
+
+            if (rApi.pfnSkipString(pszRsp, ",", pszRsp)
+                    && rApi.pfnExtractQuotedString(pszRsp, szAlpha, sizeof(szAlpha), pszRsp))
+            {
+                uiSum += Checksum(szAlpha);
+            }
+        }
+    }
+
+    return uiSum;
+}
+
+static UINT32 ParseCops(const EXTRACT_API& rApi, const char* pszRsp)
+{
+    char szLong[OUTPUT_SIZE];
+    char szShort[OUTPUT_SIZE];
+    char szNumeric[OUTPUT_SIZE];
+    UINT32 uiSum = 0;
+    UINT32 uiStat = 0;
+    UINT32 uiAct = 0;
+
+    if (!rApi.pfnFindAndSkipString(pszRsp, "+COPS: ", pszRsp))
+    {
+        return 0;
+    }
+
+    while (rApi.pfnSkipString(pszRsp, "(", pszRsp)
+            && rApi.pfnExtractUInt32(pszRsp, uiStat, pszRsp)
+            && rApi.pfnSkipString(pszRsp, ",", pszRsp)
+            && rApi.pfnExtractQuotedString(pszRsp, szLong, sizeof(szLong), pszRsp)
+            && rApi.pfnSkipString(pszRsp, ",", pszRsp)
+            && rApi.pfnExtractQuotedString(pszRsp, szShort, sizeof(szShort), pszRsp)
+            && rApi.pfnSkipString(pszRsp, ",", pszRsp)
+            && rApi.pfnExtractQuotedString(pszRsp, szNumeric, sizeof(szNumeric), pszRsp)
+            && rApi.pfnSkipString(pszRsp, ",", pszRsp)
+            && rApi.pfnExtractUInt32(pszRsp, uiAct, pszRsp)
+            && rApi.pfnSkipString(pszRsp, ")", pszRsp))
+    {
+        uiSum += uiStat + uiAct + Checksum(szLong) + Checksum(szShort) + Checksum(szNumeric);
+        rApi.pfnSkipString(pszRsp, ",", pszRsp);
+    }
+
+    return uiSum;
+}
+
+static UINT32 ParseXcellinfo(const EXTRACT_API& rApi, const char* pszRsp)
+{
+    char* rgpszArgs[MAX_ARGS];
+    char szField[OUTPUT_SIZE];
+    UINT32 uiSum = 0;
+
+    while (rApi.pfnFindAndSkipString(pszRsp, "+XCELLINFO: ", pszRsp))
+    {
+        UINT32 nArgs = rApi.pfnFindRspArgs(pszRsp, "\r\n", rgpszArgs, MAX_ARGS);
+
+        for (UINT32 i = 0; i < nArgs; i++)
+        {
+            const char* pszArg = rgpszArgs[i];
+            UINT32 uiValue = 0;
+
+            if (rApi.pfnExtractUInt32(pszArg, uiValue, pszArg))
+            {
+                uiSum += uiValue;
+            }
+            else if (rApi.pfnExtractQuotedString(pszArg, szField, sizeof(szField), pszArg))
+            {
+                uiSum += Checksum(szField);
+            }
+            else
+            {
+                uiSum += (UINT32)(pszArg - pszRsp);
+            }
+        }
+    }
+
+    return uiSum;
+}
+
+static UINT32 ParseCmt(const EXTRACT_API& rApi, const char* pszRsp)
+{
+    char szAlpha[OUTPUT_SIZE];
+    char szPdu[OUTPUT_SIZE];
+    UINT32 uiLength = 0;
+
+    if (!rApi.pfnFindAndSkipString(pszRsp, "+CMT: ", pszRsp)
+            || !rApi.pfnExtractUnquotedString(pszRsp, ",", szAlpha, sizeof(szAlpha), pszRsp)
+            || !rApi.pfnSkipString(pszRsp, ",", pszRsp)
+            || !rApi.pfnExtractUInt32(pszRsp, uiLength, pszRsp)
+            || !rApi.pfnSkipString(pszRsp, "\r\n", pszRsp)
+            || !rApi.pfnExtractUnquotedString(pszRsp, "\r\n", szPdu, sizeof(szPdu), pszRsp))
+    {
+        return 0;
+    }
+
+    return uiLength + Checksum(szAlpha) + Checksum(szPdu);
+}
+
+static UINT32 ParseCrsm(const EXTRACT_API& rApi, const char* pszRsp)
+{
+    char szData[OUTPUT_SIZE];
+    UINT32 uiSw1 = 0;
+    UINT32 uiSw2 = 0;
+
+    if (!rApi.pfnSkipString(pszRsp, "\r\n", pszRsp)
+            || !rApi.pfnSkipString(pszRsp, "+CRSM: ", pszRsp)
+            || !rApi.pfnExtractUInt32(pszRsp, uiSw1, pszRsp)
+            || !rApi.pfnSkipString(pszRsp, ",", pszRsp)
+            || !rApi.pfnExtractUInt32(pszRsp, uiSw2, pszRsp)
+            || !rApi.pfnSkipString(pszRsp, ",", pszRsp)
+            || !rApi.pfnExtractQuotedString(pszRsp, szData, sizeof(szData), pszRsp))
+    {
+        return 0;
+    }
+
+    return uiSw1 + uiSw2 + Checksum(szData);
+}
+
+static const RECORDED g_rgRecorded[] =
+{
+    { "+CLCC",      g_szClcc,       ParseClcc },
+    { "+COPS=?",    g_szCops,       ParseCops },
+    { "+XCELLINFO", g_szXcellinfo,  ParseXcellinfo },
+    { "+CMT",       g_szCmt,        ParseCmt },
+    { "+CRSM",      g_szCrsm,       ParseCrsm }
+};
+
+static const UINT32 NUM_RECORDED = sizeof(g_rgRecorded) / sizeof(g_rgRecorded[0]);
+
+/////////////////////////////////////////////////////////////////////////////
+// Regression check
+/////////////////////////////////////////////////////////////////////////////
+
+static const char* const g_rgpszPatterns[] = { ",", "\"", " ", "\r\n", "+CLCC: ", "OK", "" };
+static const UINT32 NUM_PATTERNS = sizeof(g_rgpszPatterns) / sizeof(g_rgpszPatterns[0]);
+static const UINT32 g_rguiOutputSizes[] = { 1, 2, 5, 16, OUTPUT_SIZE };
+static const UINT32 NUM_OUTPUT_SIZES = sizeof(g_rguiOutputSizes) / sizeof(g_rguiOutputSizes[0]);
+
+static void Mismatch(const char* pszHelper, const char* pszInput, UINT32 uiOffset,
+        const char* pszDetail)
+{
+    BenchCheck(FALSE);
+
+    if (BenchReportFailure())
+    {
+        printf("MISMATCH %s at offset %u: %s\n  input: ", pszHelper, uiOffset, pszDetail);
+        for (const char* p = pszInput + uiOffset; '\0' != *p && p < pszInput + uiOffset + 40; p++)
+        {
+            if (' ' <= *p && '~' >= *p)
+            {
+                putchar(*p);
+            }
+            else
+            {
+                printf("\\x%02X", (UINT8)*p);
+            }
+        }
+        putchar('\n');
+    }
+}
+
+static void CheckResult(const char* pszHelper, const char* pszInput, UINT32 uiOffset,
+        BOOL bRef, BOOL bCur, const char* pszRefEnd, const char* pszCurEnd)
+{
+    if (bRef != bCur)
+    {
+        Mismatch(pszHelper, pszInput, uiOffset, "return value");
+    }
+    else if (pszRefEnd != pszCurEnd)
+    {
+        Mismatch(pszHelper, pszInput, uiOffset, "end pointer");
+    }
+    else
+    {
+        BenchCheck(TRUE);
+    }
+}
+
+// Calls every helper on both implementations at pszInput + uiOffset
+static void CheckAt(const char* pszInput, UINT32 uiOffset)
+{
+    const char* pszStart = pszInput + uiOffset;
+    char szRef[OUTPUT_SIZE];
+    char szCur[OUTPUT_SIZE];
+
+    for (UINT32 i = 0; i < NUM_PATTERNS; i++)
+    {
+        const char* pszPattern = g_rgpszPatterns[i];
+        const char* pszRefEnd = NULL;
+        const char* pszCurEnd = NULL;
+        BOOL bRef = RefFindAndSkipString(pszStart, pszPattern, pszRefEnd);
+        BOOL bCur = FindAndSkipString(pszStart, pszPattern, pszCurEnd);
+
+        CheckResult("FindAndSkipString", pszInput, uiOffset, bRef, bCur, pszRefEnd, pszCurEnd);
+
+        pszRefEnd = pszCurEnd = NULL;
+        bRef = RefSkipString(pszStart, pszPattern, pszRefEnd);
+        bCur = SkipString(pszStart, pszPattern, pszCurEnd);
+        CheckResult("SkipString", pszInput, uiOffset, bRef, bCur, pszRefEnd, pszCurEnd);
+
+        for (UINT32 j = 0; j < NUM_OUTPUT_SIZES && '\0' != pszPattern[0]; j++)
+        {
+            pszRefEnd = pszCurEnd = NULL;
+            bRef = RefExtractUnquotedString(pszStart, pszPattern, szRef, g_rguiOutputSizes[j],
+                    pszRefEnd);
+            bCur = ExtractUnquotedString(pszStart, pszPattern, szCur, g_rguiOutputSizes[j],
+                    pszCurEnd);
+            CheckResult("ExtractUnquotedString", pszInput, uiOffset, bRef, bCur, pszRefEnd,
+                    pszCurEnd);
+            if (0 != strcmp(szRef, szCur))
+            {
+                Mismatch("ExtractUnquotedString", pszInput, uiOffset, "output");
+            }
+
+            if ('\0' == pszPattern[1])
+            {
+                pszRefEnd = pszCurEnd = NULL;
+                bRef = RefExtractUnquotedString(pszStart, pszPattern[0], szRef,
+                        g_rguiOutputSizes[j], pszRefEnd);
+                bCur = ExtractUnquotedString(pszStart, pszPattern[0], szCur,
+                        g_rguiOutputSizes[j], pszCurEnd);
+                CheckResult("ExtractUnquotedString(char)", pszInput, uiOffset, bRef, bCur,
+                        pszRefEnd, pszCurEnd);
+                if (0 != strcmp(szRef, szCur))
+                {
+                    Mismatch("ExtractUnquotedString(char)", pszInput, uiOffset, "output");
+                }
+            }
+        }
+    }
+
+    {
+        UINT32 uiRef = 0xDEADBEEF;
+        UINT32 uiCur = 0xDEADBEEF;
+        const char* pszRefEnd = NULL;
+        const char* pszCurEnd = NULL;
+        BOOL bRef = RefExtractUInt32(pszStart, uiRef, pszRefEnd);
+        BOOL bCur = ExtractUInt32(pszStart, uiCur, pszCurEnd);
+
+        CheckResult("ExtractUInt32", pszInput, uiOffset, bRef, bCur, pszRefEnd, pszCurEnd);
+        if (uiRef != uiCur)
+        {
+            Mismatch("ExtractUInt32", pszInput, uiOffset, "value");
+        }
+    }
+
+    for (UINT32 j = 0; j < NUM_OUTPUT_SIZES; j++)
+    {
+        const char* pszRefEnd = NULL;
+        const char* pszCurEnd = NULL;
+        BOOL bRef = RefExtractQuotedString(pszStart, szRef, g_rguiOutputSizes[j], pszRefEnd);
+        BOOL bCur = ExtractQuotedString(pszStart, szCur, g_rguiOutputSizes[j], pszCurEnd);
+
+        CheckResult("ExtractQuotedString", pszInput, uiOffset, bRef, bCur, pszRefEnd,
+                pszCurEnd);
+        if (0 != strcmp(szRef, szCur))
+        {
+            Mismatch("ExtractQuotedString", pszInput, uiOffset, "output");
+        }
+    }
+
+    for (UINT32 uiMaxArgs = 1; uiMaxArgs <= MAX_ARGS; uiMaxArgs *= 2)
+    {
+        char* rgpszRef[MAX_ARGS];
+        char* rgpszCur[MAX_ARGS];
+        UINT32 nRef = RefFindRspArgs(pszStart, "\r\n", rgpszRef, uiMaxArgs);
+        UINT32 nCur = FindRspArgs(pszStart, "\r\n", rgpszCur, uiMaxArgs);
+
+        if (nRef != nCur || 0 != memcmp(rgpszRef, rgpszCur, nRef * sizeof(char*)))
+        {
+            Mismatch("FindRspArgs", pszInput, uiOffset, "arguments");
+        }
+        else
+        {
+            BenchCheck(TRUE);
+        }
+    }
+}
+
+static void CheckString(const char* pszInput)
+{
+    UINT32 uiLen = strlen(pszInput);
+
+    for (UINT32 uiOffset = 0; uiOffset <= uiLen; uiOffset++)
+    {
+        CheckAt(pszInput, uiOffset);
+    }
+}
+
+// Random strings over the characters the helpers look at
+static void CheckRandom(UINT32 nStrings)
+{
+    static const char szAlphabet[] = "0123456789  ,,\"\"\r\n+C:()AZ";
+    char szInput[FUZZ_LENGTH + 1];
+
+    for (UINT32 i = 0; i < nStrings; i++)
+    {
+        UINT32 uiLen = (UINT32)rand() % (FUZZ_LENGTH + 1);
+
+        for (UINT32 j = 0; j < uiLen; j++)
+        {
+            szInput[j] = szAlphabet[(UINT32)rand() % (sizeof(szAlphabet) - 1)];
+        }
+        szInput[uiLen] = '\0';
+
+        CheckAt(szInput, 0);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Benchmark
+/////////////////////////////////////////////////////////////////////////////
+
+static UINT32 RefKernel(const void* pContext)
+{
+    const RECORDED* pRecorded = (const RECORDED*)pContext;
+    return pRecorded->pfnKernel(g_ref, pRecorded->pszRsp);
+}
+
+static UINT32 CurKernel(const void* pContext)
+{
+    const RECORDED* pRecorded = (const RECORDED*)pContext;
+    return pRecorded->pfnKernel(g_cur, pRecorded->pszRsp);
+}
+
+int main(int argc, char** argv)
+{
+    BENCH_OPTIONS options;
+    BOOL bFailed = FALSE;
+
+    if (!BenchParseOptions(argc, argv, options))
+    {
+        return 2;
+    }
+
+    for (UINT32 i = 0; i < NUM_RECORDED; i++)
+    {
+        CheckString(g_rgRecorded[i].pszRsp);
+    }
+    CheckRandom(100000);
+
+    bFailed = !BenchChecksPassed("regression");
+
+    BenchPrintHeader("kernel");
+
+    for (UINT32 i = 0; i < NUM_RECORDED; i++)
+    {
+        const RECORDED& rRecorded = g_rgRecorded[i];
+        UINT32 uiRefChecksum = RefKernel(&rRecorded);
+        UINT32 uiCurChecksum = CurKernel(&rRecorded);
+
+        if (!BenchCompare(rRecorded.pszName, RefKernel, CurKernel, &rRecorded, options))
+        {
+            bFailed = TRUE;
+        }
+
+        if (uiRefChecksum != uiCurChecksum || 0 == uiCurChecksum)
+        {
+            printf("FAIL %s: checksum %u, original %u\n", rRecorded.pszName,
+                    uiCurChecksum, uiRefChecksum);
+            bFailed = TRUE;
+        }
+    }
+
+    return bFailed ? 1 : 0;
+}
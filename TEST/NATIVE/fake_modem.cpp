@@ -0,0 +1,914 @@
+////////////////////////////////////////////////////////////////////////////
+// fake_modem.cpp
+//
+// Copyright 2009 Intrinsyc Software International, Inc.  All rights reserved.
+// Patents pending in the United States of America and other jurisdictions.
+//
+//
+// Description:
+//    Scriptable fake modem for running RapidRIL without hardware. Every
+//    channel listens on a Unix socket path, which the RIL attaches to with
+//    -s (see CPort::OpenSocket, RILSettings/SocketInit). Commands are
+//    answered from a scenario file, URCs are injected at fixed periods, and
+//    latency, fragmentation and timeouts are simulated per channel.
+//
+//    Scenario file, one directive per line, '#' starts a comment:
+//
+//        channel <name> <socket path>    start a channel section
+//        latency <ms>                    delay before each answer
+//        fragment <bytes> <gap ms>       split answers into chunks
+//        handshake <text> <reply>        answer the socket init string
+//        on <prefix>|* [delay <ms>]      start a rule, first match wins
+//          reply <line>                  answer "\r\n<line>\r\n"
+//          raw <text>                    answer <text>, \r \n \z \\ escapes
+//          prompt                        answer "\r\n> ", read up to ^Z first
+//          timeout                       never answer
+//        urc <period ms> <line>          inject <line> periodically
+//        urc-once <delay ms> <line>      inject <line> once after connect
+//
+//    Prefixes are matched without case against the start of the command
+//    line. Commands no rule matches are answered with OK. Answers to a
+//    channel go out in command order, like a modem processing one command
+//    at a time.
+//
+//    Usage: fake-modem [-v] [-t <seconds>] <scenario file>
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "types.h"
+
+static const UINT32 MAX_CHANNELS = 16;
+static const UINT32 MAX_RULES = 128;
+static const UINT32 MAX_RULE_LINES = 16;
+static const UINT32 MAX_URCS = 16;
+static const UINT32 MAX_PENDING = 512;
+static const UINT32 MAX_LINE = 1024;
+static const UINT32 RX_BUFFER_SIZE = 8192;
+
+typedef unsigned long long UINT64;
+
+struct RULE
+{
+    char szPrefix[MAX_LINE];
+    UINT32 uiDelayMs;
+    BOOL bHasDelay;
+    BOOL bTimeout;
+    BOOL bPrompt;
+    UINT32 nLines;
+    char rgszLines[MAX_RULE_LINES][MAX_LINE];
+    BOOL rgbRaw[MAX_RULE_LINES];
+    UINT32 uiHits;
+};
+
+struct URC
+{
+    UINT32 uiPeriodMs;
+    BOOL bOnce;
+    BOOL bDone;
+    UINT64 ullNextMs;
+    char szText[MAX_LINE];
+    UINT32 uiSent;
+};
+
+struct PENDING
+{
+    UINT64 ullDueMs;
+    UINT32 uiLen;
+    char* pData;
+};
+
+struct CHANNEL
+{
+    char szName[32];
+    char szPath[108];
+    int iListenFd;
+    int iFd;
+
+    UINT32 uiLatencyMs;
+    UINT32 uiFragment;
+    UINT32 uiFragmentGapMs;
+    char szHandshake[64];
+    char szHandshakeReply[64];
+    BOOL bHandshakeDone;
+
+    RULE* pRules;
+    UINT32 nRules;
+    URC rgUrcs[MAX_URCS];
+    UINT32 nUrcs;
+
+    char szRx[RX_BUFFER_SIZE];
+    UINT32 uiRxLen;
+    RULE* pPromptRule;
+
+    PENDING rgPending[MAX_PENDING];
+    UINT32 uiPendingHead;
+    UINT32 uiPendingCount;
+    UINT64 ullLastDueMs;
+
+    UINT32 uiCommands;
+    UINT32 uiUnmatched;
+    UINT32 uiUrcsSent;
+    UINT64 ullBytesOut;
+};
+
+static CHANNEL g_rgChannels[MAX_CHANNELS];
+static UINT32 g_nChannels = 0;
+static BOOL g_bVerbose = FALSE;
+static volatile sig_atomic_t g_bStop = 0;
+
+static UINT64 NowMs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (UINT64)ts.tv_sec * 1000ULL + (UINT64)(ts.tv_nsec / 1000000);
+}
+
+static void OnSignal(int /*iSignal*/)
+{
+    g_bStop = 1;
+}
+
+// Strips leading and trailing white space in place, returns the start
+static char* Trim(char* pszLine)
+{
+    while (' ' == *pszLine || '\t' == *pszLine)
+    {
+        pszLine++;
+    }
+
+    size_t len = strlen(pszLine);
+    while (len > 0 && (' ' == pszLine[len - 1] || '\t' == pszLine[len - 1] ||
+            '\r' == pszLine[len - 1] || '\n' == pszLine[len - 1]))
+    {
+        pszLine[--len] = '\0';
+    }
+
+    return pszLine;
+}
+
+// Splits the first word off pszLine, returns the rest of the line
+static char* NextWord(char* pszLine, char*& rpszWord)
+{
+    rpszWord = pszLine;
+    while ('\0' != *pszLine && ' ' != *pszLine && '\t' != *pszLine)
+    {
+        pszLine++;
+    }
+
+    if ('\0' != *pszLine)
+    {
+        *pszLine++ = '\0';
+    }
+
+    return Trim(pszLine);
+}
+
+// Expands \r \n \z (^Z) and \\ in pszText, returns the length
+static UINT32 Unescape(const char* pszText, char* pszOut, UINT32 uiOutSize)
+{
+    UINT32 uiLen = 0;
+
+    while ('\0' != *pszText && uiLen + 1 < uiOutSize)
+    {
+        char c = *pszText++;
+
+        if ('\\' == c && '\0' != *pszText)
+        {
+            c = *pszText++;
+            switch (c)
+            {
+                case 'r': c = '\r'; break;
+                case 'n': c = '\n'; break;
+                case 'z': c = 0x1A; break;
+                default: break;
+            }
+        }
+
+        pszOut[uiLen++] = c;
+    }
+
+    pszOut[uiLen] = '\0';
+    return uiLen;
+}
+
+static BOOL ParseScenario(const char* pszFile)
+{
+    BOOL bRet = FALSE;
+    char szLine[MAX_LINE];
+    UINT32 uiLineNum = 0;
+    CHANNEL* pChannel = NULL;
+    RULE* pRule = NULL;
+
+    FILE* pFile = fopen(pszFile, "r");
+    if (NULL == pFile)
+    {
+        fprintf(stderr, "Cannot open scenario %s: %s\n", pszFile, strerror(errno));
+        goto Error;
+    }
+
+    while (NULL != fgets(szLine, sizeof(szLine), pFile))
+    {
+        char* pszDirective = NULL;
+        char* pszArgs = NULL;
+        char* pszLine = Trim(szLine);
+
+        uiLineNum++;
+
+        if ('\0' == *pszLine || '#' == *pszLine)
+        {
+            continue;
+        }
+
+        pszArgs = NextWord(pszLine, pszDirective);
+
+        if (0 == strcmp(pszDirective, "channel"))
+        {
+            char* pszName = NULL;
+
+            if (g_nChannels >= MAX_CHANNELS)
+            {
+                fprintf(stderr, "%s:%u: too many channels\n", pszFile, uiLineNum);
+                goto Error;
+            }
+
+            pChannel = &g_rgChannels[g_nChannels++];
+            memset(pChannel, 0, sizeof(CHANNEL));
+            pChannel->iListenFd = -1;
+            pChannel->iFd = -1;
+            pChannel->pRules = (RULE*)calloc(MAX_RULES, sizeof(RULE));
+            pRule = NULL;
+
+            pszArgs = NextWord(pszArgs, pszName);
+            if ('\0' == *pszName || '\0' == *pszArgs ||
+                    strlen(pszArgs) >= sizeof(pChannel->szPath) || NULL == pChannel->pRules)
+            {
+                fprintf(stderr, "%s:%u: channel <name> <path>\n", pszFile, uiLineNum);
+                goto Error;
+            }
+
+            snprintf(pChannel->szName, sizeof(pChannel->szName), "%s", pszName);
+            snprintf(pChannel->szPath, sizeof(pChannel->szPath), "%s", pszArgs);
+            continue;
+        }
+
+        if (NULL == pChannel)
+        {
+            fprintf(stderr, "%s:%u: %s outside of a channel\n", pszFile, uiLineNum,
+                    pszDirective);
+            goto Error;
+        }
+
+        if (0 == strcmp(pszDirective, "latency"))
+        {
+            pChannel->uiLatencyMs = (UINT32)strtoul(pszArgs, NULL, 10);
+        }
+        else if (0 == strcmp(pszDirective, "fragment"))
+        {
+            char* pszBytes = NULL;
+            pszArgs = NextWord(pszArgs, pszBytes);
+            pChannel->uiFragment = (UINT32)strtoul(pszBytes, NULL, 10);
+            pChannel->uiFragmentGapMs = (UINT32)strtoul(pszArgs, NULL, 10);
+        }
+        else if (0 == strcmp(pszDirective, "handshake"))
+        {
+            char* pszText = NULL;
+            pszArgs = NextWord(pszArgs, pszText);
+            Unescape(pszText, pChannel->szHandshake, sizeof(pChannel->szHandshake));
+            Unescape(pszArgs, pChannel->szHandshakeReply, sizeof(pChannel->szHandshakeReply));
+        }
+        else if (0 == strcmp(pszDirective, "on"))
+        {
+            char* pszPrefix = NULL;
+            char* pszOption = NULL;
+
+            if (pChannel->nRules >= MAX_RULES)
+            {
+                fprintf(stderr, "%s:%u: too many rules\n", pszFile, uiLineNum);
+                goto Error;
+            }
+
+            pRule = &pChannel->pRules[pChannel->nRules++];
+            pszArgs = NextWord(pszArgs, pszPrefix);
+            snprintf(pRule->szPrefix, sizeof(pRule->szPrefix), "%s", pszPrefix);
+
+            pszArgs = NextWord(pszArgs, pszOption);
+            if (0 == strcmp(pszOption, "delay"))
+            {
+                pRule->uiDelayMs = (UINT32)strtoul(pszArgs, NULL, 10);
+                pRule->bHasDelay = TRUE;
+            }
+        }
+        else if (0 == strcmp(pszDirective, "reply") || 0 == strcmp(pszDirective, "raw"))
+        {
+            if (NULL == pRule || pRule->nLines >= MAX_RULE_LINES)
+            {
+                fprintf(stderr, "%s:%u: %s needs a rule with room for it\n", pszFile,
+                        uiLineNum, pszDirective);
+                goto Error;
+            }
+
+            snprintf(pRule->rgszLines[pRule->nLines], MAX_LINE, "%s", pszArgs);
+            pRule->rgbRaw[pRule->nLines] = (0 == strcmp(pszDirective, "raw"));
+            pRule->nLines++;
+        }
+        else if (0 == strcmp(pszDirective, "prompt") || 0 == strcmp(pszDirective, "timeout"))
+        {
+            if (NULL == pRule)
+            {
+                fprintf(stderr, "%s:%u: %s outside of a rule\n", pszFile, uiLineNum,
+                        pszDirective);
+                goto Error;
+            }
+
+            if ('p' == pszDirective[0])
+            {
+                pRule->bPrompt = TRUE;
+            }
+            else
+            {
+                pRule->bTimeout = TRUE;
+            }
+        }
+        else if (0 == strcmp(pszDirective, "urc") || 0 == strcmp(pszDirective, "urc-once"))
+        {
+            char* pszPeriod = NULL;
+            URC* pUrc = NULL;
+
+            if (pChannel->nUrcs >= MAX_URCS)
+            {
+                fprintf(stderr, "%s:%u: too many URCs\n", pszFile, uiLineNum);
+                goto Error;
+            }
+
+            pUrc = &pChannel->rgUrcs[pChannel->nUrcs++];
+            pszArgs = NextWord(pszArgs, pszPeriod);
+            pUrc->uiPeriodMs = (UINT32)strtoul(pszPeriod, NULL, 10);
+            pUrc->bOnce = (NULL != strchr(pszDirective, '-'));
+            snprintf(pUrc->szText, sizeof(pUrc->szText), "%s", pszArgs);
+
+            if (!pUrc->bOnce && 0 == pUrc->uiPeriodMs)
+            {
+                fprintf(stderr, "%s:%u: URC period must not be 0\n", pszFile, uiLineNum);
+                goto Error;
+            }
+        }
+        else
+        {
+            fprintf(stderr, "%s:%u: unknown directive %s\n", pszFile, uiLineNum, pszDirective);
+            goto Error;
+        }
+    }
+
+    if (0 == g_nChannels)
+    {
+        fprintf(stderr, "%s: no channel\n", pszFile);
+        goto Error;
+    }
+
+    bRet = TRUE;
+
+Error:
+    if (NULL != pFile)
+    {
+        fclose(pFile);
+    }
+
+    return bRet;
+}
+
+static BOOL Listen(CHANNEL* pChannel)
+{
+    struct sockaddr_un addr;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", pChannel->szPath);
+    unlink(pChannel->szPath);
+
+    pChannel->iListenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (pChannel->iListenFd < 0 ||
+            bind(pChannel->iListenFd, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+            listen(pChannel->iListenFd, 1) < 0)
+    {
+        fprintf(stderr, "Cannot listen on %s: %s\n", pChannel->szPath, strerror(errno));
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static void DropPending(CHANNEL* pChannel)
+{
+    while (pChannel->uiPendingCount > 0)
+    {
+        free(pChannel->rgPending[pChannel->uiPendingHead].pData);
+        pChannel->uiPendingHead = (pChannel->uiPendingHead + 1) % MAX_PENDING;
+        pChannel->uiPendingCount--;
+    }
+}
+
+static void Disconnect(CHANNEL* pChannel)
+{
+    if (pChannel->iFd >= 0)
+    {
+        close(pChannel->iFd);
+        pChannel->iFd = -1;
+        printf("[%s] disconnected\n", pChannel->szName);
+    }
+
+    DropPending(pChannel);
+    pChannel->uiRxLen = 0;
+    pChannel->pPromptRule = NULL;
+}
+
+// Queues pData to go out at ullDueMs, but never ahead of what is queued already
+static void Queue(CHANNEL* pChannel, UINT64 ullDueMs, const char* pData, UINT32 uiLen)
+{
+    UINT32 uiChunk = (pChannel->uiFragment > 0) ? pChannel->uiFragment : uiLen;
+
+    if (ullDueMs < pChannel->ullLastDueMs)
+    {
+        ullDueMs = pChannel->ullLastDueMs;
+    }
+
+    for (UINT32 uiOffset = 0; uiOffset < uiLen; uiOffset += uiChunk)
+    {
+        UINT32 uiSize = (uiLen - uiOffset < uiChunk) ? uiLen - uiOffset : uiChunk;
+        PENDING* pPending = NULL;
+
+        if (pChannel->uiPendingCount >= MAX_PENDING)
+        {
+            fprintf(stderr, "[%s] output queue full, dropping %u bytes\n", pChannel->szName,
+                    uiLen - uiOffset);
+            return;
+        }
+
+        pPending = &pChannel->rgPending[(pChannel->uiPendingHead + pChannel->uiPendingCount)
+                % MAX_PENDING];
+        pPending->pData = (char*)malloc(uiSize);
+        if (NULL == pPending->pData)
+        {
+            return;
+        }
+
+        memcpy(pPending->pData, pData + uiOffset, uiSize);
+        pPending->uiLen = uiSize;
+        pPending->ullDueMs = ullDueMs;
+        pChannel->uiPendingCount++;
+        pChannel->ullLastDueMs = ullDueMs;
+
+        ullDueMs += pChannel->uiFragmentGapMs;
+    }
+}
+
+static void QueueLine(CHANNEL* pChannel, UINT64 ullDueMs, const char* pszLine, BOOL bRaw)
+{
+    char szOut[MAX_LINE + 4];
+    UINT32 uiLen = 0;
+
+    if (bRaw)
+    {
+        uiLen = Unescape(pszLine, szOut, sizeof(szOut));
+    }
+    else
+    {
+        uiLen = (UINT32)snprintf(szOut, sizeof(szOut), "\r\n%s\r\n", pszLine);
+        if (uiLen >= sizeof(szOut))
+        {
+            uiLen = sizeof(szOut) - 1;
+        }
+    }
+
+    Queue(pChannel, ullDueMs, szOut, uiLen);
+}
+
+static void QueueAnswer(CHANNEL* pChannel, RULE* pRule, UINT64 ullNowMs)
+{
+    UINT64 ullDueMs = ullNowMs + pChannel->uiLatencyMs;
+
+    if (NULL == pRule)
+    {
+        QueueLine(pChannel, ullDueMs, "OK", FALSE);
+        return;
+    }
+
+    if (pRule->bHasDelay)
+    {
+        ullDueMs = ullNowMs + pRule->uiDelayMs;
+    }
+
+    for (UINT32 i = 0; i < pRule->nLines; i++)
+    {
+        QueueLine(pChannel, ullDueMs, pRule->rgszLines[i], pRule->rgbRaw[i]);
+    }
+}
+
+static RULE* FindRule(CHANNEL* pChannel, const char* pszCommand)
+{
+    for (UINT32 i = 0; i < pChannel->nRules; i++)
+    {
+        RULE* pRule = &pChannel->pRules[i];
+
+        if (0 == strcmp(pRule->szPrefix, "*") ||
+                0 == strncasecmp(pszCommand, pRule->szPrefix, strlen(pRule->szPrefix)))
+        {
+            return pRule;
+        }
+    }
+
+    return NULL;
+}
+
+static void HandleCommand(CHANNEL* pChannel, char* pszCommand, UINT64 ullNowMs)
+{
+    RULE* pRule = FindRule(pChannel, pszCommand);
+
+    pChannel->uiCommands++;
+
+    if (g_bVerbose)
+    {
+        printf("[%s] %llu <- %s\n", pChannel->szName, ullNowMs, pszCommand);
+    }
+
+    if (NULL == pRule)
+    {
+        pChannel->uiUnmatched++;
+    }
+    else
+    {
+        pRule->uiHits++;
+
+        if (pRule->bTimeout)
+        {
+            return;
+        }
+    }
+
+    // The answer waits for the data terminated by ^Z
+    if (NULL != pRule && pRule->bPrompt)
+    {
+        Queue(pChannel, ullNowMs + pChannel->uiLatencyMs, "\r\n> ", 4);
+        pChannel->pPromptRule = pRule;
+        return;
+    }
+
+    QueueAnswer(pChannel, pRule, ullNowMs);
+}
+
+// Splits the receive buffer into commands ended by CR, or by ^Z after a prompt
+static void ProcessRx(CHANNEL* pChannel, UINT64 ullNowMs)
+{
+    UINT32 uiStart = 0;
+
+    if (!pChannel->bHandshakeDone && '\0' != pChannel->szHandshake[0])
+    {
+        UINT32 uiLen = strlen(pChannel->szHandshake);
+
+        if (pChannel->uiRxLen < uiLen)
+        {
+            return;
+        }
+
+        if (0 == memcmp(pChannel->szRx, pChannel->szHandshake, uiLen))
+        {
+            uiStart = uiLen;
+            Queue(pChannel, ullNowMs, pChannel->szHandshakeReply,
+                    strlen(pChannel->szHandshakeReply));
+        }
+    }
+
+    pChannel->bHandshakeDone = TRUE;
+
+    for (UINT32 i = uiStart; i < pChannel->uiRxLen; i++)
+    {
+        char c = pChannel->szRx[i];
+
+        if (NULL != pChannel->pPromptRule)
+        {
+            if (0x1A == c || 0x1B == c)
+            {
+                RULE* pRule = pChannel->pPromptRule;
+                pChannel->pPromptRule = NULL;
+
+                // ESC cancels the data, the modem just answers OK
+                QueueAnswer(pChannel, (0x1A == c) ? pRule : NULL, ullNowMs);
+                uiStart = i + 1;
+            }
+            continue;
+        }
+
+        if ('\r' == c || '\n' == c)
+        {
+            pChannel->szRx[i] = '\0';
+            if (i > uiStart)
+            {
+                HandleCommand(pChannel, &pChannel->szRx[uiStart], ullNowMs);
+            }
+            uiStart = i + 1;
+        }
+    }
+
+    if (uiStart > 0)
+    {
+        memmove(pChannel->szRx, &pChannel->szRx[uiStart], pChannel->uiRxLen - uiStart);
+        pChannel->uiRxLen -= uiStart;
+    }
+
+    if (pChannel->uiRxLen >= sizeof(pChannel->szRx) - 1)
+    {
+        fprintf(stderr, "[%s] command too long, discarded\n", pChannel->szName);
+        pChannel->uiRxLen = 0;
+    }
+}
+
+static void Accept(CHANNEL* pChannel, UINT64 ullNowMs)
+{
+    int iFd = accept(pChannel->iListenFd, NULL, NULL);
+
+    if (iFd < 0)
+    {
+        return;
+    }
+
+    // The RIL reopens its ports after a modem reset, the newest peer wins
+    Disconnect(pChannel);
+    pChannel->iFd = iFd;
+    pChannel->bHandshakeDone = FALSE;
+    pChannel->ullLastDueMs = ullNowMs;
+
+    for (UINT32 i = 0; i < pChannel->nUrcs; i++)
+    {
+        pChannel->rgUrcs[i].ullNextMs = ullNowMs + pChannel->rgUrcs[i].uiPeriodMs;
+        pChannel->rgUrcs[i].bDone = FALSE;
+    }
+
+    printf("[%s] connected\n", pChannel->szName);
+}
+
+static void Read(CHANNEL* pChannel, UINT64 ullNowMs)
+{
+    ssize_t nRead = read(pChannel->iFd, &pChannel->szRx[pChannel->uiRxLen],
+            sizeof(pChannel->szRx) - 1 - pChannel->uiRxLen);
+
+    if (nRead <= 0)
+    {
+        if (nRead < 0 && (EINTR == errno || EAGAIN == errno))
+        {
+            return;
+        }
+
+        Disconnect(pChannel);
+        return;
+    }
+
+    pChannel->uiRxLen += (UINT32)nRead;
+    ProcessRx(pChannel, ullNowMs);
+}
+
+// Writes out what is due and injects the URCs, returns the next due time
+static UINT64 Flush(CHANNEL* pChannel, UINT64 ullNowMs)
+{
+    UINT64 ullNextMs = ~0ULL;
+
+    if (pChannel->iFd < 0)
+    {
+        return ullNextMs;
+    }
+
+    for (UINT32 i = 0; i < pChannel->nUrcs; i++)
+    {
+        URC* pUrc = &pChannel->rgUrcs[i];
+
+        if (pUrc->bDone)
+        {
+            continue;
+        }
+
+        if (pUrc->ullNextMs <= ullNowMs)
+        {
+            QueueLine(pChannel, ullNowMs, pUrc->szText, FALSE);
+            pUrc->uiSent++;
+            pChannel->uiUrcsSent++;
+
+            if (pUrc->bOnce)
+            {
+                pUrc->bDone = TRUE;
+                continue;
+            }
+
+            pUrc->ullNextMs += pUrc->uiPeriodMs;
+            if (pUrc->ullNextMs <= ullNowMs)
+            {
+                pUrc->ullNextMs = ullNowMs + pUrc->uiPeriodMs;
+            }
+        }
+
+        if (pUrc->ullNextMs < ullNextMs)
+        {
+            ullNextMs = pUrc->ullNextMs;
+        }
+    }
+
+    while (pChannel->uiPendingCount > 0)
+    {
+        PENDING* pPending = &pChannel->rgPending[pChannel->uiPendingHead];
+        UINT32 uiWritten = 0;
+
+        if (pPending->ullDueMs > ullNowMs)
+        {
+            if (pPending->ullDueMs < ullNextMs)
+            {
+                ullNextMs = pPending->ullDueMs;
+            }
+            break;
+        }
+
+        while (uiWritten < pPending->uiLen)
+        {
+            ssize_t nWritten = send(pChannel->iFd, pPending->pData + uiWritten,
+                    pPending->uiLen - uiWritten, MSG_NOSIGNAL);
+
+            if (nWritten < 0)
+            {
+                if (EINTR == errno)
+                {
+                    continue;
+                }
+
+                Disconnect(pChannel);
+                return ~0ULL;
+            }
+
+            uiWritten += (UINT32)nWritten;
+        }
+
+        pChannel->ullBytesOut += pPending->uiLen;
+        free(pPending->pData);
+        pChannel->uiPendingHead = (pChannel->uiPendingHead + 1) % MAX_PENDING;
+        pChannel->uiPendingCount--;
+    }
+
+    return ullNextMs;
+}
+
+static void PrintStats()
+{
+    for (UINT32 i = 0; i < g_nChannels; i++)
+    {
+        CHANNEL* pChannel = &g_rgChannels[i];
+
+        printf("[%s] commands %u unmatched %u urcs %u bytes out %llu\n", pChannel->szName,
+                pChannel->uiCommands, pChannel->uiUnmatched, pChannel->uiUrcsSent,
+                pChannel->ullBytesOut);
+
+        for (UINT32 j = 0; j < pChannel->nRules; j++)
+        {
+            printf("[%s]   on %-24s %u\n", pChannel->szName, pChannel->pRules[j].szPrefix,
+                    pChannel->pRules[j].uiHits);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int iRet = 1;
+    int opt = 0;
+    UINT64 ullEndMs = ~0ULL;
+    struct pollfd rgPollFds[MAX_CHANNELS];
+    CHANNEL* rgpPolled[MAX_CHANNELS];
+
+    while (-1 != (opt = getopt(argc, argv, "vt:")))
+    {
+        switch (opt)
+        {
+            case 'v':
+                g_bVerbose = TRUE;
+                break;
+
+            case 't':
+                ullEndMs = NowMs() + 1000ULL * strtoul(optarg, NULL, 10);
+                break;
+
+            default:
+                goto Usage;
+        }
+    }
+
+    if (optind + 1 != argc)
+    {
+        goto Usage;
+    }
+
+    if (!ParseScenario(argv[optind]))
+    {
+        goto Error;
+    }
+
+    signal(SIGINT, OnSignal);
+    signal(SIGTERM, OnSignal);
+    signal(SIGPIPE, SIG_IGN);
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    for (UINT32 i = 0; i < g_nChannels; i++)
+    {
+        if (!Listen(&g_rgChannels[i]))
+        {
+            goto Error;
+        }
+    }
+
+    while (!g_bStop)
+    {
+        UINT64 ullNowMs = NowMs();
+        UINT64 ullNextMs = ullEndMs;
+        int iTimeout = -1;
+        int nFds = 0;
+
+        if (ullNowMs >= ullEndMs)
+        {
+            break;
+        }
+
+        for (UINT32 i = 0; i < g_nChannels; i++)
+        {
+            UINT64 ullDueMs = Flush(&g_rgChannels[i], ullNowMs);
+            if (ullDueMs < ullNextMs)
+            {
+                ullNextMs = ullDueMs;
+            }
+
+            rgpPolled[nFds] = &g_rgChannels[i];
+            rgPollFds[nFds].fd = (g_rgChannels[i].iFd >= 0) ? g_rgChannels[i].iFd :
+                    g_rgChannels[i].iListenFd;
+            rgPollFds[nFds].events = POLLIN;
+            rgPollFds[nFds].revents = 0;
+            nFds++;
+        }
+
+        if (~0ULL != ullNextMs)
+        {
+            iTimeout = (ullNextMs > ullNowMs) ? (int)(ullNextMs - ullNowMs) : 0;
+        }
+
+        if (poll(rgPollFds, nFds, iTimeout) < 0 && EINTR != errno)
+        {
+            fprintf(stderr, "poll failed: %s\n", strerror(errno));
+            goto Error;
+        }
+
+        ullNowMs = NowMs();
+
+        for (int i = 0; i < nFds; i++)
+        {
+            if (0 == rgPollFds[i].revents)
+            {
+                continue;
+            }
+
+            if (rgPollFds[i].fd == rgpPolled[i]->iListenFd)
+            {
+                Accept(rgpPolled[i], ullNowMs);
+            }
+            else
+            {
+                Read(rgpPolled[i], ullNowMs);
+            }
+        }
+    }
+
+    PrintStats();
+    iRet = 0;
+
+Error:
+    for (UINT32 i = 0; i < g_nChannels; i++)
+    {
+        Disconnect(&g_rgChannels[i]);
+
+        if (g_rgChannels[i].iListenFd >= 0)
+        {
+            close(g_rgChannels[i].iListenFd);
+            unlink(g_rgChannels[i].szPath);
+        }
+
+        free(g_rgChannels[i].pRules);
+    }
+
+    return iRet;
+
+Usage:
+    fprintf(stderr, "Usage: %s [-v] [-t <seconds>] <scenario file>\n", argv[0]);
+    return 2;
+}
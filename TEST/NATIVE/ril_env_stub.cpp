@@ -0,0 +1,744 @@
+////////////////////////////////////////////////////////////////////////////
+// ril_env_stub.cpp
+//
+// Copyright 2009 Intrinsyc Software International, Inc.  All rights reserved.
+// Patents pending in the United States of America and other jurisdictions.
+//
+//
+// Description:
+//    Stand-in for rild. Loads the RIL library, hands it a RIL_Env that
+//    records every RIL_onRequestComplete and RIL_onUnsolicitedResponse with
+//    a time stamp, and drives requests from a script. Like the framework,
+//    requests and timed callbacks all run on one event thread in due order.
+//
+//    Point the RIL channels at fake-modem with -s and set
+//    RILSettings/SocketInit to empty (or give the channels a handshake).
+//    The RIL still waits for the MMGR modem up event before opening them.
+//
+//    Request script, one command per line, '#' starts a comment:
+//
+//        wait <ms>                        sleep
+//        send <id> [int <n>...]           issue a request with an int array
+//        send <id> string <s>|- ...       ... with a string array, - is NULL
+//        send <id> raw <hex>              ... with raw bytes
+//        repeat <count> send ...          issue the same request count times
+//        sync [<timeout ms>]              wait for all requests to complete
+//        unsol <id> [<timeout ms>]        wait for the next unsolicited <id>
+//        state                            record onStateRequest()
+//
+//    The record gets one line per event, then the count, errors and latency
+//    percentiles per request id. The exit code is non-zero if a request
+//    did not complete or a wait timed out.
+//
+//    Usage: ril-env-stub [-l <library>] [-o <record>] <script> -- <RIL args>
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <dlfcn.h>
+#include <pthread.h>
+#include <time.h>
+#include <sys/time.h>
+
+#include <telephony/ril.h>
+
+#include "types.h"
+
+typedef unsigned long long UINT64;
+
+static const UINT32 MAX_LINE = 1024;
+static const UINT32 MAX_ARGS = 32;
+static const UINT32 MAX_IDS = 256;
+static const UINT32 DEFAULT_WAIT_MS = 60000;
+
+struct REQUEST
+{
+    UINT32 uiSeq;
+    int iRequest;
+    void* pData;
+    size_t dataLen;
+    UINT64 ullSentUs;
+    UINT64 ullDoneUs;
+    BOOL bDone;
+    RIL_Errno eError;
+};
+
+struct EVENT
+{
+    UINT64 ullDueUs;
+    RIL_TimedCallback pCallback;
+    void* pParam;
+    REQUEST* pRequest;
+    EVENT* pNext;
+};
+
+struct ID_STATS
+{
+    int iId;
+    UINT32 uiCount;
+};
+
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_cond = PTHREAD_COND_INITIALIZER;
+static EVENT* g_pEvents = NULL;
+
+static REQUEST** g_rgpRequests = NULL;
+static UINT32 g_nRequests = 0;
+static UINT32 g_uiRequestsSize = 0;
+static UINT32 g_nOutstanding = 0;
+
+static ID_STATS g_rgUnsolStats[MAX_IDS];
+static UINT32 g_nUnsolIds = 0;
+
+static const RIL_RadioFunctions* g_pFunctions = NULL;
+static FILE* g_pRecord = NULL;
+static UINT64 g_ullStartUs = 0;
+
+static UINT64 NowUs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (UINT64)ts.tv_sec * 1000000ULL + (UINT64)(ts.tv_nsec / 1000);
+}
+
+static void Record(const char* pszFormat, ...)
+    __attribute__((format(printf, 1, 2)));
+
+// Writes one record line stamped in ms since start, g_lock held
+static void Record(const char* pszFormat, ...)
+{
+    va_list args;
+    UINT64 ullUs = NowUs() - g_ullStartUs;
+
+    fprintf(g_pRecord, "%llu.%03llu ", ullUs / 1000, ullUs % 1000);
+    va_start(args, pszFormat);
+    vfprintf(g_pRecord, pszFormat, args);
+    va_end(args);
+    fputc('\n', g_pRecord);
+}
+
+// Queues an event in due order behind the ones due at the same time
+static void Post(EVENT* pEvent)
+{
+    EVENT** ppPos = NULL;
+
+    pthread_mutex_lock(&g_lock);
+    ppPos = &g_pEvents;
+    while (NULL != *ppPos && (*ppPos)->ullDueUs <= pEvent->ullDueUs)
+    {
+        ppPos = &(*ppPos)->pNext;
+    }
+    pEvent->pNext = *ppPos;
+    *ppPos = pEvent;
+    pthread_cond_broadcast(&g_cond);
+    pthread_mutex_unlock(&g_lock);
+}
+
+static void* EventLoop(void* /*pArg*/)
+{
+    pthread_mutex_lock(&g_lock);
+
+    for (;;)
+    {
+        EVENT* pEvent = g_pEvents;
+        UINT64 ullNowUs = NowUs();
+
+        if (NULL == pEvent)
+        {
+            pthread_cond_wait(&g_cond, &g_lock);
+            continue;
+        }
+
+        if (pEvent->ullDueUs > ullNowUs)
+        {
+            struct timespec ts;
+            struct timeval tv;
+            UINT64 ullWaitUs = pEvent->ullDueUs - ullNowUs;
+
+            // CLOCK_REALTIME deadline, the condition uses the default clock
+            gettimeofday(&tv, NULL);
+            ullWaitUs += (UINT64)tv.tv_usec;
+            ts.tv_sec = tv.tv_sec + (time_t)(ullWaitUs / 1000000);
+            ts.tv_nsec = (long)(ullWaitUs % 1000000) * 1000;
+            pthread_cond_timedwait(&g_cond, &g_lock, &ts);
+            continue;
+        }
+
+        g_pEvents = pEvent->pNext;
+
+        if (NULL != pEvent->pRequest)
+        {
+            REQUEST* pRequest = pEvent->pRequest;
+
+            pRequest->ullSentUs = NowUs();
+            Record("REQ %u %d len=%zu", pRequest->uiSeq, pRequest->iRequest, pRequest->dataLen);
+            pthread_mutex_unlock(&g_lock);
+            g_pFunctions->onRequest(pRequest->iRequest, pRequest->pData, pRequest->dataLen,
+                    (RIL_Token)pRequest);
+        }
+        else
+        {
+            pthread_mutex_unlock(&g_lock);
+            pEvent->pCallback(pEvent->pParam);
+        }
+
+        delete pEvent;
+        pthread_mutex_lock(&g_lock);
+    }
+
+    return NULL;
+}
+
+static void OnRequestComplete(RIL_Token t, RIL_Errno e, void* /*response*/, size_t responselen)
+{
+    REQUEST* pRequest = (REQUEST*)t;
+
+    pthread_mutex_lock(&g_lock);
+
+    if (NULL == pRequest)
+    {
+        Record("RSP ? err=%d len=%zu unknown token", (int)e, responselen);
+    }
+    else if (pRequest->bDone)
+    {
+        Record("RSP %u %d err=%d len=%zu completed twice", pRequest->uiSeq,
+                pRequest->iRequest, (int)e, responselen);
+    }
+    else
+    {
+        pRequest->ullDoneUs = NowUs();
+        pRequest->bDone = TRUE;
+        pRequest->eError = e;
+        g_nOutstanding--;
+
+        Record("RSP %u %d err=%d len=%zu us=%llu", pRequest->uiSeq, pRequest->iRequest,
+                (int)e, responselen, pRequest->ullDoneUs - pRequest->ullSentUs);
+    }
+
+    pthread_cond_broadcast(&g_cond);
+    pthread_mutex_unlock(&g_lock);
+}
+
+static void OnUnsolicitedResponse(int unsolResponse, const void* /*data*/, size_t datalen)
+{
+    UINT32 i = 0;
+
+    pthread_mutex_lock(&g_lock);
+
+    Record("UNSOL %d len=%zu", unsolResponse, datalen);
+
+    for (i = 0; i < g_nUnsolIds; i++)
+    {
+        if (g_rgUnsolStats[i].iId == unsolResponse)
+        {
+            break;
+        }
+    }
+
+    if (i == g_nUnsolIds && g_nUnsolIds < MAX_IDS)
+    {
+        g_rgUnsolStats[g_nUnsolIds++].iId = unsolResponse;
+    }
+
+    if (i < g_nUnsolIds)
+    {
+        g_rgUnsolStats[i].uiCount++;
+    }
+
+    pthread_cond_broadcast(&g_cond);
+    pthread_mutex_unlock(&g_lock);
+}
+
+static void* RequestTimedCallback(RIL_TimedCallback callback, void* param,
+        const struct timeval* relativeTime)
+{
+    EVENT* pEvent = new EVENT;
+
+    memset(pEvent, 0, sizeof(EVENT));
+    pEvent->pCallback = callback;
+    pEvent->pParam = param;
+    pEvent->ullDueUs = NowUs();
+
+    if (NULL != relativeTime)
+    {
+        pEvent->ullDueUs += (UINT64)relativeTime->tv_sec * 1000000ULL +
+                (UINT64)relativeTime->tv_usec;
+    }
+
+    Post(pEvent);
+    return NULL;
+}
+
+static const struct RIL_Env g_env =
+{
+    OnRequestComplete,
+    OnUnsolicitedResponse,
+    RequestTimedCallback
+};
+
+// Waits on g_cond until the deadline, g_lock held. Returns FALSE on timeout.
+static BOOL WaitUntil(UINT64 ullDeadlineUs)
+{
+    struct timespec ts;
+    struct timeval tv;
+    UINT64 ullNowUs = NowUs();
+    UINT64 ullWaitUs = 0;
+
+    if (ullNowUs >= ullDeadlineUs)
+    {
+        return FALSE;
+    }
+
+    gettimeofday(&tv, NULL);
+    ullWaitUs = ullDeadlineUs - ullNowUs + (UINT64)tv.tv_usec;
+    ts.tv_sec = tv.tv_sec + (time_t)(ullWaitUs / 1000000);
+    ts.tv_nsec = (long)(ullWaitUs % 1000000) * 1000;
+    pthread_cond_timedwait(&g_cond, &g_lock, &ts);
+    return TRUE;
+}
+
+// Builds the request payload from the words after the request id
+static BOOL BuildData(char** rgpszArgs, UINT32 nArgs, void*& rpData, size_t& rDataLen)
+{
+    rpData = NULL;
+    rDataLen = 0;
+
+    if (0 == nArgs)
+    {
+        return TRUE;
+    }
+
+    if (0 == strcmp(rgpszArgs[0], "int"))
+    {
+        int* pInts = (int*)calloc(nArgs, sizeof(int));
+        for (UINT32 i = 1; i < nArgs; i++)
+        {
+            pInts[i - 1] = (int)strtol(rgpszArgs[i], NULL, 0);
+        }
+        rpData = pInts;
+        rDataLen = (nArgs - 1) * sizeof(int);
+        return TRUE;
+    }
+
+    if (0 == strcmp(rgpszArgs[0], "string"))
+    {
+        char** ppszStrings = (char**)calloc(nArgs, sizeof(char*));
+        for (UINT32 i = 1; i < nArgs; i++)
+        {
+            ppszStrings[i - 1] = (0 == strcmp(rgpszArgs[i], "-")) ? NULL :
+                    strdup(rgpszArgs[i]);
+        }
+        rpData = ppszStrings;
+        rDataLen = (nArgs - 1) * sizeof(char*);
+        return TRUE;
+    }
+
+    if (0 == strcmp(rgpszArgs[0], "raw") && 2 == nArgs)
+    {
+        size_t len = strlen(rgpszArgs[1]) / 2;
+        unsigned char* pBytes = (unsigned char*)malloc(len + 1);
+        for (size_t i = 0; i < len; i++)
+        {
+            unsigned int uiByte = 0;
+            if (1 != sscanf(&rgpszArgs[1][2 * i], "%2x", &uiByte))
+            {
+                free(pBytes);
+                return FALSE;
+            }
+            pBytes[i] = (unsigned char)uiByte;
+        }
+        rpData = pBytes;
+        rDataLen = len;
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+static BOOL Send(char** rgpszArgs, UINT32 nArgs, UINT32 uiCount)
+{
+    if (nArgs < 1)
+    {
+        return FALSE;
+    }
+
+    for (UINT32 i = 0; i < uiCount; i++)
+    {
+        REQUEST* pRequest = new REQUEST;
+        EVENT* pEvent = new EVENT;
+
+        memset(pRequest, 0, sizeof(REQUEST));
+        memset(pEvent, 0, sizeof(EVENT));
+        pRequest->iRequest = (int)strtol(rgpszArgs[0], NULL, 0);
+
+        // Each request gets its own copy, the RIL may hold on to it
+        if (!BuildData(&rgpszArgs[1], nArgs - 1, pRequest->pData, pRequest->dataLen))
+        {
+            delete pRequest;
+            delete pEvent;
+            return FALSE;
+        }
+
+        pthread_mutex_lock(&g_lock);
+        if (g_nRequests == g_uiRequestsSize)
+        {
+            g_uiRequestsSize = (0 == g_uiRequestsSize) ? 64 : 2 * g_uiRequestsSize;
+            g_rgpRequests = (REQUEST**)realloc(g_rgpRequests,
+                    g_uiRequestsSize * sizeof(REQUEST*));
+        }
+        pRequest->uiSeq = g_nRequests;
+        g_rgpRequests[g_nRequests++] = pRequest;
+        g_nOutstanding++;
+        pthread_mutex_unlock(&g_lock);
+
+        pEvent->pRequest = pRequest;
+        pEvent->ullDueUs = NowUs();
+        Post(pEvent);
+    }
+
+    return TRUE;
+}
+
+static BOOL Sync(UINT32 uiTimeoutMs)
+{
+    UINT64 ullDeadlineUs = NowUs() + 1000ULL * uiTimeoutMs;
+    BOOL bRet = TRUE;
+
+    pthread_mutex_lock(&g_lock);
+    while (g_nOutstanding > 0 && bRet)
+    {
+        bRet = WaitUntil(ullDeadlineUs);
+    }
+
+    if (!bRet)
+    {
+        Record("SYNC timed out, %u outstanding", g_nOutstanding);
+    }
+    pthread_mutex_unlock(&g_lock);
+
+    return bRet;
+}
+
+// Returns how many unsolicited iId were recorded so far, g_lock held
+static UINT32 UnsolCount(int iId)
+{
+    for (UINT32 i = 0; i < g_nUnsolIds; i++)
+    {
+        if (g_rgUnsolStats[i].iId == iId)
+        {
+            return g_rgUnsolStats[i].uiCount;
+        }
+    }
+
+    return 0;
+}
+
+static BOOL WaitUnsol(int iId, UINT32 uiTimeoutMs)
+{
+    UINT64 ullDeadlineUs = NowUs() + 1000ULL * uiTimeoutMs;
+    UINT32 uiSeen = 0;
+    BOOL bRet = TRUE;
+
+    pthread_mutex_lock(&g_lock);
+    uiSeen = UnsolCount(iId);
+    while (bRet && UnsolCount(iId) == uiSeen)
+    {
+        bRet = WaitUntil(ullDeadlineUs);
+    }
+
+    if (!bRet)
+    {
+        Record("UNSOL %d not seen", iId);
+    }
+    pthread_mutex_unlock(&g_lock);
+
+    return bRet;
+}
+
+static BOOL RunScript(const char* pszFile)
+{
+    BOOL bRet = FALSE;
+    char szLine[MAX_LINE];
+    UINT32 uiLineNum = 0;
+
+    FILE* pFile = fopen(pszFile, "r");
+    if (NULL == pFile)
+    {
+        fprintf(stderr, "Cannot open script %s: %s\n", pszFile, strerror(errno));
+        goto Error;
+    }
+
+    while (NULL != fgets(szLine, sizeof(szLine), pFile))
+    {
+        char* rgpszArgs[MAX_ARGS];
+        UINT32 nArgs = 0;
+        UINT32 uiCount = 1;
+        char* pszSave = NULL;
+        char* pszComment = strchr(szLine, '#');
+        BOOL bOk = TRUE;
+
+        uiLineNum++;
+
+        if (NULL != pszComment)
+        {
+            *pszComment = '\0';
+        }
+
+        for (char* pszWord = strtok_r(szLine, " \t\r\n", &pszSave);
+                NULL != pszWord && nArgs < MAX_ARGS;
+                pszWord = strtok_r(NULL, " \t\r\n", &pszSave))
+        {
+            rgpszArgs[nArgs++] = pszWord;
+        }
+
+        if (0 == nArgs)
+        {
+            continue;
+        }
+
+        if (0 == strcmp(rgpszArgs[0], "repeat") && nArgs > 2 &&
+                0 == strcmp(rgpszArgs[2], "send"))
+        {
+            uiCount = (UINT32)strtoul(rgpszArgs[1], NULL, 10);
+            bOk = Send(&rgpszArgs[3], nArgs - 3, uiCount);
+        }
+        else if (0 == strcmp(rgpszArgs[0], "send"))
+        {
+            bOk = Send(&rgpszArgs[1], nArgs - 1, 1);
+        }
+        else if (0 == strcmp(rgpszArgs[0], "wait") && 2 == nArgs)
+        {
+            usleep(1000 * (useconds_t)strtoul(rgpszArgs[1], NULL, 10));
+        }
+        else if (0 == strcmp(rgpszArgs[0], "sync"))
+        {
+            if (!Sync((nArgs > 1) ? (UINT32)strtoul(rgpszArgs[1], NULL, 10) : DEFAULT_WAIT_MS))
+            {
+                goto Error;
+            }
+        }
+        else if (0 == strcmp(rgpszArgs[0], "unsol") && nArgs > 1)
+        {
+            if (!WaitUnsol((int)strtol(rgpszArgs[1], NULL, 0),
+                    (nArgs > 2) ? (UINT32)strtoul(rgpszArgs[2], NULL, 10) : DEFAULT_WAIT_MS))
+            {
+                goto Error;
+            }
+        }
+        else if (0 == strcmp(rgpszArgs[0], "state"))
+        {
+            int iState = (int)g_pFunctions->onStateRequest();
+            pthread_mutex_lock(&g_lock);
+            Record("STATE %d", iState);
+            pthread_mutex_unlock(&g_lock);
+        }
+        else
+        {
+            bOk = FALSE;
+        }
+
+        if (!bOk)
+        {
+            fprintf(stderr, "%s:%u: bad command %s\n", pszFile, uiLineNum, rgpszArgs[0]);
+            goto Error;
+        }
+    }
+
+    bRet = TRUE;
+
+Error:
+    if (NULL != pFile)
+    {
+        fclose(pFile);
+    }
+
+    return bRet;
+}
+
+static int CompareLatency(const void* pA, const void* pB)
+{
+    UINT64 ullA = *(const UINT64*)pA;
+    UINT64 ullB = *(const UINT64*)pB;
+    return (ullA < ullB) ? -1 : ((ullA > ullB) ? 1 : 0);
+}
+
+// Prints count, errors and latency percentiles per request id, g_lock held
+static void Summarize()
+{
+    UINT64* pullLatencies = (UINT64*)malloc((g_nRequests + 1) * sizeof(UINT64));
+    BOOL* pbSeen = (BOOL*)calloc(g_nRequests + 1, sizeof(BOOL));
+
+    fprintf(g_pRecord, "# request count errors pending p50_us p90_us p99_us max_us\n");
+
+    for (UINT32 i = 0; i < g_nRequests && NULL != pullLatencies && NULL != pbSeen; i++)
+    {
+        int iRequest = g_rgpRequests[i]->iRequest;
+        UINT32 uiCount = 0;
+        UINT32 uiErrors = 0;
+        UINT32 uiPending = 0;
+        UINT32 nDone = 0;
+
+        if (pbSeen[i])
+        {
+            continue;
+        }
+
+        for (UINT32 j = i; j < g_nRequests; j++)
+        {
+            REQUEST* pRequest = g_rgpRequests[j];
+
+            if (pRequest->iRequest != iRequest)
+            {
+                continue;
+            }
+
+            pbSeen[j] = TRUE;
+            uiCount++;
+
+            if (!pRequest->bDone)
+            {
+                uiPending++;
+                continue;
+            }
+
+            if (RIL_E_SUCCESS != pRequest->eError)
+            {
+                uiErrors++;
+            }
+            pullLatencies[nDone++] = pRequest->ullDoneUs - pRequest->ullSentUs;
+        }
+
+        if (0 == nDone)
+        {
+            fprintf(g_pRecord, "# %d %u %u %u - - - -\n", iRequest, uiCount, uiErrors,
+                    uiPending);
+            continue;
+        }
+
+        qsort(pullLatencies, nDone, sizeof(UINT64), CompareLatency);
+        fprintf(g_pRecord, "# %d %u %u %u %llu %llu %llu %llu\n", iRequest, uiCount,
+                uiErrors, uiPending, pullLatencies[nDone * 50 / 100],
+                pullLatencies[nDone * 90 / 100], pullLatencies[nDone * 99 / 100],
+                pullLatencies[nDone - 1]);
+    }
+
+    fprintf(g_pRecord, "# unsol count\n");
+    for (UINT32 i = 0; i < g_nUnsolIds; i++)
+    {
+        fprintf(g_pRecord, "# %d %u\n", g_rgUnsolStats[i].iId, g_rgUnsolStats[i].uiCount);
+    }
+
+    free(pullLatencies);
+    free(pbSeen);
+}
+
+int main(int argc, char** argv)
+{
+    const char* pszLibrary = "librapid-ril-core.so";
+    const char* pszScript = NULL;
+    void* pHandle = NULL;
+    const RIL_RadioFunctions* (*pfnInit)(const struct RIL_Env*, int, char**) = NULL;
+    pthread_t thread;
+    char** rgpszRilArgs = NULL;
+    int nRilArgs = 0;
+    BOOL bOk = FALSE;
+    int opt = 0;
+
+    g_pRecord = stdout;
+    g_ullStartUs = NowUs();
+
+    while (-1 != (opt = getopt(argc, argv, "+l:o:")))
+    {
+        switch (opt)
+        {
+            case 'l':
+                pszLibrary = optarg;
+                break;
+
+            case 'o':
+                g_pRecord = fopen(optarg, "w");
+                if (NULL == g_pRecord)
+                {
+                    fprintf(stderr, "Cannot open %s: %s\n", optarg, strerror(errno));
+                    return 1;
+                }
+                break;
+
+            default:
+                goto Usage;
+        }
+    }
+
+    if (optind >= argc)
+    {
+        goto Usage;
+    }
+
+    pszScript = argv[optind++];
+    setvbuf(g_pRecord, NULL, _IOLBF, 0);
+
+    // The RIL parses its arguments with getopt, argv[0] is the library like rild does
+    rgpszRilArgs = (char**)calloc(argc + 1, sizeof(char*));
+    rgpszRilArgs[nRilArgs++] = (char*)pszLibrary;
+    for (int i = optind; i < argc; i++)
+    {
+        if (0 != strcmp(argv[i], "--") || i != optind)
+        {
+            rgpszRilArgs[nRilArgs++] = argv[i];
+        }
+    }
+
+    pHandle = dlopen(pszLibrary, RTLD_NOW);
+    if (NULL == pHandle)
+    {
+        fprintf(stderr, "Cannot load %s: %s\n", pszLibrary, dlerror());
+        return 1;
+    }
+
+    pfnInit = (const RIL_RadioFunctions* (*)(const struct RIL_Env*, int, char**))
+            dlsym(pHandle, "RIL_Init");
+    if (NULL == pfnInit)
+    {
+        fprintf(stderr, "No RIL_Init in %s\n", pszLibrary);
+        return 1;
+    }
+
+    if (0 != pthread_create(&thread, NULL, EventLoop, NULL))
+    {
+        fprintf(stderr, "Cannot start the event loop\n");
+        return 1;
+    }
+
+    optind = 1;
+    g_pFunctions = pfnInit(&g_env, nRilArgs, rgpszRilArgs);
+    if (NULL == g_pFunctions)
+    {
+        fprintf(stderr, "RIL_Init failed\n");
+        return 1;
+    }
+
+    pthread_mutex_lock(&g_lock);
+    Record("INIT %s", (NULL != g_pFunctions->getVersion) ? g_pFunctions->getVersion() : "");
+    pthread_mutex_unlock(&g_lock);
+
+    bOk = RunScript(pszScript);
+
+    pthread_mutex_lock(&g_lock);
+    Summarize();
+    bOk = bOk && (0 == g_nOutstanding);
+    fflush(g_pRecord);
+    pthread_mutex_unlock(&g_lock);
+
+    // The RIL threads never return, leave without running the destructors
+    _exit(bOk ? 0 : 1);
+
+Usage:
+    fprintf(stderr, "Usage: %s [-l <library>] [-o <record>] <script> -- <RIL args>\n",
+            argv[0]);
+    return 2;
+}
@@ -6,8 +6,10 @@ include $(CLEAR_VARS)
 
 LOCAL_SRC_FILES:= \
     rillog.cpp \
+    rillogqueue.cpp \
     extract.cpp \
     util.cpp \
+    codec.cpp \
     repository.cpp
 
 LOCAL_IMPORT_C_INCLUDE_DIRS_FROM_SHARED_LIBRARIES += libtcs
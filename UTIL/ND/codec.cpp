@@ -0,0 +1,496 @@
+////////////////////////////////////////////////////////////////////////////
+// codec.cpp
+//
+// Copyright 2005-2007 Intrinsyc Software International, Inc.  All rights reserved.
+// Patents pending in the United States of America and other jurisdictions.
+//
+//
+// Description:
+//    Implementation of the hex, UCS2 and GSM default alphabet conversions.
+//
+//    Hex digits are decoded with a lookup table instead of comparisons, and an
+//    invalid digit is detected once per string rather than per character. The
+//    conversions to UTF-8 write into a buffer given by the caller and do not go
+//    through an intermediate byte buffer.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#include <stddef.h>
+
+#include "types.h"
+#include "rillog.h"
+#include "codec.h"
+
+#define minimum_of(a,b) (((a) < (b)) ? (a) : (b))
+
+
+/** GSM ALPHABET
+ **/
+
+#define  GSM_7BITS_ESCAPE   0x1b
+#define  GSM_7BITS_UNKNOWN  0
+
+static const unsigned short   gsm7bits_to_unicode[128] = {
+  '@', 0xa3,  '$', 0xa5, 0xe8, 0xe9, 0xf9, 0xec, 0xf2, 0xc7, '\n', 0xd8, 0xf8, '\r', 0xc5, 0xe5,
+0x394,  '_',0x3a6,0x393,0x39b,0x3a9,0x3a0,0x3a8,0x3a3,0x398,0x39e,    0, 0xc6, 0xe6, 0xdf, 0xc9,
+  ' ',  '!',  '"',  '#', 0xa4,  '%',  '&', '\'',  '(',  ')',  '*',  '+',  ',',  '-',  '.',  '/',
+  '0',  '1',  '2',  '3',  '4',  '5',  '6',  '7',  '8',  '9',  ':',  ';',  '<',  '=',  '>',  '?',
+ 0xa1,  'A',  'B',  'C',  'D',  'E',  'F',  'G',  'H',  'I',  'J',  'K',  'L',  'M',  'N',  'O',
+  'P',  'Q',  'R',  'S',  'T',  'U',  'V',  'W',  'X',  'Y',  'Z', 0xc4, 0xd6,0x147, 0xdc, 0xa7,
+ 0xbf,  'a',  'b',  'c',  'd',  'e',  'f',  'g',  'h',  'i',  'j',  'k',  'l',  'm',  'n',  'o',
+  'p',  'q',  'r',  's',  't',  'u',  'v',  'w',  'x',  'y',  'z', 0xe4, 0xf6, 0xf1, 0xfc, 0xe0,
+};
+
+static const unsigned short  gsm7bits_extend_to_unicode[128] = {
+    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,'\f',   0,   0,   0,   0,   0,
+    0,   0,   0,   0, '^',   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,   0,   0,   0,   0,   0,   0,   0, '{', '}',   0,   0,   0,   0,   0,'\\',
+    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0, '[', '~', ']',   0,
+  '|',   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,   0,   0,   0,   0,0x20ac, 0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+};
+
+//
+// Table used to map semi-byte values to hex characters
+//
+static const char g_rgchSemiByteToCharMap[16] =
+        { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F'};
+
+//
+// Value of each character as a hex digit, E_INVALID_DIGIT if it is not one
+//
+static const BYTE E_INVALID_DIGIT = 0x10;
+
+static const BYTE g_rgbCharToSemiByteMap[256] =
+{
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+};
+
+//
+// Decode uiBytes bytes from 2 * uiBytes hex characters. An invalid digit is decoded as 0.
+// Returns FALSE if there was one.
+//
+static BOOL HexToBytes(const char* pszHex, const UINT32 uiBytes, BYTE* pbOut)
+{
+    const BYTE* pbHex = (const BYTE*)pszHex;
+    BYTE bInvalid = 0;
+
+    for (UINT32 i = 0; i < uiBytes; i++)
+    {
+        BYTE bHigh = g_rgbCharToSemiByteMap[pbHex[0]];
+        BYTE bLow = g_rgbCharToSemiByteMap[pbHex[1]];
+
+        bInvalid |= bHigh | bLow;
+        pbOut[i] = (BYTE)(((bHigh & 0x0f) << 4) | (bLow & 0x0f));
+        pbHex += 2;
+    }
+
+    return 0 == (bInvalid & E_INVALID_DIGIT);
+}
+
+//
+// Combine 2 characters representing semi-bytes into a byte
+//
+BYTE SemiByteCharsToByte(const char chHigh, const char chLow)
+{
+    char rgch[2] = { chHigh, chLow };
+    BYTE bRet;
+
+    HexToBytes(rgch, 1, &bRet);
+    return bRet;
+}
+
+
+//
+//
+//
+BOOL GSMHexToGSM(const char* sIn, const UINT32 cbIn, BYTE* sOut,
+                            const UINT32 cbOut, UINT32& rcbUsed)
+{
+    rcbUsed = minimum_of(cbIn / 2, cbOut);
+    HexToBytes(sIn, rcbUsed, sOut);
+    return TRUE;
+}
+
+
+//
+//
+//
+BOOL GSMToGSMHex(const BYTE* sIn, const UINT32 cbIn, char* sOut, const UINT32 cbOut,
+                                                                    UINT32& rcbUsed)
+{
+    UINT32 cbBytes = minimum_of(cbIn, cbOut / 2);
+
+    for (UINT32 i = 0; i < cbBytes; i++)
+    {
+        sOut[2 * i] = g_rgchSemiByteToCharMap[sIn[i] >> 4];
+        sOut[2 * i + 1] = g_rgchSemiByteToCharMap[sIn[i] & 0x0f];
+    }
+
+    rcbUsed = 2 * cbBytes;
+    return TRUE;
+}
+
+/**
+ * Utility function to translate Hexadecimal array (characters) onto byte array (numeric values).
+ *
+ * @param szHexArray An allocated string of hexadecimal characters.
+ * @param uiLength Length of Hex array.
+ * @param szByteArray An allocated bytes/UINT8 array.
+ * @return true if extraction went well
+ */
+BOOL extractByteArrayFromString(const char* szHexArray, const UINT32 uiLength, UINT8* szByteArray)
+{
+    if (NULL == szHexArray || NULL == szByteArray || 0 == uiLength)
+    {
+        return FALSE;
+    }
+
+    return HexToBytes(szHexArray, uiLength / 2, szByteArray);
+}
+
+//  UCS2 to UTF8
+//
+// Helper fuction for UCS2 to UTF8 conversion below.
+static int utf8_write(unsigned char* utf8, int offset, int v)
+{
+    int result;
+
+    if (v < 128)
+    {
+        result = 1;
+        if (utf8)
+            utf8[offset] = (unsigned char) v;
+    }
+    else if (v < 0x800)
+    {
+        result = 2;
+        if (utf8)
+        {
+            utf8[offset+0] = (unsigned char)(0xc0 | (v >> 6));
+            utf8[offset+1] = (unsigned char)(0x80 | (v & 0x3f));
+        }
+    }
+    else if (v < 0x10000)
+    {
+        result = 3;
+        if (utf8)
+        {
+            utf8[offset+0] = (unsigned char)(0xe0 | (v >> 12));
+            utf8[offset+1] = (unsigned char)(0x80 | ((v >> 6) & 0x3f));
+            utf8[offset+2] = (unsigned char)(0x80 | (v & 0x3f));
+        }
+    }
+    else {
+        result = 4;
+        if (utf8)
+        {
+            utf8[offset+0] = (unsigned char)(0xf0 | ((v >> 18) & 0x7));
+            utf8[offset+1] = (unsigned char)(0x80 | ((v >> 12) & 0x3f));
+            utf8[offset+2] = (unsigned char)(0x80 | ((v >> 6) & 0x3f));
+            utf8[offset+3] = (unsigned char)(0x80 | (v & 0x3f));
+        }
+    }
+    return  result;
+}
+
+static int ucs2_to_utf8(const unsigned char* ucs2, int ucs2len, unsigned char* buf)
+{
+    int nn;
+    int result = 0;
+
+    // 0xFF is the value used for padding. Stop the conversion when 0xFF is encountered.
+    for (nn = 0; nn < ucs2len && ucs2[0] != 0xFF; ucs2 += 2, nn++)
+    {
+        int c = (ucs2[0] << 8) | ucs2[1];
+        result += utf8_write(buf, result, c);
+    }
+    return result;
+}
+
+UINT32 ConvertUCS2HexToUTF8(const char* pszHex, const UINT32 uiHexLength,
+        char* pszOut, const UINT32 cbOut)
+{
+    UINT32 uiUsed = 0;
+
+    if (NULL == pszOut || 0 == cbOut)
+    {
+        return 0;
+    }
+
+    if (NULL == pszHex || 0 != uiHexLength % 2)
+    {
+        RIL_LOG_CRITICAL("ConvertUCS2HexToUTF8 - Invalid hex string\r\n");
+        goto Done;
+    }
+
+    for (UINT32 i = 0; i + 4 <= uiHexLength; i += 4)
+    {
+        BYTE rgbUcs2[2];
+        int c;
+        UINT32 uiSize;
+
+        HexToBytes(pszHex + i, 2, rgbUcs2);
+
+        // 0xFF is the value used for padding
+        if (0xFF == rgbUcs2[0])
+        {
+            break;
+        }
+
+        c = (rgbUcs2[0] << 8) | rgbUcs2[1];
+        uiSize = (c < 0x80) ? 1 : ((c < 0x800) ? 2 : 3);
+        if (uiUsed + uiSize >= cbOut)
+        {
+            break;
+        }
+
+        uiUsed += utf8_write((unsigned char*)pszOut, uiUsed, c);
+    }
+
+Done:
+    pszOut[uiUsed] = '\0';
+    return uiUsed;
+}
+
+char* ConvertUCS2ToUTF8(const char* pHexBuffer, const UINT32 hexBufferLength)
+{
+    char* pUtf8Buffer = NULL;
+    UINT32 cbUtf8Buffer = 0;
+    UINT32 utf8Count = 0;
+
+    if (NULL == pHexBuffer || 0 >= hexBufferLength)
+    {
+        RIL_LOG_INFO("ConvertUCS2ToUTF8 - Invalid argument\r\n");
+        return NULL;
+    }
+
+    if (0 != hexBufferLength % 2)
+    {
+        RIL_LOG_CRITICAL("ConvertUCS2ToUTF8 - String was not a multiple of 2.\r\n");
+        return NULL;
+    }
+
+    // a UCS2 character is at most 3 bytes in UTF-8
+    cbUtf8Buffer = (hexBufferLength / 4) * 3 + 1;
+    pUtf8Buffer = new char[cbUtf8Buffer];
+    if (NULL == pUtf8Buffer)
+    {
+        RIL_LOG_CRITICAL("ConvertUCS2ToUTF8 - Cannot allocate %d bytes for pUtf8Buffer",
+                cbUtf8Buffer);
+        return NULL;
+    }
+
+    utf8Count = ConvertUCS2HexToUTF8(pHexBuffer, hexBufferLength, pUtf8Buffer, cbUtf8Buffer);
+    RIL_LOG_INFO("ConvertUCS2ToUTF8 - utf8Count: %d\r\n", utf8Count);
+
+    return pUtf8Buffer;
+}
+
+static int utf8_from_gsm8(const BYTE* pSrcBuffer, int length, char* pUtf8Buffer)
+{
+    int  result  = 0;
+    int  escaped = 0;
+
+    for (; length > 0; length--)
+    {
+        int c = *pSrcBuffer++;
+
+        if (c == 0xFF)
+            break;
+
+        if (c == GSM_7BITS_ESCAPE)
+        {
+            if (escaped)
+            { /* two escape characters => one space */
+                c = 0x20;
+                escaped = 0;
+            }
+            else
+            {
+                escaped = 1;
+                continue;
+            }
+        }
+        else
+        {
+            if (c >= 0x80)
+            {
+                c = 0x20;
+                escaped = 0;
+            }
+            else if (escaped)
+            {
+                c = gsm7bits_extend_to_unicode[c];
+            }
+            else
+            {
+                c = gsm7bits_to_unicode[c];
+            }
+        }
+
+        result += utf8_write((unsigned char*) pUtf8Buffer, result, c);
+    }
+
+    return  result;
+}
+
+static int GetUtf8Count(BYTE* pAlphaBuffer, int base, int len, int offset)
+{
+    int utf8Count = 0;
+
+    while (len > 0)
+    {
+        int c = pAlphaBuffer[offset];
+        if (c >= 0x80)
+        {
+            utf8Count += utf8_write(NULL, utf8Count, base + (c & 0x7F));
+            offset++;
+            len--;
+        }
+        else
+        {
+            /* GSM character set */
+            int count;
+            for (count = 0; count < len && pAlphaBuffer[offset+count] < 0x80; count++);
+
+            utf8Count += utf8_from_gsm8(pAlphaBuffer, count, NULL);
+            offset += count;
+            len -= count;
+        }
+    }
+
+    return utf8Count;
+}
+
+BOOL convertGsmToUtf8HexString(BYTE* pAlphaBuffer, int offset, const int length,
+        char* pszUtf8HexString, const int maxUtf8HexStringLength)
+{
+    BOOL bRet = FALSE;
+    BOOL bIsUCS2 = FALSE;
+    int utf8Count = 0;
+    int len = 0;
+    int base = 0;
+
+    if (NULL == pAlphaBuffer || 0 > length
+            || NULL == pszUtf8HexString || 0 > maxUtf8HexStringLength)
+        goto Error;
+
+    if (pAlphaBuffer[offset] == 0x80)
+    {
+        /* UCS2 source encoding */
+        int ucs2Len = (length - 1) / 2;
+
+        pAlphaBuffer += 1;
+        utf8Count = ucs2_to_utf8(pAlphaBuffer, ucs2Len, NULL);
+
+        if (utf8Count > maxUtf8HexStringLength)
+        {
+            goto Error;
+        }
+
+        utf8Count = ucs2_to_utf8(pAlphaBuffer, ucs2Len, (unsigned char*) pszUtf8HexString);
+    }
+    else
+    {
+        if (length >= 3 && pAlphaBuffer[offset] == 0x81)
+        {
+            len = pAlphaBuffer[offset + 1] & 0xFF;
+            if (len > length - 3)
+            {
+                len = length - 3;
+            }
+
+            base = ((pAlphaBuffer[offset + 2] & 0xFF) << 7);
+            offset += 3;
+            bIsUCS2 = TRUE;
+        }
+        else if (length >= 4 && pAlphaBuffer[offset] == 0x82)
+        {
+            len = pAlphaBuffer[offset + 1] & 0xFF;
+            if (len > length - 4)
+            {
+                len = length - 4;
+            }
+
+            base = ((pAlphaBuffer[offset + 2] & 0xFF) << 8) |
+                    (pAlphaBuffer[offset + 3] & 0xFF);
+            offset += 4;
+            bIsUCS2 = TRUE;
+        }
+
+        if (bIsUCS2)
+        {
+            utf8Count = GetUtf8Count(pAlphaBuffer, base, len, offset);
+
+            if (utf8Count < maxUtf8HexStringLength)
+            {
+                utf8Count = 0;
+                while (len > 0)
+                {
+                    int  c = pAlphaBuffer[offset];
+                    if (c >= 0x80)
+                    {
+                        utf8Count += utf8_write((unsigned char*) pszUtf8HexString, utf8Count,
+                                base + (c & 0x7F));
+                        offset++;
+                        len--;
+                    }
+                    else
+                    {
+                        /* GSM character set */
+                        int count;
+                        for (count = 0; count < len && pAlphaBuffer[offset+count] < 0x80; count++);
+
+                        utf8Count += utf8_from_gsm8(pAlphaBuffer, count,
+                                pszUtf8HexString + utf8Count);
+                        offset += count;
+                        len -= count;
+                    }
+                }
+            }
+        }
+        else
+        {
+            utf8Count = utf8_from_gsm8(pAlphaBuffer + offset, length, NULL);
+
+            if (utf8Count < maxUtf8HexStringLength)
+            {
+                utf8Count = utf8_from_gsm8(pAlphaBuffer + offset, length, pszUtf8HexString);
+            }
+            else
+            {
+                goto Error;
+            }
+        }
+    }
+
+    bRet = TRUE;
+Error:
+    RIL_LOG_INFO("convertGsmToUtf8HexString - utf8Count: %d, "
+            "maxUtf8HexStringLength: %d\r\n", utf8Count, maxUtf8HexStringLength);
+
+    if (NULL != pszUtf8HexString)
+    {
+        pszUtf8HexString[minimum_of(utf8Count, maxUtf8HexStringLength)] = '\0';
+    }
+
+    return bRet;
+}
@@ -0,0 +1,50 @@
+////////////////////////////////////////////////////////////////////////////
+// codec.h
+//
+// Copyright 2005-2007 Intrinsyc Software International, Inc.  All rights reserved.
+// Patents pending in the United States of America and other jurisdictions.
+//
+//
+// Description:
+//  Conversions between the hex strings exchanged with the modem and bytes, and
+//  from the UCS2 and GSM default alphabet character sets to UTF-8. SIM IO
+//  responses, SMS and STK PDUs and USSD strings all go through them.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "types.h"
+
+// Combine 2 characters representing semi-bytes into a byte. Upper and lower case
+// digits are accepted, an invalid digit is converted to 0.
+BYTE SemiByteCharsToByte(const char chHigh, const char chLow);
+
+// Convert the cbIn hex characters of sIn into bytes, stopping when sOut is full.
+// rcbUsed is the number of bytes written.
+BOOL GSMHexToGSM(const char* sIn, const UINT32 cbIn, BYTE* sOut,
+              const UINT32 cbOut, UINT32& rcbUsed);
+
+// Convert the cbIn bytes of sIn into upper case hex characters, stopping when sOut
+// is full. rcbUsed is the number of characters written, sOut is not null terminated.
+BOOL GSMToGSMHex(const BYTE* sIn, const UINT32 cbIn, char* sOut,
+              const UINT32 cbOut, UINT32& rcbUsed);
+
+// Utility function to translate Hexadecimal array (characters) onto byte array (numeric values).
+// Returns FALSE if a character is not a hex digit.
+BOOL extractByteArrayFromString(const char* szHexArray, const UINT32 uiLength, UINT8* szByteArray);
+
+// Convert a hex string of UCS2 characters, as sent by the modem when the TE character
+// set is UCS2, into a null terminated UTF-8 string. The conversion stops at the 0xFF
+// padding or before a character that does not fit in pszOut.
+// Returns the length of the UTF-8 string.
+UINT32 ConvertUCS2HexToUTF8(const char* pszHex, const UINT32 uiHexLength,
+        char* pszOut, const UINT32 cbOut);
+
+// Same as above into a buffer allocated with new[], NULL if the hex string is invalid
+char* ConvertUCS2ToUTF8(const char* pHexBuffer, const UINT32 hexBufferLength);
+
+// Convert a SIM alpha identifier (GSM default alphabet or one of the UCS2 codings of
+// 3GPP TS 31.102 annex A) into a null terminated UTF-8 string
+BOOL convertGsmToUtf8HexString(BYTE* pAlphaBuffer, int offset, const int length,
+        char* pszUtf8HexString, const int maxUtf8HexStringLength);
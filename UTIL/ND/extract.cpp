@@ -10,6 +10,8 @@
 //
 /////////////////////////////////////////////////////////////////////////////
 
+#include <errno.h>
+
 #include "types.h"
 #include "../../CORE/util.h"
 #include "extract.h"
@@ -59,16 +61,14 @@ BOOL SkipSpaces(const char* szStart, const char*& rszEnd)
 BOOL SkipString(const char* szStart, const char* szSkip, const char*& rszEnd)
 {
     BOOL fRet = FALSE;
-    UINT32 dwResult;
+    const UINT32 uiSkipLen = strlen(szSkip);
 
     //  Skip over any spaces
     SkipSpaces(szStart, szStart);
 
-    dwResult = strncmp(szStart, szSkip, strlen(szSkip));
-
-    if (!dwResult)
+    if (0 == strncmp(szStart, szSkip, uiSkipLen))
     {
-        rszEnd = szStart + strlen(szSkip);
+        rszEnd = szStart + uiSkipLen;
         fRet = TRUE;
     }
     else
@@ -149,6 +149,7 @@ UINT32 FindRspArgs(const char* pszCmdStr, const char* pszEndLine, char** aPtrArg
     const char* pszCurPtr = pszCmdStr;
     const char* pszPrevPtr = pszCmdStr;
     const char* pszEndPtr = NULL;
+    const char* pszComma = NULL;
     UINT32 uinPtrArg = 0;
 
     if ((pszCmdStr == NULL) || (pszEndLine == NULL) || (aPtrArgs == NULL))
@@ -165,14 +166,16 @@ UINT32 FindRspArgs(const char* pszCmdStr, const char* pszEndLine, char** aPtrArg
     }
 
     // Loop on "," characters
-    // Until end of line (end of rsp marker)
+    // Until end of line (end of rsp marker), without looking at the following lines
     uinPtrArg = 0;
-    while((uinPtrArg < uinMaxArgs)
-            && (FindAndSkipString(pszCurPtr, ",", pszCurPtr))
-            && (pszCurPtr < pszEndPtr))
+    while ((uinPtrArg < uinMaxArgs)
+            && (pszCurPtr < pszEndPtr - 1)
+            && (NULL != (pszComma = (const char*)memchr(pszCurPtr, ',',
+                    pszEndPtr - 1 - pszCurPtr))))
     {
         aPtrArgs[uinPtrArg] = (char*)pszPrevPtr;
         uinPtrArg++;
+        pszCurPtr = pszComma + 1;
         pszPrevPtr = pszCurPtr;
     }
 
@@ -235,26 +238,42 @@ BOOL ExtractQuotedString(const char* szStart, char* szOutput, const UINT32 cbOut
 {
     BOOL fRet = FALSE;
     const char* szWalk = NULL;
+    const char* szQuote = NULL;
     UINT32 nLen = 0;
 
     //  Skip over any spaces
     SkipSpaces(szStart, szStart);
 
-    memset(szOutput, 0, cbOutput);
+    // Only terminate the output, the buffer can be much larger than the string
+    if (cbOutput > 0)
+    {
+        szOutput[0] = '\0';
+    }
     rszEnd = szStart;
 
-    if ((SkipString(szStart, "\"", szWalk)))
+    if ('"' == *szStart)
     {
-        if (FindAndSkipString(szWalk, "\"", rszEnd))
+        szWalk = szStart + 1;
+        szQuote = strchr(szWalk, '"');
+
+        if (NULL != szQuote)
         {
-            nLen = rszEnd - szWalk - 1;
+            rszEnd = szQuote + 1;
+            nLen = szQuote - szWalk;
 
             if (cbOutput > nLen)
             {
-                strncpy(szOutput, szWalk, nLen);
+                memcpy(szOutput, szWalk, nLen);
+                szOutput[nLen] = '\0';
                 fRet = TRUE;
             }
         }
+        else
+        {
+            // Without a closing quote, left after the opening one and the spaces following it
+            rszEnd = szWalk;
+            SkipSpaces(szWalk, rszEnd);
+        }
     }
 
     return fRet;
@@ -281,22 +300,27 @@ BOOL ExtractUnquotedString(const char* szStart, const char* szDelimiter, char* s
                                              const UINT32 cbOutput, const char*& rszEnd)
 {
     BOOL fRet = FALSE;
+    const UINT32 uiDelimiterLen = strlen(szDelimiter);
     UINT32 nLen = 0;
 
     //  Skip over any spaces
     SkipSpaces(szStart, szStart);
 
-    memset(szOutput, 0, cbOutput);
+    if (cbOutput > 0)
+    {
+        szOutput[0] = '\0';
+    }
     rszEnd = szStart;
 
     if (FindAndSkipString(szStart, szDelimiter, rszEnd))
     {
-        nLen = rszEnd - szStart - strlen(szDelimiter);
+        nLen = rszEnd - szStart - uiDelimiterLen;
 
         if (cbOutput > nLen)
         {
-            strncpy(szOutput, szStart, nLen);
-            rszEnd -= strlen(szDelimiter);
+            memcpy(szOutput, szStart, nLen);
+            szOutput[nLen] = '\0';
+            rszEnd -= uiDelimiterLen;
             fRet = TRUE;
         }
     }
@@ -28,6 +28,9 @@
 #include <fcntl.h>
 #include <ctype.h>
 #include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "types.h"
 #include "rril.h"
@@ -58,8 +61,17 @@ const char   g_szTimeoutWaitForXIREG[]         = "TimeoutWaitForXIREG";
 const char   g_szGroupRILSettings[]            = "RILSettings";
 
 const char   g_szTimeoutThresholdForRetry[]    = "TimeoutThresholdForRetry";
+const char   g_szMaxPipelinedCommands[]        = "MaxPipelinedCommands";
+const char   g_szRequestCacheTTL[]             = "RequestCacheTTL";
+const char   g_szChannelReactor[]              = "ChannelReactor";
 const char   g_szOpenPortRetries[]             = "OpenPortRetries";
 const char   g_szOpenPortInterval[]            = "OpenPortInterval";
+const char   g_szSocketInit[]                  = "SocketInit";
+const char   g_szMaxInitCmdLineLength[]        = "MaxInitCmdLineLength";
+const char   g_szSignalHysteresisGW[]          = "SignalHysteresisGW";
+const char   g_szSignalHysteresisLTE[]         = "SignalHysteresisLTE";
+const char   g_szSignalMinInterval[]           = "SignalMinInterval";
+const char   g_szSimFileCacheEnabled[]         = "SimFileCacheEnabled";
 const char   g_szPinCacheMode[]                = "PinCacheMode";
 
 /////////////////////////////////////////////////
@@ -129,6 +141,7 @@ const char   g_szGroupLogging[]                 = "Logging";
 
 const char   g_szCallDropReporting[]            = "CallDropReporting";
 const char   g_szLogLevel[]                     = "LogLevel";
+const char   g_szLatencyStatsDumpInterval[]     = "LatencyStatsDumpInterval";
 
 //////////////////////////////////////////////////////////////////////////
 
@@ -159,7 +172,6 @@ enum
 
 static const char* REPO_DIR = "/system/etc/rril/";
 static const char* REPO_FILE = "/system/etc/rril/repository.txt";
-static const char* REPO_TMP_FILE = "/system/etc/rril/repository.tmp";
 static const char* GROUP_MARKER = "Group";
 static const int   GROUP_MARKER_LEN = 5;
 
@@ -167,7 +179,8 @@ static const int   GROUP_MARKER_LEN = 5;
 //////////////////////////////////////////////////////////////////////////
 // Variable Initialization
 
-struct CRepository::CRepLock CRepository::m_stLock = {{0}, {0}, 0, 0};
+pthread_mutex_t CRepository::m_stLock = PTHREAD_MUTEX_INITIALIZER;
+CRepository::CRepSnapshot* CRepository::m_pSnapshot = NULL;
 bool CRepository::m_bInitialized = FALSE;
 char CRepository::m_cRepoPath[MAX_MODEM_NAME_LEN];
 
@@ -175,7 +188,7 @@ char CRepository::m_cRepoPath[MAX_MODEM_NAME_LEN];
 //////////////////////////////////////////////////////////////////////////
 // CRepository Class Implementation
 
-CRepository::CRepository() : m_iFd(-1)
+CRepository::CRepository()
 {
 }
 
@@ -190,21 +203,6 @@ BOOL CRepository::Init()
     tcs_handle_t* h = NULL;
     tcs_cfg_t* cfg = NULL;
 
-    CRepository::m_stLock.iReaders = 0;
-    CRepository::m_stLock.iReadWaiters = 0;
-
-    if (0 != pthread_mutex_init(&m_stLock.stLock, NULL))
-    {
-        goto Error;
-    }
-
-    if (0 != pthread_cond_init(&m_stLock.stRead, NULL))
-    {
-        goto Error;
-    }
-
-    m_bInitialized = TRUE;
-
     snprintf(m_cRepoPath, MAX_MODEM_NAME_LEN, "%s", REPO_FILE);
 
     h = tcs_init();
@@ -224,16 +222,15 @@ BOOL CRepository::Init()
     //Update repository path
     snprintf(m_cRepoPath, MAX_MODEM_NAME_LEN, "%srepository%s.txt", REPO_DIR, cfg->mdm_info.name);
 
+    m_bInitialized = TRUE;
+
+    // Parse the file once; a missing file is reported by Read() like before
+    Reload();
+
 Error:
     if (h)
         tcs_dispose(h);
-    //in case tcs init/get config failed, release the mutex
-    if ((m_bInitialized) && ((!h) || (!cfg)))
-    {
-        pthread_mutex_destroy(&m_stLock.stLock);
-        pthread_cond_destroy(&m_stLock.stRead);
-        m_bInitialized = FALSE;
-    }
+
     return m_bInitialized;
 }
 
@@ -241,52 +238,349 @@ BOOL CRepository::Close()
 {
     if (m_bInitialized)
     {
-        pthread_mutex_destroy(&m_stLock.stLock);
-        pthread_cond_destroy(&m_stLock.stRead);
+        CRepSnapshot* pSnapshot;
+        BOOL bDestroy;
+
+        pthread_mutex_lock(&m_stLock);
+        pSnapshot = m_pSnapshot;
+        m_pSnapshot = NULL;
+        bDestroy = (NULL != pSnapshot) && (0 == pSnapshot->uiRefs);
         m_bInitialized = FALSE;
+        pthread_mutex_unlock(&m_stLock);
+
+        if (bDestroy)
+            DestroySnapshot(pSnapshot);
     }
 
     return TRUE;
 }
 
-BOOL CRepository::OpenRepositoryFile()
+BOOL CRepository::Reload()
 {
-    BOOL fRetVal = FALSE;
+    CRepSnapshot* pNew = NULL;
+    CRepSnapshot* pOld = NULL;
+    BOOL bDestroyOld = FALSE;
 
-    m_iLine = 1;
-    m_iFd   = open(m_cRepoPath, O_RDONLY);
+    if (!m_bInitialized)
+    {
+        RIL_LOG_CRITICAL("CRepository::Reload() - Repository has not been initialized.\r\n");
+        return FALSE;
+    }
 
-    if (m_iFd < 0)
+    pNew = LoadSnapshot();
+    if (NULL == pNew)
+    {
+        RIL_LOG_CRITICAL("CRepository::Reload() - Could not load the Repository file.\r\n");
+        return FALSE;
+    }
+
+    pthread_mutex_lock(&m_stLock);
+    pOld = m_pSnapshot;
+    m_pSnapshot = pNew;
+    // a snapshot still in use is destroyed by its last reader
+    bDestroyOld = (NULL != pOld) && (0 == pOld->uiRefs);
+    pthread_mutex_unlock(&m_stLock);
+
+    if (bDestroyOld)
+        DestroySnapshot(pOld);
+
+    return TRUE;
+}
+
+CRepository::CRepSnapshot* CRepository::AcquireSnapshot()
+{
+    CRepSnapshot* pSnapshot;
+
+    pthread_mutex_lock(&m_stLock);
+    pSnapshot = m_pSnapshot;
+    if (NULL != pSnapshot)
+        ++pSnapshot->uiRefs;
+    pthread_mutex_unlock(&m_stLock);
+
+    return pSnapshot;
+}
+
+void CRepository::ReleaseSnapshot(CRepSnapshot* pSnapshot)
+{
+    BOOL bDestroy;
+
+    if (NULL == pSnapshot)
+        return;
+
+    pthread_mutex_lock(&m_stLock);
+    --pSnapshot->uiRefs;
+    bDestroy = (0 == pSnapshot->uiRefs) && (pSnapshot != m_pSnapshot);
+    pthread_mutex_unlock(&m_stLock);
+
+    if (bDestroy)
+        DestroySnapshot(pSnapshot);
+}
+
+CRepository::CRepSnapshot* CRepository::LoadSnapshot()
+{
+    CRepSnapshot* pSnapshot = (CRepSnapshot*)calloc(1, sizeof(CRepSnapshot));
+
+    if (NULL == pSnapshot)
+    {
+        RIL_LOG_CRITICAL("CRepository::LoadSnapshot() - Cannot allocate snapshot\r\n");
+        goto Error;
+    }
+
+    if (!MapRepositoryFile(pSnapshot))
+        goto Error;
+
+    if (!ParseSnapshot(pSnapshot))
+        goto Error;
+
+    return pSnapshot;
+
+Error:
+    DestroySnapshot(pSnapshot);
+    return NULL;
+}
+
+BOOL CRepository::MapRepositoryFile(CRepSnapshot* pSnapshot)
+{
+    BOOL fRetVal = FALSE;
+    struct stat sStat;
+    size_t uiSize = 0;
+    int iFd = open(m_cRepoPath, O_RDONLY);
+
+    if (iFd < 0)
     {
         //Try to open repository file using old format and update the file path
         snprintf(m_cRepoPath, MAX_MODEM_NAME_LEN, "%s", REPO_FILE);
-        m_iFd = open(m_cRepoPath, O_RDONLY);
+        iFd = open(m_cRepoPath, O_RDONLY);
 
-        if (m_iFd < 0)
+        if (iFd < 0)
         {
             int iErrCode = errno;
-            RIL_LOG_CRITICAL("OpenRepositoryFile()-Could not open file \"%s\" - %s\r\n",
+            RIL_LOG_CRITICAL("MapRepositoryFile()-Could not open file \"%s\" - %s\r\n",
                 m_cRepoPath, strerror(iErrCode));
             goto Error;
         }
     }
 
-    // seek to beginning of file
-    ResetFile();
+    if (fstat(iFd, &sStat) < 0)
+    {
+        RIL_LOG_CRITICAL("MapRepositoryFile()-Could not stat file \"%s\" - %s\r\n",
+                m_cRepoPath, strerror(errno));
+        goto Error;
+    }
+
+    uiSize = (size_t)sStat.st_size;
+
+    // The content is NUL-terminated in place. A private writable mapping does this
+    // copy-on-write on the touched pages only, but it needs a spare byte after the
+    // end of the file, which is only guaranteed inside the last page.
+    if (0 < uiSize && 0 != (uiSize % (size_t)getpagesize()))
+    {
+        void* pMap = mmap(NULL, uiSize + 1, PROT_READ | PROT_WRITE, MAP_PRIVATE, iFd, 0);
+        if (MAP_FAILED != pMap)
+        {
+            pSnapshot->pBuffer = (char*)pMap;
+            pSnapshot->uiBufferSize = uiSize;
+            pSnapshot->bMapped = TRUE;
+            fRetVal = TRUE;
+            goto Error;
+        }
+
+        RIL_LOG_WARNING("MapRepositoryFile()-mmap failed, reading file - %s\r\n",
+                strerror(errno));
+    }
+
+    // Fall back to a heap copy of the file
+    pSnapshot->pBuffer = (char*)malloc(uiSize + 1);
+    if (NULL == pSnapshot->pBuffer)
+    {
+        RIL_LOG_CRITICAL("MapRepositoryFile()-Cannot allocate %u bytes\r\n", uiSize + 1);
+        goto Error;
+    }
+
+    while (pSnapshot->uiBufferSize < uiSize)
+    {
+        ssize_t iRead = read(iFd, pSnapshot->pBuffer + pSnapshot->uiBufferSize,
+                uiSize - pSnapshot->uiBufferSize);
+        if (iRead < 0 && EINTR == errno)
+            continue;
+
+        if (iRead <= 0)
+            break;
+
+        pSnapshot->uiBufferSize += iRead;
+    }
+    pSnapshot->pBuffer[pSnapshot->uiBufferSize] = '\0';
 
     fRetVal = TRUE;
 
 Error:
+    if (iFd >= 0)
+        close(iFd);
+
     return fRetVal;
 }
 
-void CRepository::CloseRepositoryFile()
+BOOL CRepository::ParseSnapshot(CRepSnapshot* pSnapshot)
+{
+    char* pCur = pSnapshot->pBuffer;
+    char* pEnd = pSnapshot->pBuffer + pSnapshot->uiBufferSize;
+    const char* pszGroup = NULL;
+    UINT32 uiGroupLen = 0;
+    UINT32 uiLines = 1;
+    UINT32 uiSize = 1;
+
+    // Each line holds at most one key; size the table to keep the load factor <= 1/2
+    for (char* p = pCur; p < pEnd; ++p)
+    {
+        if ('\n' == *p)
+            ++uiLines;
+    }
+
+    while (uiSize < 2 * uiLines)
+        uiSize <<= 1;
+
+    pSnapshot->pEntries = (CRepEntry*)calloc(uiSize, sizeof(CRepEntry));
+    if (NULL == pSnapshot->pEntries)
+    {
+        RIL_LOG_CRITICAL("CRepository::ParseSnapshot() - Cannot allocate %u entries\r\n", uiSize);
+        return FALSE;
+    }
+    pSnapshot->uiMask = uiSize - 1;
+
+    while (pCur < pEnd)
+    {
+        char* pLine = pCur;
+        char* pBuf;
+        char* pKeyEnd;
+
+        // terminate the line; '\r' and '\n' are both line ends as in the old reader
+        while (pCur < pEnd && '\n' != *pCur && '\r' != *pCur)
+            ++pCur;
+        *pCur++ = '\0';
+
+        pBuf = SkipSpace(pLine);
+        if (strncmp(pBuf, GROUP_MARKER, GROUP_MARKER_LEN) == 0)
+        {
+            pBuf = SkipSpace(pBuf + GROUP_MARKER_LEN);
+            pszGroup = pBuf;
+            uiGroupLen = SkipAlphaNum(pBuf) - pBuf;
+            continue;
+        }
+
+        // keys before the first group are unreachable
+        pKeyEnd = SkipAlphaNum(pBuf);
+        if (NULL == pszGroup || pKeyEnd == pBuf)
+            continue;
+
+        // get value associated to key
+        RemoveComment(pKeyEnd);
+        char* pValue = SkipSpace(pKeyEnd);
+        RemoveTrailingSpaces(pValue);
+
+        InsertEntry(pSnapshot, pszGroup, uiGroupLen, pBuf, pKeyEnd - pBuf, pValue);
+    }
+
+    return TRUE;
+}
+
+void CRepository::DestroySnapshot(CRepSnapshot* pSnapshot)
+{
+    if (NULL == pSnapshot)
+        return;
+
+    if (pSnapshot->bMapped)
+    {
+        munmap(pSnapshot->pBuffer, pSnapshot->uiBufferSize + 1);
+    }
+    else
+    {
+        free(pSnapshot->pBuffer);
+    }
+
+    free(pSnapshot->pEntries);
+    free(pSnapshot);
+}
+
+UINT32 CRepository::Hash(const char* pszGroup, UINT32 uiGroupLen, const char* pszKey,
+                                                                   UINT32 uiKeyLen)
+{
+    // FNV-1a over "group\0key"
+    UINT32 uiHash = 2166136261U;
+    UINT32 i;
+
+    for (i = 0; i < uiGroupLen; ++i)
+    {
+        uiHash = (uiHash ^ (UINT8)pszGroup[i]) * 16777619U;
+    }
+
+    uiHash *= 16777619U;
+
+    for (i = 0; i < uiKeyLen; ++i)
+    {
+        uiHash = (uiHash ^ (UINT8)pszKey[i]) * 16777619U;
+    }
+
+    // 0 marks a free slot
+    return (0 == uiHash) ? 1 : uiHash;
+}
+
+void CRepository::InsertEntry(CRepSnapshot* pSnapshot, const char* pszGroup, UINT32 uiGroupLen,
+                                                       const char* pszKey, UINT32 uiKeyLen,
+                                                       const char* pszValue)
+{
+    UINT32 uiHash = Hash(pszGroup, uiGroupLen, pszKey, uiKeyLen);
+    UINT32 uiSlot = uiHash & pSnapshot->uiMask;
+
+    while (0 != pSnapshot->pEntries[uiSlot].uiHash)
+    {
+        CRepEntry& rEntry = pSnapshot->pEntries[uiSlot];
+
+        // first occurrence wins, as with the sequential file search
+        if (rEntry.uiHash == uiHash
+                && rEntry.uiGroupLen == uiGroupLen
+                && rEntry.uiKeyLen == uiKeyLen
+                && 0 == strncmp(rEntry.pszGroup, pszGroup, uiGroupLen)
+                && 0 == strncmp(rEntry.pszKey, pszKey, uiKeyLen))
+        {
+            return;
+        }
+
+        uiSlot = (uiSlot + 1) & pSnapshot->uiMask;
+    }
+
+    pSnapshot->pEntries[uiSlot].uiHash = uiHash;
+    pSnapshot->pEntries[uiSlot].pszGroup = pszGroup;
+    pSnapshot->pEntries[uiSlot].uiGroupLen = uiGroupLen;
+    pSnapshot->pEntries[uiSlot].pszKey = pszKey;
+    pSnapshot->pEntries[uiSlot].uiKeyLen = uiKeyLen;
+    pSnapshot->pEntries[uiSlot].pszValue = pszValue;
+}
+
+const CRepository::CRepEntry* CRepository::FindEntry(const CRepSnapshot* pSnapshot,
+                                                     const char* szGroup, const char* szKey)
 {
-    if (m_iFd >= 0)
+    UINT32 uiGroupLen = strlen(szGroup);
+    UINT32 uiKeyLen = strlen(szKey);
+    UINT32 uiHash = Hash(szGroup, uiGroupLen, szKey, uiKeyLen);
+    UINT32 uiSlot = uiHash & pSnapshot->uiMask;
+
+    while (0 != pSnapshot->pEntries[uiSlot].uiHash)
     {
-        close(m_iFd);
-        m_iFd = -1;
+        const CRepEntry& rEntry = pSnapshot->pEntries[uiSlot];
+
+        if (rEntry.uiHash == uiHash
+                && rEntry.uiGroupLen == uiGroupLen
+                && rEntry.uiKeyLen == uiKeyLen
+                && 0 == strncmp(rEntry.pszGroup, szGroup, uiGroupLen)
+                && 0 == strncmp(rEntry.pszKey, szKey, uiKeyLen))
+        {
+            return &rEntry;
+        }
+
+        uiSlot = (uiSlot + 1) & pSnapshot->uiMask;
     }
+
+    return NULL;
 }
 
 BOOL CRepository::Read(const char* szGroup, const char* szKey, int& iRes)
@@ -308,10 +602,9 @@ BOOL CRepository::Read(const char* szGroup, const char* szKey, int& iRes)
 
 BOOL CRepository::Read(const char* szGroup, const char* szKey, char* szRes, int iMaxLen)
 {
-    char  szBuf[MAX_LINE_LEN];
-    char* pBuf = szBuf;
-    int   iRetVal = E_ERROR;
-    int   iRes;
+    BOOL fRetVal = FALSE;
+    CRepSnapshot* pSnapshot = NULL;
+    const CRepEntry* pEntry;
 
     if (!m_bInitialized)
     {
@@ -319,40 +612,31 @@ BOOL CRepository::Read(const char* szGroup, const char* szKey, char* szRes, int
         goto Error;
     }
 
-    // grab lock before accessing the NVM file
-    ReaderLock();
-
-    if (!OpenRepositoryFile())
+    pSnapshot = AcquireSnapshot();
+    if (NULL == pSnapshot)
     {
-        RIL_LOG_CRITICAL("CRepository::Read() - Could not open the Repository file.\r\n");
+        RIL_LOG_CRITICAL("CRepository::Read() - Repository file has not been loaded.\r\n");
         goto Error;
     }
 
-    // look for group
-    iRes = LocateGroup(szGroup);
-    if (E_OK != iRes)
+    pEntry = FindEntry(pSnapshot, szGroup, szKey);
+    if (NULL == pEntry)
     {
-        RIL_LOG_INFO("CRepository::Read() - Could not locate the \"%s\" group.\r\n", szGroup);
+        RIL_LOG_VERBOSE("CRepository::Read() - Could not locate the \"%s\" key in \"%s\".\r\n",
+                szKey, szGroup);
         goto Error;
     }
 
-    // look for key in group
-    iRes = LocateKey(szKey, pBuf);
-    if (E_OK != iRes)
-    {
-        RIL_LOG_VERBOSE("CRepository::Read() - Could not locate the \"%s\" key.\r\n", szKey);
-        goto Error;
-    }
+    // copy value
+    strncpy(szRes, pEntry->pszValue, iMaxLen - 1);
+    szRes[iMaxLen - 1] = '\0';
 
-    // get value associated to key
-    RemoveComment(pBuf);
-    iRetVal = ExtractValue(pBuf, szRes, iMaxLen);
+    fRetVal = TRUE;
 
 Error:
-    CloseRepositoryFile();
-    ReaderUnlock();
+    ReleaseSnapshot(pSnapshot);
 
-    return (E_OK == iRetVal);
+    return fRetVal;
 }
 
 // Read Fast Dormancy parameters from repository
@@ -386,119 +670,6 @@ BOOL CRepository::ReadFDParam(const char* szGroup, const char* szKey, char* szRe
     return (E_OK);
 }
 
-int CRepository::DumpLines(int iFd, int iFrom, int iTo)
-{
-    int iRetVal = E_ERROR;
-
-    if (E_OK != GotoLine(iFrom))
-        goto Error;
-
-    while (m_iLine != iTo)
-    {
-        char szBuf[MAX_LINE_LEN];
-        int  iSize;
-        int  iRes;
-
-        iRes = ReadLine(szBuf, FALSE);
-        if (E_OK != iRes && E_EOF != iRes)
-            goto Error;
-
-        iSize = strlen(szBuf);
-        if (write(iFd, szBuf, iSize) != iSize)
-            goto Error;
-
-        if (E_EOF == iRes)
-            break;
-    }
-
-    iRetVal = E_OK;
-
-Error:
-    return iRetVal;
-}
-
-void CRepository::ResetFile()
-{
-    lseek(m_iFd, 0, SEEK_SET);
-    m_iLine = 1;
-}
-
-int CRepository::GotoLine(int iLine)
-{
-    int iRetVal = E_ERROR;
-
-    if (iLine < m_iLine)
-        ResetFile();
-
-    while (m_iLine != iLine)
-    {
-        if (E_OK != ReadLine())
-            goto Error;
-    }
-
-    iRetVal = E_OK;
-
-Error:
-    return iRetVal;
-}
-
-int CRepository::ReadLine(char* szBuf, bool bRemoveCRAndLF)
-{
-    int  iRetVal = E_ERROR;
-    int  iCount = 0;
-    char cCh;
-
-    // TODO: limit to 256 characters
-
-    while(1)
-    {
-        switch(read(m_iFd, &cCh, 1))
-        {
-        case 1:
-            if (cCh == '\n' || cCh == '\r')
-            {
-                if (szBuf)
-                {
-                    if (!bRemoveCRAndLF)
-                        szBuf[iCount++] = cCh;
-
-                    szBuf[iCount] = '\0';
-                }
-                iRetVal = E_OK;
-                ++m_iLine;
-                goto Done;
-            }
-            else if (szBuf)
-            {
-                szBuf[iCount++] = cCh;
-            }
-            break;
-
-        case 0:
-            // end of file
-            if (szBuf)
-                szBuf[iCount] = '\0';
-
-            iRetVal = E_EOF;
-            goto Done;
-            break;  // unreachable
-
-        default:
-            // error
-            if (szBuf)
-                szBuf[iCount] = '\0';
-
-            iRetVal = E_ERROR;
-            goto Done;
-            break;  // unreachable
-        }
-    }
-
-Done:
-    return iRetVal;
-}
-
-
 void CRepository::RemoveComment(char* szIn)
 {
     // locate // marker
@@ -551,150 +722,3 @@ char* CRepository::SkipAlphaNum(char* szIn)
     }
     return szIn;
 }
-
-int CRepository::LocateGroup(const char* szGroup)
-{
-    char  szBuf[MAX_LINE_LEN];
-    char* pBuf;
-    int   iCount = 0;
-    int   iRetVal = E_ERROR;
-
-    while (1)
-    {
-        int iRes = ReadLine(szBuf);
-        switch(iRes)
-        {
-            case E_OK:
-            case E_EOF:
-                pBuf= SkipSpace(szBuf);
-                if (strncmp(pBuf, GROUP_MARKER, GROUP_MARKER_LEN) == 0)
-                {
-                    // is this our group?
-                    pBuf += GROUP_MARKER_LEN;
-                    pBuf = SkipSpace(pBuf);
-                    if (strncmp(pBuf, szGroup, strlen(szGroup)) == 0)
-                    {
-                        // group found
-                        iRetVal = E_OK;
-                        goto Done;
-                    }
-                }
-                if (E_EOF == iRes)
-                {
-                    iRetVal = E_NOT_FOUND;
-                    goto Done;
-                }
-                break;
-
-            default:
-                iRetVal = E_ERROR;
-                goto Done;
-                break;  // unreachable
-        }
-    }
-
-Done:
-    return iRetVal;
-}
-
-
-int CRepository::LocateKey(const char* szKey, char* szOut)
-{
-    char  szBuf[MAX_LINE_LEN];
-    char* pBuf;
-    int   iRetVal = E_ERROR;
-    int   iKeyLen = strlen(szKey);
-
-    while (1)
-    {
-        int iRes = ReadLine(szBuf);
-        switch(iRes)
-        {
-            case E_OK:
-            case E_EOF:
-                pBuf= SkipSpace(szBuf);
-                if (strncmp(pBuf, szKey, iKeyLen) == 0)
-                {
-                    if (szOut)
-                    {
-                        strcpy(szOut, szBuf);
-                    }
-
-                    iRetVal = E_OK;
-                    goto Done;
-                }
-                else if (strncmp(pBuf, GROUP_MARKER, GROUP_MARKER_LEN) == 0)
-                {
-                    // into next group
-                    iRetVal = E_NOT_FOUND;
-                    goto Done;
-                }
-
-                if (E_EOF == iRes)
-                {
-                    iRetVal = E_NOT_FOUND;
-                    goto Done;
-                }
-                break;
-
-            default:
-                iRetVal = E_ERROR;
-                goto Done;
-                break;  // unreachable
-        }
-    }
-
-Done:
-    return iRetVal;
-}
-
-int CRepository::ExtractValue(char* szIn, char* szRes, UINT32 iMaxLen)
-{
-    // skip key
-    szIn = SkipSpace(szIn);
-    szIn = SkipAlphaNum(szIn);
-    szIn = SkipSpace(szIn);
-    RemoveTrailingSpaces(szIn);
-
-    // copy value
-    if (strlen(szIn) >= iMaxLen)
-    {
-        strncpy(szRes, szIn, iMaxLen - 1);
-        szRes[iMaxLen - 1] = '\0';
-    }
-    else
-    {
-        strcpy(szRes, szIn);
-    }
-
-    return E_OK;
-}
-
-int CRepository::ReaderLock()
-{
-    int iRetVal = E_ERROR;
-
-    if (0 == pthread_mutex_lock(&m_stLock.stLock))
-    {
-        ++m_stLock.iReaders;
-        iRetVal = (pthread_mutex_unlock(&m_stLock.stLock) == 0) ? E_OK : E_ERROR;
-    }
-
-Error:
-    return iRetVal;
-}
-
-int CRepository::ReaderUnlock()
-{
-    int iRetVal = E_ERROR;
-
-    if (0 != pthread_mutex_lock(&m_stLock.stLock))
-        goto Error;
-
-    --m_stLock.iReaders;
-    iRetVal = (pthread_mutex_unlock(&m_stLock.stLock) == 0) ? E_OK : E_ERROR;
-
-Error:
-    return iRetVal;
-}
-
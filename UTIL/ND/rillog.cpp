@@ -13,6 +13,7 @@
 #include "types.h"
 #include "repository.h"
 #include "rillog.h"
+#include "rillogqueue.h"
 #include <utils/Log.h>
 #include <cutils/properties.h>
 
@@ -87,30 +88,86 @@ void CRilLog::Init(char* szSIMID)
         m_uiFlags = E_RIL_CRITICAL_LOG;
     }
 
+    // Format and write the messages on a background thread from now on
+    if (!CRilLogQueue::Start(Output))
+    {
+        RLOGE("Cannot start log queue, logging synchronously\r\n");
+    }
+
     m_bInitialized = TRUE;
 }
 
+//
+//  Capture the message and hand it to the log queue. Critical messages, and
+//  those that cannot be queued, are formatted and written right away: a
+//  critical message is often the last one before an abort and must not wait
+//  for the drain thread. It can show up ahead of records still in the queue.
+//
+void CRilLog::Log(UINT8 uiLevel, const char* szFormatString, va_list argList)
+{
+    char szLogText[m_uiMaxLogBufferSize];
+
+    if (E_RIL_CRITICAL_LOG != uiLevel)
+    {
+        LOG_RECORD record;
+
+        if (CRilLogQueue::Capture(record, uiLevel, szFormatString, argList)
+                && CRilLogQueue::Enqueue(record))
+        {
+            return;
+        }
+    }
+
+    // not vsnprintf, which does not know the %R conversion
+    CRilLogQueue::Format(szFormatString, argList, szLogText, m_uiMaxLogBufferSize);
+    Output(uiLevel, szLogText);
+}
+
+void CRilLog::Output(UINT8 uiLevel, const char* szLogText)
+{
+    char szNewTag[LOG_TAG_MAX_LENGTH];
+    int iPriority;
+
+    switch (uiLevel)
+    {
+        case E_RIL_VERBOSE_LOG:
+            iPriority = ANDROID_LOG_DEBUG;
+            break;
+
+        case E_RIL_INFO_LOG:
+            iPriority = ANDROID_LOG_INFO;
+            break;
+
+        case E_RIL_WARNING_LOG:
+            iPriority = ANDROID_LOG_WARN;
+            break;
+
+        case E_RIL_CRITICAL_LOG:
+        default:
+            iPriority = ANDROID_LOG_ERROR;
+            break;
+    }
+
+    if (strcmp(m_szSIMID, SIMID_DEFAULT_VALUE)!=0)
+    {
+        snprintf(szNewTag, LOG_TAG_MAX_LENGTH, "%s%s", LOG_TAG, m_szSIMID);
+        RLOG(iPriority, szNewTag, "%s", szLogText);
+    }
+    else
+    {
+        RLOG(iPriority, LOG_TAG, "%s", szLogText);
+    }
+}
+
 void CRilLog::Verbose(const char* const szFormatString, ...)
 {
     if (m_bInitialized && (m_uiFlags & E_RIL_VERBOSE_LOG))
     {
         va_list argList;
-        char szLogText[m_uiMaxLogBufferSize];
-        char szNewTag[LOG_TAG_MAX_LENGTH];
 
         va_start(argList, szFormatString);
-        vsnprintf(szLogText, m_uiMaxLogBufferSize, szFormatString, argList);
+        Log(E_RIL_VERBOSE_LOG, szFormatString, argList);
         va_end(argList);
-
-        if (strcmp(m_szSIMID, SIMID_DEFAULT_VALUE)!=0)
-        {
-            snprintf(szNewTag, LOG_TAG_MAX_LENGTH, "%s%s", LOG_TAG, m_szSIMID);
-            RLOG(ANDROID_LOG_DEBUG, szNewTag, "%s", szLogText);
-        }
-        else
-        {
-            RLOGD("%s", szLogText);
-        }
     }
 }
 
@@ -119,22 +176,10 @@ void CRilLog::Info(const char* const szFormatString, ...)
     if (m_bInitialized && (m_uiFlags & E_RIL_INFO_LOG))
     {
         va_list argList;
-        char szLogText[m_uiMaxLogBufferSize];
-        char szNewTag[LOG_TAG_MAX_LENGTH];
 
         va_start(argList, szFormatString);
-        vsnprintf(szLogText, m_uiMaxLogBufferSize, szFormatString, argList);
+        Log(E_RIL_INFO_LOG, szFormatString, argList);
         va_end(argList);
-
-        if (strcmp(m_szSIMID, SIMID_DEFAULT_VALUE)!=0)
-        {
-            snprintf(szNewTag, LOG_TAG_MAX_LENGTH, "%s%s", LOG_TAG, m_szSIMID);
-            RLOG(ANDROID_LOG_INFO, szNewTag, "%s", szLogText);
-        }
-        else
-        {
-            RLOGI("%s", szLogText);
-        }
     }
 }
 
@@ -143,22 +188,10 @@ void CRilLog::Warning(const char* const szFormatString, ...)
     if (m_bInitialized && (m_uiFlags & E_RIL_WARNING_LOG))
     {
         va_list argList;
-        char szLogText[m_uiMaxLogBufferSize];
-        char szNewTag[LOG_TAG_MAX_LENGTH];
 
         va_start(argList, szFormatString);
-        vsnprintf(szLogText, m_uiMaxLogBufferSize, szFormatString, argList);
+        Log(E_RIL_WARNING_LOG, szFormatString, argList);
         va_end(argList);
-
-        if (strcmp(m_szSIMID, SIMID_DEFAULT_VALUE)!=0)
-        {
-            snprintf(szNewTag, LOG_TAG_MAX_LENGTH, "%s%s", LOG_TAG, m_szSIMID);
-            RLOG(ANDROID_LOG_WARN, szNewTag, "%s", szLogText);
-        }
-        else
-        {
-            RLOGW("%s", szLogText);
-        }
     }
 }
 
@@ -167,22 +200,9 @@ void CRilLog::Critical(const char* const szFormatString, ...)
     if (m_bInitialized && (m_uiFlags & E_RIL_CRITICAL_LOG))
     {
         va_list argList;
-        char szLogText[m_uiMaxLogBufferSize];
-        char szNewTag[LOG_TAG_MAX_LENGTH];
 
         va_start(argList, szFormatString);
-        vsnprintf(szLogText, m_uiMaxLogBufferSize, szFormatString, argList);
+        Log(E_RIL_CRITICAL_LOG, szFormatString, argList);
         va_end(argList);
-
-        if (strcmp(m_szSIMID, SIMID_DEFAULT_VALUE)!=0)
-        {
-            snprintf(szNewTag, LOG_TAG_MAX_LENGTH, "%s%s", LOG_TAG, m_szSIMID);
-            RLOG(ANDROID_LOG_ERROR, szNewTag, "%s", szLogText);
-        }
-        else
-        {
-            RLOGE("%s", szLogText);
-        }
     }
 }
-
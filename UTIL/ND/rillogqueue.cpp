@@ -0,0 +1,899 @@
+////////////////////////////////////////////////////////////////////////////
+// rillogqueue.cpp
+//
+// Copyright 2009 Intrinsyc Software International, Inc.  All rights reserved.
+// Patents pending in the United States of America and other jurisdictions.
+//
+//
+// Description:
+//    Implements the deferred formatting log queue.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#include <string.h>
+#include <stddef.h>
+
+#include "types.h"
+#include "rillogqueue.h"
+
+CRilLogQueue::PFN_LOG_OUTPUT CRilLogQueue::m_pfnOutput = NULL;
+BOOL CRilLogQueue::m_bStarted = FALSE;
+volatile UINT32 CRilLogQueue::m_uiSeq = 0;
+volatile int CRilLogQueue::m_iPending = 0;
+pthread_key_t CRilLogQueue::m_threadKey;
+pthread_mutex_t CRilLogQueue::m_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t CRilLogQueue::m_cond = PTHREAD_COND_INITIALIZER;
+CRilLogQueue::CRing* CRilLogQueue::m_pRings = NULL;
+
+//
+//  Parsed conversion specification of a format string
+//
+struct LOG_SPEC
+{
+    const char* pszFlagsEnd;    // end of "%<flags><width>"
+    const char* pszPrecisionEnd;
+    const char* pszEnd;         // one past the conversion character
+    BOOL        bStarWidth;
+    BOOL        bStarPrecision;
+    int         iPrecision;     // -1 if none given as digits
+    UINT8       eType;
+    char        chConversion;
+};
+
+static BOOL ParseSpec(const char* pszSpec, LOG_SPEC& rSpec)
+{
+    const char* p = pszSpec + 1;
+    int nLong = 0;
+    BOOL bLongDouble = FALSE;
+
+    rSpec.bStarWidth = FALSE;
+    rSpec.bStarPrecision = FALSE;
+    rSpec.iPrecision = -1;
+
+    while ('\0' != *p && NULL != strchr("-+ #0'", *p))
+    {
+        p++;
+    }
+
+    if ('*' == *p)
+    {
+        rSpec.bStarWidth = TRUE;
+        p++;
+    }
+    else
+    {
+        while (*p >= '0' && *p <= '9')
+        {
+            p++;
+        }
+    }
+    rSpec.pszFlagsEnd = p;
+
+    if ('.' == *p)
+    {
+        p++;
+        if ('*' == *p)
+        {
+            rSpec.bStarPrecision = TRUE;
+            p++;
+        }
+        else
+        {
+            rSpec.iPrecision = 0;
+            while (*p >= '0' && *p <= '9')
+            {
+                rSpec.iPrecision = rSpec.iPrecision * 10 + (*p - '0');
+                p++;
+            }
+        }
+    }
+    rSpec.pszPrecisionEnd = p;
+
+    for (;; p++)
+    {
+        if ('l' == *p)
+        {
+            nLong++;
+        }
+        else if ('q' == *p || 'j' == *p)
+        {
+            nLong = 2;
+        }
+        else if ('z' == *p || 't' == *p)
+        {
+            nLong = 1;
+        }
+        else if ('h' == *p)
+        {
+            // promoted to int anyway
+        }
+        else if ('L' == *p)
+        {
+            bLongDouble = TRUE;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    rSpec.chConversion = *p;
+    rSpec.pszEnd = p + 1;
+
+    switch (*p)
+    {
+        case '%':
+            return TRUE;
+
+        case 'd':
+        case 'i':
+        case 'o':
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'c':
+            rSpec.eType = (nLong >= 2) ? E_LOG_ARG_LONGLONG :
+                    ((1 == nLong) ? E_LOG_ARG_LONG : E_LOG_ARG_INT);
+            return TRUE;
+
+        case 'p':
+            rSpec.eType = E_LOG_ARG_POINTER;
+            return TRUE;
+
+        case 's':
+            rSpec.eType = E_LOG_ARG_STRING;
+            // wide strings are not supported
+            return (0 == nLong);
+
+        case 'R':
+            rSpec.eType = E_LOG_ARG_RAW;
+            return TRUE;
+
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            rSpec.eType = E_LOG_ARG_DOUBLE;
+            return !bLongDouble;
+
+        default:
+            // %n, end of string or unknown conversion
+            return FALSE;
+    }
+}
+
+static void AddData(LOG_RECORD& rRecord, LOG_ARG& rArg, const char* pData, UINT32 uiLen)
+{
+    UINT32 uiRoom = LOG_RECORD::E_MAX_DATA - rRecord.uiDataSize;
+
+    // longer than what one log line could show anyway
+    if (uiLen > uiRoom)
+    {
+        uiLen = uiRoom;
+    }
+
+    memcpy(rRecord.szData + rRecord.uiDataSize, pData, uiLen);
+    rArg.uiOffset = rRecord.uiDataSize;
+    rArg.uiLen = uiLen;
+    rRecord.uiDataSize += uiLen;
+}
+
+//
+//  Read the value of a conversion from the argument list. String types are
+//  left pointing to the caller's data in u.p, with their length in uiLen.
+//
+static void ReadArg(LOG_ARG& rArg, UINT8 eType, int iPrecision, va_list* pArgList)
+{
+    rArg.eType = eType;
+    rArg.uiLen = 0;
+    rArg.uiOffset = 0;
+
+    switch (eType)
+    {
+        case E_LOG_ARG_INT:
+            rArg.u.i = va_arg(*pArgList, int);
+            break;
+
+        case E_LOG_ARG_LONG:
+            rArg.u.l = va_arg(*pArgList, long);
+            break;
+
+        case E_LOG_ARG_LONGLONG:
+            rArg.u.ll = va_arg(*pArgList, long long);
+            break;
+
+        case E_LOG_ARG_DOUBLE:
+            rArg.u.d = va_arg(*pArgList, double);
+            break;
+
+        case E_LOG_ARG_POINTER:
+            rArg.u.p = va_arg(*pArgList, void*);
+            break;
+
+        case E_LOG_ARG_STRING:
+        {
+            const char* pszString = va_arg(*pArgList, const char*);
+            const char* pszEnd;
+
+            rArg.u.p = pszString;
+            if (NULL == pszString)
+            {
+                rArg.eType = E_LOG_ARG_NULL_STRING;
+                break;
+            }
+
+            // with a precision the string does not have to be NULL terminated
+            if (iPrecision >= 0)
+            {
+                pszEnd = (const char*)memchr(pszString, '\0', iPrecision);
+                rArg.uiLen = (NULL == pszEnd) ? (UINT32)iPrecision
+                        : (UINT32)(pszEnd - pszString);
+            }
+            else
+            {
+                rArg.uiLen = strlen(pszString);
+            }
+            break;
+        }
+
+        case E_LOG_ARG_RAW:
+        {
+            const char* pData = va_arg(*pArgList, const char*);
+            int nLen = va_arg(*pArgList, int);
+
+            rArg.u.p = pData;
+            if (NULL == pData)
+            {
+                rArg.eType = E_LOG_ARG_NULL_STRING;
+                break;
+            }
+
+            rArg.uiLen = (nLen > 0) ? (UINT32)nLen : 0;
+            break;
+        }
+    }
+}
+
+BOOL CRilLogQueue::Capture(LOG_RECORD& rRecord, UINT8 uiLevel, const char* pszFormat,
+        va_list argList)
+{
+    LOG_SPEC spec;
+    const char* p = pszFormat;
+    va_list args;
+    BOOL bResult = TRUE;
+
+    rRecord.uiSeq = __sync_fetch_and_add(&m_uiSeq, 1);
+    rRecord.uiLevel = uiLevel;
+    rRecord.uiArgCount = 0;
+    rRecord.uiDataSize = 0;
+    rRecord.pszFormat = pszFormat;
+
+    if (NULL == pszFormat)
+    {
+        return FALSE;
+    }
+
+    va_copy(args, argList);
+
+    while (NULL != (p = strchr(p, '%')))
+    {
+        int iPrecision;
+
+        if (!ParseSpec(p, spec))
+        {
+            bResult = FALSE;
+            break;
+        }
+        p = spec.pszEnd;
+
+        if ('%' == spec.chConversion)
+        {
+            continue;
+        }
+
+        // worst case: width, precision and the value
+        if (rRecord.uiArgCount + 3 > LOG_RECORD::E_MAX_ARGS)
+        {
+            bResult = FALSE;
+            break;
+        }
+
+        if (spec.bStarWidth)
+        {
+            ReadArg(rRecord.rgArgs[rRecord.uiArgCount++], E_LOG_ARG_INT, -1, &args);
+        }
+
+        iPrecision = spec.iPrecision;
+        if (spec.bStarPrecision)
+        {
+            LOG_ARG& rArg = rRecord.rgArgs[rRecord.uiArgCount++];
+            ReadArg(rArg, E_LOG_ARG_INT, -1, &args);
+            iPrecision = rArg.u.i;
+        }
+
+        LOG_ARG& rArg = rRecord.rgArgs[rRecord.uiArgCount++];
+        ReadArg(rArg, spec.eType, iPrecision, &args);
+
+        if (E_LOG_ARG_STRING == rArg.eType || E_LOG_ARG_RAW == rArg.eType)
+        {
+            AddData(rRecord, rArg, (const char*)rArg.u.p, rArg.uiLen);
+        }
+    }
+
+    va_end(args);
+    return bResult;
+}
+
+//
+//  Append the "%<flags><width>" part of a specification, with a '*' width
+//  replaced by the captured value.
+//
+static UINT32 BuildSpecPrefix(const char* pszSpec, const LOG_SPEC& rSpec, int iWidth,
+        char* pszOut, UINT32 uiOutSize)
+{
+    UINT32 uiLen = (UINT32)(rSpec.pszFlagsEnd - pszSpec) - (rSpec.bStarWidth ? 1 : 0);
+
+    if (uiLen >= uiOutSize)
+    {
+        return 0;
+    }
+
+    memcpy(pszOut, pszSpec, uiLen);
+    pszOut[uiLen] = '\0';
+
+    if (rSpec.bStarWidth)
+    {
+        // a negative width is the '-' flag followed by a positive width
+        uiLen += snprintf(pszOut + uiLen, uiOutSize - uiLen, "%d", iWidth);
+    }
+
+    return uiLen;
+}
+
+static UINT32 ExpandRaw(const char* pData, UINT32 uiLen, char* pszOut, UINT32 uiOutSize)
+{
+    UINT32 uiOut = 0;
+
+    for (UINT32 i = 0; i < uiLen && uiOut + 1 < uiOutSize; i++)
+    {
+        const char* pszSubst = NULL;
+        char szHex[5];
+
+        if (0x0A == pData[i])
+        {
+            pszSubst = "<lf>";
+        }
+        else if (0x0D == pData[i])
+        {
+            pszSubst = "<cr>";
+        }
+        else if (pData[i] >= 0x20 && pData[i] <= 0x7E)
+        {
+            pszOut[uiOut++] = pData[i];
+            continue;
+        }
+        else
+        {
+            snprintf(szHex, sizeof(szHex), "[%02X]", (UINT8)pData[i]);
+            pszSubst = szHex;
+        }
+
+        while ('\0' != *pszSubst && uiOut + 1 < uiOutSize)
+        {
+            pszOut[uiOut++] = *pszSubst++;
+        }
+    }
+
+    pszOut[uiOut] = '\0';
+    return uiOut;
+}
+
+//
+//  Format one conversion. pData holds the bytes of the string types.
+//
+static int FormatArg(const char* pszSpec, const LOG_SPEC& rSpec, int iWidth, int iPrecision,
+        const LOG_ARG& rArg, const char* pData, char* pszOut, UINT32 uiOutSize)
+{
+    char szSpec[64];
+    UINT32 uiPrefix = BuildSpecPrefix(pszSpec, rSpec, iWidth, szSpec, sizeof(szSpec));
+
+    if (0 == uiPrefix)
+    {
+        return -1;
+    }
+
+    switch (rArg.eType)
+    {
+        case E_LOG_ARG_STRING:
+            // the captured bytes are not NULL terminated, print them with a precision
+            strncat(szSpec, ".*s", sizeof(szSpec) - uiPrefix - 1);
+            return snprintf(pszOut, uiOutSize, szSpec, (int)rArg.uiLen, pData);
+
+        case E_LOG_ARG_NULL_STRING:
+            strncat(szSpec, ".*s", sizeof(szSpec) - uiPrefix - 1);
+            return snprintf(pszOut, uiOutSize, szSpec,
+                    (int)((iPrecision >= 0 && iPrecision < 6) ? iPrecision : 6),
+                    ('R' == rSpec.chConversion) ? "NULL" : "(null)");
+
+        case E_LOG_ARG_RAW:
+            return ExpandRaw(pData, rArg.uiLen, pszOut, uiOutSize);
+
+        default:
+            break;
+    }
+
+    // numbers keep their own precision and length modifiers
+    UINT32 uiLen = uiPrefix;
+    UINT32 uiSuffix = rSpec.pszEnd - rSpec.pszPrecisionEnd;
+
+    if (rSpec.bStarPrecision)
+    {
+        if (iPrecision >= 0)
+        {
+            uiLen += snprintf(szSpec + uiLen, sizeof(szSpec) - uiLen, ".%d", iPrecision);
+        }
+    }
+    else
+    {
+        UINT32 uiCopy = rSpec.pszPrecisionEnd - rSpec.pszFlagsEnd;
+        if (uiLen + uiCopy < sizeof(szSpec))
+        {
+            memcpy(szSpec + uiLen, rSpec.pszFlagsEnd, uiCopy);
+            uiLen += uiCopy;
+        }
+    }
+
+    if (uiLen + uiSuffix >= sizeof(szSpec))
+    {
+        return 0;
+    }
+    memcpy(szSpec + uiLen, rSpec.pszPrecisionEnd, uiSuffix);
+    szSpec[uiLen + uiSuffix] = '\0';
+
+    switch (rArg.eType)
+    {
+        case E_LOG_ARG_LONG:
+            return snprintf(pszOut, uiOutSize, szSpec, rArg.u.l);
+
+        case E_LOG_ARG_LONGLONG:
+            return snprintf(pszOut, uiOutSize, szSpec, rArg.u.ll);
+
+        case E_LOG_ARG_DOUBLE:
+            return snprintf(pszOut, uiOutSize, szSpec, rArg.u.d);
+
+        case E_LOG_ARG_POINTER:
+            return snprintf(pszOut, uiOutSize, szSpec, rArg.u.p);
+
+        default:
+            return snprintf(pszOut, uiOutSize, szSpec, rArg.u.i);
+    }
+}
+
+//
+//  Walk the format string, taking the arguments either from a captured record
+//  or, when pRecord is NULL, straight from the argument list.
+//
+static void FormatText(const char* pszFormat, const LOG_RECORD* pRecord, va_list* pArgList,
+        char* pszText, UINT32 uiTextSize)
+{
+    LOG_SPEC spec;
+    const char* p = pszFormat;
+    UINT32 uiOut = 0;
+    UINT32 uiArg = 0;
+
+    if (NULL == pszText || 0 == uiTextSize)
+    {
+        return;
+    }
+    pszText[0] = '\0';
+
+    if (NULL == p)
+    {
+        return;
+    }
+
+    while ('\0' != *p && uiOut + 1 < uiTextSize)
+    {
+        const char* pszSpec = p;
+        int iWidth = 0;
+        int iPrecision = -1;
+        int iWritten = 0;
+        LOG_ARG arg;
+        const LOG_ARG* pArg = &arg;
+        const char* pData;
+
+        if ('%' != *p)
+        {
+            pszText[uiOut++] = *p++;
+            continue;
+        }
+
+        // %n, long double or unknown: the remaining arguments cannot be located
+        if (!ParseSpec(pszSpec, spec))
+        {
+            break;
+        }
+        p = spec.pszEnd;
+
+        if ('%' == spec.chConversion)
+        {
+            pszText[uiOut++] = '%';
+            continue;
+        }
+
+        if (NULL != pRecord)
+        {
+            if (spec.bStarWidth && uiArg < pRecord->uiArgCount)
+            {
+                iWidth = pRecord->rgArgs[uiArg++].u.i;
+            }
+            if (spec.bStarPrecision && uiArg < pRecord->uiArgCount)
+            {
+                iPrecision = pRecord->rgArgs[uiArg++].u.i;
+            }
+            if (uiArg >= pRecord->uiArgCount)
+            {
+                break;
+            }
+
+            pArg = &pRecord->rgArgs[uiArg++];
+            pData = pRecord->szData + pArg->uiOffset;
+        }
+        else
+        {
+            if (spec.bStarWidth)
+            {
+                ReadArg(arg, E_LOG_ARG_INT, -1, pArgList);
+                iWidth = arg.u.i;
+            }
+
+            iPrecision = spec.iPrecision;
+            if (spec.bStarPrecision)
+            {
+                ReadArg(arg, E_LOG_ARG_INT, -1, pArgList);
+                iPrecision = arg.u.i;
+            }
+
+            ReadArg(arg, spec.eType, iPrecision, pArgList);
+            pData = (const char*)arg.u.p;
+
+            // as for a record, a precision given as digits stays in the spec
+            if (!spec.bStarPrecision)
+            {
+                iPrecision = -1;
+            }
+        }
+
+        iWritten = FormatArg(pszSpec, spec, iWidth, iPrecision, *pArg, pData,
+                pszText + uiOut, uiTextSize - uiOut);
+        if (iWritten < 0)
+        {
+            break;
+        }
+
+        uiOut += iWritten;
+        if (uiOut >= uiTextSize)
+        {
+            uiOut = uiTextSize - 1;
+        }
+    }
+
+    pszText[uiOut] = '\0';
+}
+
+void CRilLogQueue::Format(const LOG_RECORD& rRecord, char* pszText, UINT32 uiTextSize)
+{
+    FormatText(rRecord.pszFormat, &rRecord, NULL, pszText, uiTextSize);
+}
+
+void CRilLogQueue::Format(const char* pszFormat, va_list argList, char* pszText,
+        UINT32 uiTextSize)
+{
+    va_list args;
+
+    va_copy(args, argList);
+    FormatText(pszFormat, NULL, &args, pszText, uiTextSize);
+    va_end(args);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//
+//  Single producer (the owning thread), single consumer (the drain thread)
+//  byte ring. A record is a size word followed by the used part of the
+//  LOG_RECORD. A record never wraps; the end of the buffer is padded instead.
+//
+class CRilLogQueue::CRing
+{
+public:
+    CRing() :
+        m_pNext(NULL),
+        m_bOrphan(FALSE),
+        m_uiHead(0),
+        m_uiTail(0)
+    {
+    }
+
+    CRing*          m_pNext;
+    volatile BOOL   m_bOrphan;      // owning thread has exited
+
+    BOOL Push(const LOG_RECORD& rRecord);
+    BOOL Peek(UINT32& ruiSeq);
+    void Pop(LOG_RECORD& rRecord);
+    BOOL IsEmpty() const            { return m_uiHead == m_uiTail; }
+
+private:
+    enum
+    {
+        E_SIZE = 16384,             // must be a power of 2
+        E_MASK = E_SIZE - 1
+    };
+
+    static const UINT32 m_uiPadFlag = 0x80000000;
+    static const UINT32 m_uiHeaderSize = offsetof(LOG_RECORD, rgArgs);
+
+    char            m_rgBuffer[E_SIZE] __attribute__((aligned(8)));
+    volatile UINT32 m_uiHead;       // advanced by the consumer
+    volatile UINT32 m_uiTail;       // advanced by the producer
+};
+
+BOOL CRilLogQueue::CRing::Push(const LOG_RECORD& rRecord)
+{
+    UINT32 uiArgsSize = rRecord.uiArgCount * sizeof(LOG_ARG);
+    UINT32 uiSize = sizeof(UINT32) + m_uiHeaderSize + uiArgsSize + rRecord.uiDataSize;
+    UINT32 uiTail = m_uiTail;
+    UINT32 uiFree = E_SIZE - (uiTail - m_uiHead);
+    UINT32 uiPos = uiTail & E_MASK;
+    UINT32 uiToEnd = E_SIZE - uiPos;
+    char* pDest;
+
+    // keep every record 8 byte aligned so that a pad word always fits
+    uiSize = (uiSize + 7) & ~7;
+
+    if (uiToEnd < uiSize)
+    {
+        if (uiFree < uiToEnd + uiSize)
+        {
+            return FALSE;
+        }
+
+        *(UINT32*)(m_rgBuffer + uiPos) = m_uiPadFlag | uiToEnd;
+        uiTail += uiToEnd;
+        uiPos = 0;
+    }
+    else if (uiFree < uiSize)
+    {
+        return FALSE;
+    }
+
+    pDest = m_rgBuffer + uiPos;
+    *(UINT32*)pDest = uiSize;
+    pDest += sizeof(UINT32);
+    memcpy(pDest, &rRecord, m_uiHeaderSize);
+    pDest += m_uiHeaderSize;
+    memcpy(pDest, rRecord.rgArgs, uiArgsSize);
+    pDest += uiArgsSize;
+    memcpy(pDest, rRecord.szData, rRecord.uiDataSize);
+
+    // publish the record before the tail
+    __sync_synchronize();
+    m_uiTail = uiTail + uiSize;
+    return TRUE;
+}
+
+BOOL CRilLogQueue::CRing::Peek(UINT32& ruiSeq)
+{
+    UINT32 uiTail = m_uiTail;
+
+    __sync_synchronize();
+
+    while (m_uiHead != uiTail)
+    {
+        UINT32 uiWord = *(UINT32*)(m_rgBuffer + (m_uiHead & E_MASK));
+
+        if (uiWord & m_uiPadFlag)
+        {
+            m_uiHead += uiWord & ~m_uiPadFlag;
+            continue;
+        }
+
+        memcpy(&ruiSeq, m_rgBuffer + (m_uiHead & E_MASK) + sizeof(UINT32)
+                + offsetof(LOG_RECORD, uiSeq), sizeof(UINT32));
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+// Must follow a successful Peek()
+void CRilLogQueue::CRing::Pop(LOG_RECORD& rRecord)
+{
+    const char* pSrc = m_rgBuffer + (m_uiHead & E_MASK);
+    UINT32 uiSize = *(UINT32*)pSrc;
+
+    pSrc += sizeof(UINT32);
+    memcpy(&rRecord, pSrc, m_uiHeaderSize);
+    pSrc += m_uiHeaderSize;
+    memcpy(rRecord.rgArgs, pSrc, rRecord.uiArgCount * sizeof(LOG_ARG));
+    pSrc += rRecord.uiArgCount * sizeof(LOG_ARG);
+    memcpy(rRecord.szData, pSrc, rRecord.uiDataSize);
+
+    // done reading before handing the space back
+    __sync_synchronize();
+    m_uiHead += uiSize;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+BOOL CRilLogQueue::Start(PFN_LOG_OUTPUT pfnOutput)
+{
+    pthread_t thread;
+    pthread_attr_t attr;
+    int iResult;
+
+    if (m_bStarted)
+    {
+        return TRUE;
+    }
+
+    if (NULL == pfnOutput || 0 != pthread_key_create(&m_threadKey, OnThreadExit))
+    {
+        return FALSE;
+    }
+
+    m_pfnOutput = pfnOutput;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    iResult = pthread_create(&thread, &attr, DrainThreadProc, NULL);
+    pthread_attr_destroy(&attr);
+
+    if (0 != iResult)
+    {
+        pthread_key_delete(m_threadKey);
+        return FALSE;
+    }
+
+    m_bStarted = TRUE;
+    return TRUE;
+}
+
+CRilLogQueue::CRing* CRilLogQueue::GetThreadRing()
+{
+    CRing* pRing = (CRing*)pthread_getspecific(m_threadKey);
+
+    if (NULL == pRing)
+    {
+        pRing = new CRing();
+        if (NULL == pRing)
+        {
+            return NULL;
+        }
+
+        if (0 != pthread_setspecific(m_threadKey, pRing))
+        {
+            delete pRing;
+            return NULL;
+        }
+
+        pthread_mutex_lock(&m_lock);
+        pRing->m_pNext = m_pRings;
+        m_pRings = pRing;
+        pthread_mutex_unlock(&m_lock);
+    }
+
+    return pRing;
+}
+
+void CRilLogQueue::OnThreadExit(void* pRing)
+{
+    // the drain thread frees the ring once it is empty
+    __sync_synchronize();
+    ((CRing*)pRing)->m_bOrphan = TRUE;
+}
+
+BOOL CRilLogQueue::Enqueue(const LOG_RECORD& rRecord)
+{
+    CRing* pRing;
+
+    if (!m_bStarted)
+    {
+        return FALSE;
+    }
+
+    pRing = GetThreadRing();
+    if (NULL == pRing || !pRing->Push(rRecord))
+    {
+        return FALSE;
+    }
+
+    // only wake up the drain thread if it is not already on its way
+    if (__sync_bool_compare_and_swap(&m_iPending, 0, 1))
+    {
+        pthread_mutex_lock(&m_lock);
+        pthread_cond_signal(&m_cond);
+        pthread_mutex_unlock(&m_lock);
+    }
+
+    return TRUE;
+}
+
+//
+//  Write out everything queued so far, in the order of the log calls across
+//  all threads, then free the rings of exited threads.
+//
+void CRilLogQueue::DrainOnce()
+{
+    LOG_RECORD record;
+    char szText[LOG_RECORD::E_MAX_DATA];
+    CRing* pRings;
+    CRing** ppRing;
+
+    pthread_mutex_lock(&m_lock);
+    pRings = m_pRings;
+    pthread_mutex_unlock(&m_lock);
+
+    for (;;)
+    {
+        CRing* pNext = NULL;
+        UINT32 uiMinSeq = 0;
+
+        for (CRing* pRing = pRings; NULL != pRing; pRing = pRing->m_pNext)
+        {
+            UINT32 uiSeq;
+
+            if (pRing->Peek(uiSeq) && (NULL == pNext || (INT32)(uiSeq - uiMinSeq) < 0))
+            {
+                pNext = pRing;
+                uiMinSeq = uiSeq;
+            }
+        }
+
+        if (NULL == pNext)
+        {
+            break;
+        }
+
+        pNext->Pop(record);
+        Format(record, szText, sizeof(szText));
+        m_pfnOutput(record.uiLevel, szText);
+    }
+
+    pthread_mutex_lock(&m_lock);
+    for (ppRing = &m_pRings; NULL != *ppRing; )
+    {
+        CRing* pRing = *ppRing;
+
+        if (pRing->m_bOrphan && pRing->IsEmpty())
+        {
+            *ppRing = pRing->m_pNext;
+            delete pRing;
+        }
+        else
+        {
+            ppRing = &pRing->m_pNext;
+        }
+    }
+    pthread_mutex_unlock(&m_lock);
+}
+
+void* CRilLogQueue::DrainThreadProc(void* /*pArg*/)
+{
+    for (;;)
+    {
+        pthread_mutex_lock(&m_lock);
+        while (0 == m_iPending)
+        {
+            pthread_cond_wait(&m_cond, &m_lock);
+        }
+        m_iPending = 0;
+        pthread_mutex_unlock(&m_lock);
+
+        DrainOnce();
+    }
+
+    return NULL;
+}
@@ -0,0 +1,115 @@
+////////////////////////////////////////////////////////////////////////////
+// rillogqueue.h
+//
+// Copyright 2009 Intrinsyc Software International, Inc.  All rights reserved.
+// Patents pending in the United States of America and other jurisdictions.
+//
+//
+// Description:
+//    Deferred formatting for CRilLog. A log call only captures the format
+//    string pointer and the raw arguments (string arguments are copied) into
+//    a ring owned by the calling thread. A single drain thread formats the
+//    records and writes them to the radio log, so that the channel threads
+//    never block on vsnprintf or logcat.
+//
+/////////////////////////////////////////////////////////////////////////////
+
+#ifndef RRIL_LOG_QUEUE_H
+#define RRIL_LOG_QUEUE_H
+
+#include <stdarg.h>
+#include <pthread.h>
+
+#include "types.h"
+
+//
+// Arguments of a log call, as captured from the va_list
+//
+struct LOG_ARG
+{
+    UINT8   eType;      // LOG_ARG_TYPE
+    UINT16  uiLen;      // string types: bytes in the record data
+    UINT16  uiOffset;   // string types: offset in the record data
+    union
+    {
+        int         i;
+        long        l;
+        long long   ll;
+        double      d;
+        const void* p;
+    } u;
+};
+
+enum LOG_ARG_TYPE
+{
+    E_LOG_ARG_INT,
+    E_LOG_ARG_LONG,
+    E_LOG_ARG_LONGLONG,
+    E_LOG_ARG_DOUBLE,
+    E_LOG_ARG_POINTER,
+    E_LOG_ARG_STRING,       // %s, copied
+    E_LOG_ARG_NULL_STRING,  // %s given a NULL pointer
+    E_LOG_ARG_RAW           // %R, copied, CR/LF and non-printables expanded on output
+};
+
+struct LOG_RECORD
+{
+    enum
+    {
+        E_MAX_ARGS = 16,
+        E_MAX_DATA = 1024
+    };
+
+    UINT32      uiSeq;
+    UINT8       uiLevel;
+    UINT8       uiArgCount;
+    UINT16      uiDataSize;
+    const char* pszFormat;
+    LOG_ARG     rgArgs[E_MAX_ARGS];
+    char        szData[E_MAX_DATA];
+};
+
+class CRilLogQueue
+{
+public:
+    // Output function of the drain thread, called with the formatted text
+    typedef void (*PFN_LOG_OUTPUT)(UINT8 uiLevel, const char* pszText);
+
+    // Start the drain thread. Until then, and whenever a record cannot be
+    // queued, messages are formatted and written on the calling thread.
+    static BOOL Start(PFN_LOG_OUTPUT pfnOutput);
+
+    // Capture a log call. Returns FALSE if the format uses something that
+    // cannot be captured (%n, long double, too many arguments...).
+    static BOOL Capture(LOG_RECORD& rRecord, UINT8 uiLevel, const char* pszFormat,
+            va_list argList);
+
+    // Queue a captured record on the ring of the calling thread
+    static BOOL Enqueue(const LOG_RECORD& rRecord);
+
+    // Format a captured record into pszText
+    static void Format(const LOG_RECORD& rRecord, char* pszText, UINT32 uiTextSize);
+
+    // Format a log call on the spot, with the same conversions as above (%R included)
+    static void Format(const char* pszFormat, va_list argList, char* pszText,
+            UINT32 uiTextSize);
+
+private:
+    class CRing;
+
+    static CRing* GetThreadRing();
+    static void OnThreadExit(void* pRing);
+    static void* DrainThreadProc(void* pArg);
+    static void DrainOnce();
+
+    static PFN_LOG_OUTPUT   m_pfnOutput;
+    static BOOL             m_bStarted;
+    static volatile UINT32  m_uiSeq;
+    static volatile int     m_iPending;
+    static pthread_key_t    m_threadKey;
+    static pthread_mutex_t  m_lock;         // protects the ring list and m_iPending wake up
+    static pthread_cond_t   m_cond;
+    static CRing*           m_pRings;
+};
+
+#endif // RRIL_LOG_QUEUE_H